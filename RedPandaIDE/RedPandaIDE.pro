@@ -116,6 +116,7 @@ SOURCES += \
     caretlist.cpp \
     codesnippetsmanager.cpp \
     colorscheme.cpp \
+    compiler/buildtimes.cpp \
     compiler/compilerinfo.cpp \
     compiler/ojproblemcasesrunner.cpp \
     compiler/projectcompiler.cpp \
@@ -125,6 +126,7 @@ SOURCES += \
     compiler/compilermanager.cpp \
     compiler/executablerunner.cpp \
     compiler/filecompiler.cpp \
+    compiler/heapprofile.cpp \
     compiler/stdincompiler.cpp \
     debugger/debugger.cpp \
     debugger/gdbmidebugger.cpp \
@@ -135,6 +137,7 @@ SOURCES += \
     parser/cppparser.cpp \
     parser/cpppreprocessor.cpp \
     parser/cpptokenizer.cpp \
+    parser/filetable.cpp \
     parser/parserutils.cpp \
     parser/statementmodel.cpp \
     problems/freeprojectsetformat.cpp \
@@ -143,6 +146,7 @@ SOURCES += \
     project.cpp \
     projectoptions.cpp \
     projecttemplate.cpp \
+    quickopenindex.cpp \
     settingsdialog/compilerautolinkwidget.cpp \
     settingsdialog/debuggeneralwidget.cpp \
     settingsdialog/editorautosavewidget.cpp \
@@ -170,6 +174,7 @@ SOURCES += \
     settingsdialog/projectprecompilewidget.cpp \
     settingsdialog/toolsgeneralwidget.cpp \
     shortcutmanager.cpp \
+    startuptasks.cpp \
     symbolusagemanager.cpp \
     syntaxermanager.cpp \
     thememanager.cpp \
@@ -185,6 +190,7 @@ SOURCES += \
     widgets/cpudialog.cpp \
     editor.cpp \
     editorlist.cpp \
+    filechangewatcher.cpp \
     iconsmanager.cpp \
     main.cpp \
     mainwindow.cpp \
@@ -205,16 +211,19 @@ SOURCES += \
     utils.cpp \
     utils/escape.cpp \
     utils/font.cpp \
+    utils/linediff.cpp \
     utils/parsearg.cpp \
     widgets/coloredit.cpp \
     widgets/compileargumentswidget.cpp \
     widgets/customdisablediconengine.cpp \
     widgets/customfilesystemmodel.cpp \
+    widgets/buildtimesdialog.cpp \
     widgets/custommakefileinfodialog.cpp \
     widgets/darkfusionstyle.cpp \
     widgets/editorfontdialog.cpp \
     widgets/editorstabwidget.cpp \
     widgets/filenameeditdelegate.cpp \
+    widgets/heapprofiledialog.cpp \
     widgets/filepropertiesdialog.cpp \
     widgets/functiontooltipwidget.cpp \
     widgets/headercompletionpopup.cpp \
@@ -234,12 +243,15 @@ SOURCES += \
     widgets/projectalreadyopendialog.cpp \
     widgets/qconsole.cpp \
     widgets/qpatchedcombobox.cpp \
+    widgets/quickopenpopup.cpp \
+    widgets/runconsole.cpp \
     widgets/searchdialog.cpp \
     widgets/searchinfiledialog.cpp \
     widgets/searchresultview.cpp \
     widgets/shortcutinputedit.cpp \
     widgets/shrinkabletabwidget.cpp \
-    widgets/signalmessagedialog.cpp
+    widgets/signalmessagedialog.cpp \
+    widgets/terminalscreen.cpp
 
 HEADERS += \
     SimpleIni.h \
@@ -250,11 +262,13 @@ HEADERS += \
     caretlist.h \
     codesnippetsmanager.h \
     colorscheme.h \
+    compiler/buildtimes.h \
     compiler/compiler.h \
     compiler/compilerinfo.h \
     compiler/compilermanager.h \
     compiler/executablerunner.h \
     compiler/filecompiler.h \
+    compiler/heapprofile.h \
     compiler/ojproblemcasesrunner.h \
     compiler/projectcompiler.h \
     compiler/runner.h \
@@ -262,6 +276,7 @@ HEADERS += \
     debugger/debugger.h \
     debugger/gdbmidebugger.h \
     debugger/gdbmiresultparser.h \
+    debugger/parseresultqueue.h \
 #    debugger/dapprotocol.h \    
 #    debugger/dapdebugger.h \    
     cpprefacter.h \
@@ -269,6 +284,7 @@ HEADERS += \
     parser/cppparser.h \
     parser/cpppreprocessor.h \
     parser/cpptokenizer.h \
+    parser/filetable.h \
     parser/parserutils.h \
     parser/statementmodel.h \
     problems/freeprojectsetformat.h \
@@ -277,6 +293,7 @@ HEADERS += \
     project.h \
     projectoptions.h \
     projecttemplate.h \
+    quickopenindex.h \
     settingsdialog/compilerautolinkwidget.h \
     settingsdialog/debuggeneralwidget.h \
     settingsdialog/editorautosavewidget.h \
@@ -304,6 +321,7 @@ HEADERS += \
     settingsdialog/projectprecompilewidget.h \
     settingsdialog/toolsgeneralwidget.h \
     shortcutmanager.h \
+    startuptasks.h \
     symbolusagemanager.h \
     syntaxermanager.h \
     thememanager.h \
@@ -319,6 +337,7 @@ HEADERS += \
     widgets/cpudialog.h \
     editor.h \
     editorlist.h \
+    filechangewatcher.h \
     iconsmanager.h \
     mainwindow.h \
     settingsdialog/compilersetdirectorieswidget.h \
@@ -338,17 +357,20 @@ HEADERS += \
     utils.h \
     utils/escape.h \
     utils/font.h \
+    utils/linediff.h \
     utils/parsearg.h \
     common.h \
     widgets/coloredit.h \
     widgets/compileargumentswidget.h \
     widgets/customdisablediconengine.h \
     widgets/customfilesystemmodel.h \
+    widgets/buildtimesdialog.h \
     widgets/custommakefileinfodialog.h \
     widgets/darkfusionstyle.h \
     widgets/editorfontdialog.h \
     widgets/editorstabwidget.h \
     widgets/filenameeditdelegate.h \
+    widgets/heapprofiledialog.h \
     widgets/filepropertiesdialog.h \
     widgets/functiontooltipwidget.h \
     widgets/headercompletionpopup.h \
@@ -368,12 +390,15 @@ HEADERS += \
     widgets/projectalreadyopendialog.h \
     widgets/qconsole.h \
     widgets/qpatchedcombobox.h \
+    widgets/quickopenpopup.h \
+    widgets/runconsole.h \
     widgets/searchdialog.h \
     widgets/searchinfiledialog.h \
     widgets/searchresultview.h \
     widgets/shortcutinputedit.h \
     widgets/shrinkabletabwidget.h \
-    widgets/signalmessagedialog.h
+    widgets/signalmessagedialog.h \
+    widgets/terminalscreen.h
 
 FORMS += \
     settingsdialog/compilerautolinkwidget.ui \
@@ -417,9 +442,11 @@ FORMS += \
     settingsdialog/environmentappearancewidget.ui \
     settingsdialog/executorgeneralwidget.ui \
     settingsdialog/settingsdialog.ui \
+    widgets/buildtimesdialog.ui \
     widgets/custommakefileinfodialog.ui \
     widgets/editorfontdialog.ui \
     widgets/filepropertiesdialog.ui \
+    widgets/heapprofiledialog.ui \
     widgets/infomessagebox.ui \
     widgets/newclassdialog.ui \
     widgets/newheaderdialog.ui \
@@ -475,6 +502,7 @@ ENABLE_VCS {
         vcs/gitresetdialog.cpp \
         vcs/gituserconfigdialog.cpp \
         vcs/gitutils.cpp \
+        vcs/linechangetracker.cpp \
         settingsdialog/toolsgitwidget.cpp
 
     HEADERS += \
@@ -490,6 +518,7 @@ ENABLE_VCS {
         vcs/gitresetdialog.h \
         vcs/gituserconfigdialog.h \
         vcs/gitutils.h \
+        vcs/linechangetracker.h \
         settingsdialog/toolsgitwidget.h
 
 
@@ -522,9 +551,11 @@ win32: {
 
 unix: {
     HEADERS += \
+    compiler/ptyrunner.h \
     settingsdialog/formatterpathwidget.h
 
     SOURCES += \
+    compiler/ptyrunner.cpp \
     settingsdialog/formatterpathwidget.cpp
 
     FORMS += \
@@ -533,7 +564,7 @@ unix: {
 
 linux: {
     # legacy glibc compatibility -- modern Unices have all components in `libc.so`
-    LIBS += -lrt -ldl
+    LIBS += -lrt -ldl -lutil
 
     _LINUX_STATIC_IME_PLUGIN = $$(LINUX_STATIC_IME_PLUGIN)
     equals(_LINUX_STATIC_IME_PLUGIN, "ON") {
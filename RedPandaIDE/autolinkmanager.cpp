@@ -25,21 +25,33 @@
 
 AutolinkManager* pAutolinkManager;
 
-AutolinkManager::AutolinkManager()
+AutolinkManager::AutolinkManager():
+    mTrieRoot{std::make_shared<AutolinkTrieNode>()},
+    mVersion{0}
 {
 }
 
 PAutolink AutolinkManager::getLink(const QString &header) const
 {
-    PAutolink link = mLinks.value(header,PAutolink());
-    if (link)
-        return link;
-    foreach (QString key, mLinks.keys()) {
-        if (header.endsWith("/"+key, PATH_SENSITIVITY)) {
-            return mLinks.value(key);
-        }
+    // the deepest match wins, i.e. the header itself, or else the
+    // longest registered path that the header ends with
+    PAutolink link;
+    AutolinkTrieNode* node = mTrieRoot.get();
+    int end = header.length();
+    while (end>=0) {
+        int start = (end>0)?header.lastIndexOf('/', end-1):-1;
+        PAutolinkTrieNode child = node->children.value(
+                    pathComponentKey(header.mid(start+1, end-start-1)));
+        if (!child)
+            break;
+        node = child.get();
+        if (node->link)
+            link = node->link;
+        if (start<0)
+            break;
+        end = start;
     }
-    return PAutolink();
+    return link;
 }
 
 void AutolinkManager::load()
@@ -118,7 +130,20 @@ void AutolinkManager::setLink(const QString &header, const QString &linkOption,
         link->linkOption = linkOption;
         link->execUseUTF8 = execUseUTF8;
         mLinks.insert(header,link);
+        AutolinkTrieNode* node = mTrieRoot.get();
+        QStringList components = header.split('/');
+        for (int i=components.length()-1;i>=0;i--) {
+            QString key = pathComponentKey(components[i]);
+            PAutolinkTrieNode child = node->children.value(key);
+            if (!child) {
+                child = std::make_shared<AutolinkTrieNode>();
+                node->children.insert(key, child);
+            }
+            node = child.get();
+        }
+        node->link = link;
     }
+    mVersion++;
 }
 
 const QMap<QString, PAutolink> &AutolinkManager::links() const
@@ -129,6 +154,8 @@ const QMap<QString, PAutolink> &AutolinkManager::links() const
 void AutolinkManager::clear()
 {
     mLinks.clear();
+    mTrieRoot = std::make_shared<AutolinkTrieNode>();
+    mVersion++;
 }
 
 QJsonArray AutolinkManager::toJson()
@@ -152,3 +179,15 @@ void AutolinkManager::fromJson(QJsonArray json)
         setLink(obj["header"].toString(),obj["links"].toString(),obj["execUseUTF8"].toBool());
     }
 }
+
+int AutolinkManager::version() const
+{
+    return mVersion;
+}
+
+QString AutolinkManager::pathComponentKey(const QString &component)
+{
+    if (PATH_SENSITIVITY == Qt::CaseInsensitive)
+        return component.toLower();
+    return component;
+}
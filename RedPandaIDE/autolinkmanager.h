@@ -22,6 +22,7 @@
 #include <memory>
 #include <QVector>
 #include <QMap>
+#include <QHash>
 
 struct Autolink {
     QString header;
@@ -30,6 +31,16 @@ struct Autolink {
 };
 using PAutolink = std::shared_ptr<Autolink>;
 
+struct AutolinkTrieNode;
+using PAutolinkTrieNode = std::shared_ptr<AutolinkTrieNode>;
+
+// Autolinks indexed by their path components in reverse order,
+// so a header path can be resolved by walking it from the file name up.
+struct AutolinkTrieNode {
+    QHash<QString, PAutolinkTrieNode> children;
+    PAutolink link;
+};
+
 class AutolinkManager
 {
 public:
@@ -40,13 +51,18 @@ public:
     void setLink(const QString& header,
                  const QString& linkOption,
                  bool execUseUTF8);
-    void removeLink(const QString& header);
     const QMap<QString,PAutolink>& links() const;
     void clear();
     QJsonArray toJson();
     void fromJson(QJsonArray json);
+    // changed each time the autolinks are modified
+    int version() const;
+private:
+    static QString pathComponentKey(const QString& component);
 private:
     QMap<QString,PAutolink> mLinks;
+    PAutolinkTrieNode mTrieRoot;
+    int mVersion;
 };
 
 extern AutolinkManager* pAutolinkManager;
@@ -279,7 +279,9 @@ void ColorManager::init()
 
 void ColorManager::reload()
 {
+    // only the names are collected, schemes are loaded when they are used
     mSchemes.clear();
+    mSchemeFiles.clear();
     //bundled schemes ( the lowest priority)
     loadSchemesInDir(pSettings->dirs().data(Settings::Dirs::DataType::ColorScheme),true,false);
     //config schemes ( higher priority)
@@ -295,7 +297,7 @@ QStringList ColorManager::getSchemes(const QString &themeType)
     }
     QStringList lst;
     for (QString name:mSchemes.keys()) {
-        PColorScheme scheme = mSchemes[name];
+        PColorScheme scheme = get(name);
         if (scheme && scheme->preferThemeType() == themeType) {
             lst.append(name);
         }
@@ -313,11 +315,19 @@ bool ColorManager::exists(const QString name)
     return mSchemes.contains(name);
 }
 
+bool ColorManager::isCustomed(const QString &name)
+{
+    PColorScheme scheme = mSchemes.value(name);
+    if (scheme)
+        return scheme->customed();
+    return mSchemeFiles.value(name).customed;
+}
+
 QString ColorManager::copy(const QString &sourceName)
 {
-    if (!mSchemes.contains(sourceName))
+    PColorScheme sourceScheme = get(sourceName);
+    if (!sourceScheme)
         return QString();
-    PColorScheme sourceScheme = mSchemes[sourceName];
     QString newName = sourceName+" Copy";
     if (mSchemes.contains(newName))
         return QString();
@@ -406,22 +416,13 @@ void ColorManager::loadSchemesInDir(const QString &dirName, bool isBundled, bool
             name.replace('_',' ');
             if (!isValidName(name))
                 continue;
-            PColorScheme scheme = ColorScheme::load(fileInfo.absoluteFilePath());
-            if (!isCustomed) {
-                scheme->setBundled(isBundled);
-                scheme->setCustomed(false);
-            } else {
-                scheme->setBundled(false);
-                if (mSchemes.contains(name)) {
-                    PColorScheme oldScheme = mSchemes[name];
-                    if (oldScheme) {
-                        scheme->setBundled(oldScheme->bundled());
-                    }
-                    mSchemes.remove(name);
-                }
-                scheme->setCustomed(true);
+            SchemeFile schemeFile{fileInfo.absoluteFilePath(), isBundled, isCustomed};
+            if (isCustomed) {
+                // keeps the bundled flag of the scheme it overrides
+                schemeFile.bundled = mSchemeFiles.contains(name) && mSchemeFiles[name].bundled;
             }
-            mSchemes[name]=scheme;
+            mSchemeFiles[name]=schemeFile;
+            mSchemes[name]=PColorScheme();
         }
     }
 }
@@ -629,9 +630,19 @@ bool ColorManager::add(const QString &name, PColorScheme scheme)
 
 PColorScheme ColorManager::get(const QString &name)
 {
-    if (mSchemes.contains(name))
-        return mSchemes[name];
-    return PColorScheme();
+    auto it = mSchemes.find(name);
+    if (it == mSchemes.end())
+        return PColorScheme();
+    if (!it.value() && mSchemeFiles.contains(name)) {
+        SchemeFile schemeFile = mSchemeFiles.take(name);
+        PColorScheme scheme = ColorScheme::load(schemeFile.filename);
+        if (scheme) {
+            scheme->setBundled(schemeFile.bundled);
+            scheme->setCustomed(schemeFile.customed);
+        }
+        it.value() = scheme;
+    }
+    return it.value();
 }
 
 PColorSchemeItem ColorManager::getItem(const QString &schemeName, const QString &itemName)
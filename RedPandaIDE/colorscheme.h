@@ -18,6 +18,7 @@
 #define COLORSCHEME_H
 
 #include <QColor>
+#include <QHash>
 #include "qsynedit/syntaxer/syntaxer.h"
 #include "parser/statementmodel.h"
 
@@ -151,6 +152,8 @@ public:
     QStringList getDefines();
 
     bool exists(const QString name);
+    // doesn't load the scheme
+    bool isCustomed(const QString& name);
     QString copy(const QString& source);
     bool restoreToDefault(const QString& name);
     bool remove(const QString& name);
@@ -172,8 +175,16 @@ private:
     void loadSchemesInDir(const QString& dirName, bool isBundled, bool isCustomed);
     void initItemDefines();
 private:
+    struct SchemeFile {
+        QString filename;
+        bool bundled = false;
+        bool customed = false;
+    };
     QMap<QString,PColorSchemeItemDefine> mSchemeItemDefines;
+    // all schemes, the ones not used yet are null
     QMap<QString,PColorScheme> mSchemes;
+    // files of the schemes not used yet, loaded by get()
+    QHash<QString,SchemeFile> mSchemeFiles;
     PColorSchemeItemDefine mDefaultSchemeItemDefine;
 };
 
@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "buildtimes.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <algorithm>
+#include "qt_utils/utils.h"
+#include "../systemconsts.h"
+#include "../utils/parsearg.h"
+
+static const int MaxBuildRecords = 30;
+static const int MaxHeaderCosts = 200;
+// file times may be rounded (2 seconds on FAT)
+static const qint64 FileTimeTolerance = 2000;
+
+BuildTimeRecorder::BuildTimeRecorder(const QString &directory, bool readTimeTraces):
+    mDirectory{directory},
+    mReadTimeTraces{readTimeTraces},
+    mStartTime{QDateTime::currentDateTime()}
+{
+
+}
+
+void BuildTimeRecorder::processOutput(const QString &output)
+{
+    QString text = mPendingLine + output;
+    int start = 0;
+    while (true) {
+        int pos = text.indexOf('\n', start);
+        if (pos < 0)
+            break;
+        processLine(text.mid(start, pos - start));
+        start = pos + 1;
+    }
+    mPendingLine = text.mid(start);
+}
+
+PBuildRecord BuildTimeRecorder::finish()
+{
+    if (!mPendingLine.isEmpty()) {
+        processLine(mPendingLine);
+        mPendingLine.clear();
+    }
+    PBuildRecord record = std::make_shared<BuildRecord>();
+    record->time = mStartTime;
+    record->wallTime = mStartTime.msecsTo(QDateTime::currentDateTime());
+    foreach (BuildStep step, mSteps) {
+        QFileInfo info(step.outputFile);
+        // the command failed, or didn't write the file
+        if (!info.exists())
+            continue;
+        qint64 endTime = mStartTime.msecsTo(info.lastModified());
+        if (endTime < step.startTime - FileTimeTolerance)
+            continue;
+        step.endTime = std::max(endTime, step.startTime);
+        record->steps.append(step);
+    }
+    if (record->steps.isEmpty())
+        return PBuildRecord();
+    markCriticalPath(record->steps);
+    if (mReadTimeTraces)
+        record->headers = readTimeTraces(record->steps);
+    return record;
+}
+
+void BuildTimeRecorder::processLine(const QString &line)
+{
+    QStringList args = parseArgumentsWithoutVariables(line.trimmed());
+    int outputIndex = args.indexOf("-o");
+    if (args.count() < 3 || outputIndex < 1 || outputIndex + 1 >= args.count())
+        return;
+    BuildStep step;
+    step.outputFile = generateAbsolutePath(mDirectory, args[outputIndex + 1]);
+    step.link = true;
+    // -c for gcc/clang, -i for windres
+    foreach (const QString& option, QStringList{"-c", "-i"}) {
+        int index = args.indexOf(option);
+        if (index >= 0) {
+            step.link = false;
+            if (index + 1 < args.count() && !args[index + 1].startsWith('-'))
+                step.sourceFile = generateAbsolutePath(mDirectory, args[index + 1]);
+            break;
+        }
+    }
+    step.startTime = mStartTime.msecsTo(QDateTime::currentDateTime());
+    step.endTime = step.startTime;
+    step.critical = false;
+    mSteps.append(step);
+}
+
+void BuildTimeRecorder::markCriticalPath(QList<BuildStep> &steps)
+{
+    // Objects only depend on the precompiled header, and the link step on all objects,
+    // so the build waits for the object finished last before the link.
+    int link = -1;
+    for (int i=0;i<steps.count();i++) {
+        if (steps[i].link && (link < 0 || steps[i].startTime >= steps[link].startTime))
+            link = i;
+    }
+    int last = -1;
+    for (int i=0;i<steps.count();i++) {
+        BuildStep& step = steps[i];
+        if (step.link)
+            continue;
+        if (step.outputFile.endsWith("." GCH_EXT)) {
+            step.critical = true;
+            continue;
+        }
+        if (link >= 0 && step.startTime > steps[link].startTime)
+            continue;
+        if (last < 0 || step.endTime > steps[last].endTime)
+            last = i;
+    }
+    if (last >= 0)
+        steps[last].critical = true;
+    if (link >= 0)
+        steps[link].critical = true;
+}
+
+QList<HeaderCost> BuildTimeRecorder::readTimeTraces(const QList<BuildStep> &steps)
+{
+    // clang -ftime-trace writes a chrome trace beside each object file,
+    // "Source" events are the time spent in each included file
+    QHash<QString, HeaderCost> costs;
+    foreach (const BuildStep& step, steps) {
+        if (step.link || step.sourceFile.isEmpty())
+            continue;
+        QString traceFile = changeFileExt(step.outputFile, "json");
+        QFileInfo info(traceFile);
+        if (!info.exists() || mStartTime.msecsTo(info.lastModified()) < step.startTime - FileTimeTolerance)
+            continue;
+        QFile file(traceFile);
+        if (!file.open(QFile::ReadOnly))
+            continue;
+        QJsonArray events = QJsonDocument::fromJson(file.readAll()).object().value("traceEvents").toArray();
+        QSet<QString> included;
+        foreach (const QJsonValue& value, events) {
+            QJsonObject event = value.toObject();
+            if (event.value("name").toString() != "Source")
+                continue;
+            QString fileName = cleanPath(event.value("args").toObject().value("detail").toString());
+            if (fileName.isEmpty())
+                continue;
+            HeaderCost& cost = costs[fileName];
+            cost.fileName = fileName;
+            // microseconds
+            cost.time += event.value("dur").toVariant().toLongLong();
+            if (!included.contains(fileName)) {
+                included.insert(fileName);
+                cost.count++;
+            }
+        }
+    }
+    QList<HeaderCost> result = costs.values();
+    std::sort(result.begin(), result.end(), [](const HeaderCost& cost1, const HeaderCost& cost2) {
+        return cost1.time > cost2.time;
+    });
+    if (result.count() > MaxHeaderCosts)
+        result.erase(result.begin() + MaxHeaderCosts, result.end());
+    for (HeaderCost& cost: result)
+        cost.time /= 1000;
+    return result;
+}
+
+BuildTimeHistory::BuildTimeHistory(const QString &fileName):
+    mFileName{fileName},
+    mDirectory{extractFileDir(fileName)}
+{
+
+}
+
+void BuildTimeHistory::load()
+{
+    mRecords.clear();
+    QFile file(mFileName);
+    if (!file.open(QFile::ReadOnly))
+        return;
+    QJsonArray builds = QJsonDocument::fromJson(file.readAll()).object().value("builds").toArray();
+    foreach (const QJsonValue& value, builds) {
+        QJsonObject build = value.toObject();
+        PBuildRecord record = std::make_shared<BuildRecord>();
+        record->time = QDateTime::fromString(build.value("time").toString(), Qt::ISODate);
+        record->wallTime = build.value("wallTime").toVariant().toLongLong();
+        foreach (const QJsonValue& stepValue, build.value("steps").toArray()) {
+            QJsonObject jsonStep = stepValue.toObject();
+            BuildStep step;
+            step.outputFile = generateAbsolutePath(mDirectory, jsonStep.value("output").toString());
+            step.sourceFile = generateAbsolutePath(mDirectory, jsonStep.value("source").toString());
+            step.link = jsonStep.value("link").toBool();
+            step.startTime = jsonStep.value("start").toVariant().toLongLong();
+            step.endTime = jsonStep.value("end").toVariant().toLongLong();
+            step.critical = jsonStep.value("critical").toBool();
+            record->steps.append(step);
+        }
+        foreach (const QJsonValue& headerValue, build.value("headers").toArray()) {
+            QJsonObject jsonHeader = headerValue.toObject();
+            HeaderCost cost;
+            cost.fileName = jsonHeader.value("file").toString();
+            cost.time = jsonHeader.value("time").toVariant().toLongLong();
+            cost.count = jsonHeader.value("count").toInt();
+            record->headers.append(cost);
+        }
+        mRecords.append(record);
+    }
+}
+
+bool BuildTimeHistory::save() const
+{
+    QJsonArray builds;
+    foreach (const PBuildRecord& record, mRecords) {
+        QJsonObject build;
+        build["time"] = record->time.toString(Qt::ISODate);
+        build["wallTime"] = record->wallTime;
+        QJsonArray steps;
+        foreach (const BuildStep& step, record->steps) {
+            QJsonObject jsonStep;
+            jsonStep["output"] = extractRelativePath(mDirectory, step.outputFile);
+            jsonStep["source"] = extractRelativePath(mDirectory, step.sourceFile);
+            jsonStep["link"] = step.link;
+            jsonStep["start"] = step.startTime;
+            jsonStep["end"] = step.endTime;
+            jsonStep["critical"] = step.critical;
+            steps.append(jsonStep);
+        }
+        build["steps"] = steps;
+        QJsonArray headers;
+        foreach (const HeaderCost& cost, record->headers) {
+            QJsonObject jsonHeader;
+            jsonHeader["file"] = cost.fileName;
+            jsonHeader["time"] = cost.time;
+            jsonHeader["count"] = cost.count;
+            headers.append(jsonHeader);
+        }
+        build["headers"] = headers;
+        builds.append(build);
+    }
+    QJsonObject root;
+    root["builds"] = builds;
+    QFile file(mFileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+        return false;
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return true;
+}
+
+void BuildTimeHistory::add(const PBuildRecord &record)
+{
+    mRecords.append(record);
+    while (mRecords.count() > MaxBuildRecords)
+        mRecords.removeFirst();
+}
+
+const QList<PBuildRecord> &BuildTimeHistory::records() const
+{
+    return mRecords;
+}
+
+qint64 BuildTimeHistory::previousDuration(int index, const BuildStep &step) const
+{
+    for (int i=index-1;i>=0;i--) {
+        foreach (const BuildStep& oldStep, mRecords[i]->steps) {
+            if (oldStep.outputFile == step.outputFile)
+                return oldStep.duration();
+        }
+    }
+    return -1;
+}
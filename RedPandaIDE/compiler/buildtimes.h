@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BUILDTIMES_H
+#define BUILDTIMES_H
+
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <memory>
+
+#define BUILD_TIMES_EXT "buildtimes"
+
+/**
+ * @brief A compile or link command run by make.
+ *
+ * Times are in milliseconds from the start of the build.
+ */
+struct BuildStep {
+    QString outputFile;
+    QString sourceFile; // empty for the link step
+    bool link;
+    qint64 startTime;
+    qint64 endTime;
+    bool critical; // on the critical path of the build
+    qint64 duration() const { return endTime - startTime; }
+};
+
+/**
+ * @brief Time spent in a header, summed over all translation units including it
+ */
+struct HeaderCost {
+    QString fileName;
+    qint64 time = 0;
+    int count = 0;
+};
+
+struct BuildRecord {
+    QDateTime time;
+    qint64 wallTime;
+    QList<BuildStep> steps;
+    QList<HeaderCost> headers;
+};
+
+using PBuildRecord = std::shared_ptr<BuildRecord>;
+
+/**
+ * @brief Collects the build steps from the output of make.
+ *
+ * make echoes each command when it starts it, and the output file is written
+ * when the command finishes, so the file's modification time is the end time.
+ * This works with parallel builds and needs no change to the makefile.
+ * Only wall times are available this way.
+ */
+class BuildTimeRecorder
+{
+public:
+    BuildTimeRecorder(const QString& directory, bool readTimeTraces);
+    // the output may end in the middle of a line
+    void processOutput(const QString& output);
+    // nullptr if nothing is built
+    PBuildRecord finish();
+private:
+    void processLine(const QString& line);
+    void markCriticalPath(QList<BuildStep>& steps);
+    QList<HeaderCost> readTimeTraces(const QList<BuildStep>& steps);
+private:
+    QString mDirectory;
+    bool mReadTimeTraces;
+    QDateTime mStartTime;
+    QString mPendingLine;
+    QList<BuildStep> mSteps;
+};
+
+/**
+ * @brief Build records of a project, saved in a json file beside the project file.
+ *
+ * File names are saved relative to the project directory.
+ */
+class BuildTimeHistory
+{
+public:
+    explicit BuildTimeHistory(const QString& fileName);
+    void load();
+    bool save() const;
+    void add(const PBuildRecord& record);
+    const QList<PBuildRecord>& records() const;
+    // duration of the step with the same output in the build before records()[index], -1 if none
+    qint64 previousDuration(int index, const BuildStep& step) const;
+private:
+    QString mFileName;
+    QString mDirectory;
+    QList<PBuildRecord> mRecords;
+};
+
+#endif // BUILDTIMES_H
@@ -23,6 +23,7 @@
 
 #include <cmath>
 #include <QFileInfo>
+#include <QMutex>
 #include <QProcess>
 #include <QString>
 #include <QTextCodec>
@@ -33,6 +34,7 @@
 #include "../editorlist.h"
 #include "../parser/cppparser.h"
 #include "../autolinkmanager.h"
+#include "../startuptasks.h"
 #include "qt_utils/charsetinfo.h"
 #include "../project.h"
 
@@ -89,6 +91,7 @@ void Compiler::run()
             log(tr("- Output Size: %1").arg(locale.formattedDataSize(QFileInfo(mOutputFile).size())));
         }
         log(tr("- Compilation Time: %1 secs").arg(timer.elapsed() / 1000.0));
+        afterCompile();
     } catch (CompileError e) {
         emit compileErrorOccured(e.reason());
     }
@@ -239,6 +242,16 @@ bool Compiler::beforeRunExtraCommand(int /* idx */)
     return true;
 }
 
+void Compiler::processStdOutput(const QString & /* output */)
+{
+
+}
+
+void Compiler::afterCompile()
+{
+
+}
+
 void Compiler::processOutput(QString &line)
 {
     if (line == COMPILE_PROCESS_END) {
@@ -368,10 +381,7 @@ QStringList Compiler::getCharsetArgument(const QByteArray& encoding,FileType fil
             app->processEvents();
         }
         if (waitCount<=10) {
-            QSet<QString> parsedFiles;
-            forceExecUTF8 = parseForceUTF8ForAutolink(
-                        mFilename,
-                        parsedFiles);
+            forceExecUTF8 = parseForceUTF8ForAutolink(mFilename);
         }
     }
     if ((forceExecUTF8 || compilerSet()->autoAddCharsetParams()) && encoding != ENCODING_ASCII
@@ -560,8 +570,7 @@ QStringList Compiler::getLibraryArguments(FileType fileType)
             app->processEvents();
         }
         if (waitCount<=10) {
-            QSet<QString> parsedFiles;
-            result += parseFileIncludesForAutolink(mFilename, parsedFiles);
+            result += parseFileIncludesForAutolink(mFilename);
         }
     }
 
@@ -619,58 +628,80 @@ QStringList Compiler::getLibraryArguments(FileType fileType)
     return result;
 }
 
-QStringList Compiler::parseFileIncludesForAutolink(
-        const QString &filename,
-        QSet<QString>& parsedFiles)
+QStringList Compiler::parseFileIncludesForAutolink(const QString &filename)
 {
-    QStringList result;
-    if (parsedFiles.contains(filename))
-        return result;
-    parsedFiles.insert(filename);
-    PAutolink autolink = pAutolinkManager->getLink(filename);
-    if (autolink) {
-        result += parseArgumentsWithoutVariables(autolink->linkOption);
-    }
-    QStringList includedFiles = mParserForFile->getFileDirectIncludes(filename);
-//    log(QString("File %1 included:").arg(filename));
-//    for (int i=includedFiles.size()-1;i>=0;i--) {
-//        QString includeFilename = includedFiles[i];
-//        log(includeFilename);
-//    }
+    return findAutolinks(filename).linkOptions;
+}
 
-    for (int i=includedFiles.size()-1;i>=0;i--) {
-        QString includeFilename = includedFiles[i];
-        result += parseFileIncludesForAutolink(includeFilename, parsedFiles);
+bool Compiler::parseForceUTF8ForAutolink(const QString &filename)
+{
+    return findAutolinks(filename).forceExecUTF8;
+}
+
+Compiler::AutolinkResult Compiler::findAutolinks(const QString &filename)
+{
+    // Both the link options and the utf-8 flag come from the same include walk,
+    // so it's done once and reused until the includes or the autolinks change.
+    static QMutex cacheMutex;
+    static QHash<QString, AutolinkResult> cache;
+    // the autolinks are read in background at startup
+    StartupTasks::waitFor(STARTUP_TASK_AUTOLINKS);
+    int includeGraphVersion = mParserForFile->includeGraphVersion();
+    int autolinksVersion = pAutolinkManager->version();
+    {
+        QMutexLocker locker(&cacheMutex);
+        auto it = cache.constFind(filename);
+        if (it!=cache.constEnd()
+                && it->parserId == mParserForFile->parserId()
+                && it->includeGraphVersion == includeGraphVersion
+                && it->autolinksVersion == autolinksVersion)
+            return *it;
+    }
+    AutolinkResult result;
+    result.parserId = mParserForFile->parserId();
+    result.includeGraphVersion = includeGraphVersion;
+    result.autolinksVersion = autolinksVersion;
+    result.forceExecUTF8 = false;
+    bool parsing = mParserForFile->parsing();
+    QSet<QString> parsedFiles;
+    collectAutolinks(filename, parsedFiles, result);
+    // the includes can't be read while parsing, the result is not complete
+    if (parsing || mParserForFile->parsing())
+        return result;
+    {
+        QMutexLocker locker(&cacheMutex);
+        // drop the results that can't be used any more
+        if (cache.count() >= 256) {
+            for (auto it = cache.begin(); it != cache.end();) {
+                if (it->includeGraphVersion != includeGraphVersion
+                        || it->autolinksVersion != autolinksVersion)
+                    it = cache.erase(it);
+                else
+                    ++it;
+            }
+            if (cache.count() >= 256)
+                cache.clear();
+        }
+        cache.insert(filename, result);
     }
     return result;
 }
 
-bool Compiler::parseForceUTF8ForAutolink(const QString &filename, QSet<QString> &parsedFiles)
+void Compiler::collectAutolinks(const QString &filename, QSet<QString> &parsedFiles, AutolinkResult &result)
 {
-    bool result;
     if (parsedFiles.contains(filename))
-        return false;
+        return;
     parsedFiles.insert(filename);
     PAutolink autolink = pAutolinkManager->getLink(filename);
-    if (autolink && autolink->execUseUTF8) {
-        return true;
+    if (autolink) {
+        result.linkOptions += parseArgumentsWithoutVariables(autolink->linkOption);
+        if (autolink->execUseUTF8)
+            result.forceExecUTF8 = true;
     }
     QStringList includedFiles = mParserForFile->getFileDirectIncludes(filename);
-//    log(QString("File %1 included:").arg(filename));
-//    for (int i=includedFiles.size()-1;i>=0;i--) {
-//        QString includeFilename = includedFiles[i];
-//        log(includeFilename);
-//    }
-
     for (int i=includedFiles.size()-1;i>=0;i--) {
-        QString includeFilename = includedFiles[i];
-        result = parseForceUTF8ForAutolink(
-                    includeFilename,
-                    parsedFiles);
-        if (result)
-            return true;
+        collectAutolinks(includedFiles[i], parsedFiles, result);
     }
-    return false;
 }
 
 void Compiler::runCommand(const QString &cmd, const QStringList &arguments, const QString &workingDir, const QByteArray& inputText, const QString& outputFile)
@@ -722,10 +753,13 @@ void Compiler::runCommand(const QString &cmd, const QStringList &arguments, cons
         if (!outputFile.isEmpty()) {
             output.write(process.readAllStandardOutput());
         } else {
+            QString text;
             if (outputUTF8)
-                this->log(QString::fromUtf8(process.readAllStandardOutput()));
+                text = QString::fromUtf8(process.readAllStandardOutput());
             else
-                this->log(QString::fromLocal8Bit( process.readAllStandardOutput()));
+                text = QString::fromLocal8Bit( process.readAllStandardOutput());
+            this->log(text);
+            this->processStdOutput(text);
         }
     });
     process.connect(&process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),[this](){
@@ -70,6 +70,9 @@ protected:
     virtual QByteArray pipedText();
     virtual bool prepareForRebuild() = 0;
     virtual bool beforeRunExtraCommand(int idx);
+    // stdout of the commands, in the compiler thread
+    virtual void processStdOutput(const QString& output);
+    virtual void afterCompile();
     virtual QStringList getCharsetArgument(const QByteArray& encoding, FileType fileType, bool onlyCheckSyntax);
     virtual QStringList getCCompileArguments(bool checkSyntax);
     virtual QStringList getCppCompileArguments(bool checkSyntax);
@@ -78,11 +81,9 @@ protected:
     virtual QStringList getCppIncludeArguments();
     virtual QStringList getLibraryArguments(FileType fileType);
     virtual QStringList parseFileIncludesForAutolink(
-            const QString& filename,
-            QSet<QString>& parsedFiles);
+            const QString& filename);
     virtual bool parseForceUTF8ForAutolink(
-            const QString& filename,
-            QSet<QString>& parsedFiles);
+            const QString& filename);
     void log(const QString& msg);
     void error(const QString& msg);
     void runCommand(const QString& cmd, const QStringList& arguments, const QString& workingDir, const QByteArray& inputText=QByteArray(), const QString& outputFile=QString());
@@ -107,6 +108,18 @@ protected:
     PCppParser mParserForFile;
     bool mForceEnglishOutput;
 
+private:
+    struct AutolinkResult {
+        int parserId;
+        int includeGraphVersion;
+        int autolinksVersion;
+        QStringList linkOptions;
+        bool forceExecUTF8;
+    };
+    AutolinkResult findAutolinks(const QString& filename);
+    void collectAutolinks(const QString& filename,
+                          QSet<QString>& parsedFiles,
+                          AutolinkResult& result);
 private:
     bool mStop;
 };
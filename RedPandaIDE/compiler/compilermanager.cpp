@@ -23,6 +23,7 @@
 #endif
 #include "stdincompiler.h"
 #include "../mainwindow.h"
+#include "../editor.h"
 #include "executablerunner.h"
 #include "ojproblemcasesrunner.h"
 #include "utils.h"
@@ -35,6 +36,10 @@
 #ifdef Q_OS_MACOS
 #include <sys/posix_shm.h>
 #endif
+#ifndef Q_OS_WIN
+#include "ptyrunner.h"
+#include "../widgets/runconsole.h"
+#endif
 
 enum RunProgramFlag {
     RPF_PAUSE_CONSOLE =     0x0001,
@@ -83,6 +88,8 @@ bool CompilerManager::running()
 
 void CompilerManager::compile(const QString& filename, const QByteArray& encoding, bool rebuild, CppCompileType compileType)
 {
+    // the compiler reads the files saved in background
+    Editor::waitForBackgroundSaves();
     if (!pSettings->compilerSets().defaultSet()) {
         QMessageBox::critical(pMainWindow,
                               tr("No compiler set"),
@@ -119,6 +126,8 @@ void CompilerManager::compile(const QString& filename, const QByteArray& encodin
 
 void CompilerManager::compileProject(std::shared_ptr<Project> project, bool rebuild)
 {
+    // the compiler reads the files saved in background
+    Editor::waitForBackgroundSaves();
     if (!pSettings->compilerSets().defaultSet()) {
         QMessageBox::critical(pMainWindow,
                               tr("No compiler set"),
@@ -237,7 +246,8 @@ void CompilerManager::run(
         const QString &filename,
         const QString &arguments,
         const QString &workDir,
-        const QStringList& binDirs)
+        const QStringList& binDirs,
+        const QProcessEnvironment& extraEnvironment)
 {
     QMutexLocker locker(&mRunnerMutex);
     if (mRunner!=nullptr && !mRunner->pausing()) {
@@ -250,6 +260,12 @@ void CompilerManager::run(
         redirectInput =true;
         redirectInputFilename = pSettings->executor().inputFilename();
     }
+#ifndef Q_OS_WIN
+    if (pSettings->executor().useIntegratedConsole() && programHasConsole(filename)) {
+        doRunInIntegratedConsole(filename, arguments, workDir, binDirs, redirectInputFilename, extraEnvironment);
+        return;
+    }
+#endif
     ExecutableRunner * execRunner;
     if (programHasConsole(filename)) {
         int consoleFlag=0;
@@ -346,6 +362,7 @@ void CompilerManager::run(
     execRunner->addBinDirs(binDirs);
 
     execRunner->addBinDir(pSettings->dirs().appDir());
+    execRunner->setExtraEnvironment(extraEnvironment);
 
     mRunner = execRunner;
 
@@ -359,6 +376,33 @@ void CompilerManager::run(
 }
 
 
+#ifndef Q_OS_WIN
+void CompilerManager::doRunInIntegratedConsole(const QString &filename, const QString &arguments, const QString &workDir, const QStringList &binDirs, const QString &redirectInputFilename, const QProcessEnvironment& extraEnvironment)
+{
+    RunConsole* console = pMainWindow->runConsole();
+    console->clear();
+    //delete when thread finished
+    PtyRunner* ptyRunner = new PtyRunner(localizePath(filename), parseArgumentsWithoutVariables(arguments), workDir, console->screen());
+    ptyRunner->setRedirectInputFilename(redirectInputFilename);
+    ptyRunner->addBinDirs(binDirs);
+    ptyRunner->addBinDir(pSettings->dirs().appDir());
+    ptyRunner->setExtraEnvironment(extraEnvironment);
+    mRunner = ptyRunner;
+
+    connect(mRunner, &Runner::finished, this ,&CompilerManager::onRunnerTerminated);
+    connect(mRunner, &Runner::finished, mRunner ,&Runner::deleteLater);
+    connect(mRunner, &Runner::finished, pMainWindow ,&MainWindow::onRunFinished);
+    connect(mRunner, &Runner::runErrorOccurred, pMainWindow ,&MainWindow::onRunErrorOccured);
+    // input and resizing are handled in the GUI thread
+    connect(console, &RunConsole::inputReceived, ptyRunner, &PtyRunner::writeInput, Qt::DirectConnection);
+    connect(console, &RunConsole::sizeChanged, ptyRunner, &PtyRunner::setWindowSize, Qt::DirectConnection);
+    connect(mRunner, &Runner::finished, console, &RunConsole::stopRefreshing);
+    pMainWindow->showRunConsole();
+    console->startRefreshing();
+    mRunner->start();
+}
+#endif
+
 void CompilerManager::runProblem(const QString &filename, const QString &arguments, const QString &workDir, POJProblemCase problemCase,
                                  const POJProblem& problem
                                  )
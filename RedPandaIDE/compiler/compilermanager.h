@@ -19,6 +19,7 @@
 
 #include <QObject>
 #include <QMutex>
+#include <QProcessEnvironment>
 #include "qt_utils/utils.h"
 #include "../utils.h"
 #include "../common.h"
@@ -52,7 +53,8 @@ public:
             const QString& filename,
             const QString& arguments,
             const QString& workDir,
-            const QStringList& extraBinDir);
+            const QStringList& extraBinDir,
+            const QProcessEnvironment& extraEnvironment = QProcessEnvironment());
     void runProblem(
             const QString& filename, const QString& arguments, const QString& workDir, POJProblemCase problemCase,
             const POJProblem& problem
@@ -89,6 +91,11 @@ private slots:
     void onSyntaxCheckIssue(PCompileIssue issue);
 private:
     ProjectCompiler* createProjectCompiler(std::shared_ptr<Project> project);
+#ifndef Q_OS_WIN
+    void doRunInIntegratedConsole(const QString& filename, const QString& arguments, const QString& workDir,
+                                  const QStringList& binDirs, const QString& redirectInputFilename,
+                                  const QProcessEnvironment& extraEnvironment);
+#endif
 private:
     Compiler* mCompiler;
     int mCompileErrorCount;
@@ -122,6 +122,7 @@ void ExecutableRunner::run()
         path = pathAdded.join(PATH_SEPARATOR);
     }
     env.insert("PATH",path);
+    env.insert(mExtraEnvironment);
     mProcess->setProcessEnvironment(env);
     connect(
                 mProcess.get(), &QProcess::errorOccurred,
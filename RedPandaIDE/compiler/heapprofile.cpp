@@ -0,0 +1,440 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "heapprofile.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QProcess>
+#include <algorithm>
+#include <cstring>
+
+static const char* const SystemLibraries[] = {
+    "libredpanda-heapprof",
+    "libc.so",
+    "libc-",
+    "libstdc++",
+    "libgcc_s",
+    "libpthread",
+    "ld-linux"
+};
+
+static bool isSystemLibrary(const QString& fileName)
+{
+    QString name = QFileInfo(fileName).fileName();
+    for (const char* prefix : SystemLibraries) {
+        if (name.startsWith(prefix))
+            return true;
+    }
+    return false;
+}
+
+// position independent executables and shared libraries are
+// symbolized by the offset from the load address
+static bool isPositionIndependent(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return true;
+    QByteArray header = file.read(18);
+    if (header.length() < 18 || !header.startsWith("\x7f" "ELF"))
+        return true;
+    // e_type, ET_EXEC is 2
+    int type = header[5] == 2 ? quint8(header[17]) : quint8(header[16]);
+    return type != 2;
+}
+
+class LogReader {
+public:
+    explicit LogReader(const QByteArray& data):mData{data},mPos{0} {}
+    bool atEnd() const { return mPos >= mData.length(); }
+    template<typename T>
+    bool read(T& value) {
+        if (mPos + int(sizeof(T)) > mData.length())
+            return false;
+        memcpy(&value, mData.constData() + mPos, sizeof(T));
+        mPos += sizeof(T);
+        return true;
+    }
+    bool read(QByteArray& value, int length) {
+        if (length < 0 || mPos + length > mData.length())
+            return false;
+        value = mData.mid(mPos, length);
+        mPos += length;
+        return true;
+    }
+private:
+    const QByteArray& mData;
+    int mPos;
+};
+
+HeapProfile::HeapProfile():
+    mFinished{false},
+    mSampleRate{0},
+    mPeakHeap{0},
+    mAllocationCount{0},
+    mAllocatedBytes{0},
+    mHeapInUse{0}
+{
+
+}
+
+bool HeapProfile::load(const QString &fileName)
+{
+    mFinished = false;
+    mModules.clear();
+    mFrames.clear();
+    mSamples.clear();
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        mErrorMessage = QObject::tr("Can't open file '%1' for read.").arg(fileName);
+        return false;
+    }
+    QByteArray data = file.readAll();
+    LogReader reader(data);
+    QByteArray magic;
+    if (!reader.read(magic, 8) || magic != "RPHEAP01" || !reader.read(mSampleRate)) {
+        mErrorMessage = QObject::tr("'%1' is not a heap profile.").arg(fileName);
+        return false;
+    }
+    QHash<quint64, int> frameIndexes;
+    QHash<quint64, int> liveSamples;
+    QByteArray maps;
+    // the last record may be cut if the program crashed
+    while (!reader.atEnd()) {
+        char type;
+        if (!reader.read(type))
+            break;
+        if (type == 'A') {
+            HeapProfileSample sample;
+            quint16 depth;
+            if (!reader.read(sample.address) || !reader.read(sample.size) || !reader.read(depth))
+                break;
+            sample.frames.reserve(depth);
+            sample.freed = false;
+            bool ok = true;
+            for (int i=0;i<depth && ok;i++) {
+                quint64 address;
+                ok = reader.read(address);
+                int index = frameIndexes.value(address, -1);
+                if (index < 0) {
+                    index = mFrames.count();
+                    frameIndexes.insert(address, index);
+                    mFrames.append(HeapProfileFrame{address, -1,
+                                                    QString("0x%1").arg(address, 0, 16),
+                                                    QString(), 0});
+                }
+                sample.frames.append(index);
+            }
+            if (!ok)
+                break;
+            liveSamples.insert(sample.address, mSamples.count());
+            mSamples.append(sample);
+        } else if (type == 'F') {
+            quint64 address;
+            if (!reader.read(address))
+                break;
+            int index = liveSamples.value(address, -1);
+            if (index >= 0) {
+                mSamples[index].freed = true;
+                liveSamples.remove(address);
+            }
+        } else if (type == 'M') {
+            quint32 length;
+            if (!reader.read(length) || !reader.read(maps, length))
+                break;
+        } else if (type == 'E') {
+            if (!reader.read(mPeakHeap) || !reader.read(mAllocationCount)
+                    || !reader.read(mAllocatedBytes) || !reader.read(mHeapInUse))
+                break;
+            mFinished = true;
+        } else
+            break;
+    }
+    parseMaps(maps);
+    for (HeapProfileFrame& frame : mFrames)
+        frame.module = findModule(frame.address);
+    trimStacks();
+    return true;
+}
+
+void HeapProfile::symbolize(const QString &addr2line)
+{
+    QMap<int, QVector<int>> moduleFrames;
+    for (int i=0;i<mFrames.count();i++) {
+        int module = mFrames[i].module;
+        if (module < 0)
+            continue;
+        if (mModules[module].system) {
+            mFrames[i].function = QString("%1+0x%2")
+                    .arg(QFileInfo(mModules[module].fileName).fileName())
+                    .arg(mFrames[i].address - mModules[module].start + mModules[module].offset, 0, 16);
+            continue;
+        }
+        moduleFrames[module].append(i);
+    }
+    for (auto it = moduleFrames.begin(); it != moduleFrames.end(); ++it) {
+        const HeapProfileModule& module = mModules[it.key()];
+        const QVector<int>& frames = it.value();
+        bool relative = isPositionIndependent(module.fileName);
+        QByteArray input;
+        foreach (int index, frames) {
+            // return addresses point after the call
+            quint64 address = mFrames[index].address - 1;
+            if (relative)
+                address = address - module.start + module.offset;
+            input += "0x" + QByteArray::number(address, 16) + "\n";
+        }
+        QProcess process;
+        process.start(addr2line, {"-f", "-C", "-e", module.fileName});
+        if (!process.waitForStarted())
+            return;
+        process.write(input);
+        process.closeWriteChannel();
+        process.waitForFinished(60000);
+        QList<QByteArray> lines = process.readAllStandardOutput().split('\n');
+        for (int i=0;i<frames.count() && 2*i+1<lines.count();i++) {
+            HeapProfileFrame& frame = mFrames[frames[i]];
+            QString function = QString::fromLocal8Bit(lines[2*i]).trimmed();
+            QString location = QString::fromLocal8Bit(lines[2*i+1]).trimmed();
+            if (function != "??")
+                frame.function = function;
+            int pos = location.indexOf(" (discriminator");
+            if (pos >= 0)
+                location.truncate(pos);
+            pos = location.lastIndexOf(':');
+            if (pos > 0 && !location.startsWith("??")) {
+                frame.fileName = location.left(pos);
+                frame.line = location.mid(pos+1).toInt();
+            }
+        }
+    }
+    // _start is known now
+    trimStacks();
+}
+
+const QString &HeapProfile::errorMessage() const
+{
+    return mErrorMessage;
+}
+
+bool HeapProfile::finished() const
+{
+    return mFinished;
+}
+
+quint64 HeapProfile::sampleRate() const
+{
+    return mSampleRate;
+}
+
+quint64 HeapProfile::peakHeap() const
+{
+    return mPeakHeap;
+}
+
+quint64 HeapProfile::allocationCount() const
+{
+    return mAllocationCount;
+}
+
+quint64 HeapProfile::allocatedBytes() const
+{
+    return mAllocatedBytes;
+}
+
+quint64 HeapProfile::heapInUse() const
+{
+    return mHeapInUse;
+}
+
+const QList<HeapProfileModule> &HeapProfile::modules() const
+{
+    return mModules;
+}
+
+const QVector<HeapProfileFrame> &HeapProfile::frames() const
+{
+    return mFrames;
+}
+
+const QList<HeapProfileSample> &HeapProfile::samples() const
+{
+    return mSamples;
+}
+
+quint64 HeapProfile::sampleBytes(const HeapProfileSample &sample) const
+{
+    return std::max(sample.size, mSampleRate);
+}
+
+QList<HeapProfileSite> HeapProfile::hotSpots() const
+{
+    QHash<int, HeapProfileSite> sites;
+    foreach (const HeapProfileSample& sample, mSamples) {
+        int frame = siteFrame(sample.frames);
+        HeapProfileSite& site = sites[frame];
+        if (site.count == 0) {
+            site.frame = frame;
+            site.stack = sample.frames;
+        }
+        site.bytes += sampleBytes(sample);
+        site.count++;
+    }
+    QList<HeapProfileSite> result = sites.values();
+    std::sort(result.begin(), result.end(), [](const HeapProfileSite& site1, const HeapProfileSite& site2) {
+        return site1.bytes > site2.bytes;
+    });
+    return result;
+}
+
+QList<HeapProfileSite> HeapProfile::leaks() const
+{
+    QMap<QVector<int>, HeapProfileSite> sites;
+    foreach (const HeapProfileSample& sample, mSamples) {
+        if (sample.freed)
+            continue;
+        HeapProfileSite& site = sites[sample.frames];
+        if (site.count == 0) {
+            site.frame = siteFrame(sample.frames);
+            site.stack = sample.frames;
+        }
+        site.bytes += sampleBytes(sample);
+        site.count++;
+    }
+    QList<HeapProfileSite> result = sites.values();
+    std::sort(result.begin(), result.end(), [](const HeapProfileSite& site1, const HeapProfileSite& site2) {
+        return site1.bytes > site2.bytes;
+    });
+    return result;
+}
+
+static void sortFlameNode(const PHeapFlameNode& node)
+{
+    std::sort(node->children.begin(), node->children.end(),
+              [](const PHeapFlameNode& node1, const PHeapFlameNode& node2) {
+        return node1->bytes > node2->bytes;
+    });
+    foreach (const PHeapFlameNode& child, node->children)
+        sortFlameNode(child);
+}
+
+PHeapFlameNode HeapProfile::flameGraph() const
+{
+    PHeapFlameNode root = std::make_shared<HeapFlameNode>();
+    root->frame = -1;
+    foreach (const HeapProfileSample& sample, mSamples) {
+        quint64 bytes = sampleBytes(sample);
+        HeapFlameNode* node = root.get();
+        node->bytes += bytes;
+        node->count++;
+        for (int i=sample.frames.count()-1;i>=0;i--) {
+            int frame = sample.frames[i];
+            PHeapFlameNode child;
+            foreach (const PHeapFlameNode& n, node->children) {
+                if (n->frame == frame) {
+                    child = n;
+                    break;
+                }
+            }
+            if (!child) {
+                child = std::make_shared<HeapFlameNode>();
+                child->frame = frame;
+                node->children.append(child);
+            }
+            child->bytes += bytes;
+            child->count++;
+            node = child.get();
+        }
+    }
+    sortFlameNode(root);
+    return root;
+}
+
+int HeapProfile::findModule(quint64 address) const
+{
+    auto it = std::upper_bound(mModules.begin(), mModules.end(), address,
+                               [](quint64 address, const HeapProfileModule& module) {
+        return address < module.start;
+    });
+    if (it == mModules.begin())
+        return -1;
+    --it;
+    if (address >= it->end)
+        return -1;
+    return it - mModules.begin();
+}
+
+int HeapProfile::siteFrame(const QVector<int> &stack) const
+{
+    // skip the inlined library code, such as std::vector
+    foreach (int index, stack) {
+        const HeapProfileFrame& frame = mFrames[index];
+        if (!frame.fileName.isEmpty() && !frame.fileName.startsWith("/usr/"))
+            return index;
+    }
+    return stack.isEmpty() ? -1 : stack.first();
+}
+
+void HeapProfile::parseMaps(const QByteArray &maps)
+{
+    // start-end perms offset dev inode path
+    foreach (const QByteArray& line, maps.split('\n')) {
+        QList<QByteArray> fields = line.simplified().split(' ');
+        if (fields.count() < 6 || !fields[5].startsWith('/'))
+            continue;
+        int pos = fields[0].indexOf('-');
+        if (pos < 0)
+            continue;
+        HeapProfileModule module;
+        module.start = fields[0].left(pos).toULongLong(nullptr, 16);
+        module.end = fields[0].mid(pos+1).toULongLong(nullptr, 16);
+        module.offset = fields[2].toULongLong(nullptr, 16);
+        // paths may contain spaces
+        module.fileName = QString::fromLocal8Bit(fields.mid(5).join(' '));
+        module.system = isSystemLibrary(module.fileName);
+        mModules.append(module);
+    }
+    std::sort(mModules.begin(), mModules.end(), [](const HeapProfileModule& module1, const HeapProfileModule& module2) {
+        return module1.start < module2.start;
+    });
+}
+
+void HeapProfile::trimStacks()
+{
+    auto isSystemFrame = [this](int index) {
+        int module = mFrames[index].module;
+        return (module >= 0 && mModules[module].system)
+                || mFrames[index].function == "_start";
+    };
+    for (HeapProfileSample& sample : mSamples) {
+        // frames of the profiler and of operator new
+        int first = 0;
+        while (first < sample.frames.count() && isSystemFrame(sample.frames[first]))
+            first++;
+        // _start and __libc_start_main
+        int last = sample.frames.count() - 1;
+        while (last >= first && isSystemFrame(sample.frames[last]))
+            last--;
+        if (first <= last)
+            sample.frames = sample.frames.mid(first, last - first + 1);
+        else
+            sample.frames.clear();
+    }
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef HEAPPROFILE_H
+#define HEAPPROFILE_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <memory>
+
+#define HEAP_PROFILE_EXT "heapprof"
+#define HEAP_PROFILER_LIBRARY "libredpanda-heapprof.so"
+
+struct HeapProfileModule {
+    quint64 start;
+    quint64 end;
+    quint64 offset;
+    QString fileName;
+    bool system; // the profiler or a runtime library
+};
+
+struct HeapProfileFrame {
+    quint64 address;
+    int module; // -1 if not in a known module
+    QString function;
+    QString fileName;
+    int line;
+};
+
+/**
+ * @brief A sampled allocation. Frames are indexes of HeapProfile::frames(),
+ * from the allocation site to the outermost caller.
+ */
+struct HeapProfileSample {
+    quint64 address;
+    quint64 size;
+    QVector<int> frames;
+    bool freed;
+};
+
+/**
+ * @brief Sampled allocations summed by their allocation site or stack.
+ *
+ * Bytes are estimated: each sample stands for the sample rate bytes, or its
+ * own size if it's larger.
+ */
+struct HeapProfileSite {
+    int frame;
+    QVector<int> stack;
+    quint64 bytes = 0;
+    int count = 0;
+};
+
+struct HeapFlameNode;
+using PHeapFlameNode = std::shared_ptr<HeapFlameNode>;
+struct HeapFlameNode {
+    int frame; // -1 for the root
+    quint64 bytes = 0;
+    int count = 0;
+    QList<PHeapFlameNode> children;
+};
+
+/**
+ * @brief Log of the heap profiler (tools/heapprofiler) loaded into the program.
+ *
+ * Addresses are symbolized with addr2line, using the module maps written by the
+ * profiler at exit.
+ */
+class HeapProfile
+{
+public:
+    HeapProfile();
+    bool load(const QString& fileName);
+    void symbolize(const QString& addr2line);
+
+    const QString& errorMessage() const;
+    // false if the program didn't exit normally, and the summary is not written
+    bool finished() const;
+    quint64 sampleRate() const;
+    quint64 peakHeap() const;
+    quint64 allocationCount() const;
+    quint64 allocatedBytes() const;
+    quint64 heapInUse() const;
+
+    const QList<HeapProfileModule>& modules() const;
+    const QVector<HeapProfileFrame>& frames() const;
+    const QList<HeapProfileSample>& samples() const;
+
+    quint64 sampleBytes(const HeapProfileSample& sample) const;
+    // grouped by the first frame in the user's code
+    QList<HeapProfileSite> hotSpots() const;
+    // blocks never freed, grouped by the stack
+    QList<HeapProfileSite> leaks() const;
+    // the outermost callers are the children of the root
+    PHeapFlameNode flameGraph() const;
+private:
+    int findModule(quint64 address) const;
+    int siteFrame(const QVector<int>& stack) const;
+    void parseMaps(const QByteArray& maps);
+    void trimStacks();
+private:
+    QString mErrorMessage;
+    bool mFinished;
+    quint64 mSampleRate;
+    quint64 mPeakHeap;
+    quint64 mAllocationCount;
+    quint64 mAllocatedBytes;
+    quint64 mHeapInUse;
+    QList<HeapProfileModule> mModules;
+    QVector<HeapProfileFrame> mFrames;
+    QList<HeapProfileSample> mSamples;
+};
+
+#endif // HEAPPROFILE_H
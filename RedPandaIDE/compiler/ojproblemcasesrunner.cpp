@@ -19,11 +19,14 @@
 #include "../settings.h"
 #include "../systemconsts.h"
 #include <QElapsedTimer>
+#include <QFile>
 #include <QProcess>
+#include <QTextCodec>
 #ifdef Q_OS_WINDOWS
 #include <psapi.h>
 #endif
 
+static const int InputChunkSize = 4*1024*1024;
 
 OJProblemCasesRunner::OJProblemCasesRunner(const QString& filename, const QStringList& arguments, const QString& workDir,
                                            const QVector<POJProblemCase>& problemCases, QObject *parent):
@@ -103,17 +106,31 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
         hProcess = OpenProcess(PROCESS_ALL_ACCESS,FALSE,process.processId());
     }
 #endif
+    // input in files is fed to the program chunk by chunk, instead of reading it all in memory
+    QFile inputFile;
     if (process.state()==QProcess::Running) {
         if (fileExists(problemCase->inputFileName))
-            process.write(readFileToByteArray(problemCase->inputFileName));
+            inputFile.setFileName(problemCase->inputFileName);
+        else if (!problemCase->inputDataFile().isEmpty()
+                 && QTextCodec::codecForLocale()->name()=="UTF-8")
+            inputFile.setFileName(problemCase->inputDataFile());
+        if (!inputFile.fileName().isEmpty() && inputFile.open(QFile::ReadOnly))
+            process.write(inputFile.read(InputChunkSize));
         else
-            process.write(problemCase->input.toLocal8Bit());
+            process.write(problemCase->input().toLocal8Bit());
         process.waitForFinished(0);
     }
 
     elapsedTimer.start();
     while (true) {
-        if (process.bytesToWrite()==0 && !writeChannelClosed) {
+        if (inputFile.isOpen() && !writeChannelClosed
+                && process.bytesToWrite()<InputChunkSize) {
+            if (inputFile.atEnd())
+                inputFile.close();
+            else
+                process.write(inputFile.read(InputChunkSize));
+        }
+        if (process.bytesToWrite()==0 && !writeChannelClosed && !inputFile.isOpen()) {
             writeChannelClosed = true;
             process.closeWriteChannel();
         }
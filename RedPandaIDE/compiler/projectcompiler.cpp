@@ -26,6 +26,9 @@
 #include "utils/parsearg.h"
 
 #include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include <algorithm>
 
 ProjectCompiler::ProjectCompiler(std::shared_ptr<Project> project):
     Compiler("",false),
@@ -107,6 +110,7 @@ void ProjectCompiler::newMakeFile(QFile& file)
     if (!mProject->options().exeOutput.isEmpty()) {
         QDir(mProject->directory()).mkpath(mProject->options().exeOutput);
     }
+    createUnityBatches();
     // Write more information to the log file than before
     log(tr("Building makefile..."));
     log("--------");
@@ -168,6 +172,9 @@ void ProjectCompiler::writeMakeDefines(QFile &file)
         QString RelativeName = extractRelativePath(mProject->directory(), unit->fileName());
         FileType fileType = getFileType(RelativeName);
 
+        if (mUnityBatchOfUnit.contains(unit->fileName()))
+            continue;
+
         if (fileType == FileType::CSource || fileType == FileType::CppSource
                 || fileType==FileType::GAS) {
             if (!mProject->options().objectOutput.isEmpty()) {
@@ -188,6 +195,14 @@ void ProjectCompiler::writeMakeDefines(QFile &file)
             }
         }
     }
+    foreach (const UnityBatch& batch, mUnityBatches) {
+        QString relativeObjFile = extractRelativePath(mProject->directory(), changeFileExt(batch.fileName, OBJ_EXT));
+        Objects << relativeObjFile;
+        cleanObjects << localizePath(relativeObjFile);
+        LinkObjects << relativeObjFile;
+        // the batch sources are generated, so they are cleaned too
+        cleanObjects << localizePath(extractRelativePath(mProject->directory(), batch.fileName));
+    }
 
     // Get windres file
     QString objResFile;
@@ -229,6 +244,11 @@ void ProjectCompiler::writeMakeDefines(QFile &file)
         cCompileArguments << "-D__DEBUG__";
         cxxCompileArguments << "-D__DEBUG__";
     }
+    if (mProject->options().traceCompileTime
+            && compilerSet()->compilerType() == CompilerType::Clang) {
+        cCompileArguments << "-ftime-trace";
+        cxxCompileArguments << "-ftime-trace";
+    }
     QStringList libraryArguments = getLibraryArguments(FileType::Project);
     QStringList cIncludeArguments = getCIncludeArguments();
     QStringList cxxIncludeArguments = getCppIncludeArguments();
@@ -347,7 +367,6 @@ void ProjectCompiler::writeMakeClean(QFile &file)
 
 void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
 {
-    PCppParser parser = mProject->cppParser();
     QString precompileStr;
 
     QList<PProjectUnit> projectUnits=mProject->unitList();
@@ -359,36 +378,16 @@ void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
         if (fileType!=FileType::CSource && fileType!=FileType::CppSource
                 && fileType!=FileType::GAS)
             continue;
+        // compiled in a unity batch
+        if (mUnityBatchOfUnit.contains(unit->fileName()))
+            continue;
 
         QString shortFileName = extractRelativePath(mProject->makeFileName(),unit->fileName());
 
         writeln(file);
-        QString objStr = escapeFilenameForMakefilePrerequisite(shortFileName);
-        // if we have scanned it, use scanned info
-        if (parser && parser->fileScanned(unit->fileName())) {
-            QSet<QString> fileIncludes = parser->getIncludedFiles(unit->fileName());
-            foreach(const PProjectUnit &unit2, projectUnits) {
-                if (unit2==unit)
-                    continue;
-                if (fileIncludes.contains(unit2->fileName())) {
-                    if (mProject->options().usePrecompiledHeader &&
-                           unit2->fileName() == mProject->options().precompiledHeader)
-                        precompileStr = " $(PCH) ";
-                    else {
-                        QString prereq = extractRelativePath(mProject->makeFileName(), unit2->fileName());
-                        objStr = objStr + ' ' + escapeFilenameForMakefilePrerequisite(prereq);
-                    }
-                }
-            }
-        } else {
-            foreach(const PProjectUnit &unit2, projectUnits) {
-                FileType fileType = getFileType(unit2->fileName());
-                if (fileType == FileType::CHeader || fileType==FileType::CppHeader) {
-                    QString prereq = extractRelativePath(mProject->makeFileName(), unit2->fileName());
-                    objStr = objStr + ' ' + escapeFilenameForMakefilePrerequisite(prereq);
-                }
-            }
-        }
+        QStringList prereqs{escapeFilenameForMakefilePrerequisite(shortFileName)};
+        prereqs.append(unitPrerequisites(unit, projectUnits, precompileStr));
+        QString objStr = prereqs.join(' ');
         QString objFileNameTarget;
         QString objFileNameCommand;
         if (!mProject->options().objectOutput.isEmpty()) {
@@ -414,57 +413,7 @@ void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
             writeln(file, '\t' + BuildCmd);
             // Or roll our own
         } else {
-            QString encodingStr;
-            if (compilerSet()->compilerType() != CompilerType::Clang && mProject->options().addCharset) {
-                QByteArray defaultSystemEncoding=pCharsetInfoManager->getDefaultSystemEncoding();
-                QByteArray encoding = mProject->options().execEncoding;
-                QByteArray targetEncoding;
-                QByteArray sourceEncoding;
-                if ( encoding == ENCODING_SYSTEM_DEFAULT || encoding.isEmpty()) {
-                    targetEncoding = defaultSystemEncoding;
-                } else if (encoding == ENCODING_UTF8_BOM) {
-                    targetEncoding = "UTF-8";
-                } else if (encoding == ENCODING_UTF16_BOM) {
-                    targetEncoding = "UTF-16";
-                } else if (encoding == ENCODING_UTF32_BOM) {
-                    targetEncoding = "UTF-32";
-                } else {
-                    targetEncoding = encoding;
-                }
-
-                if (unit->realEncoding().isEmpty()) {
-                    if (unit->encoding() == ENCODING_AUTO_DETECT) {
-                        Editor* editor = mProject->unitEditor(unit);
-                        if (editor && editor->fileEncoding()!=ENCODING_ASCII
-                                && editor->fileEncoding()!=targetEncoding) {
-                            sourceEncoding = editor->fileEncoding();
-                        } else {
-                            sourceEncoding = targetEncoding;
-                        }
-                    } else if (unit->encoding()==ENCODING_PROJECT) {
-                        sourceEncoding=mProject->options().encoding;
-                    } else if (unit->encoding()==ENCODING_SYSTEM_DEFAULT) {
-                        sourceEncoding = defaultSystemEncoding;
-                    } else if (unit->encoding()!=ENCODING_ASCII && !unit->encoding().isEmpty()) {
-                        sourceEncoding = unit->encoding();
-                    } else {
-                        sourceEncoding = targetEncoding;
-                    }
-                } else if (unit->realEncoding()==ENCODING_ASCII) {
-                    sourceEncoding = targetEncoding;
-                } else {
-                    sourceEncoding = unit->realEncoding();
-                }
-                if (sourceEncoding==ENCODING_SYSTEM_DEFAULT)
-                    sourceEncoding = defaultSystemEncoding;
-
-                if (sourceEncoding!=targetEncoding) {
-                    encodingStr = QString(" -finput-charset=%1 -fexec-charset=%2")
-                            .arg(QString(sourceEncoding),
-                                 QString(targetEncoding));
-                }
-            }
-
+            QString encodingStr = unitEncodingArguments(unit);
             if (fileType==FileType::CSource || fileType==FileType::CppSource) {
                 if (unit->compileCpp())
                     writeln(file, "\t$(CXX) -c " + escapeArgumentForMakefileRecipe(shortFileName, false) + " -o " + objFileNameCommand + " $(CXXFLAGS) " + encodingStr);
@@ -476,6 +425,24 @@ void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
         }
     }
 
+    foreach (const UnityBatch& batch, mUnityBatches) {
+        QString batchFile = extractRelativePath(mProject->makeFileName(), batch.fileName);
+        QString objectFile = extractRelativePath(mProject->makeFileName(), changeFileExt(batch.fileName, OBJ_EXT));
+        QStringList prereqs{escapeFilenameForMakefilePrerequisite(batchFile)};
+        foreach (const PProjectUnit& unit, batch.units) {
+            QString shortFileName = extractRelativePath(mProject->makeFileName(), unit->fileName());
+            prereqs.append(escapeFilenameForMakefilePrerequisite(shortFileName));
+            prereqs.append(unitPrerequisites(unit, projectUnits, precompileStr));
+        }
+        prereqs.removeDuplicates();
+        writeln(file);
+        writeln(file, escapeFilenameForMakefileTarget(objectFile) + ": " + prereqs.join(' ') + precompileStr);
+        writeln(file, QString("\t%1 -c ").arg(batch.cpp ? "$(CXX)" : "$(CC)")
+                + escapeArgumentForMakefileRecipe(batchFile, false)
+                + " -o " + escapeArgumentForMakefileRecipe(objectFile, false)
+                + (batch.cpp ? " $(CXXFLAGS) " : " $(CFLAGS) ") + batch.encodingArguments);
+    }
+
 #ifdef Q_OS_WIN
     if (!mProject->options().privateResource.isEmpty()) {
         // Concatenate all resource include directories
@@ -527,6 +494,206 @@ void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
 #endif
 }
 
+void ProjectCompiler::createUnityBatches()
+{
+    mUnityBatches.clear();
+    mUnityBatchOfUnit.clear();
+    if (!mProject->options().unityBuild)
+        return;
+    PCppParser parser = mProject->cppParser();
+
+    // units sharing the language and the charset options can be compiled together
+    QMap<QString, QList<PProjectUnit>> groups;
+    QHash<QString, QString> includeSignatures;
+    QHash<QString, qint64> fileSizes;
+    int unitCount = 0;
+    foreach(const PProjectUnit &unit, mProject->unitList()) {
+        if (!unit->compile() || !unit->link() || !unit->unityBuild())
+            continue;
+        if (unit->overrideBuildCmd() && !unit->buildCmd().isEmpty())
+            continue;
+        FileType fileType = getFileType(unit->fileName());
+        if (fileType!=FileType::CSource && fileType!=FileType::CppSource)
+            continue;
+        QString encodingArguments = unitEncodingArguments(unit);
+        QString key = QString("%1 %2").arg(unit->compileCpp()?"cpp":"c", encodingArguments);
+        groups[key].append(unit);
+        unitCount++;
+        // units including the same headers are put next to each other
+        QStringList includes;
+        if (parser && parser->fileScanned(unit->fileName())) {
+            foreach (const QString& fileName, parser->getIncludedFiles(unit->fileName())) {
+                if (fileName != unit->fileName() && mProject->findUnit(fileName))
+                    includes.append(fileName);
+            }
+            includes.sort();
+        }
+        includeSignatures.insert(unit->fileName(), includes.join('\n'));
+        fileSizes.insert(unit->fileName(), std::max<qint64>(1, QFileInfo(unit->fileName()).size()));
+    }
+    if (unitCount < 2)
+        return;
+
+    int batchCount = mProject->options().unityBuildBatches;
+    if (batchCount <= 0) {
+        if (!mProject->options().allowParallelBuilding)
+            batchCount = 1;
+        else if (mProject->options().parellelBuildingJobs > 0)
+            batchCount = mProject->options().parellelBuildingJobs;
+        else
+            batchCount = QThread::idealThreadCount();
+    }
+    batchCount = std::max(1, std::min(batchCount, unitCount / 2));
+
+    QString batchDir = mProject->options().objectOutput.isEmpty() ?
+                mProject->directory()
+              : generateAbsolutePath(mProject->directory(), mProject->options().objectOutput);
+    for (auto it = groups.begin(); it != groups.end(); ++it) {
+        QList<PProjectUnit>& units = it.value();
+        std::sort(units.begin(), units.end(),
+                  [&includeSignatures](const PProjectUnit& unit1, const PProjectUnit& unit2) {
+            QString signature1 = includeSignatures.value(unit1->fileName());
+            QString signature2 = includeSignatures.value(unit2->fileName());
+            if (signature1 != signature2)
+                return signature1 < signature2;
+            return unit1->fileName() < unit2->fileName();
+        });
+        qint64 totalSize = 0;
+        foreach (const PProjectUnit& unit, units)
+            totalSize += fileSizes.value(unit->fileName());
+        // the group gets its share of batches, split by the source sizes
+        int groupBatchCount = std::max(1, int((batchCount * units.count() + unitCount - 1) / unitCount));
+        QList<QList<PProjectUnit>> chunks;
+        QList<PProjectUnit> chunk;
+        qint64 size = 0;
+        foreach (const PProjectUnit& unit, units) {
+            chunk.append(unit);
+            size += fileSizes.value(unit->fileName());
+            if (size * groupBatchCount >= totalSize * (chunks.count() + 1)) {
+                chunks.append(chunk);
+                chunk.clear();
+            }
+        }
+        if (!chunk.isEmpty())
+            chunks.append(chunk);
+        bool cpp = units.front()->compileCpp();
+        foreach (const QList<PProjectUnit>& batchUnits, chunks) {
+            // a single unit is compiled as usual
+            if (batchUnits.count() < 2)
+                continue;
+            UnityBatch batch;
+            batch.fileName = includeTrailingPathDelimiter(batchDir)
+                    + QString("unity_build_%1.%2").arg(mUnityBatches.count()).arg(cpp?"cpp":"c");
+            batch.units = batchUnits;
+            batch.cpp = cpp;
+            batch.encodingArguments = unitEncodingArguments(batchUnits.front());
+            foreach (const PProjectUnit& unit, batchUnits)
+                mUnityBatchOfUnit.insert(unit->fileName(), mUnityBatches.count());
+            mUnityBatches.append(batch);
+        }
+    }
+
+    foreach (const UnityBatch& batch, mUnityBatches) {
+        QStringList lines;
+        lines.append("/* Generated by Red Panda C++, do not edit. */");
+        foreach (const PProjectUnit& unit, batch.units)
+            lines.append(QString("#include \"%1\"").arg(extractRelativePath(batch.fileName, unit->fileName())));
+        // keep the timestamp if nothing is changed, or the batch is always rebuilt
+        if (fileExists(batch.fileName) && readFileToLines(batch.fileName) == lines)
+            continue;
+        if (!stringsToFile(lines, batch.fileName))
+            throw CompileError(tr("Can't open '%1' for write!").arg(batch.fileName));
+    }
+    log(tr("- Unity Build: %1 units in %2 batch files").arg(mUnityBatchOfUnit.count()).arg(mUnityBatches.count()));
+}
+
+QStringList ProjectCompiler::unitPrerequisites(const PProjectUnit &unit, const QList<PProjectUnit> &projectUnits, QString &precompileStr)
+{
+    QStringList prereqs;
+    PCppParser parser = mProject->cppParser();
+    // if we have scanned it, use scanned info
+    if (parser && parser->fileScanned(unit->fileName())) {
+        QSet<QString> fileIncludes = parser->getIncludedFiles(unit->fileName());
+        foreach(const PProjectUnit &unit2, projectUnits) {
+            if (unit2==unit)
+                continue;
+            if (fileIncludes.contains(unit2->fileName())) {
+                if (mProject->options().usePrecompiledHeader &&
+                       unit2->fileName() == mProject->options().precompiledHeader)
+                    precompileStr = " $(PCH) ";
+                else {
+                    QString prereq = extractRelativePath(mProject->makeFileName(), unit2->fileName());
+                    prereqs.append(escapeFilenameForMakefilePrerequisite(prereq));
+                }
+            }
+        }
+    } else {
+        foreach(const PProjectUnit &unit2, projectUnits) {
+            FileType fileType = getFileType(unit2->fileName());
+            if (fileType == FileType::CHeader || fileType==FileType::CppHeader) {
+                QString prereq = extractRelativePath(mProject->makeFileName(), unit2->fileName());
+                prereqs.append(escapeFilenameForMakefilePrerequisite(prereq));
+            }
+        }
+    }
+    return prereqs;
+}
+
+QString ProjectCompiler::unitEncodingArguments(const PProjectUnit &unit)
+{
+    QString encodingStr;
+    if (compilerSet()->compilerType() != CompilerType::Clang && mProject->options().addCharset) {
+        QByteArray defaultSystemEncoding=pCharsetInfoManager->getDefaultSystemEncoding();
+        QByteArray encoding = mProject->options().execEncoding;
+        QByteArray targetEncoding;
+        QByteArray sourceEncoding;
+        if ( encoding == ENCODING_SYSTEM_DEFAULT || encoding.isEmpty()) {
+            targetEncoding = defaultSystemEncoding;
+        } else if (encoding == ENCODING_UTF8_BOM) {
+            targetEncoding = "UTF-8";
+        } else if (encoding == ENCODING_UTF16_BOM) {
+            targetEncoding = "UTF-16";
+        } else if (encoding == ENCODING_UTF32_BOM) {
+            targetEncoding = "UTF-32";
+        } else {
+            targetEncoding = encoding;
+        }
+
+        if (unit->realEncoding().isEmpty()) {
+            if (unit->encoding() == ENCODING_AUTO_DETECT) {
+                Editor* editor = mProject->unitEditor(unit);
+                if (editor && editor->fileEncoding()!=ENCODING_ASCII
+                        && editor->fileEncoding()!=targetEncoding) {
+                    sourceEncoding = editor->fileEncoding();
+                } else {
+                    sourceEncoding = targetEncoding;
+                }
+            } else if (unit->encoding()==ENCODING_PROJECT) {
+                sourceEncoding=mProject->options().encoding;
+            } else if (unit->encoding()==ENCODING_SYSTEM_DEFAULT) {
+                sourceEncoding = defaultSystemEncoding;
+            } else if (unit->encoding()!=ENCODING_ASCII && !unit->encoding().isEmpty()) {
+                sourceEncoding = unit->encoding();
+            } else {
+                sourceEncoding = targetEncoding;
+            }
+        } else if (unit->realEncoding()==ENCODING_ASCII) {
+            sourceEncoding = targetEncoding;
+        } else {
+            sourceEncoding = unit->realEncoding();
+        }
+        if (sourceEncoding==ENCODING_SYSTEM_DEFAULT)
+            sourceEncoding = defaultSystemEncoding;
+
+        if (sourceEncoding!=targetEncoding) {
+            encodingStr = QString(" -finput-charset=%1 -fexec-charset=%2")
+                    .arg(QString(sourceEncoding),
+                         QString(targetEncoding));
+        }
+    }
+    return encodingStr;
+}
+
 void ProjectCompiler::writeln(QFile &file, const QString &s)
 {
     if (!s.isEmpty())
@@ -606,6 +773,12 @@ bool ProjectCompiler::prepareForCompile()
         mArguments = makeAllArgs;
     }
     mDirectory = mProject->directory();
+    if (!mOnlyClean) {
+        mBuildTimeRecorder = std::make_shared<BuildTimeRecorder>(
+                    mDirectory,
+                    mProject->options().traceCompileTime
+                    && compilerSet()->compilerType() == CompilerType::Clang);
+    }
 
     log(tr("Processing makefile:"));
     log("--------");
@@ -616,3 +789,60 @@ bool ProjectCompiler::prepareForCompile()
 
     return true;
 }
+
+void ProjectCompiler::processStdOutput(const QString &output)
+{
+    if (mBuildTimeRecorder)
+        mBuildTimeRecorder->processOutput(output);
+}
+
+void ProjectCompiler::afterCompile()
+{
+    if (!mBuildTimeRecorder)
+        return;
+    PBuildRecord record = mBuildTimeRecorder->finish();
+    mBuildTimeRecorder.reset();
+    if (!record)
+        return;
+    BuildTimeHistory history(changeFileExt(mProject->filename(), BUILD_TIMES_EXT));
+    history.load();
+    history.add(record);
+    history.save();
+
+    QList<BuildStep> steps = record->steps;
+    std::sort(steps.begin(), steps.end(), [](const BuildStep& step1, const BuildStep& step2) {
+        return step1.duration() > step2.duration();
+    });
+    log(tr("- Slowest Steps:"));
+    for (int i=0;i<std::min(3, steps.count());i++) {
+        const BuildStep& step = steps[i];
+        QString fileName = step.sourceFile.isEmpty() ? step.outputFile : step.sourceFile;
+        log(tr("    %1: %2 secs")
+            .arg(extractRelativePath(mProject->directory(), fileName))
+            .arg(step.duration() / 1000.0));
+    }
+}
+
+QString ProjectCompiler::getFileNameFromOutputLine(QString &line)
+{
+    QString fileName = Compiler::getFileNameFromOutputLine(line);
+    if (mUnityBatches.isEmpty())
+        return fileName;
+    // gcc prints the path in the command line, which is relative to the project folder
+    QString absoluteFileName = generateAbsolutePath(mDirectory, fileName);
+    foreach (const UnityBatch& batch, mUnityBatches) {
+        if (batch.fileName.compare(absoluteFileName, PATH_SENSITIVITY) != 0)
+            continue;
+        // line n of the batch file includes its (n-1)th unit
+        int pos = 0;
+        while (pos < line.length() && line[pos].isDigit())
+            pos++;
+        int index = line.left(pos).toInt() - 2;
+        if (index >= 0 && index < batch.units.count()) {
+            line = "1" + line.mid(pos);
+            return batch.units[index]->fileName();
+        }
+        break;
+    }
+    return fileName;
+}
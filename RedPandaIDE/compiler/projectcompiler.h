@@ -18,10 +18,13 @@
 #define PROJECTCOMPILER_H
 
 #include "compiler.h"
+#include "buildtimes.h"
 #include <QObject>
 #include <QFile>
 
 class Project;
+class ProjectUnit;
+using PProjectUnit = std::shared_ptr<ProjectUnit>;
 class ProjectCompiler : public Compiler
 {
     Q_OBJECT
@@ -46,12 +49,28 @@ private:
     void writeMakeClean(QFile& file);
     void writeMakeObjFilesRules(QFile& file);
     void writeln(QFile& file, const QString& s="");
+    void createUnityBatches();
+    QStringList unitPrerequisites(const PProjectUnit& unit, const QList<PProjectUnit>& projectUnits, QString& precompileStr);
+    QString unitEncodingArguments(const PProjectUnit& unit);
     // Compiler interface
 private:
+    struct UnityBatch {
+        QString fileName; // the generated source including all units
+        QList<PProjectUnit> units;
+        bool cpp;
+        QString encodingArguments;
+    };
     bool mOnlyClean;
+    QList<UnityBatch> mUnityBatches;
+    // unit file name -> index of its unity batch
+    QHash<QString,int> mUnityBatchOfUnit;
+    std::shared_ptr<BuildTimeRecorder> mBuildTimeRecorder;
 protected:
     bool prepareForCompile() override;
     bool prepareForRebuild() override;
+    void processStdOutput(const QString& output) override;
+    void afterCompile() override;
+    QString getFileNameFromOutputLine(QString &line) override;
 };
 
 #endif // PROJECTCOMPILER_H
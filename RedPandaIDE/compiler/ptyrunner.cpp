@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "ptyrunner.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QProcessEnvironment>
+#include <vector>
+#include "utils.h"
+#include "../systemconsts.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+#if defined(Q_OS_MACOS)
+#include <util.h>
+#elif defined(Q_OS_FREEBSD)
+#include <libutil.h>
+#else
+#include <pty.h>
+#endif
+
+PtyRunner::PtyRunner(const QString &filename, const QStringList &arguments, const QString &workDir,
+                     const PTerminalScreen &screen, QObject *parent):
+    Runner(filename,arguments,workDir,parent),
+    mScreen(screen),
+    mMasterFd(-1),
+    mPid(-1)
+{
+    mWakeupFds[0] = -1;
+    mWakeupFds[1] = -1;
+    setWaitForFinishTime(100);
+}
+
+const QString &PtyRunner::redirectInputFilename() const
+{
+    return mRedirectInputFilename;
+}
+
+void PtyRunner::setRedirectInputFilename(const QString &newRedirectInputFilename)
+{
+    mRedirectInputFilename = newRedirectInputFilename;
+}
+
+void PtyRunner::addBinDirs(const QStringList &binDirs)
+{
+    mBinDirs.append(binDirs);
+}
+
+void PtyRunner::addBinDir(const QString &binDir)
+{
+    mBinDirs.append(binDir);
+}
+
+void PtyRunner::writeInput(const QByteArray &data)
+{
+    QMutexLocker locker(&mMutex);
+    if (mMasterFd<0)
+        return;
+    bool wasEmpty = mPendingInput.isEmpty();
+    mPendingInput.append(data);
+    if (wasEmpty) {
+        char c = 0;
+        // a full pipe means the poll loop is going to wake up anyway
+        if (::write(mWakeupFds[1], &c, 1)<0 && errno!=EAGAIN) {
+            qDebug()<<"Can't wake up the pty runner:"<<strerror(errno);
+        }
+    }
+}
+
+void PtyRunner::setWindowSize(int rows, int columns)
+{
+    QMutexLocker locker(&mMutex);
+    if (mMasterFd<0)
+        return;
+    struct winsize size;
+    memset(&size, 0, sizeof(size));
+    size.ws_row = rows;
+    size.ws_col = columns;
+    ioctl(mMasterFd, TIOCSWINSZ, &size);
+}
+
+void PtyRunner::run()
+{
+    emit started();
+    auto action = finally([this]{
+        emit terminated();
+    });
+    mStop = false;
+
+    // prepare everything used by the child before forking,
+    // only async-signal-safe functions can be called after fork()
+    std::vector<QByteArray> argStore;
+    argStore.push_back(mFilename.toLocal8Bit());
+    foreach (const QString& arg, mArguments)
+        argStore.push_back(arg.toLocal8Bit());
+    std::vector<char*> argv;
+    for (QByteArray& arg:argStore)
+        argv.push_back(arg.data());
+    argv.push_back(nullptr);
+
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    QString path = env.value("PATH");
+    if (!path.isEmpty()) {
+        path = mBinDirs.join(PATH_SEPARATOR) + PATH_SEPARATOR + path;
+    } else {
+        path = mBinDirs.join(PATH_SEPARATOR);
+    }
+    env.insert("PATH",path);
+    env.insert("TERM","xterm-256color");
+    env.insert(mExtraEnvironment);
+    std::vector<QByteArray> envStore;
+    foreach (const QString& s, env.toStringList())
+        envStore.push_back(s.toLocal8Bit());
+    std::vector<char*> envp;
+    for (QByteArray& s:envStore)
+        envp.push_back(s.data());
+    envp.push_back(nullptr);
+
+    QByteArray workDir = mWorkDir.toLocal8Bit();
+    int inputFd = -1;
+    if (!mRedirectInputFilename.isEmpty()) {
+        inputFd = ::open(mRedirectInputFilename.toLocal8Bit().constData(), O_RDONLY | O_CLOEXEC);
+        if (inputFd<0) {
+            emit runErrorOccurred(tr("Can't open input file \"%1\": %2")
+                                  .arg(mRedirectInputFilename, strerror(errno)));
+            return;
+        }
+    }
+
+    struct winsize size;
+    memset(&size, 0, sizeof(size));
+    {
+        QMutexLocker locker(mScreen->mutex());
+        size.ws_row = mScreen->rows();
+        size.ws_col = mScreen->columns();
+    }
+
+    QElapsedTimer timer;
+    int masterFd = -1;
+    timer.start();
+    pid_t pid = forkpty(&masterFd, nullptr, nullptr, &size);
+    if (pid == 0) {
+        if (!workDir.isEmpty() && chdir(workDir.constData())!=0)
+            _exit(127);
+        if (inputFd>=0)
+            dup2(inputFd, STDIN_FILENO);
+        execve(argv[0], argv.data(), envp.data());
+        const char* message = "Can't execute the program\r\n";
+        if (::write(STDERR_FILENO, message, strlen(message))<0) {
+            // nowhere else to report it
+        }
+        _exit(127);
+    }
+    if (inputFd>=0)
+        ::close(inputFd);
+    if (pid < 0) {
+        emit runErrorOccurred(tr("Can't create a pseudo terminal: %1").arg(strerror(errno)));
+        return;
+    }
+    int wakeupFds[2];
+    if (::pipe(wakeupFds)!=0) {
+        emit runErrorOccurred(tr("Can't create a pipe: %1").arg(strerror(errno)));
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        ::close(masterFd);
+        return;
+    }
+    for (int fd:{masterFd, wakeupFds[0], wakeupFds[1]}) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    {
+        QMutexLocker locker(&mMutex);
+        mMasterFd = masterFd;
+        mPid = pid;
+        mWakeupFds[0] = wakeupFds[0];
+        mWakeupFds[1] = wakeupFds[1];
+    }
+
+    char buffer[65536];
+    int status = 0;
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    bool exited = false;
+    while (true) {
+        bool hasInput;
+        {
+            QMutexLocker locker(&mMutex);
+            hasInput = !mPendingInput.isEmpty();
+        }
+        struct pollfd pfds[2];
+        pfds[0].fd = masterFd;
+        pfds[0].events = POLLIN | (hasInput ? POLLOUT : 0);
+        pfds[0].revents = 0;
+        pfds[1].fd = wakeupFds[0];
+        pfds[1].events = POLLIN;
+        pfds[1].revents = 0;
+        int result = poll(pfds, 2, mWaitForFinishTime);
+        if (result>0) {
+            if (pfds[1].revents & POLLIN) {
+                char dummy[64];
+                while (::read(wakeupFds[0], dummy, sizeof(dummy))>0)
+                    ;
+            }
+            if (pfds[0].revents & POLLOUT)
+                writePendingInput();
+            if (!(pfds[0].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            ssize_t n = ::read(masterFd, buffer, sizeof(buffer));
+            if (n>0) {
+                feedScreen(buffer, n);
+                continue;
+            }
+            if (n<0 && (errno == EINTR || errno == EAGAIN))
+                continue;
+            // EIO: all processes using the terminal have exited
+            break;
+        } else if (result<0 && errno!=EINTR) {
+            break;
+        }
+        // no output in time, the program may have left background processes
+        if (wait4(pid, &status, WNOHANG, &usage) == pid) {
+            exited = true;
+            break;
+        }
+    }
+    if (!exited)
+        wait4(pid, &status, 0, &usage);
+    double seconds = timer.elapsed() / 1000.0;
+    {
+        QMutexLocker locker(&mMutex);
+        ::close(mMasterFd);
+        mMasterFd = -1;
+        mPid = -1;
+        ::close(mWakeupFds[0]);
+        ::close(mWakeupFds[1]);
+        mWakeupFds[0] = -1;
+        mWakeupFds[1] = -1;
+        mPendingInput.clear();
+    }
+
+    QString message;
+    if (WIFSIGNALED(status)) {
+        message = tr("Process terminated by signal %1 after %2 seconds.")
+                .arg(WTERMSIG(status))
+                .arg(seconds, 0, 'g', 4);
+    } else {
+        message = tr("Process exited after %1 seconds with return value %2, %3 KB mem used.")
+                .arg(seconds, 0, 'g', 4)
+                .arg(WEXITSTATUS(status))
+                .arg(usage.ru_maxrss);
+    }
+    QByteArray tail = QString("\r\n--------------------------------\r\n%1\r\n").arg(message).toUtf8();
+    feedScreen(tail.constData(), tail.length());
+}
+
+void PtyRunner::doStop()
+{
+    QMutexLocker locker(&mMutex);
+    if (mPid>0)
+        kill(mPid, SIGKILL);
+}
+
+void PtyRunner::writePendingInput()
+{
+    QMutexLocker locker(&mMutex);
+    while (!mPendingInput.isEmpty()) {
+        ssize_t n = ::write(mMasterFd, mPendingInput.constData(), mPendingInput.length());
+        if (n>0) {
+            mPendingInput.remove(0, n);
+            continue;
+        }
+        if (n<0 && errno == EINTR)
+            continue;
+        // EAGAIN: the terminal is full, wait for the next POLLOUT
+        if (n<0 && errno != EAGAIN)
+            mPendingInput.clear();
+        break;
+    }
+}
+
+void PtyRunner::feedScreen(const char *data, int length)
+{
+    QMutexLocker locker(mScreen->mutex());
+    mScreen->feed(data, length);
+}
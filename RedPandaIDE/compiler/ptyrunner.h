@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PTYRUNNER_H
+#define PTYRUNNER_H
+
+#include "runner.h"
+#include <QMutex>
+#include "../widgets/terminalscreen.h"
+
+/**
+ * @brief Runs a console program in a pseudo terminal.
+ *
+ * The output is parsed into the terminal screen in the runner thread,
+ * the integrated console only paints it.
+ */
+class PtyRunner : public Runner
+{
+    Q_OBJECT
+public:
+    PtyRunner(const QString& filename, const QStringList& arguments, const QString& workDir,
+              const PTerminalScreen& screen, QObject* parent = nullptr);
+    PtyRunner(const PtyRunner&)=delete;
+    PtyRunner& operator=(const PtyRunner&)=delete;
+
+    const QString &redirectInputFilename() const;
+    void setRedirectInputFilename(const QString &newRedirectInputFilename);
+
+    void addBinDirs(const QStringList &binDirs);
+    void addBinDir(const QString &binDir);
+
+public slots:
+    // can be called from any thread
+    void writeInput(const QByteArray& data);
+    void setWindowSize(int rows, int columns);
+
+    // QThread interface
+protected:
+    void run() override;
+
+    // Runner interface
+protected:
+    void doStop() override;
+private:
+    void feedScreen(const char* data, int length);
+    void writePendingInput();
+private:
+    PTerminalScreen mScreen;
+    QString mRedirectInputFilename;
+    QStringList mBinDirs;
+    int mMasterFd;
+    int mPid;
+    // input is written to the nonblocking master fd in the runner thread,
+    // writeInput() only queues it and wakes up the poll loop
+    QByteArray mPendingInput;
+    int mWakeupFds[2];
+    // guards mMasterFd, mPid, mPendingInput and mWakeupFds
+    QMutex mMutex;
+};
+
+#endif // PTYRUNNER_H
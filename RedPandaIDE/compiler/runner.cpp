@@ -60,3 +60,12 @@ void Runner::setWaitForFinishTime(int newWaitForFinishTime)
     mWaitForFinishTime = newWaitForFinishTime;
 }
 
+const QProcessEnvironment &Runner::extraEnvironment() const
+{
+    return mExtraEnvironment;
+}
+
+void Runner::setExtraEnvironment(const QProcessEnvironment &newExtraEnvironment)
+{
+    mExtraEnvironment = newExtraEnvironment;
+}
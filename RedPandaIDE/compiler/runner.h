@@ -17,6 +17,7 @@
 #ifndef RUNNER_H
 #define RUNNER_H
 
+#include <QProcessEnvironment>
 #include <QThread>
 
 class Runner : public QThread
@@ -33,6 +34,10 @@ public:
     int waitForFinishTime() const;
     void setWaitForFinishTime(int newWaitForFinishTime);
 
+    // added to the system environment of the program
+    const QProcessEnvironment& extraEnvironment() const;
+    void setExtraEnvironment(const QProcessEnvironment &newExtraEnvironment);
+
 signals:
     void started();
     void terminated();
@@ -51,6 +56,7 @@ protected:
     QStringList mArguments; // without argv[0]
     QString mWorkDir;
     int mWaitForFinishTime;
+    QProcessEnvironment mExtraEnvironment;
 };
 
 #endif // RUNNER_H
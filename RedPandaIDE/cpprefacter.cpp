@@ -294,6 +294,8 @@ void CppRefacter::renameSymbolInFile(const QString &filename, const PStatement &
     QStringList buffer;
     Editor * oldEditor=pMainWindow->editorList()->getOpenedEditorByFilename(filename);
     if (oldEditor){
+        // an unloaded editor is empty
+        oldEditor->loadContent();
         QSynedit::PSyntaxer syntaxer = syntaxerManager.getSyntaxer(QSynedit::ProgrammingLanguage::CPP);
         int posY = 0;
         oldEditor->clearSelection();
@@ -387,9 +389,8 @@ void CppRefacter::renameSymbolInFile(const QString &filename, const PStatement &
             posY++;
         }
         QByteArray realEncoding;
-        QFile file(filename);
         try {
-            editor.document()->saveToFile(file,ENCODING_AUTO_DETECT,
+            editor.document()->saveToFile(filename,ENCODING_AUTO_DETECT,
                                        pSettings->editor().defaultEncoding(),
                                        realEncoding);
         } catch(FileError e) {
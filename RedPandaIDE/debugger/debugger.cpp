@@ -55,6 +55,7 @@ Debugger::Debugger(QObject *parent) : QObject(parent),
     mExecuting = false;
     mClient = nullptr;
     mTarget = nullptr;
+    mSyncingParseResults = false;
     mCommandChanged = false;
     mLeftPageIndexBackup = -1;
 
@@ -66,6 +67,7 @@ Debugger::Debugger(QObject *parent) : QObject(parent),
 
 Debugger::~Debugger()
 {
+    stopParkedClients();
 //    delete mBreakpointModel;
 //    delete mBacktraceModel;
 //    delete mWatchModel;
@@ -163,14 +165,51 @@ bool Debugger::startClient(int compilerSetIndex,
         mTarget->start();
         mTarget->waitStart();
     }
-    //delete when thread finished
-    mClient = new GDBMIDebuggerClient(this, debuggerType());
-    mClient->addBinDirs(binDirs);
-    mClient->addBinDir(pSettings->dirs().appDir());
-    mClient->setDebuggerPath(debuggerPath);
+    // skip settings are kept by gdb, so they are part of the key
+    mClientKey = QString("%1\n%2\n%3%4")
+            .arg(debuggerPath, binDirs.join(PATH_SEPARATOR))
+            .arg(int(pSettings->debugger().skipSystemLibraries()))
+            .arg(int(pSettings->debugger().skipCustomLibraries()));
+    if (!pSettings->debugger().keepDebuggerRunning())
+        stopParkedClients();
+    GDBMIDebuggerClient* parkedClient = takeParkedClient(mClientKey);
+    if (parkedClient) {
+        mClient = parkedClient;
+        connectClient();
+    } else {
+        //delete when thread finished
+        mClient = new GDBMIDebuggerClient(this, debuggerType());
+        mClient->addBinDirs(binDirs);
+        mClient->addBinDir(pSettings->dirs().appDir());
+        mClient->setDebuggerPath(debuggerPath);
+        connectClient();
+        mClient->start();
+        mClient->waitStart();
+    }
+
+    mClient->initialize(inferior, inferiorHasSymbols);
+    includeOrSkipDirsInSymbolSearch(compilerSet->libDirs(), pSettings->debugger().skipCustomLibraries());
+    includeOrSkipDirsInSymbolSearch(compilerSet->CIncludeDirs(), pSettings->debugger().skipCustomLibraries());
+    includeOrSkipDirsInSymbolSearch(compilerSet->CppIncludeDirs(), pSettings->debugger().skipCustomLibraries());
+
+    //gcc system libraries is auto loaded by gdb
+    if (pSettings->debugger().skipSystemLibraries()) {
+        includeOrSkipDirsInSymbolSearch(compilerSet->defaultCIncludeDirs(),true);
+        includeOrSkipDirsInSymbolSearch(compilerSet->defaultCIncludeDirs(),true);
+        includeOrSkipDirsInSymbolSearch(compilerSet->defaultCppIncludeDirs(),true);
+    }
+
+    sendAllBreakpointsToDebugger();
+    pMainWindow->updateAppTitle();
+    mInferiorHasBreakpoints = inferiorHasBreakpoints;
+    return true;
+}
+
+void Debugger::connectClient()
+{
     connect(mClient, &QThread::finished,this,&Debugger::cleanUpReader);
     connect(mClient, &QThread::finished,mMemoryModel.get(),&MemoryModel::reset);
-    connect(mClient, &DebuggerClient::parseFinished,this,&Debugger::syncFinishedParsing,Qt::BlockingQueuedConnection);
+    connect(mClient, &DebuggerClient::parseFinished,this,&Debugger::syncFinishedParsing);
     connect(mClient, &DebuggerClient::changeDebugConsoleLastLine,this,&Debugger::onChangeDebugConsoleLastline);
     connect(mClient, &DebuggerClient::cmdStarted,pMainWindow, &MainWindow::disableDebugActions);
     connect(mClient, &DebuggerClient::cmdFinished,pMainWindow, &MainWindow::enableDebugActions);
@@ -210,26 +249,74 @@ bool Debugger::startClient(int compilerSetIndex,
             &MainWindow::stopDebugForNoSymbolTable);
     connect(mClient, &DebuggerClient::inferiorStopped,this,
             &Debugger::refreshAll);
+}
 
-    mClient->start();
-    mClient->waitStart();
+static void stopParkedClient(GDBMIDebuggerClient* client)
+{
+    client->disconnect();
+    client->stopDebug();
+    client->wait();
+    delete client;
+}
 
-    mClient->initialize(inferior, inferiorHasSymbols);
-    includeOrSkipDirsInSymbolSearch(compilerSet->libDirs(), pSettings->debugger().skipCustomLibraries());
-    includeOrSkipDirsInSymbolSearch(compilerSet->CIncludeDirs(), pSettings->debugger().skipCustomLibraries());
-    includeOrSkipDirsInSymbolSearch(compilerSet->CppIncludeDirs(), pSettings->debugger().skipCustomLibraries());
+bool Debugger::canParkClient() const
+{
+    if (!pSettings->debugger().keepDebuggerRunning())
+        return false;
+    if (!mClient || mClient->clientType()!=DebuggerType::GDB)
+        return false;
+    // gdb exited
+    if (!mClient->isRunning())
+        return false;
+    return dynamic_cast<GDBMIDebuggerClient*>(mClient)!=nullptr;
+}
 
-    //gcc system libraries is auto loaded by gdb
-    if (pSettings->debugger().skipSystemLibraries()) {
-        includeOrSkipDirsInSymbolSearch(compilerSet->defaultCIncludeDirs(),true);
-        includeOrSkipDirsInSymbolSearch(compilerSet->defaultCIncludeDirs(),true);
-        includeOrSkipDirsInSymbolSearch(compilerSet->defaultCppIncludeDirs(),true);
+void Debugger::parkClient()
+{
+    GDBMIDebuggerClient* client = dynamic_cast<GDBMIDebuggerClient*>(mClient);
+    mClient = nullptr;
+    // parked client must not update the views
+    client->disconnect();
+    client->park();
+    foreach (const PWatchVar& var, mWatchModel->watchVars()) {
+        if (!var->name.isEmpty())
+            client->removeWatch(var);
     }
+    mMemoryModel->reset();
+    GDBMIDebuggerClient* oldClient = mParkedClients.take(mClientKey);
+    if (oldClient)
+        stopParkedClient(oldClient);
+    mParkedClients.insert(mClientKey, client);
+    connect(client, &QThread::finished, this, [this, client]() {
+        // gdb exited while parked
+        QString key = mParkedClients.key(client);
+        if (!key.isEmpty())
+            mParkedClients.remove(key);
+        client->deleteLater();
+    });
+}
 
-    sendAllBreakpointsToDebugger();
-    pMainWindow->updateAppTitle();
-    mInferiorHasBreakpoints = inferiorHasBreakpoints;
-    return true;
+GDBMIDebuggerClient *Debugger::takeParkedClient(const QString &key)
+{
+    GDBMIDebuggerClient* client = mParkedClients.take(key);
+    if (!client)
+        return nullptr;
+    client->disconnect();
+    if (!client->isRunning()) {
+        client->deleteLater();
+        return nullptr;
+    }
+    // replies to the commands posted when parking were never taken
+    client->takeParseResults();
+    return client;
+}
+
+void Debugger::stopParkedClients()
+{
+    foreach (GDBMIDebuggerClient* client, mParkedClients) {
+        stopParkedClient(client);
+    }
+    mParkedClients.clear();
 }
 
 void Debugger::runInferior()
@@ -244,7 +331,11 @@ void Debugger::stop() {
             mTarget->stopDebug();
             mTarget = nullptr;
         }
-        mClient->stopDebug();
+        if (canParkClient()) {
+            parkClient();
+            cleanUpReader();
+        } else
+            mClient->stopDebug();
     }
     mCurrentSourceFile="";
 }
@@ -254,8 +345,10 @@ void Debugger::cleanUpReader()
         mExecuting = false;
 
         //stop debugger
-        mClient->deleteLater();
-        mClient=nullptr;
+        if (mClient) {
+            mClient->deleteLater();
+            mClient=nullptr;
+        }
 
         if (pMainWindow->cpuDialog()!=nullptr) {
             pMainWindow->cpuDialog()->close();
@@ -515,13 +608,22 @@ void Debugger::setBreakPointCondition(int index, const QString &condition, bool
 
 void Debugger::sendAllBreakpointsToDebugger()
 {
+    QList<PBreakpoint> breakpoints;
     for (PBreakpoint breakpoint:mBreakpointModel->breakpoints(mBreakpointModel->isForProject())) {
         if (mBreakpointModel->isForProject()) {
-            sendBreakpointCommand(breakpoint);
+            breakpoints.append(breakpoint);
         } else if (breakpoint->filename == mCurrentSourceFile) {
-            sendBreakpointCommand(breakpoint);
+            breakpoints.append(breakpoint);
         }
     }
+    // gdb kept from the last session may have some of them
+    GDBMIDebuggerClient* gdbmiClient = dynamic_cast<GDBMIDebuggerClient*>(mClient);
+    if (gdbmiClient) {
+        gdbmiClient->syncBreakpoints(breakpoints);
+        return;
+    }
+    for (PBreakpoint breakpoint:breakpoints)
+        sendBreakpointCommand(breakpoint);
 }
 
 void Debugger::saveForNonproject(const QString &filename)
@@ -974,11 +1076,43 @@ void Debugger::includeOrSkipDirsInSymbolSearch(const QStringList &dirs, bool ski
 }
 
 void Debugger::syncFinishedParsing()
+{
+    // dialogs shown below run nested event loops
+    if (mSyncingParseResults)
+        return;
+    mSyncingParseResults = true;
+    auto action = finally([this]{
+        mSyncingParseResults = false;
+    });
+    while (mClient) {
+        // the reader never waits for us, handle all the results parsed since the last call
+        QList<PDebuggerParseResult> results = mClient->takeParseResults();
+        if (results.isEmpty())
+            break;
+        if (!applyParseResults(results))
+            break;
+    }
+}
+
+bool Debugger::applyParseResults(const QList<PDebuggerParseResult> &results)
 {
     bool spawnedcpuform = false;
+    bool receivedSFWarning = false;
+    bool processExited = false;
+    bool updateCPUInfo = false;
+    PDebuggerParseResult signalResult;
+    for (const PDebuggerParseResult& result: results) {
+        receivedSFWarning |= result->receivedSFWarning;
+        processExited |= result->processExited;
+        updateCPUInfo |= result->updateCPUInfo;
+        if (result->signalReceived
+                && result->signalName!="SIGINT"
+                && result->signalName!="SIGTRAP")
+            signalResult = result;
+    }
 
     // GDB determined that the source code is more recent than the executable. Ask the user if he wants to rebuild.
-    if (mClient->receivedSFWarning()) {
+    if (receivedSFWarning) {
         if (QMessageBox::question(pMainWindow,
                                   tr("Compile"),
                                   tr("Source file is more recent than executable.")+"<BR /><BR />" + tr("Recompile?"),
@@ -987,33 +1121,19 @@ void Debugger::syncFinishedParsing()
                                   ) == QMessageBox::Yes) {
             stop();
             pMainWindow->compile();
-            return;
+            return false;
         }
     }
 
     // show command output
     if (pSettings->debugger().enableDebugConsole() ) {
-        if (pSettings->debugger().showDetailLog()) {
-            for (const QString& line:mClient->fullOutput()) {
-                pMainWindow->addDebugOutput(line);
-            }
-            //pMainWindow->addDebugOutput("(gdb)");
-        } else {
-            // if (mClient->currentCmd() && mClient->currentCmd()->command == "disas") {
-
-            // } else {
-            //     for (const QString& line:mClient->consoleOutput()) {
-            //         pMainWindow->addDebugOutput(line);
-            //     }
-            //     if (
-            //             (mClient->currentCmd()
-            //              && mClient->currentCmd()->source== DebugCommandSource::Console)
-            //             || !mClient->consoleOutput().isEmpty() ) {
-            //         pMainWindow->addDebugOutput("(gdb)");
-            //     }
-            // }
-            if (!mClient->consoleOutput().isEmpty()) {
-                for (const QString& line:mClient->consoleOutput()) {
+        for (const PDebuggerParseResult& result: results) {
+            if (pSettings->debugger().showDetailLog()) {
+                for (const QString& line:result->fullOutput) {
+                    pMainWindow->addDebugOutput(line);
+                }
+            } else if (!result->consoleOutput.isEmpty()) {
+                for (const QString& line:result->consoleOutput) {
                     pMainWindow->addDebugOutput(line);
                 }
                 pMainWindow->addDebugOutput("(gdb)");
@@ -1022,20 +1142,18 @@ void Debugger::syncFinishedParsing()
     }
 
     // The program to debug has stopped. Stop the debugger
-    if (mClient->processExited()) {
+    if (processExited) {
         stop();
-        return;
+        return false;
     }
 
-    if (mClient->signalReceived()
-            && mClient->signalName()!="SIGINT"
-            && mClient->signalName()!="SIGTRAP") {
+    if (signalResult) {
         SignalMessageDialog dialog(pMainWindow);
         dialog.setOpenCPUInfo(pSettings->debugger().openCPUInfoWhenSignaled());
         dialog.setMessage(
-                    tr("Signal \"%1\" Received: ").arg(mClient->signalName())
+                    tr("Signal \"%1\" Received: ").arg(signalResult->signalName)
                     + "<br />"
-                    + mClient->signalMeaning());
+                    + signalResult->signalMeaning);
         int result = dialog.exec();
         if (result == QDialog::Accepted && dialog.openCPUInfo()) {
             pMainWindow->showCPUInfoDialog();
@@ -1043,9 +1161,10 @@ void Debugger::syncFinishedParsing()
     }
 
     // CPU form updates itself when spawned, don't update twice!
-    if ((mClient->updateCPUInfo() && !spawnedcpuform) && (pMainWindow->cpuDialog()!=nullptr)) {
+    if ((updateCPUInfo && !spawnedcpuform) && (pMainWindow->cpuDialog()!=nullptr)) {
         pMainWindow->cpuDialog()->updateInfo();
     }
+    return true;
 }
 
 void Debugger::setMemoryData(qulonglong address, unsigned char data)
@@ -1128,49 +1247,29 @@ void DebuggerClient::addBinDir(const QString &binDir)
     mBinDirs.append(binDir);
 }
 
-const QString &DebuggerClient::signalMeaning() const
-{
-    return mSignalMeaning;
-}
-
-const QString &DebuggerClient::signalName() const
-{
-    return mSignalName;
-}
-
 bool DebuggerClient::inferiorRunning() const
 {
     return mInferiorRunning;
 }
 
-const QStringList &DebuggerClient::fullOutput() const
-{
-    return mFullOutput;
-}
-
-bool DebuggerClient::receivedSFWarning() const
-{
-    return mReceivedSFWarning;
-}
-
-bool DebuggerClient::updateCPUInfo() const
-{
-    return mUpdateCPUInfo;
-}
-
-const QStringList &DebuggerClient::consoleOutput() const
-{
-    return mConsoleOutput;
-}
-
-bool DebuggerClient::signalReceived() const
+QList<PDebuggerParseResult> DebuggerClient::takeParseResults()
 {
-    return mSignalReceived;
+    return mParseResults.take();
 }
 
-bool DebuggerClient::processExited() const
+void DebuggerClient::postParseResult()
 {
-    return mProcessExited;
+    std::shared_ptr<DebuggerParseResult> result = std::make_shared<DebuggerParseResult>();
+    result->consoleOutput = mConsoleOutput;
+    result->fullOutput = mFullOutput;
+    result->processExited = mProcessExited;
+    result->signalReceived = mSignalReceived;
+    result->signalName = mSignalName;
+    result->signalMeaning = mSignalMeaning;
+    result->updateCPUInfo = mUpdateCPUInfo;
+    result->receivedSFWarning = mReceivedSFWarning;
+    if (mParseResults.post(result))
+        emit parseFinished();
 }
 
 QString DebuggerClient::debuggerPath() const
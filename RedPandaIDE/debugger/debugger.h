@@ -18,6 +18,7 @@
 #define DEBUGGER_H
 
 #include <QAbstractTableModel>
+#include <QHash>
 #include <QList>
 #include <QList>
 #include <QMap>
@@ -32,6 +33,7 @@
 #include <QTimer>
 #include <memory>
 #include "gdbmiresultparser.h"
+#include "parseresultqueue.h"
 
 enum class DebugCommandSource {
     Console,
@@ -290,11 +292,29 @@ private:
 
 
 class DebuggerClient;
+class GDBMIDebuggerClient;
 class DebugTarget;
 class Editor;
 
 using PDebugReader = std::shared_ptr<DebuggerClient>;
 
+/**
+ * @brief Snapshot of the client's state after an output of the debugger is parsed.
+ *
+ * It's not changed after posted to the gui thread.
+ */
+struct DebuggerParseResult {
+    QStringList consoleOutput;
+    QStringList fullOutput;
+    bool processExited;
+    bool signalReceived;
+    QString signalName;
+    QString signalMeaning;
+    bool updateCPUInfo;
+    bool receivedSFWarning;
+};
+using PDebuggerParseResult = std::shared_ptr<const DebuggerParseResult>;
+
 class Debugger : public QObject
 {
     Q_OBJECT
@@ -413,6 +433,12 @@ private:
     void save(const QString& filename, const QString& projectFolder);
     PDebugConfig load(const QString& filename, bool forProject);
     void addWatchVar(const PWatchVar &watchVar, bool forProject);
+    void connectClient();
+    bool applyParseResults(const QList<PDebuggerParseResult>& results);
+    bool canParkClient() const;
+    void parkClient();
+    GDBMIDebuggerClient* takeParkedClient(const QString& key);
+    void stopParkedClients();
 
 private slots:
     void syncFinishedParsing();
@@ -435,6 +461,10 @@ private:
     std::shared_ptr<RegisterModel> mRegisterModel;
     std::shared_ptr<MemoryModel> mMemoryModel;
     DebuggerClient *mClient;
+    bool mSyncingParseResults;
+    // gdb kept running between debug sessions, by mClientKey
+    QHash<QString,GDBMIDebuggerClient*> mParkedClients;
+    QString mClientKey;
     DebugTarget *mTarget;
     bool mForceUTF8;
     bool mDebugInfosUsingUTF8;
@@ -491,23 +521,10 @@ public:
     void setDebuggerPath(const QString &debuggerPath);
     void waitStart();
 
-    bool processExited() const;
-
-    bool signalReceived() const;
-
-    const QStringList &consoleOutput() const;
-
-    bool updateCPUInfo() const;
-
-    bool receivedSFWarning() const;
-
-    const QStringList &fullOutput() const;
-
     bool inferiorRunning() const;
 
-    const QString &signalName() const;
-
-    const QString &signalMeaning() const;
+    // results parsed since the last call, oldest first
+    QList<PDebuggerParseResult> takeParseResults();
 
     const QStringList &binDirs() const;
     void addBinDirs(const QStringList &binDirs);
@@ -615,8 +632,11 @@ protected:
     QString mSignalName;
     QString mSignalMeaning;
     bool mReceivedSFWarning;
+
+    void postParseResult();
 private:
     Debugger *mDebugger;
+    ParseResultQueue<PDebuggerParseResult> mParseResults;
     QString mDebuggerPath;
 
     QStringList mBinDirs;
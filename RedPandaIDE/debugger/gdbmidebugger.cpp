@@ -20,6 +20,7 @@
 #include "../utils.h"
 #include "../systemconsts.h"
 #include "../settings.h"
+#include "qt_utils/tracer.h"
 
 #include <QFileInfo>
 
@@ -35,6 +36,8 @@ GDBMIDebuggerClient::GDBMIDebuggerClient(
 {
     mProcess = std::make_shared<QProcess>();
     mAsyncUpdated = false;
+    mLoadedInferiorHasSymbols = false;
+    mLoadedInferiorSize = -1;
     registerInferiorStoppedCommand("-stack-list-frames","");
 }
 
@@ -170,6 +173,8 @@ void GDBMIDebuggerClient::runNextCmd()
     QMutexLocker locker(&mCmdQueueMutex);
 
     if (mCurrentCmd) {
+        if (mCurrentCmd->sendTime>=0)
+            Tracer::record("GDB MI command round trip", mCurrentCmd->sendTime, Tracer::now());
         DebugCommandSource commandSource = mCurrentCmd->source;
         mCurrentCmd=nullptr;
         if (commandSource!=DebugCommandSource::HeartBeat)
@@ -220,6 +225,7 @@ void GDBMIDebuggerClient::runNextCmd()
     }
     s+=" "+params;
     s+= "\n";
+    pCmd->sendTime = Tracer::enabled()?Tracer::now():-1;
     if (mProcess->write(s)<0) {
         emit writeToDebugFailed();
     }
@@ -349,6 +355,13 @@ void GDBMIDebuggerClient::handleBreakpoint(const GDBMIResultParser::ParseObject&
         filename = breakpoint["fullname"].pathValue();
     int line = breakpoint["line"].intValue();
     int number = breakpoint["number"].intValue();
+    // temporary breakpoints (like "-t main") are deleted by gdb when hit
+    if (breakpoint["disp"].value() == "keep") {
+        QMutexLocker locker(&mCmdQueueMutex);
+        mInsertedBreakpoints.insert(number,
+                                    InsertedBreakpoint{filename, line,
+                                                       QString::fromUtf8(breakpoint["cond"].value())});
+    }
     emit breakpointInfoGetted(filename, line , number);
 }
 
@@ -936,7 +949,7 @@ void GDBMIDebuggerClient::processDebugOutput(const QByteArray& debugOutput)
              break;
          }
     }
-    emit parseFinished();
+    postParseResult();
     mConsoleOutput.clear();
     mFullOutput.clear();
 }
@@ -989,11 +1002,24 @@ void GDBMIDebuggerClient::initialize(const QString& inferior, bool hasSymbols)
     if (clientType()==DebuggerType::GDB)
         postCommand("-data-list-register-names","");
 
-    if (hasSymbols) {
-        postCommand("-file-exec-and-symbols", '"' + inferior + '"');
-    } else {
-        postCommand("-file-exec-file", '"' + inferior + '"');
+    // gdb kept from the last session still has the symbols,
+    // reload them only if the inferior is rebuilt
+    QFileInfo info(inferior);
+    if (inferior != mLoadedInferior
+            || hasSymbols != mLoadedInferiorHasSymbols
+            || info.lastModified() != mLoadedInferiorTime
+            || info.size() != mLoadedInferiorSize) {
+        if (hasSymbols) {
+            postCommand("-file-exec-and-symbols", '"' + inferior + '"');
+        } else {
+            postCommand("-file-exec-file", '"' + inferior + '"');
+        }
+        mLoadedInferior = inferior;
+        mLoadedInferiorHasSymbols = hasSymbols;
+        mLoadedInferiorTime = info.lastModified();
+        mLoadedInferiorSize = info.size();
     }
+    mFileCache.clear();
     if (debugger()->useDebugServer()) {
         postCommand("-target-select",QString("remote localhost:%1").arg(pSettings->debugger().GDBServerPort()));
     }
@@ -1127,6 +1153,8 @@ void GDBMIDebuggerClient::removeBreakpoint(PBreakpoint breakpoint)
         //clear "filename":linenum
         QString filename = breakpoint->filename;
         filename.replace('\\','/');
+        QMutexLocker locker(&mCmdQueueMutex);
+        mInsertedBreakpoints.remove(breakpoint->number);
         postCommand("-break-delete",
                 QString("%1").arg(breakpoint->number));
     }
@@ -1136,6 +1164,12 @@ void GDBMIDebuggerClient::setBreakpointCondition(PBreakpoint breakpoint)
 {
     Q_ASSERT(breakpoint!=nullptr);
     QString condition = breakpoint->condition;
+    {
+        QMutexLocker locker(&mCmdQueueMutex);
+        auto it = mInsertedBreakpoints.find(breakpoint->number);
+        if (it != mInsertedBreakpoints.end())
+            it->condition = condition;
+    }
     if (condition.isEmpty()) {
         postCommand("-break-condition",
                     QString("%1").arg(breakpoint->number));
@@ -1240,19 +1274,69 @@ void GDBMIDebuggerClient::setDisassemblyLanguage(bool isIntel)
 void GDBMIDebuggerClient::skipDirectoriesInSymbolSearch(const QStringList &lst)
 {
     foreach(const QString &dirName, lst) {
-        postCommand(
-                    "skip",
-                    QString("-gfi \"%1/%2\"")
-                    .arg(dirName,"*.*"));
+        QString params = QString("-gfi \"%1/%2\"")
+                .arg(dirName,"*.*");
+        // skips are kept by gdb between warm sessions
+        if (mSymbolSearchCommands.contains("skip "+params))
+            continue;
+        mSymbolSearchCommands.insert("skip "+params);
+        postCommand("skip", params);
     }
 }
 
 void GDBMIDebuggerClient::addSymbolSearchDirectories(const QStringList &lst)
 {
     foreach(const QString &dirName, lst) {
-        postCommand(
-                    "-environment-directory",
-                    QString("\"%1\"").arg(dirName));
+        QString params = QString("\"%1\"").arg(dirName);
+        if (mSymbolSearchCommands.contains("-environment-directory "+params))
+            continue;
+        mSymbolSearchCommands.insert("-environment-directory "+params);
+        postCommand("-environment-directory", params);
+    }
+}
+
+void GDBMIDebuggerClient::park()
+{
+    QMutexLocker locker(&mCmdQueueMutex);
+    mCmdQueue.clear();
+    // results of the last session
+    takeParseResults();
+    // the result of the running command may never come if the inferior exited
+    mCmdRunning = false;
+    mProcessExited = false;
+    mInferiorRunning = false;
+    postCommand("kill","");
+    if (debugger()->useDebugServer())
+        postCommand("-target-disconnect","");
+}
+
+void GDBMIDebuggerClient::syncBreakpoints(const QList<PBreakpoint> &breakpoints)
+{
+    QMutexLocker locker(&mCmdQueueMutex);
+    QHash<int,InsertedBreakpoint> obsoleted = mInsertedBreakpoints;
+    foreach (const PBreakpoint& breakpoint, breakpoints) {
+        int number = -1;
+        QString condition;
+        for (auto it=obsoleted.begin();it!=obsoleted.end();++it) {
+            if (it->filename == breakpoint->filename && it->line == breakpoint->line) {
+                number = it.key();
+                condition = it->condition;
+                obsoleted.erase(it);
+                break;
+            }
+        }
+        if (number < 0) {
+            addBreakpoint(breakpoint);
+            continue;
+        }
+        // kept by gdb
+        breakpoint->number = number;
+        if (condition != breakpoint->condition)
+            setBreakpointCondition(breakpoint);
+    }
+    for (auto it=obsoleted.begin();it!=obsoleted.end();++it) {
+        mInsertedBreakpoints.remove(it.key());
+        postCommand("-break-delete", QString("%1").arg(it.key()));
     }
 }
 
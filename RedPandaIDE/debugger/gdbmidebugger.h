@@ -20,8 +20,11 @@
 #include "debugger.h"
 #include <QProcess>
 #include <QByteArray>
+#include <QDateTime>
+#include <QHash>
 #include <QList>
 #include <QMap>
+#include <QSet>
 #include <QString>
 #include <QStringList>
 #include <memory>
@@ -31,6 +34,7 @@ struct GDBMICommand{
     QString command;
     QString params;
     DebugCommandSource source;
+    qint64 sendTime; // for the latency tracer, -1 if not traced
 };
 
 using PGDBMICommand = std::shared_ptr<GDBMICommand>;
@@ -89,6 +93,11 @@ public:
 
     void skipDirectoriesInSymbolSearch(const QStringList& lst) override;
     void addSymbolSearchDirectories(const QStringList& lst) override;
+
+    // Keep gdb (and the symbols it loaded) for the next debug session
+    void park();
+    // Add/remove breakpoints, so gdb has exactly the given ones
+    void syncBreakpoints(const QList<PBreakpoint>& breakpoints);
     // QThread interface
 protected:
     void run() override;
@@ -140,6 +149,20 @@ private:
     PGDBMICommand mLastConsoleCmd;
     QList<PGDBMICommand> mInferiorStoppedHookCommands;
 
+    struct InsertedBreakpoint {
+        QString filename;
+        int line;
+        QString condition;
+    };
+    // breakpoints in gdb by their numbers, guarded by mCmdQueueMutex
+    QHash<int,InsertedBreakpoint> mInsertedBreakpoints;
+    // the loaded inferior, to skip reloading it in warm sessions
+    QString mLoadedInferior;
+    bool mLoadedInferiorHasSymbols;
+    QDateTime mLoadedInferiorTime;
+    qint64 mLoadedInferiorSize;
+    QSet<QString> mSymbolSearchCommands;
+
     DebuggerType mClientType;
 };
 
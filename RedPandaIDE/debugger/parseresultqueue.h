@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PARSERESULTQUEUE_H
+#define PARSERESULTQUEUE_H
+
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+
+// Results posted by the debugger reader thread and taken by the gui thread.
+// The taker handles all the results posted since it was notified, so it is
+// only notified again after it has taken them.
+template<typename T>
+class ParseResultQueue {
+public:
+    ParseResultQueue():
+        mNotifyPending{false} {
+    }
+
+    // returns true if the taker should be notified
+    bool post(const T& result) {
+        QMutexLocker locker(&mMutex);
+        mResults.append(result);
+        if (mNotifyPending)
+            return false;
+        mNotifyPending = true;
+        return true;
+    }
+
+    // results posted since the last call, oldest first
+    QList<T> take() {
+        QMutexLocker locker(&mMutex);
+        QList<T> results;
+        results.swap(mResults);
+        mNotifyPending = false;
+        return results;
+    }
+private:
+    QMutex mMutex;
+    QList<T> mResults;
+    bool mNotifyPending;
+};
+
+#endif // PARSERESULTQUEUE_H
@@ -18,9 +18,11 @@
 
 #include <QtCore/QFileInfo>
 #include <QFont>
+#include <QProcess>
 #include <QTextCodec>
 #include <QVariant>
 #include <QWheelEvent>
+#include <functional>
 #include <memory>
 #include "settings.h"
 #include "mainwindow.h"
@@ -30,6 +32,9 @@
 #include <QDebug>
 #include <QMimeData>
 #include <QTemporaryFile>
+#include <QPointer>
+#include <QRunnable>
+#include <QThreadPool>
 #include "qsynedit/syntaxer/cpp.h"
 #include "qsynedit/syntaxer/asm.h"
 #include "syntaxermanager.h"
@@ -37,6 +42,8 @@
 #include "qsynedit/exporter/htmlexporter.h"
 #include "qsynedit/exporter/qtsupportedhtmlexporter.h"
 #include "qsynedit/constants.h"
+#include "qsynedit/minimap.h"
+#include "qsynedit/filewriter.h"
 #include <QGuiApplication>
 #include <QClipboard>
 #include <QPainter>
@@ -55,6 +62,11 @@
 #include <QDebug>
 #include "project.h"
 #include <qt_utils/charsetinfo.h>
+#include "qsynedit/miscprocs.h"
+#include "utils/linediff.h"
+#ifdef ENABLE_VCS
+#include "vcs/gitmanager.h"
+#endif
 
 QHash<ParserLanguage,std::weak_ptr<CppParser>> Editor::mSharedParsers;
 
@@ -66,9 +78,12 @@ Editor::Editor(QWidget *parent):
 Editor::Editor(QWidget *parent, const QString& filename,
                   const QByteArray& encoding,
                   Project* pProject, bool isNew,
-                  QTabWidget* parentPageControl):
+                  QTabWidget* parentPageControl,
+                  bool deferLoad):
   QSynEdit{parent},
   mInited{false},
+  mContentLoaded{true},
+  mDeferredViewState{1,1,1,1},
   mEncodingOption{encoding},
   mFilename{filename},
   mParentPageControl{parentPageControl},
@@ -80,6 +95,7 @@ Editor::Editor(QWidget *parent, const QString& filename,
   mActiveBreakpointLine{-1},
   mCurrentTipType{TipType::None},
   mSaving{false},
+  mPendingBackgroundSaves{0},
   mHoverModifiedLine{-1},
   mWheelAccumulatedDelta{0}
 {
@@ -108,15 +124,21 @@ Editor::Editor(QWidget *parent, const QString& filename,
     }
     mFileEncoding = ENCODING_ASCII;
     if (!isNew) {
-        try {
-            loadFile();
-        } catch (FileError& e) {
-            QMessageBox::critical(nullptr,
-                                  tr("Error Load File"),
-                                  e.reason());
+        if (deferLoad) {
+            //file content is loaded when the editor is shown the first time
+            mContentLoaded = false;
+        } else {
+            try {
+                loadFile();
+            } catch (FileError& e) {
+                QMessageBox::critical(nullptr,
+                                      tr("Error Load File"),
+                                      e.reason());
+            }
         }
     }
-    resolveAutoDetectEncodingOption();
+    if (mContentLoaded)
+        resolveAutoDetectEncodingOption();
 
     if (mProject) {
         if (syntaxer && syntaxer->language() == QSynedit::ProgrammingLanguage::CPP)
@@ -157,6 +179,15 @@ Editor::Editor(QWidget *parent, const QString& filename,
             this, &Editor::onLinesDeleted);
     connect(this,&QSynEdit::linesInserted,
             this, &Editor::onLinesInserted);
+#ifdef ENABLE_VCS
+    mLineChangeBaseProcess = nullptr;
+    connect(document().get(), &QSynedit::Document::inserted,
+            this, &Editor::onDocumentLinesInserted);
+    connect(document().get(), &QSynedit::Document::deleted,
+            this, &Editor::onDocumentLinesDeleted);
+    connect(document().get(), &QSynedit::Document::putted,
+            this, &Editor::onDocumentLinePutted);
+#endif
 
     setContextMenuPolicy(Qt::CustomContextMenu);
 
@@ -187,7 +218,7 @@ Editor::Editor(QWidget *parent, const QString& filename,
             setModified(false);
         }
     }
-    if (!isNew && parentPageControl) {
+    if (!isNew && parentPageControl && mContentLoaded) {
         resetBookmarks();
         resetBreakpoints();
     }
@@ -232,6 +263,9 @@ Editor::Editor(QWidget *parent, const QString& filename,
 Editor::~Editor() {
     //qDebug()<<"editor "<<mFilename<<" deleted";
     cleanAutoBackup();
+#ifdef ENABLE_VCS
+    stopLineChangeBaseProcess();
+#endif
 }
 
 void Editor::loadFile(QString filename) {
@@ -260,7 +294,13 @@ void Editor::loadFile(QString filename) {
 
     //FileError should by catched by the caller of loadFile();
 
+#ifdef ENABLE_VCS
+    mLineChangeTracker.clear();
+#endif
     this->document()->loadFromFile(filename,mEncodingOption,mFileEncoding);
+#ifdef ENABLE_VCS
+    updateLineChangeBase();
+#endif
 
     if (mProject) {
         PProjectUnit unit = mProject->findUnit(this);
@@ -291,8 +331,74 @@ void Editor::loadFile(QString filename) {
     saveAutoBackup();
 }
 
+bool Editor::contentLoaded() const
+{
+    return mContentLoaded;
+}
+
+void Editor::loadContent()
+{
+    if (mContentLoaded)
+        return;
+    // line insert notifications must not shift bookmarks/breakpoints while loading
+    try {
+        loadFile();
+    } catch (FileError& e) {
+        QMessageBox::critical(nullptr,
+                              tr("Error Load File"),
+                              e.reason());
+    }
+    mContentLoaded = true;
+    resolveAutoDetectEncodingOption();
+    if (mParentPageControl) {
+        resetBookmarks();
+        resetBreakpoints();
+    }
+    setViewState(mDeferredViewState);
+    // editors loaded to jump to a line, save or rename symbols are not shown,
+    // they must be counted against the loaded editors limit too
+    if (mParentPageControl)
+        pMainWindow->editorList()->touchLoadedEditor(this);
+}
+
+void Editor::unloadContent()
+{
+    if (!mContentLoaded || mIsNew || modified() || isVisible())
+        return;
+    mDeferredViewState = viewState();
+    mContentLoaded = false;
+    mSyntaxIssues.clear();
+#ifdef ENABLE_VCS
+    stopLineChangeBaseProcess();
+    mLineChangeTracker.clear();
+#endif
+    clearAll();
+}
+
+Editor::ViewState Editor::viewState() const
+{
+    if (!mContentLoaded)
+        return mDeferredViewState;
+    ViewState state;
+    state.caretX = caretX();
+    state.caretY = caretY();
+    state.topLine = topLine();
+    state.leftPos = leftPos();
+    return state;
+}
+
+void Editor::setViewState(const ViewState &state)
+{
+    if (!mContentLoaded) {
+        mDeferredViewState = state;
+        return;
+    }
+    setCaretXY(QSynedit::BufferCoord{state.caretX, state.caretY});
+    setTopLine(state.topLine);
+    setLeftPos(state.leftPos);
+}
+
 void Editor::saveFile(QString filename) {
-    QFile file(filename);
 //    QByteArray encoding = mFileEncoding;
 //    if (mEncodingOption != ENCODING_AUTO_DETECT || mFileEncoding==ENCODING_ASCII)
 //        encoding = mEncodingOption;
@@ -321,9 +427,92 @@ void Editor::saveFile(QString filename) {
 //                              QMessageBox::Yes | QMessageBox::No,QMessageBox::No)!=QMessageBox::Yes)
 //            return;
 //    }
-    this->document()->saveToFile(file,encoding,
+    this->document()->saveToFile(filename,encoding,
                               pSettings->editor().defaultEncoding(),
                               mFileEncoding);
+    onFileSaved(filename);
+//    QFile::remove(backupFilename);
+}
+
+namespace {
+class BackgroundSaveTask: public QRunnable {
+public:
+    using FinishedCallback = std::function<void (const QByteArray& realEncoding, const QString& error)>;
+    BackgroundSaveTask(const QString& filename, const QStringList& lines, const QString& lineBreak,
+                       const QByteArray& encoding, const QByteArray& defaultEncoding,
+                       const FinishedCallback& onFinished):
+        mFilename{filename}, mLines{lines}, mLineBreak{lineBreak},
+        mEncoding{encoding}, mDefaultEncoding{defaultEncoding}, mOnFinished{onFinished} {}
+    void run() override {
+        QByteArray realEncoding;
+        QString error;
+        try {
+            QSynedit::saveLinesToFile(mFilename, mLines, mLineBreak,
+                                      mEncoding, mDefaultEncoding, realEncoding);
+        } catch (FileError& e) {
+            error = e.reason();
+        }
+        FinishedCallback onFinished = mOnFinished;
+        QMetaObject::invokeMethod(qApp, [onFinished, realEncoding, error](){
+            onFinished(realEncoding, error);
+        }, Qt::QueuedConnection);
+    }
+private:
+    QString mFilename;
+    QStringList mLines;
+    QString mLineBreak;
+    QByteArray mEncoding;
+    QByteArray mDefaultEncoding;
+    FinishedCallback mOnFinished;
+};
+}
+
+static QThreadPool* backgroundSavePool()
+{
+    static QThreadPool pool;
+    // one thread, so the writes to a file keep their order
+    if (pool.maxThreadCount() != 1)
+        pool.setMaxThreadCount(1);
+    return &pool;
+}
+
+void Editor::saveFileInBackground(const QString &filename)
+{
+    // lines are implicitly shared, so the snapshot is cheap
+    QStringList lines = document()->contents();
+    QPointer<Editor> editor(this);
+    mPendingBackgroundSaves++;
+    backgroundSavePool()->start(new BackgroundSaveTask(
+                                    filename, lines, document()->lineBreak(),
+                                    mEncodingOption, pSettings->editor().defaultEncoding(),
+                                    [editor, filename](const QByteArray& realEncoding, const QString& error) {
+        if (editor) {
+            editor->onBackgroundSaveFinished(filename, realEncoding, error);
+        } else if (!error.isEmpty()) {
+            QMessageBox::critical(pMainWindow,tr("Error"), error);
+        }
+    }));
+}
+
+void Editor::onBackgroundSaveFinished(const QString &filename, const QByteArray &realEncoding, const QString &error)
+{
+    // our own writes are not reported as external changes,
+    // so don't watch the file until the last pending write is done
+    mPendingBackgroundSaves--;
+    if (filename == mFilename && mPendingBackgroundSaves == 0)
+        pMainWindow->fileSystemWatcher()->addPath(mFilename);
+    if (!error.isEmpty()) {
+        setModified(true);
+        updateCaption();
+        QMessageBox::critical(pMainWindow,tr("Error"), error);
+        return;
+    }
+    mFileEncoding = realEncoding;
+    onFileSaved(filename);
+}
+
+void Editor::onFileSaved(const QString &filename)
+{
     if (mProject) {
         PProjectUnit unit = mProject->findUnit(this);
         if (unit) {
@@ -333,7 +522,13 @@ void Editor::saveFile(QString filename) {
     if (isVisible() && mParentPageControl)
         pMainWindow->updateForEncodingInfo(this);
     emit fileSaved(filename, inProject());
-//    QFile::remove(backupFilename);
+}
+
+void Editor::waitForBackgroundSaves()
+{
+    backgroundSavePool()->waitForDone();
+    // report the results
+    QCoreApplication::sendPostedEvents(qApp, QEvent::MetaCall);
 }
 
 void Editor::convertToEncoding(const QByteArray &encoding)
@@ -351,9 +546,24 @@ void Editor::convertToEncoding(const QByteArray &encoding)
 }
 
 bool Editor::save(bool force, bool doReparse) {
+    return doSave(force, doReparse, false);
+}
+
+bool Editor::saveInBackground()
+{
+    return doSave(false, true, true);
+}
+
+bool Editor::doSave(bool force, bool doReparse, bool inBackground)
+{
+    // an unloaded editor is empty, it would overwrite the file
+    loadContent();
     if (this->mIsNew && !force) {
         return saveAs();
-    }    
+    }
+    // writes to the file must keep their order
+    if (!inBackground)
+        waitForBackgroundSaves();
 
     pMainWindow->fileSystemWatcher()->removePath(mFilename);
     try {
@@ -362,11 +572,20 @@ bool Editor::save(bool force, bool doReparse) {
         } else if (pSettings->editor().removeTrailingSpacesWhenSaved()) {
             trimTrailingSpaces();
         }
-        saveFile(mFilename);
-        pMainWindow->fileSystemWatcher()->addPath(mFilename);
+        if (inBackground) {
+            // the path is watched again after it's written
+            saveFileInBackground(mFilename);
+        } else {
+            saveFile(mFilename);
+            pMainWindow->fileSystemWatcher()->addPath(mFilename);
+        }
         setModified(false);
         mIsNew = false;
         updateCaption();
+#ifdef ENABLE_VCS
+        // the file may have been staged since it's loaded
+        updateLineChangeBase();
+#endif
     } catch (FileError& exception) {
         if (!force) {
             QMessageBox::critical(pMainWindow,tr("Error"),
@@ -387,6 +606,10 @@ bool Editor::save(bool force, bool doReparse) {
 }
 
 bool Editor::saveAs(const QString &name, bool fromProject){
+    // an unloaded editor is empty, it would overwrite the file
+    loadContent();
+    // writes to the file must keep their order
+    waitForBackgroundSaves();
     QString newName = name;
     QString oldName = mFilename;
     bool firstSave = isNew();
@@ -541,17 +764,20 @@ void Editor::setEncodingOption(const QByteArray& encoding) noexcept{
     if (mEncodingOption == newEncoding)
         return;
     mEncodingOption = newEncoding;
-    if (!isNew()) {
-        try {
-            loadFile();
-        } catch (FileError& e) {
-            QMessageBox::critical(nullptr,
-                                  tr("Error Load File"),
-                                  e.reason());
-        }
-    } else if (mParentPageControl)
-        pMainWindow->updateForEncodingInfo(this);
-    resolveAutoDetectEncodingOption();
+    //if the content is not loaded yet, the new encoding is used when loading it
+    if (mContentLoaded) {
+        if (!isNew()) {
+            try {
+                loadFile();
+            } catch (FileError& e) {
+                QMessageBox::critical(nullptr,
+                                      tr("Error Load File"),
+                                      e.reason());
+            }
+        } else if (mParentPageControl)
+            pMainWindow->updateForEncodingInfo(this);
+        resolveAutoDetectEncodingOption();
+    }
     if (mProject) {
         PProjectUnit unit = mProject->findUnit(this);
         if (unit) {
@@ -723,6 +949,9 @@ void Editor::keyPressEvent(QKeyEvent *event)
     }
     if (readOnly())
         return;
+    // keys are applied at all the carets by QSynEdit
+    if (hasExtraCarets())
+        return;
 
     switch (event->key()) {
     case Qt::Key_Return:
@@ -1098,6 +1327,29 @@ void Editor::mouseMoveEvent(QMouseEvent *event)
 
 void Editor::onGutterPaint(QPainter &painter, int aLine, int X, int Y)
 {
+#ifdef ENABLE_VCS
+    switch(mLineChangeTracker.lineChange(aLine-1)) {
+    case LineChangeType::Added:
+        painter.fillRect(0,Y,3,textHeight(),QColor(0x2e,0xa0,0x43));
+        break;
+    case LineChangeType::Modified:
+        painter.fillRect(0,Y,3,textHeight(),QColor(0x1f,0x6f,0xeb));
+        break;
+    case LineChangeType::Deleted: {
+        QPolygon triangle;
+        triangle << QPoint(0,Y-4) << QPoint(5,Y) << QPoint(0,Y+4);
+        painter.save();
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(QColor(0xcf,0x22,0x2e));
+        painter.drawPolygon(triangle);
+        painter.restore();
+        break;
+    }
+    default:
+        break;
+    }
+#endif
+
     IconsManager::PPixmap icon;
 
     if (mActiveBreakpointLine == aLine) {
@@ -1131,6 +1383,95 @@ void Editor::onGutterPaint(QPainter &painter, int aLine, int X, int Y)
     }
 }
 
+#ifdef ENABLE_VCS
+void Editor::updateLineChangeBase()
+{
+    stopLineChangeBaseProcess();
+    mLineChangeTracker.clear();
+    invalidateGutter();
+    if (mIsNew || !pSettings->vcs().gitOk())
+        return;
+    // git is run in background, the base is set when it's finished
+    GitManager manager;
+    QProcess* process = manager.startFileIndexContent(QFileInfo(mFilename), this);
+    if (!process)
+        return;
+    mLineChangeBaseProcess = process;
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+        if (process != mLineChangeBaseProcess)
+            return;
+        mLineChangeBaseProcess = nullptr;
+        process->deleteLater();
+        if (exitStatus == QProcess::NormalExit && exitCode == 0)
+            setLineChangeBase(process->readAllStandardOutput());
+    });
+    connect(process, &QProcess::errorOccurred,
+            this, [this, process](QProcess::ProcessError error) {
+        // no finished() is emitted if it's not started
+        if (error != QProcess::FailedToStart || process != mLineChangeBaseProcess)
+            return;
+        mLineChangeBaseProcess = nullptr;
+        process->deleteLater();
+    });
+}
+
+void Editor::setLineChangeBase(const QByteArray &content)
+{
+    QTextCodec* codec;
+    if (mFileEncoding == ENCODING_UTF8_BOM || mFileEncoding == ENCODING_ASCII)
+        codec = QTextCodec::codecForName(ENCODING_UTF8);
+    else if (mFileEncoding == ENCODING_SYSTEM_DEFAULT)
+        codec = QTextCodec::codecForLocale();
+    else
+        codec = QTextCodec::codecForName(mFileEncoding);
+    if (!codec)
+        return;
+    // lines edited while git is running are in the current contents
+    mLineChangeTracker.setBase(textToLines(codec->toUnicode(content)),
+                               document()->contents());
+    invalidateGutter();
+}
+
+void Editor::stopLineChangeBaseProcess()
+{
+    if (!mLineChangeBaseProcess)
+        return;
+    QProcess* process = mLineChangeBaseProcess;
+    mLineChangeBaseProcess = nullptr;
+    process->disconnect(this);
+    process->kill();
+    process->deleteLater();
+}
+
+void Editor::onDocumentLinesInserted(int line, int count)
+{
+    if (!mLineChangeTracker.isActive())
+        return;
+    QStringList texts;
+    for (int i=line;i<line+count;i++)
+        texts.append(document()->getLine(i));
+    mLineChangeTracker.linesInserted(line, texts);
+    invalidateGutter();
+}
+
+void Editor::onDocumentLinesDeleted(int line, int count)
+{
+    if (!mLineChangeTracker.isActive())
+        return;
+    mLineChangeTracker.linesDeleted(line, count);
+    invalidateGutter();
+}
+
+void Editor::onDocumentLinePutted(int line)
+{
+    if (!mLineChangeTracker.isActive())
+        return;
+    mLineChangeTracker.lineChanged(line, document()->getLine(line));
+    invalidateGutter();
+}
+#endif
+
 void setIncludeUnderline(const QString& lineText, int startPos,
                   const QChar& quoteEndChar,
                   QSynedit::PSyntaxer syntaxer,
@@ -1480,6 +1821,9 @@ void Editor::closeEvent(QCloseEvent *)
 
 void Editor::showEvent(QShowEvent */*event*/)
 {
+    loadContent();
+    if (mParentPageControl)
+        pMainWindow->editorList()->touchLoadedEditor(this);
 //    if (pSettings->codeCompletion().clearWhenEditorHidden()
 //            && !inProject()) {
 ////        initParser();
@@ -1640,12 +1984,14 @@ void Editor::copyAsHTML()
 
 void Editor::setCaretPosition(int line, int aChar)
 {
+    loadContent();
     this->uncollapseAroundLine(line);
     this->setCaretXYCentered(QSynedit::BufferCoord{aChar,line});
 }
 
 void Editor::setCaretPositionAndActivate(int line, int aChar)
 {
+    loadContent();
     this->uncollapseAroundLine(line);
     if (!this->hasFocus())
         this->activate();
@@ -1945,6 +2291,8 @@ void Editor::onTipEvalValueReady(const QString& value)
 
 void Editor::onLinesDeleted(int first, int count)
 {
+    if (!mContentLoaded)
+        return;
     pMainWindow->caretList().linesDeleted(this,first,count);
     pMainWindow->debugger()->breakpointModel()->onFileDeleteLines(mFilename,first,count,inProject());
     pMainWindow->bookmarkModel()->onFileDeleteLines(mFilename,first,count, inProject());
@@ -1957,6 +2305,8 @@ void Editor::onLinesDeleted(int first, int count)
 
 void Editor::onLinesInserted(int first, int count)
 {
+    if (!mContentLoaded)
+        return;
     pMainWindow->caretList().linesInserted(this,first,count);
     pMainWindow->debugger()->breakpointModel()->onFileInsertLines(mFilename,first,count, inProject());
     pMainWindow->bookmarkModel()->onFileInsertLines(mFilename,first,count, inProject());
@@ -5036,16 +5386,59 @@ void Editor::reformat(bool doReparse)
 {
     if (readOnly())
         return;
+    QStringList formattedLines;
+    if (!runFormatter(formattedLines))
+        return;
+    applyFormattedLines(formattedLines, QVector<bool>(), doReparse);
+}
+
+void Editor::reformatSelection()
+{
+    if (readOnly())
+        return;
+    QVector<bool> linesToFormat(document()->count(), false);
+    if (selAvail()) {
+        int first = blockBegin().line-1;
+        int last = blockEnd().line-1;
+        // the selection ends at the line break before the last line
+        if (last > first && blockEnd().ch == 1)
+            last--;
+        for (int i=first;i<=last;i++)
+            linesToFormat[i] = true;
+    } else {
+        bool found = false;
+#ifdef ENABLE_VCS
+        // format the lines changed against git
+        if (mLineChangeTracker.isActive()) {
+            for (int i=0;i<linesToFormat.count();i++) {
+                if (mLineChangeTracker.lineChange(i) != LineChangeType::Unchanged) {
+                    linesToFormat[i] = true;
+                    found = true;
+                }
+            }
+        }
+#endif
+        if (!found)
+            linesToFormat[caretY()-1] = true;
+    }
+    // astyle can't format a range, so the whole file is formatted for the context,
+    // and only the changes in the lines to format are applied
+    QStringList formattedLines;
+    if (!runFormatter(formattedLines))
+        return;
+    applyFormattedLines(formattedLines, linesToFormat, true);
+}
+
+bool Editor::runFormatter(QStringList &formattedLines)
+{
 #ifndef Q_OS_WIN
     if (!fileExists(pSettings->environment().AStylePath())) {
         QMessageBox::critical(this,
                               tr("astyle not found"),
                               tr("Can't find astyle in \"%1\".").arg(pSettings->environment().AStylePath()));
-        return;
+        return false;
     }
 #endif
-    //we must remove all breakpoints and syntax issues
-//    onLinesDeleted(1,document()->count());
     QByteArray content = text().toUtf8();
     QStringList args = pSettings->codeFormatter().getArguments();
     //qDebug()<<args;
@@ -5061,20 +5454,99 @@ void Editor::reformat(bool doReparse)
                                             content);
 #endif
     if (newContent.isEmpty())
+        return false;
+    // split the same way as setSelText(), so unchanged lines compare equal
+    formattedLines = QSynedit::splitStrings(QString::fromUtf8(newContent));
+    return true;
+}
+
+void Editor::applyFormattedLines(const QStringList &formattedLines, const QVector<bool> &linesToFormat, bool doReparse)
+{
+    // Only the changed lines are replaced, so the breakpoints, bookmarks, folds
+    // and syntax issues on the other lines are kept, and the undo item is small.
+    QStringList oldLines = document()->contents();
+    QVector<LineDiffHunk> hunks = diffLines(oldLines, formattedLines);
+    if (!linesToFormat.isEmpty()) {
+        QVector<LineDiffHunk> selectedHunks;
+        foreach (const LineDiffHunk& hunk, hunks) {
+            // lines are inserted between the two lines around them
+            int start = (hunk.baseCount == 0) ? std::max(hunk.baseStart - 1, 0) : hunk.baseStart;
+            int end = std::min(hunk.baseStart + std::max(hunk.baseCount, 1), linesToFormat.count());
+            for (int i=start;i<end;i++) {
+                if (linesToFormat[i]) {
+                    selectedHunks.append(hunk);
+                    break;
+                }
+            }
+        }
+        hunks = selectedHunks;
+    }
+    if (hunks.isEmpty())
         return;
+
+    // 0-based line of the old text -> line after the hunks are applied
+    auto mapLine = [&hunks](int line) {
+        int delta = 0;
+        foreach (const LineDiffHunk& hunk, hunks) {
+            if (hunk.baseStart > line)
+                break;
+            if (line < hunk.baseStart + hunk.baseCount)
+                return hunk.baseStart + delta + std::min(line - hunk.baseStart, std::max(hunk.count - 1, 0));
+            delta += hunk.count - hunk.baseCount;
+        }
+        return line + delta;
+    };
     int oldTopLine = topLine();
-    QSynedit::BufferCoord mOldCaret = caretXY();
+    QSynedit::BufferCoord oldCaret = caretXY();
 
     beginEditing();
+    // the hunks are reparsed once, from the first changed line
+    deferReparse();
     addLeftTopToUndo();
     addCaretToUndo();
+    addSelectionToUndo();
 
     QSynedit::EditorOptions oldOptions = getOptions();
     QSynedit::EditorOptions newOptions = oldOptions;
     newOptions.setFlag(QSynedit::EditorOption::eoAutoIndent,false);
     setOptions(newOptions);
-    replaceAll(QString::fromUtf8(newContent));
-    setCaretXY(mOldCaret);
+    // from the bottom up, so the old line numbers of the hunks stay valid
+    for (int i=hunks.count()-1;i>=0;i--) {
+        const LineDiffHunk& hunk = hunks[i];
+        int baseEnd = hunk.baseStart + hunk.baseCount;
+        QStringList newLines = formattedLines.mid(hunk.start, hunk.count);
+        QSynedit::BufferCoord selBegin;
+        QSynedit::BufferCoord selEnd;
+        if (hunk.baseCount > 0 && hunk.count > 0) {
+            selBegin = QSynedit::BufferCoord{1, hunk.baseStart+1};
+            selEnd = QSynedit::BufferCoord{oldLines[baseEnd-1].length()+1, baseEnd};
+        } else if (hunk.baseCount == 0) {
+            if (hunk.baseStart < oldLines.count()) {
+                // insert before the line
+                selBegin = QSynedit::BufferCoord{1, hunk.baseStart+1};
+                newLines.append("");
+            } else {
+                // append after the last line
+                selBegin = QSynedit::BufferCoord{oldLines.last().length()+1, oldLines.count()};
+                newLines.prepend("");
+            }
+            selEnd = selBegin;
+        } else if (baseEnd < oldLines.count() || hunk.baseStart == 0) {
+            // delete the lines with the line break after them
+            selBegin = QSynedit::BufferCoord{1, hunk.baseStart+1};
+            if (baseEnd < oldLines.count())
+                selEnd = QSynedit::BufferCoord{1, baseEnd+1};
+            else
+                selEnd = QSynedit::BufferCoord{oldLines[baseEnd-1].length()+1, baseEnd};
+        } else {
+            // delete the last lines with the line break before them
+            selBegin = QSynedit::BufferCoord{oldLines[hunk.baseStart-1].length()+1, hunk.baseStart};
+            selEnd = QSynedit::BufferCoord{oldLines[baseEnd-1].length()+1, baseEnd};
+        }
+        setCaretAndSelection(selBegin, selBegin, selEnd);
+        setSelText(newLines.join("\n"));
+    }
+    setCaretXY(QSynedit::BufferCoord{oldCaret.ch, mapLine(oldCaret.line-1)+1});
     setTopLine(oldTopLine);
     setOptions(oldOptions);
     endEditing();
@@ -5250,6 +5722,7 @@ void Editor::applySettings()
     options.setFlag(QSynedit::eoHideShowScrollbars,pSettings->editor().autoHideScrollbar());
     options.setFlag(QSynedit::eoScrollPastEol,pSettings->editor().scrollPastEol());
     options.setFlag(QSynedit::eoScrollPastEof,pSettings->editor().scrollPastEof());
+    options.setFlag(QSynedit::eoWrapLines,pSettings->editor().wrapLines());
     options.setFlag(QSynedit::eoScrollByOneLess,pSettings->editor().scrollByOneLess());
     options.setFlag(QSynedit::eoHalfPageScroll,pSettings->editor().halfPageScroll());
     options.setFlag(QSynedit::eoHalfPageScroll,pSettings->editor().halfPageScroll());
@@ -5344,10 +5817,30 @@ void Editor::applySettings()
 
     setMouseWheelScrollSpeed(pSettings->editor().mouseWheelScrollSpeed());
     setMouseSelectionScrollSpeed(pSettings->editor().mouseSelectionScrollSpeed());
+
+    if (pSettings->editor().showMiniMap()) {
+        if (!miniMap()) {
+            setMiniMap(new QSynedit::MiniMap(this));
+            updateMiniMapSyntaxer(pSettings->editor().colorScheme());
+        }
+    } else {
+        setMiniMap(nullptr);
+    }
     invalidate();
     decPaintLock();
 }
 
+void Editor::updateMiniMapSyntaxer(const QString &schemeName)
+{
+    if (!miniMap())
+        return;
+    // the minimap highlights in its own thread, so it can't share our syntaxer
+    QSynedit::PSyntaxer hl = syntaxerManager.copy(syntaxer());
+    if (hl)
+        syntaxerManager.applyColorScheme(hl,schemeName);
+    miniMap()->setSyntaxer(hl);
+}
+
 static QSynedit::PTokenAttribute createRainbowAttribute(const QString& attrName, const QString& schemeName, const QString& schemeItemName) {
     PColorSchemeItem item = pColorManager->getItem(schemeName,schemeItemName);
     if (item) {
@@ -5442,6 +5935,7 @@ void Editor::applyColorScheme(const QString& schemeName)
         mCurrentHighlighWordForeground = selectedForeground();
         mCurrentHighlighWordBackground = selectedBackground();
     }
+    updateMiniMapSyntaxer(schemeName);
 
     this->invalidate();
 }
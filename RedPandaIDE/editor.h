@@ -26,6 +26,9 @@
 #include "parser/cppparser.h"
 #include "widgets/codecompletionpopup.h"
 #include "widgets/headercompletionpopup.h"
+#ifdef ENABLE_VCS
+#include "vcs/linechangetracker.h"
+#endif
 
 #define USER_CODE_IN_INSERT_POS "%INSERT%"
 #define USER_CODE_IN_REPL_POS_BEGIN "%REPL_BEGIN%"
@@ -38,6 +41,7 @@ struct TabStop {
     int y;
 };
 
+class QProcess;
 class QTemporaryFile;
 
 using PTabStop = std::shared_ptr<TabStop>;
@@ -122,11 +126,19 @@ public:
     using SyntaxIssueList = QVector<PSyntaxIssue>;
     using PSyntaxIssueList = std::shared_ptr<SyntaxIssueList>;
 
+    struct ViewState {
+        int caretX;
+        int caretY;
+        int topLine;
+        int leftPos;
+    };
+
     explicit Editor(QWidget *parent);
 
     explicit Editor(QWidget *parent, const QString& filename,
                     const QByteArray& encoding,
-                    Project* pProject, bool isNew,QTabWidget* parentPageControl);
+                    Project* pProject, bool isNew,QTabWidget* parentPageControl,
+                    bool deferLoad=false);
 
     ~Editor();
 
@@ -147,7 +159,14 @@ public:
 
     void loadFile(QString filename = "");
     void saveFile(QString filename);
+    bool contentLoaded() const;
+    void loadContent();
+    void unloadContent();
+    ViewState viewState() const;
+    void setViewState(const ViewState& state);
     bool save(bool force=false, bool reparse=true);
+    // the file is written by a worker thread, and errors are reported when it's done
+    bool saveInBackground();
     bool saveAs(const QString& name="", bool fromProject = false);
     void activate();
 
@@ -187,6 +206,7 @@ public:
     QString getPreviousWordAtPositionForSuggestion(const QSynedit::BufferCoord& p);
     QString getPreviousWordAtPositionForCompleteFunctionDefinition(const QSynedit::BufferCoord& p);
     void reformat(bool doReparse=true);
+    void reformatSelection();
     void checkSyntaxInBack();
     void gotoDeclaration(const QSynedit::BufferCoord& pos);
     void gotoDefinition(const QSynedit::BufferCoord& pos);
@@ -225,6 +245,8 @@ public:
     void tab() override;
 
     static PCppParser sharedParser(ParserLanguage language);
+    // wait until the files saved in background are written
+    static void waitForBackgroundSaves();
 
 signals:
     void renamed(const QString& oldName, const QString& newName, bool firstSave);
@@ -241,7 +263,12 @@ private slots:
     void onEndParsing();
 
 private:
+    bool doSave(bool force, bool doReparse, bool inBackground);
+    void saveFileInBackground(const QString& filename);
+    void onBackgroundSaveFinished(const QString& filename, const QByteArray& realEncoding, const QString& error);
+    void onFileSaved(const QString& filename);
     void resolveAutoDetectEncodingOption();
+    void updateMiniMapSyntaxer(const QString& schemeName);
     bool isBraceChar(QChar ch);
     bool shouldOpenInReadonly();
     QChar getCurrentChar();
@@ -269,6 +296,11 @@ private:
     void showCompletion(const QString& preWord, bool autoComplete, CodeCompletionType type);
     void showHeaderCompletion(bool autoComplete, bool forceShow=false);
 
+    bool runFormatter(QStringList& formattedLines);
+    void applyFormattedLines(const QStringList& formattedLines,
+                             const QVector<bool>& linesToFormat,
+                             bool doReparse);
+
     void initAutoBackup();
     void saveAutoBackup();
     void cleanAutoBackup();
@@ -300,9 +332,24 @@ private:
     void onScrollBarValueChanged();
     void updateHoverLink(int line);
     void cancelHoverLink();
+#ifdef ENABLE_VCS
+    void updateLineChangeBase();
+    void setLineChangeBase(const QByteArray& content);
+    void stopLineChangeBaseProcess();
+    void onDocumentLinesInserted(int line, int count);
+    void onDocumentLinesDeleted(int line, int count);
+    void onDocumentLinePutted(int line);
+#endif
 
 private:
     bool mInited;
+    bool mContentLoaded;
+#ifdef ENABLE_VCS
+    LineChangeTracker mLineChangeTracker;
+    // reads the base of mLineChangeTracker from git in background
+    QProcess* mLineChangeBaseProcess;
+#endif
+    ViewState mDeferredViewState;
     QDateTime mBackupTime;
     QFile* mBackupFile;
     QByteArray mEncodingOption; // the encoding type set by the user
@@ -338,6 +385,8 @@ private:
     QDateTime mHideTime;
 
     bool mSaving;
+    // background saves not finished yet, the file is watched again after the last one
+    int mPendingBackgroundSaves;
     bool mCurrentLineModified;
     int mXOffsetSince;
     int mTabStopBegin;
@@ -44,7 +44,7 @@ EditorList::EditorList(QTabWidget* leftPageWidget,
 
 Editor* EditorList::newEditor(const QString& filename, const QByteArray& encoding,
                  Project *pProject, bool newFile,
-                 QTabWidget* page) {
+                 QTabWidget* page, bool deferLoad) {
     QTabWidget * parentPageControl = nullptr;
     if (page == nullptr)
         parentPageControl = getNewEditorPageControl();
@@ -55,7 +55,10 @@ Editor* EditorList::newEditor(const QString& filename, const QByteArray& encodin
     }
 
     // parentPageControl takes the owner ship
-    Editor * e = new Editor(parentPageControl,filename,encoding,pProject,newFile,parentPageControl);
+    Editor * e = new Editor(parentPageControl,filename,encoding,pProject,newFile,parentPageControl,deferLoad);
+    mEditorIndex.insert(filenameKey(e->filename()),e);
+    if (e->contentLoaded() && !mLoadedEditors.contains(e))
+        mLoadedEditors.append(e);
     connect(e, &Editor::renamed, this, &EditorList::onEditorRenamed);
     updateLayout();
     connect(e,&Editor::fileSaved,
@@ -122,12 +125,28 @@ void EditorList::doRemoveEditor(Editor *e)
     pMainWindow->fileSystemWatcher()->removePath(e->filename());
     pMainWindow->caretList().removeEditor(e);
     pMainWindow->updateCaretActions();
+    if (mEditorIndex.value(filenameKey(e->filename()))==e)
+        mEditorIndex.remove(filenameKey(e->filename()));
+    mLoadedEditors.removeOne(e);
     e->setParent(nullptr);
     delete e;
 }
 
+QString EditorList::filenameKey(const QString &filename)
+{
+    if (PATH_SENSITIVITY == Qt::CaseInsensitive)
+        return filename.toLower();
+    return filename;
+}
+
 void EditorList::onEditorRenamed(const QString &oldFilename, const QString &newFilename, bool firstSave)
 {
+    Editor* e = qobject_cast<Editor*>(sender());
+    if (e) {
+        if (mEditorIndex.value(filenameKey(oldFilename))==e)
+            mEditorIndex.remove(filenameKey(oldFilename));
+        mEditorIndex.insert(filenameKey(newFilename),e);
+    }
     emit editorRenamed(oldFilename, newFilename, firstSave);
 }
 
@@ -319,17 +338,8 @@ bool EditorList::isFileOpened(const QString &fullfilepath) const
 {
     QFileInfo fileInfo(fullfilepath);
     QString filename = fileInfo.absoluteFilePath();
-    for (int i=0;i<mLeftPageWidget->count();i++) {
-        Editor* e = static_cast<Editor*>(mLeftPageWidget->widget(i));
-        if (e->filename().compare(filename)==0 || e->filename().compare(fullfilepath)==0)
-            return true;
-    }
-    for (int i=0;i<mRightPageWidget->count();i++) {
-        Editor* e = static_cast<Editor*>(mRightPageWidget->widget(i));
-        if (e->filename().compare(filename)==0 || e->filename().compare(fullfilepath)==0)
-            return true;
-    }
-    return false;
+    return mEditorIndex.contains(filenameKey(filename))
+            || mEditorIndex.contains(filenameKey(fullfilepath));
 }
 
 bool EditorList::hasFilename(const QString &filename) const
@@ -439,23 +449,7 @@ Editor* EditorList::getOpenedEditorByFilename(QString filename) const
 {
     if (filename.isEmpty())
         return nullptr;
-    for (int i=0;i<mLeftPageWidget->count();i++) {
-        Editor* e = static_cast<Editor*>(mLeftPageWidget->widget(i));
-        if (!e)
-            continue;
-        if (e->filename().compare(filename, PATH_SENSITIVITY)==0) {
-            return e;
-        }
-    }
-    for (int i=0;i<mRightPageWidget->count();i++) {
-        Editor* e = static_cast<Editor*>(mRightPageWidget->widget(i));
-        if (!e)
-            continue;
-        if (e->filename().compare(filename)==0) {
-            return e;
-        }
-    }
-    return nullptr;
+    return mEditorIndex.value(filenameKey(filename),nullptr);
 }
 
 bool EditorList::getContentFromOpenedEditor(const QString &filename, QStringList &buffer) const
@@ -463,12 +457,33 @@ bool EditorList::getContentFromOpenedEditor(const QString &filename, QStringList
     if (pMainWindow->isQuitting())
         return false;
     Editor * e= getOpenedEditorByFilename(filename);
-    if (!e)
+    //content of editors not loaded yet is the same as the file on disk
+    if (!e || !e->contentLoaded())
         return false;
     buffer = e->contents();
     return true;
 }
 
+void EditorList::touchLoadedEditor(Editor *editor)
+{
+    if (!editor->contentLoaded())
+        return;
+    mLoadedEditors.removeOne(editor);
+    mLoadedEditors.prepend(editor);
+    int maxLoaded = pSettings->editor().maxLoadedEditors();
+    if (maxLoaded<=0)
+        return;
+    for (int i=mLoadedEditors.count()-1;i>=0 && mLoadedEditors.count()>maxLoaded;i--) {
+        Editor* e = mLoadedEditors[i];
+        if (e == editor)
+            continue;
+        //modified, new and visible editors are kept
+        e->unloadContent();
+        if (!e->contentLoaded())
+            mLoadedEditors.removeAt(i);
+    }
+}
+
 void EditorList::getVisibleEditors(Editor *&left, Editor *&right) const
 {
     switch(mLayout) {
@@ -41,7 +41,7 @@ public:
 
     Editor* newEditor(const QString& filename, const QByteArray& encoding,
                      Project *pProject, bool newFile,
-                     QTabWidget* page=nullptr);
+                     QTabWidget* page=nullptr, bool deferLoad=false);
 
     Editor* getEditor(int index=-1, QTabWidget* tabsWidget=nullptr) const;
 
@@ -64,6 +64,8 @@ public:
 
     bool getContentFromOpenedEditor(const QString& filename, QStringList& buffer) const;
 
+    void touchLoadedEditor(Editor* editor);
+
     void getVisibleEditors(Editor*& left, Editor*& right) const;
     void updateLayout();
 
@@ -92,6 +94,7 @@ private:
     QTabWidget* getFocusedPageControl() const;
     void showLayout(LayoutShowType layout);
     void doRemoveEditor(Editor* e);
+    static QString filenameKey(const QString& filename);
 private slots:
     void onEditorRenamed(const QString& oldFilename, const QString& newFilename, bool firstSave);
 private:
@@ -101,6 +104,9 @@ private:
     QSplitter *mSplitter;
     QWidget *mPanel;
     int mUpdateCount;
+    QHash<QString, Editor*> mEditorIndex;
+    //loaded editors, the most recently shown first
+    QList<Editor*> mLoadedEditors;
 };
 
 #endif // EDITORLIST_H
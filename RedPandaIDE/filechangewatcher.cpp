@@ -0,0 +1,438 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "filechangewatcher.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include "qt_utils/utils.h"
+
+#ifdef Q_OS_LINUX
+#include <QMutex>
+#include <QThread>
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// events in this interval are reported together
+static const int DebounceInterval = 200;
+// changes are reported at least once in this interval, during a long burst
+static const int MaxReportDelay = 1000;
+
+void FileChangeSet::unite(const FileChangeSet &other)
+{
+    changed.unite(other.changed);
+    removed.unite(other.removed);
+    overflowed = overflowed || other.overflowed;
+}
+
+#ifdef Q_OS_LINUX
+
+static const uint32_t WatchMask = IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE
+        | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+static bool isUnder(const QString& path, const QString& dir)
+{
+    return path == dir || path.startsWith(includeTrailingPathDelimiter(dir));
+}
+
+/**
+ * @brief Reads the inotify events.
+ *
+ * Watches are added and removed in the thread too, so walking a large
+ * directory tree doesn't block the GUI.
+ */
+class InotifyThread: public QThread {
+public:
+    explicit InotifyThread(FileChangeWatcher* watcher):
+        mWatcher{watcher},
+        mStopping{false} {
+        mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        mWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    ~InotifyThread() {
+        stop();
+        wait();
+        if (mFd >= 0)
+            close(mFd);
+        if (mWakeFd >= 0)
+            close(mWakeFd);
+    }
+    bool isValid() const {
+        return mFd >= 0 && mWakeFd >= 0;
+    }
+    void watchDirectory(const QString& dir, bool recursive) {
+        addRequest(Request{dir, recursive, true});
+    }
+    void unwatchDirectory(const QString& dir, bool recursive) {
+        addRequest(Request{dir, recursive, false});
+    }
+    void stop() {
+        {
+            QMutexLocker locker(&mMutex);
+            mStopping = true;
+        }
+        wake();
+    }
+protected:
+    void run() override {
+        pollfd fds[2];
+        fds[0].fd = mFd;
+        fds[0].events = POLLIN;
+        fds[1].fd = mWakeFd;
+        fds[1].events = POLLIN;
+        while (true) {
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            QStringList paths;
+            bool overflowed = false;
+            if (fds[1].revents & POLLIN) {
+                quint64 value;
+                while (read(mWakeFd, &value, sizeof(value)) > 0)
+                    ;
+                if (!handleRequests())
+                    return;
+            }
+            if (fds[0].revents & POLLIN)
+                readEvents(paths, overflowed);
+            if (!paths.isEmpty() || overflowed) {
+                FileChangeWatcher* watcher = mWatcher;
+                QMetaObject::invokeMethod(mWatcher, [watcher, paths, overflowed](){
+                    watcher->onPathsChanged(paths, overflowed);
+                }, Qt::QueuedConnection);
+            }
+        }
+    }
+private:
+    struct Request {
+        QString dir;
+        bool recursive;
+        bool add;
+    };
+
+    void addRequest(const Request& request) {
+        {
+            QMutexLocker locker(&mMutex);
+            mRequests.append(request);
+        }
+        wake();
+    }
+
+    void wake() {
+        quint64 value = 1;
+        if (mWakeFd >= 0 && write(mWakeFd, &value, sizeof(value)) < 0)
+            qWarning("Can't wake the inotify thread");
+    }
+
+    // false if the thread should stop
+    bool handleRequests() {
+        QList<Request> requests;
+        {
+            QMutexLocker locker(&mMutex);
+            if (mStopping)
+                return false;
+            requests.swap(mRequests);
+        }
+        foreach (const Request& request, requests) {
+            if (request.add) {
+                if (request.recursive)
+                    mRoots.insert(request.dir);
+                else
+                    mDirs.insert(request.dir);
+                addWatches(request.dir, request.recursive, nullptr);
+            } else {
+                if (request.recursive)
+                    mRoots.remove(request.dir);
+                else
+                    mDirs.remove(request.dir);
+                foreach (const QString& dir, mWatchOfDir.keys()) {
+                    if (isUnder(dir, request.dir) && !isNeeded(dir))
+                        inotify_rm_watch(mFd, mWatchOfDir.take(dir));
+                }
+            }
+        }
+        return true;
+    }
+
+    bool isNeeded(const QString& dir) const {
+        return mDirs.contains(dir) || isInRoots(dir);
+    }
+
+    bool isInRoots(const QString& dir) const {
+        foreach (const QString& root, mRoots) {
+            if (isUnder(dir, root))
+                return true;
+        }
+        return false;
+    }
+
+    // files found in the new directories are added to files
+    void addWatches(const QString& dir, bool recursive, QStringList* files) {
+        int wd = inotify_add_watch(mFd, QFile::encodeName(dir).constData(), WatchMask);
+        if (wd < 0) {
+            if (errno == ENOSPC)
+                qWarning("Inotify watch limit reached, '%s' is not watched", qPrintable(dir));
+            return;
+        }
+        mDirOfWatch.insert(wd, dir);
+        mWatchOfDir.insert(dir, wd);
+        if (!recursive)
+            return;
+        // hidden directories (like .git) and links are skipped
+        QDir directory(dir);
+        foreach (const QFileInfo& info, directory.entryInfoList(
+                     QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks)) {
+            if (info.isDir())
+                addWatches(info.absoluteFilePath(), true, files);
+            else if (files)
+                files->append(info.absoluteFilePath());
+        }
+    }
+
+    void readEvents(QStringList& paths, bool& overflowed) {
+        alignas(inotify_event) char buffer[64 * 1024];
+        while (true) {
+            ssize_t length = read(mFd, buffer, sizeof(buffer));
+            if (length <= 0)
+                break;
+            const char* p = buffer;
+            while (p < buffer + length) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    overflowed = true;
+                    continue;
+                }
+                auto it = mDirOfWatch.find(event->wd);
+                if (it == mDirOfWatch.end())
+                    continue;
+                QString dir = it.value();
+                if (event->mask & IN_IGNORED) {
+                    mDirOfWatch.erase(it);
+                    if (mWatchOfDir.value(dir, -1) == event->wd)
+                        mWatchOfDir.remove(dir);
+                    continue;
+                }
+                if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                    paths.append(dir);
+                    continue;
+                }
+                if (event->len == 0)
+                    continue;
+                QString path = includeTrailingPathDelimiter(dir) + QFile::decodeName(event->name);
+                if (event->mask & IN_ISDIR) {
+                    if ((event->mask & (IN_CREATE | IN_MOVED_TO))
+                            && !QFileInfo(path).isHidden() && isInRoots(path)) {
+                        // files may be created before the directory is watched
+                        addWatches(path, true, &paths);
+                    } else if (event->mask & IN_MOVED_FROM) {
+                        // the files in it are moved away without events
+                        overflowed = true;
+                    }
+                }
+                paths.append(path);
+            }
+        }
+    }
+private:
+    FileChangeWatcher* mWatcher;
+    int mFd;
+    int mWakeFd;
+    QMutex mMutex;
+    QList<Request> mRequests;
+    bool mStopping;
+    // used in the thread only
+    QHash<int, QString> mDirOfWatch;
+    QHash<QString, int> mWatchOfDir;
+    QSet<QString> mRoots;
+    QSet<QString> mDirs;
+};
+
+#endif
+
+FileChangeWatcher::FileChangeWatcher(QObject *parent) : QObject(parent),
+    mPendingOverflow{false}
+{
+    mDebounceTimer.setSingleShot(true);
+    mDebounceTimer.setInterval(DebounceInterval);
+    connect(&mDebounceTimer, &QTimer::timeout,
+            this, &FileChangeWatcher::reportChanges);
+#ifdef Q_OS_LINUX
+    mThread = new InotifyThread(this);
+    if (mThread->isValid())
+        mThread->start();
+    else
+        qWarning("Can't initialize inotify, file changes are not watched");
+#else
+    connect(&mWatcher, &QFileSystemWatcher::fileChanged,
+            this, [this](const QString& path) {
+        onPathsChanged(QStringList{path}, false);
+    });
+    connect(&mWatcher, &QFileSystemWatcher::directoryChanged,
+            this, [this](const QString& path) {
+        onPathsChanged(QStringList{path}, false);
+    });
+#endif
+}
+
+FileChangeWatcher::~FileChangeWatcher()
+{
+#ifdef Q_OS_LINUX
+    delete mThread;
+#endif
+}
+
+bool FileChangeWatcher::addPath(const QString &file)
+{
+    if (file.isEmpty() || mFiles.contains(file))
+        return false;
+    mFiles.insert(file, fileStamp(file));
+#ifdef Q_OS_LINUX
+    QString dir = QFileInfo(file).absolutePath();
+    if (mFileDirectories[dir]++ == 0)
+        mThread->watchDirectory(dir, false);
+#else
+    mWatcher.addPath(file);
+#endif
+    return true;
+}
+
+bool FileChangeWatcher::removePath(const QString &file)
+{
+    if (!mFiles.remove(file))
+        return false;
+#ifdef Q_OS_LINUX
+    QString dir = QFileInfo(file).absolutePath();
+    if (--mFileDirectories[dir] == 0) {
+        mFileDirectories.remove(dir);
+        mThread->unwatchDirectory(dir, false);
+    }
+#else
+    mWatcher.removePath(file);
+#endif
+    return true;
+}
+
+bool FileChangeWatcher::isWatching(const QString &file) const
+{
+    return mFiles.contains(file);
+}
+
+void FileChangeWatcher::addDirectory(const QString &dir)
+{
+    if (dir.isEmpty())
+        return;
+    if (mDirectories[dir]++ == 0) {
+#ifdef Q_OS_LINUX
+        mThread->watchDirectory(dir, true);
+#else
+        mWatcher.addPath(dir);
+#endif
+    }
+}
+
+void FileChangeWatcher::removeDirectory(const QString &dir)
+{
+    auto it = mDirectories.find(dir);
+    if (it == mDirectories.end())
+        return;
+    if (--it.value() == 0) {
+        mDirectories.erase(it);
+#ifdef Q_OS_LINUX
+        mThread->unwatchDirectory(dir, true);
+#else
+        mWatcher.removePath(dir);
+#endif
+    }
+}
+
+void FileChangeWatcher::onPathsChanged(const QStringList &paths, bool overflowed)
+{
+    foreach (const QString& path, paths)
+        mPendingPaths.insert(path);
+    mPendingOverflow = mPendingOverflow || overflowed;
+    if (!mDebounceTimer.isActive())
+        mPendingTimer.start();
+    if (mPendingTimer.elapsed() < MaxReportDelay)
+        mDebounceTimer.start();
+}
+
+void FileChangeWatcher::reportChanges()
+{
+    FileChangeSet changes;
+    changes.overflowed = mPendingOverflow;
+    QSet<QString> paths;
+    paths.swap(mPendingPaths);
+    mPendingOverflow = false;
+    if (changes.overflowed) {
+        foreach (const QString& file, mFiles.keys())
+            paths.insert(file);
+    }
+    foreach (const QString& path, paths) {
+        auto it = mFiles.find(path);
+        if (it != mFiles.end()) {
+            FileStamp stamp = fileStamp(path);
+            if (stamp == it.value())
+                continue;
+            it.value() = stamp;
+            if (stamp.exists)
+                changes.changed.insert(path);
+            else
+                changes.removed.insert(path);
+#ifndef Q_OS_LINUX
+            // the file may be unwatched after it's replaced
+            if (stamp.exists && !mWatcher.files().contains(path))
+                mWatcher.addPath(path);
+#endif
+        } else if (isInDirectories(path)) {
+            if (QFileInfo::exists(path))
+                changes.changed.insert(path);
+            else
+                changes.removed.insert(path);
+        }
+    }
+    if (!changes.isEmpty())
+        emit filesChanged(changes);
+}
+
+FileChangeWatcher::FileStamp FileChangeWatcher::fileStamp(const QString &file)
+{
+    QFileInfo info(file);
+    if (!info.exists())
+        return FileStamp{false, 0, QDateTime()};
+    return FileStamp{true, info.size(), info.lastModified()};
+}
+
+bool FileChangeWatcher::isInDirectories(const QString &path) const
+{
+    for (auto it = mDirectories.constBegin(); it != mDirectories.constEnd(); ++it) {
+        if (path == it.key() || path.startsWith(includeTrailingPathDelimiter(it.key())))
+            return true;
+    }
+    return false;
+}
+
+bool FileChangeWatcher::FileStamp::operator==(const FileStamp &other) const
+{
+    return exists == other.exists && size == other.size && lastModified == other.lastModified;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FILECHANGEWATCHER_H
+#define FILECHANGEWATCHER_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#ifndef Q_OS_LINUX
+#include <QFileSystemWatcher>
+#endif
+
+struct FileChangeSet {
+    QSet<QString> changed; // modified or created
+    QSet<QString> removed;
+    // events are lost, any file in the watched directories may be changed
+    bool overflowed = false;
+    bool isEmpty() const {
+        return changed.isEmpty() && removed.isEmpty() && !overflowed;
+    }
+    void unite(const FileChangeSet& other);
+};
+
+#ifdef Q_OS_LINUX
+class InotifyThread;
+#endif
+
+/**
+ * @brief Watches files and directory trees for changes made by other programs.
+ *
+ * On Linux, the directories are watched by inotify in a background thread. A
+ * file is watched through its directory, so it's still watched after it's
+ * replaced by a rename, and directories added by addDirectory() are watched
+ * recursively (hidden sub directories are skipped). On other platforms
+ * QFileSystemWatcher is used, and only the directory itself is watched.
+ *
+ * Events are debounced, and reported in one batch by filesChanged().
+ * Files added by addPath() are reported only if their size or modification
+ * time is changed, so the files written by the IDE itself (removed before, and
+ * added again after it's written) are not reported.
+ */
+class FileChangeWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileChangeWatcher(QObject *parent = nullptr);
+    ~FileChangeWatcher();
+    bool addPath(const QString& file);
+    bool removePath(const QString& file);
+    bool isWatching(const QString& file) const;
+    void addDirectory(const QString& dir);
+    void removeDirectory(const QString& dir);
+signals:
+    void filesChanged(const FileChangeSet& changes);
+private slots:
+    void onPathsChanged(const QStringList& paths, bool overflowed);
+    void reportChanges();
+private:
+    struct FileStamp {
+        bool exists;
+        qint64 size;
+        QDateTime lastModified;
+        bool operator==(const FileStamp& other) const;
+    };
+    static FileStamp fileStamp(const QString& file);
+    bool isInDirectories(const QString& path) const;
+private:
+    QHash<QString, FileStamp> mFiles;
+    // number of watched files in each directory
+    QHash<QString, int> mFileDirectories;
+    // number of addDirectory() calls for each directory
+    QHash<QString, int> mDirectories;
+    QSet<QString> mPendingPaths;
+    bool mPendingOverflow;
+    QTimer mDebounceTimer;
+    QElapsedTimer mPendingTimer;
+#ifdef Q_OS_LINUX
+    InotifyThread* mThread;
+#else
+    QFileSystemWatcher mWatcher;
+#endif
+#ifdef Q_OS_LINUX
+    friend class InotifyThread;
+#endif
+};
+
+#endif // FILECHANGEWATCHER_H
@@ -30,10 +30,13 @@
 #include <QScreen>
 #include <QLockFile>
 #include <QFontDatabase>
+#include <QTimer>
 #include "common.h"
 #include "colorscheme.h"
 #include "iconsmanager.h"
 #include "autolinkmanager.h"
+#include "startuptasks.h"
+#include "symbolusagemanager.h"
 #include <qt_utils/charsetinfo.h>
 #include "parser/parserutils.h"
 #include "editorlist.h"
@@ -350,6 +353,10 @@ int main(int argc, char *argv[])
     initParser();
 
     try {
+        // must outlive the startup tasks
+        AutolinkManager autolinkManager;
+        pAutolinkManager = &autolinkManager;
+        StartupTasks startupTasks;
 
         SystemConsts systemConsts;
         pSystemConsts = &systemConsts;
@@ -358,14 +365,38 @@ int main(int argc, char *argv[])
 
         //We must use smarter point here, to manually control it's lifetime:
         // when restore default settings, it must be destoyed before we remove all setting files.
+        startupTasks.beginPhase("settings");
         auto settings = std::make_unique<Settings>(settingFilename);
         //load settings
         pSettings = settings.get();
+        startupTasks.endPhase();
+
+        // Only needs the config folder, so it's read while the settings are loaded
+        // and the main window is created. Compilers wait for it.
+        auto autolinkError = std::make_shared<QString>();
+        startupTasks.addTask(STARTUP_TASK_AUTOLINKS, [autolinkError](){
+            try {
+                pAutolinkManager->load();
+            } catch (FileError e) {
+                *autolinkError = e.reason();
+            }
+        }, QStringList(), [autolinkError](){
+            if (!autolinkError->isEmpty())
+                QMessageBox::critical(nullptr,
+                                      QObject::tr("Can't load autolink settings"),
+                                      *autolinkError,
+                                      QMessageBox::Ok);
+        });
+
         if (firstRun) {
+            startupTasks.beginPhase("find compiler sets");
             pSettings->compilerSets().findSets();
             pSettings->compilerSets().saveSets();
+            startupTasks.endPhase();
         }
+        startupTasks.beginPhase("load settings");
         pSettings->load();
+        startupTasks.endPhase();
         if (firstRun) {
             //set theme
             ChooseThemeDialog themeDialog;
@@ -394,25 +425,40 @@ int main(int argc, char *argv[])
 #endif
         }
         //Color scheme settings must be loaded after translation
+        startupTasks.beginPhase("color schemes");
         ColorManager colorManager;
         pColorManager = &colorManager;
+        startupTasks.endPhase();
+        startupTasks.beginPhase("icons");
         IconsManager iconsManager;
         pIconsManager = &iconsManager;
-        AutolinkManager autolinkManager;
-        pAutolinkManager = &autolinkManager;
-        try {
-            pAutolinkManager->load();
-        } catch (FileError e) {
-            QMessageBox::critical(nullptr,
-                                  QObject::tr("Can't load autolink settings"),
-                                  e.reason(),
-                                  QMessageBox::Ok);
-        }
         // qDebug()<<"Load font";
         QFontDatabase::addApplicationFont(":/fonts/asciicontrol.ttf");
+        startupTasks.endPhase();
 
+        startupTasks.beginPhase("main window");
         MainWindow mainWindow;
         pMainWindow = &mainWindow;
+        startupTasks.endPhase();
+
+        // only used to sort the completion list, so it's not waited for
+        auto symbolUsages = std::make_shared<QHash<QString, PSymbolUsage>>();
+        auto symbolUsageError = std::make_shared<QString>();
+        startupTasks.addTask(STARTUP_TASK_SYMBOL_USAGES, [symbolUsages, symbolUsageError](){
+            try {
+                *symbolUsages = SymbolUsageManager::readUsages();
+            } catch (FileError e) {
+                *symbolUsageError = e.reason();
+            }
+        }, QStringList(), [symbolUsages, symbolUsageError](){
+            pMainWindow->symbolUsageManager()->addUsages(*symbolUsages);
+            if (!symbolUsageError->isEmpty())
+                QMessageBox::warning(nullptr,
+                                     QObject::tr("Error"),
+                                     *symbolUsageError);
+        });
+
+        startupTasks.beginPhase("show main window");
 #if QT_VERSION_MAJOR==5 && QT_VERSION_MINOR < 15
         setScreenDPI(qApp->primaryScreen()->logicalDotsPerInch());
 #else
@@ -420,6 +466,8 @@ int main(int argc, char *argv[])
             setScreenDPI(mainWindow.screen()->logicalDotsPerInch());
 #endif
         mainWindow.show();
+        startupTasks.endPhase();
+        startupTasks.beginPhase("open files");
         if (app.arguments().count()>1) {
             QStringList filesToOpen = app.arguments();
             filesToOpen.pop_front();
@@ -436,6 +484,7 @@ int main(int argc, char *argv[])
         QDir::setCurrent(pSettings->environment().defaultOpenFolder());
 
         pMainWindow->setFilesViewRoot(pSettings->environment().currentFolder());
+        startupTasks.endPhase();
 
 #ifdef Q_OS_WIN
         WindowLogoutEventFilter filter;
@@ -445,7 +494,21 @@ int main(int argc, char *argv[])
             lockFile.unlock();
         }
 
+        // the timing is logged after the background tasks are finished
+        startupTasks.beginPhase("first events");
+        QTimer::singleShot(0, &app, [&startupTasks](){
+            startupTasks.endPhase();
+            startupTasks.addTask("startup report", [](){},
+                                 QStringList{STARTUP_TASK_AUTOLINKS, STARTUP_TASK_SYMBOL_USAGES},
+                                 [&startupTasks](){
+                foreach (const QString& line, startupTasks.report())
+                    qDebug().noquote()<<"Startup:"<<line;
+                qDebug().noquote()<<"Startup: ready in"<<startupTasks.elapsed()<<"ms";
+            });
+        });
+
         int retCode = app.exec();
+        startupTasks.waitForAll();
         if (mainWindow.shouldRemoveAllSettings()) {
             QString configDir = pSettings->dirs().config();
             settings.release();
@@ -24,6 +24,8 @@
 #include "debugger/debugger.h"
 #include "utils/escape.h"
 #include "utils/parsearg.h"
+#include "widgets/buildtimesdialog.h"
+#include "widgets/heapprofiledialog.h"
 #include "widgets/cpudialog.h"
 #include "widgets/filepropertiesdialog.h"
 #include "widgets/filenameeditdelegate.h"
@@ -31,6 +33,7 @@
 #include "projecttemplate.h"
 #include "widgets/newprojectdialog.h"
 #include <qt_utils/charsetinfo.h>
+#include <qt_utils/tracer.h>
 #include "widgets/aboutdialog.h"
 #include "shortcutmanager.h"
 #include "colorscheme.h"
@@ -75,10 +78,12 @@
 #include <QLineEdit>
 #include <QMessageBox>
 #include <QMimeData>
+#include <QRunnable>
 #include <QScreen>
 #include <QStyleFactory>
 #include <QTcpSocket>
 #include <QTemporaryFile>
+#include <QThreadPool>
 #include <QTextBlock>
 #include <QTranslator>
 #include <QFileIconProvider>
@@ -111,6 +116,9 @@ static const char *Translation[] =
   QT_TRANSLATE_NOOP("QFileSystemModel", "<b>The name \"%1\" cannot be used.</b><p>Try using another name, with fewer characters or no punctuation marks.")
 };
 
+// problem case data larger than this are shown as read-only previews
+static const int MaxProblemCasePreviewLength = 512*1024;
+
 static int findTabIndex(QTabWidget* tabWidget , QWidget* w) {
     for (int i=0;i<tabWidget->count();i++) {
         if (w==tabWidget->widget(i))
@@ -137,7 +145,8 @@ MainWindow::MainWindow(QWidget *parent)
       mClosingAll{false},
       mOpenningFiles{false},
       mSystemTurnedOff{false},
-      mCompileIssuesState{CompileIssuesState::None}
+      mCompileIssuesState{CompileIssuesState::None},
+      mFilesChangedNotifying{false}
 
 {
     ui->setupUi(this);
@@ -163,6 +172,12 @@ MainWindow::MainWindow(QWidget *parent)
     mFileModeStatus->setStyleSheet("margin-left:5px; margin-right:5px");
     prepareTabInfosData();
     prepareTabMessagesData();
+#ifdef Q_OS_WIN
+    showHideMessagesTab(ui->tabRunConsole, false);
+#endif
+#ifndef Q_OS_LINUX
+    ui->actionProfile_Memory->setVisible(false);
+#endif
     ui->statusbar->insertPermanentWidget(0,mFileModeStatus);
     ui->statusbar->insertPermanentWidget(0,mFileEncodingStatus);
     ui->statusbar->insertPermanentWidget(0,mFileInfoStatus);
@@ -292,14 +307,8 @@ MainWindow::MainWindow(QWidget *parent)
             this, &MainWindow::onDebugMemoryAddressInput);
 
     mTodoParser = std::make_shared<TodoParser>();
+    // the usages are read in background at startup, see main()
     mSymbolUsageManager = std::make_shared<SymbolUsageManager>();
-    try {
-        mSymbolUsageManager->load();
-    } catch (FileError &e) {
-        QMessageBox::warning(nullptr,
-                         tr("Error"),
-                         e.reason());
-    }
 
     mCodeSnippetManager = std::make_shared<CodeSnippetsManager>();
     try {
@@ -421,15 +430,17 @@ MainWindow::MainWindow(QWidget *parent)
     connect(&mClassBrowserModel, &ClassBrowserModel::refreshEnd,
             this, &MainWindow::onClassBrowserRefreshEnd);
 
-    connect(&mFileSystemWatcher,&QFileSystemWatcher::fileChanged,
-            this, &MainWindow::onFileChanged);
-    connect(&mFileSystemWatcher,&QFileSystemWatcher::directoryChanged,
-            this, &MainWindow::onDirChanged);
+    connect(&mFileSystemWatcher,&FileChangeWatcher::filesChanged,
+            this, &MainWindow::onFilesChanged);
 
     mStatementColors = std::make_shared<QHash<StatementKind, PColorSchemeItem> >();
     mCompletionPopup = std::make_shared<CodeCompletionPopup>();
     mCompletionPopup->setColors(mStatementColors);
     mHeaderCompletionPopup = std::make_shared<HeaderCompletionPopup>();
+    mQuickOpenIndex = new QuickOpenIndex(this);
+    mQuickOpenPopup = std::make_shared<QuickOpenPopup>(mQuickOpenIndex);
+    connect(mQuickOpenPopup.get(), &QuickOpenPopup::itemSelected,
+            this, &MainWindow::onQuickOpenItemSelected);
     mFunctionTip = std::make_shared<FunctionTooltipWidget>();
 
     mClassBrowserModel.setColors(mStatementColors);
@@ -633,6 +644,7 @@ void MainWindow::updateEditorActions(const Editor *e)
 
         //code
         ui->actionReformat_Code->setEnabled(false);
+        ui->actionFormat_Selection->setEnabled(false);
 
         ui->actionClose->setEnabled(false);
         ui->actionClose_All->setEnabled(false);
@@ -724,6 +736,7 @@ void MainWindow::updateEditorActions(const Editor *e)
 
         //code
         ui->actionReformat_Code->setEnabled(isCFile(e->filename()) || isHFile(e->filename()));
+        ui->actionFormat_Selection->setEnabled(ui->actionReformat_Code->isEnabled());
 
         ui->actionClose->setEnabled(true);
         ui->actionClose_All->setEnabled(true);
@@ -767,6 +780,7 @@ void MainWindow::updateProjectActions()
     ui->actionAdd_to_project->setEnabled(hasProject);
     ui->actionRemove_from_project->setEnabled(hasProject && ui->projectView->selectionModel()->selectedIndexes().count()>0);
     ui->actionMakeClean->setEnabled(hasProject);
+    ui->actionBuild_Time_Insights->setEnabled(hasProject);
     ui->actionProject_options->setEnabled(hasProject);
     ui->actionClose_Project->setEnabled(hasProject);
     ui->actionNew_Class->setEnabled(hasProject);
@@ -787,6 +801,7 @@ void MainWindow::updateCompileActions(const Editor *e)
             || mCompilerManager->running() || mDebugger->executing()) {
         ui->actionCompile->setEnabled(false);
         ui->actionRun->setEnabled(false);
+        ui->actionProfile_Memory->setEnabled(false);
         ui->actionRebuild->setEnabled(false);
         ui->actionGenerate_Assembly->setEnabled(false);
         ui->actionDebug->setEnabled(false);
@@ -852,6 +867,7 @@ void MainWindow::updateCompileActions(const Editor *e)
         }
         ui->actionCompile->setEnabled(canCompile);
         ui->actionRun->setEnabled(canRun);
+        ui->actionProfile_Memory->setEnabled(canRun);
         ui->actionRebuild->setEnabled(canCompile);
         ui->actionGenerate_Assembly->setEnabled(canGenerateAssembly);
         ui->actionDebug->setEnabled(canDebug);
@@ -1127,7 +1143,7 @@ void MainWindow::applyUISettings()
         ui->tabExplorer->setShrinkedFlag(true);
 }
 
-QFileSystemWatcher *MainWindow::fileSystemWatcher()
+FileChangeWatcher *MainWindow::fileSystemWatcher()
 {
     return &mFileSystemWatcher;
 }
@@ -1489,6 +1505,19 @@ QPlainTextEdit *MainWindow::txtLocals()
     return ui->txtLocals;
 }
 
+RunConsole *MainWindow::runConsole()
+{
+    return ui->runConsole;
+}
+
+void MainWindow::showRunConsole()
+{
+    showHideMessagesTab(ui->tabRunConsole, true);
+    stretchMessagesPanel(true);
+    ui->tabMessages->setCurrentWidget(ui->tabRunConsole);
+    ui->runConsole->setFocus();
+}
+
 QMenuBar *MainWindow::menuBar() const
 {
     return ui->menubar;
@@ -1597,8 +1626,9 @@ void MainWindow::openFiles(const QStringList &files)
         }
     }
     //Didn't find a project? Open all files
+    //Files not activated are loaded when their tabs are shown
     for (int i=0;i<files.length()-1;i++) {
-        openFile(files[i],false);
+        openFile(files[i],false,nullptr,true);
     }
     if (files.length()>0) {
         openFile(files.last(),true);
@@ -1613,7 +1643,7 @@ void MainWindow::openFiles(const QStringList &files)
     }
 }
 
-Editor* MainWindow::openFile(QString filename, bool activate, QTabWidget* page)
+Editor* MainWindow::openFile(QString filename, bool activate, QTabWidget* page, bool deferLoad)
 {
     if (!fileExists(filename))
         return nullptr;
@@ -1649,7 +1679,7 @@ Editor* MainWindow::openFile(QString filename, bool activate, QTabWidget* page)
         if (pProject && encoding==ENCODING_PROJECT)
             encoding=pProject->options().encoding;
         editor = mEditorList->newEditor(filename,encoding,
-                                    pProject, false, page);
+                                    pProject, false, page, deferLoad);
 //        if (mProject) {
 //            mProject->associateEditorToUnit(editor,unit);
 //        }
@@ -1848,6 +1878,7 @@ void MainWindow::updateDebuggerSettings()
     QFont font(pSettings->debugger().fontName());
     font.setPixelSize(pointToPixel(pSettings->debugger().fontSize()));
     ui->debugConsole->setFont(font);
+    ui->runConsole->setFont(font);
     ui->tblMemoryView->setFont(font);
     //ui->txtMemoryView->setFont(font);
     ui->txtLocals->setFont(font);
@@ -2268,11 +2299,90 @@ void MainWindow::runExecutable(
             stretchMessagesPanel(true);
             ui->tabMessages->setCurrentWidget(ui->tabProblem);
         }
+    } else if (runType == RunType::ProfileMemory) {
+#ifdef Q_OS_LINUX
+        QString profiler = includeTrailingPathDelimiter(pSettings->dirs().appLibexecDir()) + HEAP_PROFILER_LIBRARY;
+        if (!fileExists(profiler)) {
+            QMessageBox::critical(this,
+                                  tr("Can't find Heap Profiler"),
+                                  tr("Heap profiler \"%1\" doesn't exists!").arg(profiler));
+            return;
+        }
+        mHeapProfileFile = changeFileExt(exeName, HEAP_PROFILE_EXT);
+        QFile::remove(mHeapProfileFile);
+        QProcessEnvironment env;
+        QString preload = qEnvironmentVariable("LD_PRELOAD");
+        env.insert("LD_PRELOAD", preload.isEmpty() ? profiler : profiler + ":" + preload);
+        env.insert("REDPANDA_HEAPPROF_OUTPUT", mHeapProfileFile);
+        // the terminal and the console pauser are not profiled
+        env.insert("REDPANDA_HEAPPROF_EXE", QFileInfo(exeName).canonicalFilePath());
+        env.insert("REDPANDA_HEAPPROF_RATE", QString::number(pSettings->executor().heapProfileSampleRate()));
+        mCompilerManager->run(exeName,params,QFileInfo(exeName).absolutePath(),binDirs,env);
+#endif
     }
     updateCompileActions();
     updateAppTitle();
 }
 
+namespace {
+// addr2line is run once for each module, which can take seconds
+class HeapProfileLoadTask: public QRunnable {
+public:
+    using FinishedCallback = std::function<void (std::shared_ptr<HeapProfile> profile)>;
+    HeapProfileLoadTask(const QString& fileName, const QString& addr2line,
+                        const FinishedCallback& onFinished):
+        mFileName{fileName}, mAddr2line{addr2line}, mOnFinished{onFinished} {}
+    void run() override {
+        std::shared_ptr<HeapProfile> profile = std::make_shared<HeapProfile>();
+        if (profile->load(mFileName))
+            profile->symbolize(mAddr2line);
+        FinishedCallback onFinished = mOnFinished;
+        QMetaObject::invokeMethod(qApp, [onFinished, profile](){
+            onFinished(profile);
+        }, Qt::QueuedConnection);
+    }
+private:
+    QString mFileName;
+    QString mAddr2line;
+    FinishedCallback mOnFinished;
+};
+}
+
+void MainWindow::showHeapProfile(const QString &fileName)
+{
+    if (!fileExists(fileName)) {
+        QMessageBox::critical(this,
+                              tr("Profile Memory"),
+                              tr("No memory profile is written by the program.")
+                              +"<BR/><BR/>"
+                              +tr("Statically linked programs can't be profiled."));
+        return;
+    }
+    Settings::PCompilerSet compilerSet;
+    if (getCompileTarget() == CompileTarget::Project)
+        compilerSet = pSettings->compilerSets().getSet(mProject->options().compilerSet);
+    if (!compilerSet)
+        compilerSet = pSettings->compilerSets().defaultSet();
+    QString addr2line;
+    if (compilerSet)
+        addr2line = compilerSet->findProgramInBinDirs(ADDR2LINE_PROGRAM);
+    if (addr2line.isEmpty())
+        addr2line = ADDR2LINE_PROGRAM;
+    updateStatusbarMessage(tr("Loading the memory profile..."));
+    QThreadPool::globalInstance()->start(new HeapProfileLoadTask(
+                                             fileName, addr2line,
+                                             [this](std::shared_ptr<HeapProfile> profile) {
+        updateStatusbarMessage(QString());
+        if (!profile->errorMessage().isEmpty()) {
+            QMessageBox::critical(this, tr("Profile Memory"), profile->errorMessage());
+            return;
+        }
+        HeapProfileDialog* dialog = new HeapProfileDialog(profile, this);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        dialog->show();
+    }));
+}
+
 void MainWindow::runExecutable(RunType runType)
 {
     CompileTarget target =getCompileTarget();
@@ -2671,7 +2781,7 @@ void MainWindow::doAutoSave(Editor *e)
         QString suffix = fileInfo.suffix();
         switch(pSettings->editor().autoSaveStrategy()) {
         case assOverwrite:
-            e->save();
+            e->saveInBackground();
             return;
         case assAppendUnixTimestamp:
             filename = parent.filePath(
@@ -3264,13 +3374,14 @@ bool MainWindow::saveLastOpens()
           }
       }
 
+      Editor::ViewState viewState = editor->viewState();
       fileObj["filename"] = editor->filename();
       fileObj["onLeft"] = (editor->pageControl() != mEditorList->rightPageWidget());
       fileObj["focused"] = editor->hasFocus();
-      fileObj["caretX"] = editor->caretX();
-      fileObj["caretY"] = editor->caretY();
-      fileObj["topLine"] = editor->topLine();
-      fileObj["left"] = editor->leftPos();
+      fileObj["caretX"] = viewState.caretX;
+      fileObj["caretY"] = viewState.caretY;
+      fileObj["topLine"] = viewState.topLine;
+      fileObj["left"] = viewState.leftPos;
       filesArray.append(fileObj);
     }
     rootObj["files"]=filesArray;
@@ -3357,7 +3468,8 @@ void MainWindow::loadLastOpens()
         Project* pProject = (inProject?mProject.get():nullptr);
         if (pProject && encoding==ENCODING_PROJECT)
             encoding=pProject->options().encoding;
-        Editor * editor = mEditorList->newEditor(editorFilename, encoding, pProject,false,page);
+        //only the editor shown is loaded, others are loaded when activated
+        Editor * editor = mEditorList->newEditor(editorFilename, encoding, pProject,false,page,true);
 
         if (inProject && editor) {
             mProject->loadUnitLayout(editor);
@@ -3367,16 +3479,12 @@ void MainWindow::loadLastOpens()
 //        }
         if (!editor)
             continue;
-        QSynedit::BufferCoord pos;
-        pos.ch = fileObj["caretX"].toInt(1);
-        pos.line = fileObj["caretY"].toInt(1);
-        editor->setCaretXY(pos);
-        editor->setTopLine(
-                    fileObj["topLine"].toInt(1)
-                    );
-        editor->setLeftPos(
-                    fileObj["left"].toInt(1)
-                    );
+        Editor::ViewState viewState;
+        viewState.caretX = fileObj["caretX"].toInt(1);
+        viewState.caretY = fileObj["caretY"].toInt(1);
+        viewState.topLine = fileObj["topLine"].toInt(1);
+        viewState.leftPos = fileObj["left"].toInt(1);
+        editor->setViewState(viewState);
         if (fileObj["focused"].toBool(false))
             focusedEditor = editor;
         //mVisitHistoryManager->removeFile(editorFilename);
@@ -3406,6 +3514,9 @@ void MainWindow::updateTools()
 {
     ui->menuTools->clear();
     ui->menuTools->addAction(ui->actionOptions);
+    ui->menuTools->addSeparator();
+    ui->menuTools->addAction(ui->actionLatency_Tracing);
+    ui->menuTools->addAction(ui->actionExport_Latency_Trace);
     if (!mToolsManager->tools().isEmpty()) {
         ui->menuTools->addSeparator();
         foreach (const PToolItem& item, mToolsManager->tools()) {
@@ -4233,8 +4344,10 @@ void MainWindow::onProblemCaseIndexChanged(const QModelIndex &current, const QMo
     QModelIndex idx = current;
     if (previous.isValid()) {
         POJProblemCase problemCase = mOJProblemModel.getCase(previous.row());
-        problemCase->input = ui->txtProblemCaseInput->toPlainText();
-        problemCase->expected = ui->txtProblemCaseExpected->toPlainText();
+        if (!ui->txtProblemCaseInput->isReadOnly())
+            problemCase->setInput(ui->txtProblemCaseInput->toPlainText());
+        if (!ui->txtProblemCaseExpected->isReadOnly())
+            problemCase->setExpected(ui->txtProblemCaseExpected->toPlainText());
     }
     if (idx.isValid()) {
         POJProblemCase problemCase = mOJProblemModel.getCase(idx.row());
@@ -4383,15 +4496,15 @@ void MainWindow::onNewProblemConnection()
             if (pSettings->executor().convertHTMLToTextForInput()) {
                 QTextDocument doc;
                 doc.setHtml(caseObj["input"].toString());
-                problemCase->input = doc.toPlainText();
+                problemCase->setInput(doc.toPlainText());
             } else
-                problemCase->input = caseObj["input"].toString();
+                problemCase->setInput(caseObj["input"].toString());
             if (pSettings->executor().convertHTMLToTextForExpected()) {
                 QTextDocument doc;
                 doc.setHtml(caseObj["output"].toString());
-                problemCase->expected = doc.toPlainText();
+                problemCase->setExpected(doc.toPlainText());
             } else
-                problemCase->expected = caseObj["output"].toString();
+                problemCase->setExpected(caseObj["output"].toString());
             problem->cases.append(problemCase);
         }
         mOJProblemSetModel.addProblem(problem);
@@ -5107,6 +5220,7 @@ void MainWindow::onEditorContextMenu(const QPoint& pos)
         menu.addSeparator();
         menu.addAction(ui->actionTrim_trailing_spaces);
         menu.addAction(ui->actionReformat_Code);
+        menu.addAction(ui->actionFormat_Selection);
         menu.addSeparator();
         menu.addAction(ui->actionCut);
         menu.addAction(ui->actionCopy);
@@ -5443,19 +5557,73 @@ void MainWindow::updateProjectView()
     updateProjectActions();
 }
 
-void MainWindow::onFileChanged(const QString &path)
+void MainWindow::onFilesChanged(const FileChangeSet &changes)
 {
-    if (mFilesChangedNotifying.contains(path))
+    if (mFilesChangedNotifying) {
+        // handled after the user answers the current questions
+        mPendingFileChanges.unite(changes);
         return;
-    mFilesChangedNotifying.insert(path);
-    Editor *e = mEditorList->getOpenedEditorByFilename(path);
-    if (e) {
-        if (fileExists(path)) {
+    }
+    mFilesChangedNotifying = true;
+    auto action = finally([this]{
+        mFilesChangedNotifying = false;
+        if (!mPendingFileChanges.isEmpty()) {
+            FileChangeSet pending = mPendingFileChanges;
+            mPendingFileChanges = FileChangeSet();
+            QTimer::singleShot(0, this, [this, pending](){
+                onFilesChanged(pending);
+            });
+        }
+    });
+    if (mProject && !fileExists(mProject->directory())) {
+        QMessageBox::information(this,tr("Project folder removed."),
+                                  tr("Folder for project '%1' was removed.").arg(mProject->directory())
+                                 +"<BR /><BR />"
+                                 + tr("It will be closed."));
+        closeProject(false);
+    }
+
+    QList<Editor*> changedEditors;
+    QList<Editor*> removedEditors;
+    QSet<QString> changedFiles;
+    QSet<QString> removedFiles;
+    foreach (const QString& path, changes.changed) {
+        Editor *e = mEditorList->getOpenedEditorByFilename(path);
+        if (!e)
+            changedFiles.insert(path);
+        else if (mFileSystemWatcher.isWatching(path))
+            changedEditors.append(e);
+    }
+    foreach (const QString& path, changes.removed) {
+        Editor *e = mEditorList->getOpenedEditorByFilename(path);
+        if (!e)
+            removedFiles.insert(path);
+        else if (mFileSystemWatcher.isWatching(path))
+            removedEditors.append(e);
+    }
+
+    if (!changedEditors.isEmpty()) {
+        QMessageBox::StandardButton answer;
+        if (changedEditors.count()==1) {
+            Editor* e = changedEditors.front();
             e->activate();
-            if (QMessageBox::question(this,tr("File Changed"),
-                                      tr("File '%1' was changed.").arg(path)+"<BR /><BR />" + tr("Reload its content from disk?"),
+            answer = QMessageBox::question(this,tr("File Changed"),
+                                      tr("File '%1' was changed.").arg(e->filename())+"<BR /><BR />" + tr("Reload its content from disk?"),
                                       QMessageBox::Yes|QMessageBox::No,
-                                      QMessageBox::No) == QMessageBox::Yes) {
+                                      QMessageBox::No);
+        } else {
+            QStringList fileNames;
+            foreach (Editor* e, changedEditors)
+                fileNames.append(e->filename());
+            QMessageBox msgBox(QMessageBox::Question, tr("File Changed"),
+                               tr("%1 files were changed.").arg(changedEditors.count())+"<BR /><BR />" + tr("Reload their contents from disk?"),
+                               QMessageBox::Yes|QMessageBox::No, this);
+            msgBox.setDefaultButton(QMessageBox::No);
+            msgBox.setDetailedText(fileNames.join("\n"));
+            answer = static_cast<QMessageBox::StandardButton>(msgBox.exec());
+        }
+        foreach (Editor* e, changedEditors) {
+            if (answer == QMessageBox::Yes) {
                 try {
                     e->loadFile();
                 } catch(FileError e) {
@@ -5464,35 +5632,102 @@ void MainWindow::onFileChanged(const QString &path)
             } else {
                 e->setModified(true);
             }
-        } else {
-            mFileSystemWatcher.removePath(path);
-            if (QMessageBox::question(this,tr("File Changed"),
-                                      tr("File '%1' was removed.").arg(path)+"<BR /><BR />" + tr("Keep it open?"),
+        }
+    }
+
+    if (!removedEditors.isEmpty()) {
+        QMessageBox::StandardButton answer;
+        foreach (Editor* e, removedEditors)
+            mFileSystemWatcher.removePath(e->filename());
+        if (removedEditors.count()==1) {
+            answer = QMessageBox::question(this,tr("File Changed"),
+                                      tr("File '%1' was removed.").arg(removedEditors.front()->filename())+"<BR /><BR />" + tr("Keep it open?"),
                                       QMessageBox::Yes|QMessageBox::No,
-                                      QMessageBox::Yes) == QMessageBox::No) {
+                                      QMessageBox::Yes);
+        } else {
+            QStringList fileNames;
+            foreach (Editor* e, removedEditors)
+                fileNames.append(e->filename());
+            QMessageBox msgBox(QMessageBox::Question, tr("File Changed"),
+                               tr("%1 files were removed.").arg(removedEditors.count())+"<BR /><BR />" + tr("Keep them open?"),
+                               QMessageBox::Yes|QMessageBox::No, this);
+            msgBox.setDefaultButton(QMessageBox::Yes);
+            msgBox.setDetailedText(fileNames.join("\n"));
+            answer = static_cast<QMessageBox::StandardButton>(msgBox.exec());
+        }
+        foreach (Editor* e, removedEditors) {
+            if (answer == QMessageBox::No)
                 mEditorList->closeEditor(e);
-            } else {
+            else
                 e->setModified(true);
-            }
         }
     }
-    mFilesChangedNotifying.remove(path);
+
+    // files opened in editors are parsed again when they are loaded or edited
+    invalidateParsedFiles(changedFiles, removedFiles, changes.overflowed);
 }
 
-void MainWindow::onDirChanged(const QString &path)
+void MainWindow::invalidateParsedFiles(const QSet<QString> &changedFiles, const QSet<QString> &removedFiles, bool overflowed)
 {
-    if (mFilesChangedNotifying.contains(path))
+    QSet<QString> files;
+    foreach (const QString& file, changedFiles+removedFiles) {
+        if (isCFile(file) || isHFile(file))
+            files.insert(file);
+    }
+    if (files.isEmpty() && !overflowed)
         return;
-    mFilesChangedNotifying.insert(path);
-    if (mProject && QString::compare(mProject->directory(),path,PATH_SENSITIVITY)==0
-            && !fileExists(path)) {
-        QMessageBox::information(this,tr("Project folder removed."),
-                                  tr("Folder for project '%1' was removed.").arg(path)
-                                 +"<BR /><BR />"
-                                 + tr("It will be closed."));
-        closeProject(false);
+    if (mProject) {
+        PCppParser parser = mProject->cppParser();
+        if (overflowed) {
+            // the changed files are unknown
+            if (parser->parsing()) {
+                QTimer::singleShot(500, this, [this, changedFiles, removedFiles, overflowed](){
+                    invalidateParsedFiles(changedFiles, removedFiles, overflowed);
+                });
+                return;
+            }
+            scanActiveProject(true);
+        } else if (pSettings->codeCompletion().enabled() && parser->enabled()) {
+            if (!parser->invalidateFiles(files)) {
+                QTimer::singleShot(500, this, [this, changedFiles, removedFiles, overflowed](){
+                    invalidateParsedFiles(changedFiles, removedFiles, overflowed);
+                });
+                return;
+            }
+            parseFileList(parser);
+        }
+        QStringList todoFiles;
+        foreach (const QString& file, changedFiles) {
+            if (mProject->findUnit(file))
+                todoFiles.append(file);
+        }
+        foreach (const QString& file, removedFiles)
+            mTodoModel.removeTodosForFile(file);
+        if (overflowed)
+            mTodoParser->parseFiles(mProject->unitFiles());
+        else if (!todoFiles.isEmpty())
+            mTodoParser->parseFiles(todoFiles, false);
+    }
+    QSet<CppParser*> invalidatedParsers;
+    for (int i=0;i<mEditorList->pageCount();i++) {
+        Editor * e=(*mEditorList)[i];
+        if (e->inProject() || !e->parser())
+            continue;
+        CppParser* parser = e->parser().get();
+        if (!invalidatedParsers.contains(parser)) {
+            bool parsed = false;
+            foreach (const QString& file, files) {
+                if (parser->isFileParsed(file)) {
+                    parsed = true;
+                    break;
+                }
+            }
+            if (!parsed || !parser->invalidateFiles(files))
+                continue;
+            invalidatedParsers.insert(parser);
+        }
+        e->reparse(false);
     }
-    mFilesChangedNotifying.remove(path);
 }
 
 void MainWindow::onFilesViewPathChanged()
@@ -5603,6 +5838,7 @@ void MainWindow::on_actionOpen_triggered()
 
 void MainWindow::closeEvent(QCloseEvent *event) {
     mQuitting = true;
+    Editor::waitForBackgroundSaves();
     if (!mShouldRemoveAllSettings) {
         if (mCPUDialog)
             mCPUDialog->close();
@@ -5787,7 +6023,7 @@ void MainWindow::on_actionSave_triggered()
     if (editor) {
         if (editor->inProject() && mCompileIssuesState == CompileIssuesState::ProjectCompilationResultFilled)
             mCompileIssuesState = CompileIssuesState::None;
-        editor->save();
+        editor->saveInBackground();
 //            if (editor->inProject() && (mProject))
 //                mProject->saveAll();
     }    
@@ -6041,6 +6277,9 @@ void MainWindow::onCompileFinished(QString filename, bool isCheckSyntax)
                 case MainWindow::CompileSuccessionTaskType::RunCurrentProblemCase:
                     runExecutable(mCompileSuccessionTask->execName,QString(),RunType::CurrentProblemCase, mCompileSuccessionTask->binDirs);
                     break;
+                case MainWindow::CompileSuccessionTaskType::RunProfileMemory:
+                    runExecutable(mCompileSuccessionTask->execName,QString(),RunType::ProfileMemory, mCompileSuccessionTask->binDirs);
+                    break;
                 case MainWindow::CompileSuccessionTaskType::Debug:
                     debug();
                     break;
@@ -6097,6 +6336,11 @@ void MainWindow::onRunFinished()
         showNormal();
     }
     updateAppTitle();
+    if (!mHeapProfileFile.isEmpty()) {
+        QString fileName = mHeapProfileFile;
+        mHeapProfileFile.clear();
+        showHeapProfile(fileName);
+    }
 }
 
 void MainWindow::onRunPausingForFinish()
@@ -6142,6 +6386,8 @@ void MainWindow::onOJProblemCaseFinished(const QString& id, int current, int tot
         problemCase->testState = validator.validate(problemCase,pSettings->executor().problemCaseValidateType())?
                     ProblemCaseTestState::Passed:
                     ProblemCaseTestState::Failed;
+        // the expected output is only loaded to validate the case
+        problemCase->unloadData();
         mOJProblemModel.update(row);
         updateProblemCaseOutput(problemCase);
     }
@@ -6768,6 +7014,15 @@ void MainWindow::on_actionReformat_Code_triggered()
     }
 }
 
+void MainWindow::on_actionFormat_Selection_triggered()
+{
+    Editor* e = mEditorList->getEditor();
+    if (e) {
+        e->reformatSelection();
+        e->activate();
+    }
+}
+
 CaretList &MainWindow::caretList()
 {
     return mCaretList;
@@ -7287,6 +7542,20 @@ void MainWindow::on_actionMakeClean_triggered()
     mCompilerManager->cleanProject(mProject);
 }
 
+void MainWindow::on_actionBuild_Time_Insights_triggered()
+{
+    if (!mProject)
+        return;
+    BuildTimesDialog dialog(changeFileExt(mProject->filename(), BUILD_TIMES_EXT),
+                            mProject->directory(), this);
+    dialog.exec();
+}
+
+void MainWindow::on_actionProfile_Memory_triggered()
+{
+    runExecutable(RunType::ProfileMemory);
+}
+
 
 void MainWindow::on_actionProject_Open_Folder_In_Explorer_triggered()
 {
@@ -7596,38 +7865,53 @@ void MainWindow::newProjectUnitFile(const QString& suffix)
 
 void MainWindow::fillProblemCaseInputAndExpected(const POJProblemCase &problemCase)
 {
+    // Huge case data are shown as read-only previews, the full data are
+    // only read when running the cases.
+    bool truncated;
+    QString text;
     ui->btnProblemCaseInputFileName->setEnabled(true);
     if (fileExists(problemCase->inputFileName)) {
+        text = readProblemCaseFilePreview(problemCase->inputFileName, MaxProblemCasePreviewLength, truncated);
         ui->txtProblemCaseInput->setReadOnly(true);
-        ui->txtProblemCaseInput->setPlainText(readFileToByteArray(problemCase->inputFileName));
+        ui->txtProblemCaseInput->setPlainText(problemCaseText(text, truncated));
         ui->btnProblemCaseClearInputFileName->setVisible(true);
         ui->txtProblemCaseInputFileName->setText(extractFileName(problemCase->inputFileName));
         ui->txtProblemCaseInputFileName->setToolTip(problemCase->inputFileName);
     } else {
-        ui->txtProblemCaseInput->setReadOnly(false);
-        ui->txtProblemCaseInput->setPlainText(problemCase->input);
+        text = problemCase->inputPreview(MaxProblemCasePreviewLength, truncated);
+        ui->txtProblemCaseInput->setReadOnly(truncated);
+        ui->txtProblemCaseInput->setPlainText(problemCaseText(text, truncated));
         ui->btnProblemCaseClearInputFileName->setVisible(false);
         ui->txtProblemCaseInputFileName->clear();
         ui->txtProblemCaseInputFileName->setToolTip("");
     }
     ui->btnProblemCaseExpectedOutputFileName->setEnabled(true);
     if (fileExists(problemCase->expectedOutputFileName)) {
+        text = readProblemCaseFilePreview(problemCase->expectedOutputFileName, MaxProblemCasePreviewLength, truncated);
         ui->txtProblemCaseExpected->setReadOnly(true);
         ui->txtProblemCaseExpected->clearAll();
-        ui->txtProblemCaseExpected->setPlainText(readFileToByteArray(problemCase->expectedOutputFileName));
+        ui->txtProblemCaseExpected->setPlainText(problemCaseText(text, truncated));
         ui->btnProblemCaseClearExpectedOutputFileName->setVisible(true);
         ui->txtProblemCaseExpectedOutputFileName->setText(extractFileName(problemCase->expectedOutputFileName));
         ui->txtProblemCaseExpectedOutputFileName->setToolTip(problemCase->inputFileName);
     } else {
-        ui->txtProblemCaseExpected->setReadOnly(false);
+        text = problemCase->expectedPreview(MaxProblemCasePreviewLength, truncated);
+        ui->txtProblemCaseExpected->setReadOnly(truncated);
         ui->txtProblemCaseExpected->clearAll();
-        ui->txtProblemCaseExpected->setPlainText(problemCase->expected);
+        ui->txtProblemCaseExpected->setPlainText(problemCaseText(text, truncated));
         ui->btnProblemCaseClearExpectedOutputFileName->setVisible(false);
         ui->txtProblemCaseExpectedOutputFileName->clear();
         ui->txtProblemCaseExpectedOutputFileName->setToolTip("");
     }
 }
 
+QString MainWindow::problemCaseText(const QString &text, bool truncated)
+{
+    if (!truncated)
+        return text;
+    return text + "\n" + tr("...(Too large to be shown completely)");
+}
+
 void MainWindow::doFilesViewRemoveFile(const QModelIndex &index)
 {
     if (!index.isValid())
@@ -8216,9 +8500,10 @@ void MainWindow::applyCurrentProblemCaseChanges()
     if (idx.isValid()) {
         POJProblemCase problemCase = mOJProblemModel.getCase(idx.row());
         if (problemCase) {
-            if (!fileExists(problemCase->inputFileName))
-                problemCase->input = ui->txtProblemCaseInput->toPlainText();
-            problemCase->expected = ui->txtProblemCaseExpected->toPlainText();
+            if (!ui->txtProblemCaseInput->isReadOnly())
+                problemCase->setInput(ui->txtProblemCaseInput->toPlainText());
+            if (!ui->txtProblemCaseExpected->isReadOnly())
+                problemCase->setExpected(ui->txtProblemCaseExpected->toPlainText());
         }
     }
 }
@@ -8255,6 +8540,7 @@ void MainWindow::on_btnReplace_clicked()
         bool needSave=false;
         std::shared_ptr<Editor> pEditor;
         if (editor) {
+            editor->loadContent();
             editor->clearSelection();
             editor->addGroupBreak();
             editor->beginEditing();
@@ -8293,9 +8579,8 @@ void MainWindow::on_btnReplace_clicked()
             editor->endEditing();
         } else {
             QByteArray realEncoding;
-            QFile toFile(file->filename);
             try {
-                editor->document()->saveToFile(toFile,ENCODING_AUTO_DETECT,
+                editor->document()->saveToFile(file->filename,ENCODING_AUTO_DETECT,
                                        pSettings->editor().defaultEncoding(),
                                        realEncoding);
             } catch(FileError e) {
@@ -8803,6 +9088,8 @@ MainWindow::CompileSuccessionTaskType MainWindow::runTypeToCompileSuccessionTask
         return CompileSuccessionTaskType::RunCurrentProblemCase;
     case RunType::ProblemCases:
         return CompileSuccessionTaskType::RunProblemCases;
+    case RunType::ProfileMemory:
+        return CompileSuccessionTaskType::RunProfileMemory;
     default:
         return CompileSuccessionTaskType::RunNormal;
     }
@@ -9534,7 +9821,7 @@ void MainWindow::on_btnProblemCaseInputFileName_clicked()
             return;
         problemCase->inputFileName = fileName;
         if (problemCase->expectedOutputFileName.isEmpty()
-                && problemCase->expected.isEmpty()
+                && problemCase->expected().isEmpty()
                 && QFileInfo(fileName).suffix()=="in") {
             QString expectedFileName;
             expectedFileName = fileName.mid(0,fileName.length()-2)+"ans";
@@ -9740,6 +10027,58 @@ void MainWindow::on_actionGo_to_Line_triggered()
     }
 }
 
+void MainWindow::showQuickOpenPopup(QuickOpenItemType type)
+{
+    QStringList files;
+    QSet<QString> fileSet;
+    PCppParser parser;
+    if (mProject) {
+        foreach (const PProjectUnit& unit, mProject->unitList()) {
+            files.append(unit->fileName());
+            fileSet.insert(unit->fileName());
+        }
+        parser = mProject->cppParser();
+    }
+    for (int i=0;i<mEditorList->pageCount();i++) {
+        Editor* e=(*mEditorList)[i];
+        if (e->isNew() || fileSet.contains(e->filename()))
+            continue;
+        files.append(e->filename());
+        fileSet.insert(e->filename());
+    }
+    Editor* e=mEditorList->getEditor();
+    if (!parser && e)
+        parser = e->parser();
+    mQuickOpenIndex->setParser(parser);
+    mQuickOpenIndex->setFiles(files);
+
+    QRect rect = geometry();
+    int width = std::min(rect.width()*2/3, rect.width()-20);
+    int height = rect.height()/2;
+    mQuickOpenPopup->setGeometry(rect.left()+(rect.width()-width)/2,
+                                 rect.top()+rect.height()/8,
+                                 width, height);
+    mQuickOpenPopup->popup(type);
+}
+
+void MainWindow::on_actionGo_to_File_triggered()
+{
+    showQuickOpenPopup(QuickOpenItemType::File);
+}
+
+void MainWindow::on_actionGo_to_Symbol_triggered()
+{
+    showQuickOpenPopup(QuickOpenItemType::Symbol);
+}
+
+void MainWindow::onQuickOpenItemSelected(PQuickOpenItem item)
+{
+    Editor* e = openFile(item->filename);
+    if (e) {
+        e->setCaretPositionAndActivate(item->line,1);
+    }
+}
+
 
 void MainWindow::on_actionNew_Template_triggered()
 {
@@ -10171,3 +10510,29 @@ void MainWindow::on_cbProblemCaseValidateType_currentIndexChanged(int index)
     pSettings->executor().save();
 }
 
+void MainWindow::on_actionLatency_Tracing_toggled(bool checked)
+{
+    Tracer::setEnabled(checked);
+    ui->actionExport_Latency_Trace->setEnabled(checked);
+    //show / hide the latency overlay
+    for (int i=0;i<mEditorList->pageCount();i++) {
+        Editor * e=(*mEditorList)[i];
+        e->invalidate();
+    }
+}
+
+void MainWindow::on_actionExport_Latency_Trace_triggered()
+{
+    QString filename = QFileDialog::getSaveFileName(this,
+                                 tr("Export Latency Trace"),
+                                 QDir::currentPath(),
+                                 tr("Chrome Trace Files (*.json)")
+                                 );
+    if (filename.isEmpty())
+        return;
+    if (!Tracer::exportChromeTrace(filename)) {
+        QMessageBox::critical(this,
+                              tr("Error"),
+                              tr("Can't save file '%1'.").arg(filename));
+    }
+}
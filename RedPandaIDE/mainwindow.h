@@ -17,7 +17,6 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
-#include <QFileSystemWatcher>
 #include <QMainWindow>
 #include <QTimer>
 #include <QFileSystemModel>
@@ -25,10 +24,12 @@
 #include <QElapsedTimer>
 #include <QSortFilterProxyModel>
 #include "common.h"
+#include "filechangewatcher.h"
 #include "widgets/searchresultview.h"
 #include "widgets/classbrowser.h"
 #include "widgets/codecompletionpopup.h"
 #include "widgets/headercompletionpopup.h"
+#include "widgets/quickopenpopup.h"
 #include "widgets/functiontooltipwidget.h"
 #include "caretlist.h"
 #include "symbolusagemanager.h"
@@ -53,7 +54,8 @@ enum class CompileTarget {
 enum class RunType {
     Normal,
     CurrentProblemCase,
-    ProblemCases
+    ProblemCases,
+    ProfileMemory
 };
 
 
@@ -65,6 +67,7 @@ class Editor;
 class Debugger;
 class CPUDialog;
 class QPlainTextEdit;
+class RunConsole;
 class SearchInFileDialog;
 class SearchDialog;
 class Project;
@@ -95,6 +98,7 @@ class MainWindow : public QMainWindow
         RunNormal,
         RunProblemCases,
         RunCurrentProblemCase,
+        RunProfileMemory,
         Debug,
         Profile
     };
@@ -149,6 +153,7 @@ public:
             RunType runType,
             const QStringList& binDirs);
     void runExecutable(RunType runType = RunType::Normal);
+    void showHeapProfile(const QString& fileName);
     void debug();
     void showSearchPanel(bool showReplace = false);
     void showCPUInfoDialog();
@@ -157,7 +162,7 @@ public:
 
     void applySettings();
     void applyUISettings();
-    QFileSystemWatcher* fileSystemWatcher();
+    FileChangeWatcher* fileSystemWatcher();
     void initDocks();
 
     void removeActiveBreakpoints();
@@ -180,6 +185,9 @@ public:
 
     QPlainTextEdit* txtLocals();
 
+    RunConsole* runConsole();
+    void showRunConsole();
+
     QMenuBar* menuBar() const;
 
     CPUDialog *cpuDialog() const;
@@ -221,7 +229,7 @@ public:
 
     TodoModel* todoModel();
 
-    Editor* openFile(QString filename, bool activate=true, QTabWidget* page=nullptr);
+    Editor* openFile(QString filename, bool activate=true, QTabWidget* page=nullptr, bool deferLoad=false);
     void openProject(QString filename, bool openFiles = true);
     void changeOptions(const QString& widgetName=QString(), const QString& groupName=QString());
     void changeProjectOptions(const QString& widgetName=QString(), const QString& groupName=QString());
@@ -282,6 +290,7 @@ private:
     void hideAllSearchDialogs();
     void prepareSearchDialog();
     void prepareSearchInFilesDialog();
+    void showQuickOpenPopup(QuickOpenItemType type);
     void prepareProjectForCompile();
     void closeProject(bool refreshEditor);
     void updateProjectView();
@@ -322,6 +331,7 @@ private:
     void prepareTabMessagesData();
     void newProjectUnitFile(const QString& suffix="");
     void fillProblemCaseInputAndExpected(const POJProblemCase &problemCase);
+    QString problemCaseText(const QString& text, bool truncated);
 
     void doFilesViewRemoveFile(const QModelIndex& index);
 
@@ -329,6 +339,7 @@ private:
     void setProjectViewCurrentUnit(std::shared_ptr<ProjectUnit> unit);
 
     void reparseNonProjectEditors();
+    void invalidateParsedFiles(const QSet<QString>& changedFiles, const QSet<QString>& removedFiles, bool overflowed);
     QString switchHeaderSourceTarget(Editor *editor);
 
 private slots:
@@ -345,8 +356,7 @@ private slots:
     void invalidateProjectProxyModel();
     void onEditorRenamed(const QString &oldFilename, const QString &newFilename, bool firstSave);
     void onAutoSaveTimeout();
-    void onFileChanged(const QString &path);
-    void onDirChanged(const QString &path);
+    void onFilesChanged(const FileChangeSet &changes);
     void onFilesViewPathChanged();
     void onWatchViewContextMenu(const QPoint& pos);
     void onBookmarkContextMenu(const QPoint& pos);
@@ -527,6 +537,8 @@ private slots:
 
     void on_actionReformat_Code_triggered();
 
+    void on_actionFormat_Selection_triggered();
+
     void on_actionBack_triggered();
 
     void on_actionForward_triggered();
@@ -590,6 +602,10 @@ private slots:
 
     void on_actionMakeClean_triggered();
 
+    void on_actionBuild_Time_Insights_triggered();
+
+    void on_actionProfile_Memory_triggered();
+
     void on_actionProject_Open_Folder_In_Explorer_triggered();
 
     void on_actionProject_Open_In_Terminal_triggered();
@@ -774,6 +790,12 @@ private slots:
 
     void on_actionGo_to_Line_triggered();
 
+    void on_actionGo_to_File_triggered();
+
+    void on_actionGo_to_Symbol_triggered();
+
+    void onQuickOpenItemSelected(PQuickOpenItem item);
+
     void on_actionNew_Template_triggered();
 
     void on_actionGoto_block_start_triggered();
@@ -851,6 +873,10 @@ private slots:
 
     void on_cbProblemCaseValidateType_currentIndexChanged(int index);
 
+    void on_actionLatency_Tracing_toggled(bool checked);
+
+    void on_actionExport_Latency_Trace_triggered();
+
 private:
     Ui::MainWindow *ui;
     bool mFullInitialized;
@@ -877,12 +903,14 @@ private:
     bool mOpeningProject;
     bool mClosingProject;
     QElapsedTimer mParserTimer;
-    QFileSystemWatcher mFileSystemWatcher;
+    FileChangeWatcher mFileSystemWatcher;
     std::shared_ptr<Project> mProject;
     Qt::DockWidgetArea mMessagesDockLocation;
 
     std::shared_ptr<CodeCompletionPopup> mCompletionPopup;
     std::shared_ptr<HeaderCompletionPopup> mHeaderCompletionPopup;
+    QuickOpenIndex* mQuickOpenIndex;
+    std::shared_ptr<QuickOpenPopup> mQuickOpenPopup;
     std::shared_ptr<FunctionTooltipWidget> mFunctionTip;
 
     std::shared_ptr<VisitHistoryManager> mVisitHistoryManager;
@@ -912,6 +940,8 @@ private:
     bool mCheckSyntaxInBack;
     bool mShouldRemoveAllSettings;
     PCompileSuccessionTask mCompileSuccessionTask;
+    // written by the running program
+    QString mHeapProfileFile;
 
     QMap<QWidget*, PTabWidgetInfo> mTabInfosData;
     QMap<QWidget*, PTabWidgetInfo> mTabMessagesData;
@@ -929,7 +959,9 @@ private:
     QColor mErrorColor;
     CompileIssuesState mCompileIssuesState;
 
-    QSet<QString> mFilesChangedNotifying;
+    // changes reported while the user is asked about the previous ones
+    bool mFilesChangedNotifying;
+    FileChangeSet mPendingFileChanges;
 
     //actions for compile issue table
     QAction * mTableIssuesCopyAction;
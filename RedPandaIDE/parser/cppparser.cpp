@@ -18,6 +18,7 @@
 #include "parserutils.h"
 #include "../utils.h"
 #include "qsynedit/syntaxer/cpp.h"
+#include "qt_utils/tracer.h"
 
 #include <QApplication>
 #include <QDate>
@@ -29,6 +30,30 @@
 
 static QAtomicInt cppParserCount(0);
 
+// evaluation caches are dropped if they grow too large before the next parse
+static const int MaxEvalCacheSize = 10000;
+
+template <typename Cache, typename Key, typename Value>
+static void addToEvalCache(Cache& cache, const Key& key, const Value& value)
+{
+    if (cache.count() >= MaxEvalCacheSize)
+        cache.clear();
+    cache.insert(key, value);
+}
+
+static QString scopeCacheKey(const QString& fileName, const PStatement& scope)
+{
+    return QString("%1\n%2\n").arg(fileName).arg(reinterpret_cast<quintptr>(scope.get()));
+}
+
+// the cached eval statements are copied, since callers may change them
+static PEvalStatement copyEvalStatement(const PEvalStatement& statement)
+{
+    if (!statement)
+        return PEvalStatement();
+    return std::make_shared<EvalStatement>(*statement);
+}
+
 static QString calcFullname(const QString& parentName, const QString& name) {
     QString s;
     s.reserve(parentName.size()+2+name.size());
@@ -635,6 +660,19 @@ PStatement CppParser::doFindAliasedStatement(const PStatement &statement) const
 {
     if (!statement)
         return PStatement();
+    if (!mParsing) {
+        auto it = mAliasedStatementCache.constFind(statement.get());
+        if (it != mAliasedStatementCache.constEnd())
+            return it.value();
+        PStatement result = doFindAliasedStatementUncached(statement);
+        addToEvalCache(mAliasedStatementCache, statement.get(), result);
+        return result;
+    }
+    return doFindAliasedStatementUncached(statement);
+}
+
+PStatement CppParser::doFindAliasedStatementUncached(const PStatement &statement) const
+{
     QString alias = statement->type;
     int pos = statement->type.lastIndexOf("::");
     if (pos<0)
@@ -829,6 +867,21 @@ QSet<QString> CppParser::getIncludedFiles(const QString &filename)
     return internalGetIncludedFiles(filename);
 }
 
+FileIdSet CppParser::getIncludedFileIds(const QString &filename)
+{
+    QMutexLocker locker(&mMutex);
+    FileIdSet result;
+    if (mParsing)
+        return result;
+    if (filename.isEmpty())
+        return result;
+    result.insert(FileTable::instance()->intern(filename));
+    PFileIncludes fileIncludes = mPreprocessor.findFileIncludes(filename);
+    if (fileIncludes)
+        result.unite(fileIncludes->includeFileIds);
+    return result;
+}
+
 QSet<QString> CppParser::getFileUsings(const QString &filename)
 {
     QMutexLocker locker(&mMutex);
@@ -917,9 +970,39 @@ void CppParser::invalidateFile(const QString &fileName)
     }
     QSet<QString> files = calculateFilesToBeReparsed(fileName);
     internalInvalidateFiles(files);
+    flushInvalidatedIncludes();
     mParsing = false;
 }
 
+bool CppParser::invalidateFiles(const QSet<QString> &fileNames)
+{
+    if (!mEnabled)
+        return true;
+    {
+        QMutexLocker locker(&mMutex);
+        if (mParsing || mLockCount>0)
+            return false;
+        updateSerialId();
+        mParsing = true;
+    }
+    QSet<QString> files;
+    foreach (const QString& fileName, fileNames) {
+        if (mPreprocessor.fileScanned(fileName) || mProjectFiles.contains(fileName))
+            files.unite(calculateFilesToBeReparsed(fileName));
+    }
+    internalInvalidateFiles(files);
+    flushInvalidatedIncludes();
+    {
+        QMutexLocker locker(&mMutex);
+        foreach (const QString& file, files) {
+            if (mProjectFiles.contains(file))
+                mFilesToScan.insert(file);
+        }
+    }
+    mParsing = false;
+    return true;
+}
+
 bool CppParser::isIncludeLine(const QString &line)
 {
     QString trimmedLine = line.trimmed();
@@ -970,6 +1053,7 @@ void CppParser::parseFile(const QString &fileName, bool inProject, bool onlyIfNo
     }
     {
         auto action = finally([&,this]{
+            flushInvalidatedIncludes();
             mParsing = false;
 
             if (updateView)
@@ -1033,6 +1117,7 @@ void CppParser::parseFileList(bool updateView)
     }
     {
         auto action = finally([&,this]{
+            flushInvalidatedIncludes();
             mParsing = false;
             if (updateView)
                 emit onEndParsing(mFilesScannedCount,1);
@@ -1111,6 +1196,7 @@ void CppParser::resetParser()
             mParsing = false;
         });
         emit  onBusy();
+        updateSerialId();
         mUniqId = 0;
 
         mParseLocalHeaders = true;
@@ -1135,6 +1221,8 @@ void CppParser::resetParser()
         mClassInheritances.clear();
         mPreprocessor.clear();
         mTokenizer.clear();
+        mInvalidatedIncludes.clear();
+        mIncludeGraphVersion.fetchAndAddRelaxed(1);
     }
 }
 
@@ -1398,6 +1486,7 @@ PStatement CppParser::addStatement(const PStatement& parent,
                 }
                 oldStatement->definitionLine = line;
                 oldStatement->definitionFileName = fileName;
+                oldStatement->definitionFileId = FileTable::instance()->intern(fileName);
                 return oldStatement;
             }
         }
@@ -1422,6 +1511,8 @@ PStatement CppParser::addStatement(const PStatement& parent,
     result->definitionLine = line;
     result->fileName = fileName;
     result->definitionFileName = fileName;
+    result->fileId = FileTable::instance()->intern(fileName);
+    result->definitionFileId = result->fileId;
     if (!fileName.isEmpty()) {
         result->setInProject(mIsProjectFile);
         result->setInSystemHeader(mIsSystemHeader);
@@ -2429,10 +2520,19 @@ PStatement CppParser::doFindTypeDefinitionOf(const QString &fileName, const QStr
     if (position >= 0)
         s = s.mid(position+1);
 
-    PStatement scopeStatement = currentClass;
+    QString cacheKey;
+    if (!mParsing) {
+        cacheKey = scopeCacheKey(fileName, currentClass) + aType;
+        auto it = mTypeDefinitionCache.constFind(cacheKey);
+        if (it != mTypeDefinitionCache.constEnd())
+            return it.value();
+    }
 
     PStatement statement = doFindStatementOf(fileName,s,currentClass);
-    return getTypeDef(statement,fileName,aType);
+    PStatement result = getTypeDef(statement,fileName,aType);
+    if (!cacheKey.isEmpty())
+        addToEvalCache(mTypeDefinitionCache, cacheKey, result);
+    return result;
 }
 
 QString CppParser::doFindFirstTemplateParamOf(const QString &fileName, const QString &phrase, const PStatement &currentScope) const
@@ -2447,24 +2547,39 @@ QString CppParser::doFindTemplateParamOf(const QString &fileName, const QString
     // Remove pointer stuff from type
     QString s = phrase; // 'Type' is a keyword
     int i = s.indexOf('<');
+    // template arguments are parsed from the phrase itself, so they are cached
+    // by the phrase only; otherwise the phrase is looked up in the scope
+    QString cacheKey;
+    if (!mParsing) {
+        if (i>=0)
+            cacheKey = QString("%1\n%2").arg(index).arg(phrase);
+        else
+            cacheKey = scopeCacheKey(fileName, currentScope) + QString("%1\n%2").arg(index).arg(phrase);
+        auto it = mTemplateParamCache.constFind(cacheKey);
+        if (it != mTemplateParamCache.constEnd())
+            return it.value();
+    }
+    QString result;
     if (i>=0) {
         i=getTemplateParamStart(s,i,index);
         int t=getTemplateParamEnd(s,i);
         //qDebug()<<index<<s<<s.mid(i,t-i)<<i<<t;
-        return s.mid(i,t-i).replace(QRegularExpression("\\s+"),"");
-    }
-    int position = s.length()-1;
-    while ((position >= 0) && (s[position] == '*'
-                               || s[position] == ' '
-                               || s[position] == '&'))
-        position--;
-    if (position != s.length()-1)
-        s.truncate(position+1);
-
-    PStatement scopeStatement = currentScope;
-
-    PStatement statement = doFindStatementOf(fileName,s,currentScope);
-    return getTemplateParam(statement,fileName, phrase,index, currentScope);
+        result = s.mid(i,t-i).replace(QRegularExpression("\\s+"),"");
+    } else {
+        int position = s.length()-1;
+        while ((position >= 0) && (s[position] == '*'
+                                   || s[position] == ' '
+                                   || s[position] == '&'))
+            position--;
+        if (position != s.length()-1)
+            s.truncate(position+1);
+
+        PStatement statement = doFindStatementOf(fileName,s,currentScope);
+        result = getTemplateParam(statement,fileName, phrase,index, currentScope);
+    }
+    if (!cacheKey.isEmpty())
+        addToEvalCache(mTemplateParamCache, cacheKey, result);
+    return result;
 }
 
 //int CppParser::getCurrentBlockEndSkip() const
@@ -4500,6 +4615,7 @@ void CppParser::skipRequires()
 
 void CppParser::internalParse(const QString &fileName)
 {
+    TraceSpan traceSpan("CppParser::internalParse");
     // Perform some validation before we start
     if (!mEnabled)
         return;
@@ -4515,6 +4631,8 @@ void CppParser::internalParse(const QString &fileName)
     // Let the preprocessor augment the include records
     mPreprocessor.setScanOptions(mParseGlobalHeaders, mParseLocalHeaders);
     mPreprocessor.preprocess(fileName);
+    if (includesChangedByParse(fileName))
+        mIncludeGraphVersion.fetchAndAddRelaxed(1);
 
     QStringList preprocessResult = mPreprocessor.result();
 #ifdef QT_DEBUG
@@ -4621,7 +4739,7 @@ PStatement CppParser::findMacro(const QString &phrase, const QString &fileName)
     PFileIncludes includes = mPreprocessor.findFileIncludes(fileName);
     foreach (const PStatement& s, statements) {
         if (s->kind == StatementKind::skPreprocessor) {
-            if (includes && fileName != s->fileName && !includes->includeFiles.contains(s->fileName))
+            if (includes && fileName != s->fileName && !includes->includeFileIds.contains(s->fileId))
                 continue;
             return s;
         }
@@ -4687,8 +4805,8 @@ PStatement CppParser::findMemberOfStatement(const QString& filename,
                 return s; // hard defines
             } if (s->fileName == filename || s->definitionFileName==filename) {
                 return s;
-            } else if (fileIncludes && (fileIncludes->includeFiles.contains(s->fileName)
-                    || fileIncludes->includeFiles.contains(s->definitionFileName))) {
+            } else if (fileIncludes && (fileIncludes->includeFileIds.contains(s->fileId)
+                    || fileIncludes->includeFileIds.contains(s->definitionFileId))) {
                 return s;
             }
         }
@@ -4770,6 +4888,19 @@ PEvalStatement CppParser::doEvalExpression(const QString& fileName,
                                        bool freeScoped,
                                        bool expandMacros) const
 {
+    // evaluations of whole expressions are cached, the partial ones
+    // depend on the previous results
+    QString cacheKey;
+    if (!mParsing && !previousResult) {
+        cacheKey = scopeCacheKey(fileName, scope)
+                + QString("%1 %2 %3\n").arg(pos).arg(int(freeScoped)).arg(int(expandMacros))
+                + phraseExpression.join('\n');
+        auto it = mEvalExpressionCache.constFind(cacheKey);
+        if (it != mEvalExpressionCache.constEnd()) {
+            pos = it->pos;
+            return copyEvalStatement(it->result);
+        }
+    }
     if (expandMacros) {
         QList<QSet<QString>> usedMacros;
         usedMacros.reserve(phraseExpression.length());
@@ -4792,12 +4923,15 @@ PEvalStatement CppParser::doEvalExpression(const QString& fileName,
             i++;
         }
     }
-    return doEvalPointerArithmetic(fileName,
+    PEvalStatement result = doEvalPointerArithmetic(fileName,
                                         phraseExpression,
                                         pos,
                                         scope,
                                         previousResult,
                                    freeScoped);
+    if (!cacheKey.isEmpty())
+        addToEvalCache(mEvalExpressionCache, cacheKey, EvalCacheEntry{copyEvalStatement(result), pos});
+    return result;
 }
 
 PEvalStatement CppParser::doEvalPointerArithmetic(const QString &fileName, const QStringList &phraseExpression, int &pos, const PStatement &scope, const PEvalStatement &previousResult, bool freeScoped) const
@@ -6005,6 +6139,8 @@ void CppParser::internalInvalidateFile(const QString &fileName)
 
     // remove its include files list
     PFileIncludes p = findFileIncludes(fileName, true);
+    if (p && !mInvalidatedIncludes.contains(fileName))
+        mInvalidatedIncludes.insert(fileName, p->directIncludes);
     if (p) {
         //fPreprocessor.InvalidDefinesInFile(FileName); //we don't need this, since we reset defines after each parse
         //p->includeFiles.clear();
@@ -6015,6 +6151,7 @@ void CppParser::internalInvalidateFile(const QString &fileName)
             } else {
                 statement->setHasDefinition(false);
                 statement->definitionFileName = statement->fileName;
+                statement->definitionFileId = statement->fileId;
                 statement->definitionLine = statement->line;
             }
         }
@@ -6060,6 +6197,33 @@ void CppParser::internalInvalidateFiles(const QSet<QString> &files)
         internalInvalidateFile(file);
 }
 
+bool CppParser::includesChangedByParse(const QString &fileName)
+{
+    // a file parsed for the first time adds new includes
+    bool changed = !mInvalidatedIncludes.contains(fileName);
+    // headers invalidated with the file may be scanned by its preprocessing
+    for (auto it = mInvalidatedIncludes.begin(); it != mInvalidatedIncludes.end();) {
+        PFileIncludes fileIncludes = mPreprocessor.findFileIncludes(it.key());
+        if (!fileIncludes) {
+            ++it;
+            continue;
+        }
+        if (fileIncludes->directIncludes != it.value())
+            changed = true;
+        it = mInvalidatedIncludes.erase(it);
+    }
+    return changed;
+}
+
+void CppParser::flushInvalidatedIncludes()
+{
+    // files invalidated but not parsed again have lost their includes
+    if (mInvalidatedIncludes.isEmpty())
+        return;
+    mInvalidatedIncludes.clear();
+    mIncludeGraphVersion.fetchAndAddRelaxed(1);
+}
+
 QSet<QString> CppParser::calculateFilesToBeReparsed(const QString &fileName)
 {
     if (fileName.isEmpty())
@@ -6368,7 +6532,18 @@ bool CppParser::isTypeStatement(StatementKind kind) const
 
 void CppParser::updateSerialId()
 {
+    mSerialCount++;
     mSerialId = QString("%1 %2").arg(mParserId).arg(mSerialCount);
+    // statements will be changed
+    clearEvalCaches();
+}
+
+void CppParser::clearEvalCaches()
+{
+    mEvalExpressionCache.clear();
+    mTypeDefinitionCache.clear();
+    mTemplateParamCache.clear();
+    mAliasedStatementCache.clear();
 }
 
 int CppParser::indexOfNextSemicolon(int index, int endIndex)
@@ -6734,6 +6909,11 @@ int CppParser::parserId() const
     return mParserId;
 }
 
+int CppParser::includeGraphVersion() const
+{
+    return mIncludeGraphVersion.loadAcquire();
+}
+
 void CppParser::setOnGetFileStream(const GetFileStreamCallBack &newOnGetFileStream)
 {
     mPreprocessor.setOnGetFileStream(newOnGetFileStream);
@@ -17,6 +17,7 @@
 #ifndef CPPPARSER_H
 #define CPPPARSER_H
 
+#include <QAtomicInt>
 #include <QMutex>
 #include <QObject>
 #include <QThread>
@@ -99,11 +100,16 @@ public:
     QStringList getClassesList();
     QStringList getFileDirectIncludes(const QString& filename);
     QSet<QString> getIncludedFiles(const QString& filename);
+    FileIdSet getIncludedFileIds(const QString& filename);
     QSet<QString> getFileUsings(const QString& filename);
 
     QString getHeaderFileName(const QString& relativeTo, const QString& headerName, bool fromNext=false);// both
 
     void invalidateFile(const QString& fileName);
+    // invalidates the files and the project files including them, the project
+    // files are parsed again by the next parseFileList().
+    // false if the parser is busy.
+    bool invalidateFiles(const QSet<QString>& fileNames);
     bool isLineVisible(const QString& fileName, int line);
     bool isIncludeLine(const QString &line);
     bool isIncludeNextLine(const QString &line);
@@ -134,6 +140,9 @@ public:
 
     const QString &serialId() const;
 
+    // changed each time a file includes different files
+    int includeGraphVersion() const;
+
     bool parseLocalHeaders() const;
     void setParseLocalHeaders(bool newParseLocalHeaders);
 
@@ -261,6 +270,7 @@ private:
                                const QStringList& expression,
                                int line) const;
     PStatement doFindAliasedStatement(const PStatement& statement) const;
+    PStatement doFindAliasedStatementUncached(const PStatement& statement) const;
 
     QList<PStatement> doListTypeStatements(const QString& fileName,int line) const;
 
@@ -529,6 +539,8 @@ private:
                                       const PStatement& scope) const;
     void internalInvalidateFile(const QString& fileName);
     void internalInvalidateFiles(const QSet<QString>& files);
+    bool includesChangedByParse(const QString& fileName);
+    void flushInvalidatedIncludes();
     QSet<QString> calculateFilesToBeReparsed(const QString& fileName);
 //    int calcKeyLenForStruct(const QString& word);
 //    {
@@ -665,6 +677,7 @@ private:
     bool isTypeStatement(StatementKind kind) const;
 
     void updateSerialId();
+    void clearEvalCaches();
 
     int indexOfNextSemicolon(int index, int endIndex=-1);
     int indexOfNextPeriodOrSemicolon(int index, int endIndex=-1);
@@ -689,6 +702,9 @@ private:
     ParserLanguage mLanguage;
     int mSerialCount;
     QString mSerialId;
+    QAtomicInt mIncludeGraphVersion;
+    // direct includes of the invalidated files before they are parsed again
+    QHash<QString,QStringList> mInvalidatedIncludes;
     int mUniqId;
     bool mEnabled;
     int mIndex;
@@ -718,6 +734,16 @@ private:
     bool mIsProjectFile;
     int mLockCount; // lock(don't reparse) when we need to find statements in a batch
     bool mParsing;
+    // Results of the evaluations, valid until the statements are changed.
+    // They are only used when not parsing, so mMutex guards them.
+    struct EvalCacheEntry {
+        PEvalStatement result;
+        int pos; // pos after the evaluation
+    };
+    mutable QHash<QString,EvalCacheEntry> mEvalExpressionCache;
+    mutable QHash<QString,PStatement> mTypeDefinitionCache;
+    mutable QHash<QString,QString> mTemplateParamCache;
+    mutable QHash<const Statement*,PStatement> mAliasedStatementCache;
     QHash<QString,PStatementList> mNamespaces;  // namespace and the statements in its scope
     QList<PClassInheritanceInfo> mClassInheritances;
     QSet<QString> mInlineNamespaces;
@@ -793,8 +793,10 @@ void CppPreprocessor::openInclude(QString fileName)
         if (topFile->fileIncludes->includeFiles.contains(fileName)) {
             return; //already included
         }
+        FileId fileId = FileTable::instance()->intern(fileName);
         for (PParsedFile& parsedFile:mIncludes) {
             parsedFile->fileIncludes->includeFiles.insert(fileName,false);
+            parsedFile->fileIncludes->includeFileIds.insert(fileId);
         }
         // Backup old position if we're entering a new file
         PParsedFile innerMostFile = mIncludes.back();
@@ -861,6 +863,7 @@ void CppPreprocessor::openInclude(QString fileName)
                 foreach (const QString& incFile,fileIncludes->includeFiles.keys()) {
                     file->fileIncludes->includeFiles.insert(incFile,false);
                 }
+                file->fileIncludes->includeFileIds.unite(fileIncludes->includeFileIds);
             }
         }
     }
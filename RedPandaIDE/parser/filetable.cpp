@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "filetable.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include "parserutils.h"
+#include "../utils.h"
+
+// the cache is dropped if include path sets keep changing
+static const int MaxIncludePathSets = 64;
+
+static bool isFullFileName(const QString& fileName)
+{
+#ifdef Q_OS_WIN
+    return fileName.startsWith("/") || (fileName.length()>2 && fileName[1]==':');
+#else
+    return fileName.startsWith("/");
+#endif
+}
+
+static FileKind fileKindOfName(const QString &fileName)
+{
+    if (isHFile(fileName))
+        return FileKind::Header;
+    if (isCFile(fileName))
+        return FileKind::Source;
+    return FileKind::Other;
+}
+
+void FileIdSet::insert(FileId id)
+{
+    if (id <= 0)
+        return;
+    size_t word = static_cast<size_t>(id) / 64;
+    if (word >= mBits.size())
+        mBits.resize(word+1, 0);
+    mBits[word] |= quint64(1) << (id % 64);
+}
+
+void FileIdSet::unite(const FileIdSet &other)
+{
+    if (other.mBits.size() > mBits.size())
+        mBits.resize(other.mBits.size(), 0);
+    for (size_t i=0;i<other.mBits.size();i++)
+        mBits[i] |= other.mBits[i];
+}
+
+void FileIdSet::clear()
+{
+    mBits.clear();
+}
+
+bool FileIdSet::isEmpty() const
+{
+    for (quint64 word:mBits) {
+        if (word != 0)
+            return false;
+    }
+    return true;
+}
+
+FileTable::FileTable()
+{
+    // id 0 is the empty file name (hard defines)
+    mEntries.append(FileEntry{QString(), FileKind::Other});
+    mIds.insert(QString(), 0);
+}
+
+FileTable *FileTable::instance()
+{
+    static FileTable table;
+    return &table;
+}
+
+FileId FileTable::intern(const QString &fileName)
+{
+    if (fileName.isEmpty())
+        return 0;
+    {
+        QReadLocker locker(&mLock);
+        auto it = mIds.constFind(fileName);
+        if (it != mIds.constEnd())
+            return it.value();
+    }
+    FileKind kind = fileKindOfName(fileName);
+    QWriteLocker locker(&mLock);
+    auto it = mIds.constFind(fileName);
+    if (it != mIds.constEnd())
+        return it.value();
+    FileId id = mEntries.count();
+    mEntries.append(FileEntry{fileName, kind});
+    mIds.insert(fileName, id);
+    return id;
+}
+
+FileId FileTable::find(const QString &fileName) const
+{
+    QReadLocker locker(&mLock);
+    return mIds.value(fileName, 0);
+}
+
+QString FileTable::fileName(FileId id) const
+{
+    QReadLocker locker(&mLock);
+    if (id < 0 || id >= mEntries.count())
+        return QString();
+    return mEntries[id].fileName;
+}
+
+FileKind FileTable::kind(FileId id) const
+{
+    QReadLocker locker(&mLock);
+    if (id < 0 || id >= mEntries.count())
+        return FileKind::Other;
+    return mEntries[id].kind;
+}
+
+int FileTable::count() const
+{
+    QReadLocker locker(&mLock);
+    return mEntries.count();
+}
+
+bool FileTable::isInIncludePaths(const QString &fileName, const QSet<QString> &includePaths)
+{
+    if (fileName.isEmpty() || includePaths.isEmpty())
+        return false;
+    FileId id = intern(fileName);
+    quint64 key;
+    {
+        QWriteLocker locker(&mLock);
+        key = (quint64(includePathSetId(includePaths)) << 32) | quint64(id);
+        auto it = mInIncludePathsCache.constFind(key);
+        if (it != mInIncludePathsCache.constEnd())
+            return it.value();
+    }
+    bool result = false;
+    // files may be created later, so only the existing files are cached
+    bool cacheable = false;
+    if (isFullFileName(fileName)) {
+        QFileInfo info(fileName);
+        // If it's a full file name, check if its directory is an include path
+        if (info.exists()) {
+            cacheable = true;
+            QString absPath = includeTrailingPathDelimiter(info.dir().absolutePath());
+            foreach (const QString& incPath, includePaths) {
+                if (absPath.startsWith(incPath)) {
+                    result = true;
+                    break;
+                }
+            }
+        }
+    } else {
+        //check if it's in the include dir
+        for (const QString& includePath: includePaths) {
+            QDir dir(includePath);
+            if (dir.exists(fileName)) {
+                result = true;
+                break;
+            }
+        }
+    }
+    if (result || cacheable) {
+        QWriteLocker locker(&mLock);
+        // the cache may be dropped by other threads meanwhile
+        if (includePathSetId(includePaths) == int(key >> 32))
+            mInIncludePathsCache.insert(key, result);
+    }
+    return result;
+}
+
+int FileTable::includePathSetId(const QSet<QString> &includePaths)
+{
+    // include paths are member sets of the preprocessors,
+    // comparing the copies is cheap while they share the data
+    for (int i=0;i<mIncludePathSets.count();i++) {
+        if (mIncludePathSets[i] == includePaths)
+            return i;
+    }
+    if (mIncludePathSets.count() >= MaxIncludePathSets) {
+        mIncludePathSets.clear();
+        mInIncludePathsCache.clear();
+    }
+    mIncludePathSets.append(includePaths);
+    return mIncludePathSets.count()-1;
+}
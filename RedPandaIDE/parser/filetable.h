@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FILETABLE_H
+#define FILETABLE_H
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <vector>
+
+// id of an interned file name, 0 is the empty file name
+using FileId = int;
+
+enum class FileKind {
+    Other,
+    Header,
+    Source
+};
+
+/**
+ * @brief Set of file ids, stored as a bitset
+ */
+class FileIdSet {
+public:
+    void insert(FileId id);
+    bool contains(FileId id) const {
+        if (id <= 0)
+            return false;
+        size_t word = static_cast<size_t>(id) / 64;
+        return word < mBits.size() && (mBits[word] & (quint64(1) << (id % 64)));
+    }
+    void unite(const FileIdSet& other);
+    void clear();
+    bool isEmpty() const;
+private:
+    std::vector<quint64> mBits;
+};
+
+/**
+ * @brief Process wide table of file names.
+ *
+ * Each file name gets a small integer id the first time it's interned, which
+ * never changes. Attributes derived from the name are computed only once.
+ *
+ * Thread safe.
+ */
+class FileTable
+{
+public:
+    static FileTable* instance();
+
+    FileId intern(const QString& fileName);
+    // 0 if the file name is not interned yet
+    FileId find(const QString& fileName) const;
+    QString fileName(FileId id) const;
+    FileKind kind(FileId id) const;
+    int count() const;
+
+    // if the file is in one of the include paths
+    bool isInIncludePaths(const QString& fileName, const QSet<QString>& includePaths);
+
+    FileTable(const FileTable&)=delete;
+    FileTable& operator=(const FileTable&)=delete;
+private:
+    FileTable();
+    int includePathSetId(const QSet<QString>& includePaths);
+private:
+    struct FileEntry {
+        QString fileName;
+        FileKind kind;
+    };
+    QVector<FileEntry> mEntries;
+    QHash<QString, FileId> mIds;
+    // include path sets are numbered to key the cache below
+    QVector<QSet<QString>> mIncludePathSets;
+    // (include path set id, file id) -> if the file is in the include paths
+    QHash<quint64, bool> mInIncludePathsCache;
+    mutable QReadWriteLock mLock;
+};
+
+#endif // FILETABLE_H
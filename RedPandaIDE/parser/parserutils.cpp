@@ -22,6 +22,7 @@
 #include <QDebug>
 #include <QGlobalStatic>
 #include "../utils.h"
+#include "filetable.h"
 
 QStringList CppDirectives;
 QStringList JavadocTags;
@@ -487,37 +488,7 @@ QString getSystemHeaderFilename(const QString &fileName, const QStringList& incl
 
 bool isSystemHeaderFile(const QString &fileName, const QSet<QString> &includePaths)
 {
-    if (fileName.isEmpty())
-        return false;
-    if (includePaths.isEmpty())
-        return false;
-    bool isFullName = false;
-
-#ifdef Q_OS_WIN
-    isFullName = fileName.startsWith("/") || (fileName.length()>2 && fileName[1]==':');
-#else
-    isFullName = fileName.startsWith("/");
-#endif
-    if (isFullName) {
-        QFileInfo info(fileName);
-        // If it's a full file name, check if its directory is an include path
-        if (info.exists()) { // full file name
-            QDir dir = info.dir();
-            QString absPath = includeTrailingPathDelimiter(dir.absolutePath());
-            foreach (const QString& incPath, includePaths) {
-                if (absPath.startsWith(incPath))
-                    return true;
-            }
-        }
-    } else {
-        //check if it's in the include dir
-        for (const QString& includePath: includePaths) {
-            QDir dir(includePath);
-            if (dir.exists(fileName))
-                return true;
-        }
-    }
-    return false;
+    return FileTable::instance()->isInIncludePaths(fileName, includePaths);
 }
 
 bool isCppKeyword(const QString &word)
@@ -525,14 +496,25 @@ bool isCppKeyword(const QString &word)
     return CppKeywords.contains(word);
 }
 
+// same as QFileInfo::suffix().toLower(), without creating the QFileInfo
+static QString lowerSuffix(const QString& filename)
+{
+    for (int i=filename.length()-1;i>=0;i--) {
+        QChar ch = filename[i];
+        if (ch == '.')
+            return filename.mid(i+1).toLower();
+        if (ch == '/' || ch == QDir::separator())
+            break;
+    }
+    return QString();
+}
+
 bool isHFile(const QString& filename)
 {
     if (filename.isEmpty())
         return false;
 
-    QFileInfo fileInfo(filename);
-    return CppHeaderExts->contains(fileInfo.suffix().toLower());
-
+    return CppHeaderExts->contains(lowerSuffix(filename));
 }
 
 bool isCFile(const QString& filename)
@@ -540,8 +522,7 @@ bool isCFile(const QString& filename)
     if (filename.isEmpty())
         return false;
 
-    QFileInfo fileInfo(filename);
-    return CppSourceExts->contains(fileInfo.suffix().toLower());
+    return CppSourceExts->contains(lowerSuffix(filename));
 }
 
 PStatement CppScopes::findScopeAtLine(int line)
@@ -22,6 +22,7 @@
 #include <QVector>
 #include <memory>
 #include <functional>
+#include "filetable.h"
 
 using GetFileStreamCallBack = std::function<bool (const QString&, QStringList&)>;
 
@@ -191,6 +192,8 @@ struct Statement {
     int definitionLine; // definition
     QString fileName; // declaration
     QString definitionFileName; // definition
+    FileId fileId = 0; // interned fileName
+    FileId definitionFileId = 0; // interned definitionFileName
     StatementMap children; // functions can be overloaded,so we use list to save children with the same name
     QSet<QString> friends; // friend class / functions
     QString fullName; // fullname(including class and namespace), ClassA::foo
@@ -311,6 +314,7 @@ using PClassInheritanceInfo = std::shared_ptr<ClassInheritanceInfo>;
 struct FileIncludes {
     QString baseFile;
     QMap<QString, bool> includeFiles; // true means the file is directly included, false means included indirectly
+    FileIdSet includeFileIds; // ids of includeFiles
     QStringList directIncludes; //
     QSet<QString> usings; // namespaces it usings
     StatementMap statements; // but we don't save temporary statements (full name as key)
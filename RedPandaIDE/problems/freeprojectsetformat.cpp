@@ -70,9 +70,9 @@ QList<POJProblem> importFreeProblemSet(const QString &filename)
             break;
         case QXmlStreamReader::TokenType::Characters:
             if (currentCase && currentProblem && currentEleName=="test_input") {
-                    currentCase->input = xml.text().toString();
+                    currentCase->setInput(xml.text().toString());
             } else if (currentCase && currentProblem && currentEleName=="test_output" ) {
-                currentCase->expected = xml.text().toString();
+                currentCase->setExpected(xml.text().toString());
                 currentProblem->cases.append(currentCase);
                 currentCase.reset();
             } else if (currentProblem &&  currentEleName=="description") {
@@ -168,10 +168,10 @@ void exportFreeProblemSet(const QList<POJProblem> &problems, const QString &file
             foreach(const POJProblemCase& pCase, problem->cases) {
                 writer.writeStartElement("test_input");
                 writer.writeAttribute("name",pCase->name);
-                writer.writeCDATA(pCase->input);
+                writer.writeCDATA(pCase->input());
                 writer.writeEndElement(); //test_input
                 writer.writeStartElement("test_output");
-                writer.writeCDATA(pCase->expected);
+                writer.writeCDATA(pCase->expected());
                 writer.writeEndElement(); //test_output
             }
             {
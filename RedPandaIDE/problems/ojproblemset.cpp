@@ -16,7 +16,12 @@
  */
 #include "ojproblemset.h"
 
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QTextCodec>
 #include <QUuid>
+#include "qt_utils/utils.h"
 
 OJProblemCase::OJProblemCase():
     testState(ProblemCaseTestState::NotTested),
@@ -33,6 +38,75 @@ const QString &OJProblemCase::getId() const
     return id;
 }
 
+QString OJProblemCase::input()
+{
+    return mInput.text(mDataDir);
+}
+
+void OJProblemCase::setInput(const QString &newInput)
+{
+    mInput.setText(newInput);
+}
+
+QString OJProblemCase::expected()
+{
+    return mExpected.text(mDataDir);
+}
+
+void OJProblemCase::setExpected(const QString &newExpected)
+{
+    mExpected.setText(newExpected);
+}
+
+QString OJProblemCase::inputPreview(int maxLength, bool &truncated) const
+{
+    return mInput.preview(mDataDir, maxLength, truncated);
+}
+
+QString OJProblemCase::expectedPreview(int maxLength, bool &truncated) const
+{
+    return mExpected.preview(mDataDir, maxLength, truncated);
+}
+
+QString OJProblemCase::inputDataFile() const
+{
+    return mInput.dataFile(mDataDir);
+}
+
+QString OJProblemCase::inputHash() const
+{
+    return mInput.hash();
+}
+
+QString OJProblemCase::expectedHash() const
+{
+    return mExpected.hash();
+}
+
+void OJProblemCase::setData(const QString &dataDir, const QString &inputHash, const QString &expectedHash)
+{
+    mDataDir = dataDir;
+    mInput.setHash(inputHash);
+    mExpected.setHash(expectedHash);
+}
+
+bool OJProblemCase::saveData(const QString &dataDir)
+{
+    if (!mInput.save(mDataDir, dataDir))
+        return false;
+    if (!mExpected.save(mDataDir, dataDir))
+        return false;
+    mDataDir = dataDir;
+    unloadData();
+    return true;
+}
+
+void OJProblemCase::unloadData()
+{
+    mInput.unload();
+    mExpected.unload();
+}
+
 size_t OJProblem::getTimeLimit()
 {
     switch(timeLimitUnit) {
@@ -63,3 +137,148 @@ OJProblem::OJProblem() :
 {
 
 }
+
+OJProblemCaseData::OJProblemCaseData():
+    mLoaded(true),
+    mModified(false)
+{
+
+}
+
+QString OJProblemCaseData::text(const QString &dataDir)
+{
+    QMutexLocker locker(&mMutex);
+    if (!mLoaded) {
+        QString filename = doDataFile(dataDir);
+        if (!filename.isEmpty())
+            mText = QString::fromUtf8(readFileToByteArray(filename));
+        mLoaded = true;
+    }
+    return mText;
+}
+
+void OJProblemCaseData::setText(const QString &newText)
+{
+    QMutexLocker locker(&mMutex);
+    if (mLoaded && newText == mText)
+        return;
+    mText = newText;
+    mLoaded = true;
+    mModified = true;
+}
+
+QString OJProblemCaseData::preview(const QString &dataDir, int maxLength, bool &truncated) const
+{
+    QMutexLocker locker(&mMutex);
+    if (mLoaded) {
+        truncated = (mText.length()>maxLength);
+        return mText.left(maxLength);
+    }
+    truncated = false;
+    QString filename = doDataFile(dataDir);
+    locker.unlock();
+    if (filename.isEmpty())
+        return QString();
+    return readProblemCaseFilePreview(filename, maxLength, truncated);
+}
+
+QString OJProblemCaseData::dataFile(const QString &dataDir) const
+{
+    QMutexLocker locker(&mMutex);
+    return doDataFile(dataDir);
+}
+
+QString OJProblemCaseData::doDataFile(const QString &dataDir) const
+{
+    if (mModified || mHash.isEmpty() || dataDir.isEmpty())
+        return QString();
+    return QDir(dataDir).absoluteFilePath(mHash);
+}
+
+QString OJProblemCaseData::hash() const
+{
+    QMutexLocker locker(&mMutex);
+    return mHash;
+}
+
+void OJProblemCaseData::setHash(const QString &newHash)
+{
+    QMutexLocker locker(&mMutex);
+    mHash = newHash;
+    mText.clear();
+    mLoaded = mHash.isEmpty();
+    mModified = false;
+}
+
+bool OJProblemCaseData::save(const QString &oldDataDir, const QString &newDataDir)
+{
+    QMutexLocker locker(&mMutex);
+    QDir dir(newDataDir);
+    if (mModified) {
+        if (mText.isEmpty()) {
+            mHash.clear();
+        } else {
+            QByteArray content = mText.toUtf8();
+            mHash = QCryptographicHash::hash(content, QCryptographicHash::Sha1).toHex();
+            QString filename = dir.absoluteFilePath(mHash);
+            if (!fileExists(filename)) {
+                // write to a temp file first, so a broken file never gets the hash name
+                QString tempFilename = filename + ".tmp";
+                QFile file(tempFilename);
+                if (!file.open(QFile::WriteOnly | QFile::Truncate))
+                    return false;
+                if (file.write(content)!=content.length()) {
+                    file.remove();
+                    return false;
+                }
+                file.close();
+                if (!QFile::rename(tempFilename, filename)) {
+                    QFile::remove(tempFilename);
+                    return false;
+                }
+            }
+        }
+        mModified = false;
+        return true;
+    }
+    if (mHash.isEmpty())
+        return true;
+    QString filename = dir.absoluteFilePath(mHash);
+    if (fileExists(filename))
+        return true;
+    // the data was loaded from another problem set, copy it
+    QString oldFilename = QDir(oldDataDir).absoluteFilePath(mHash);
+    if (!oldDataDir.isEmpty() && fileExists(oldFilename))
+        return QFile::copy(oldFilename, filename);
+    // the data file is lost, the case must not be saved as empty
+    return false;
+}
+
+void OJProblemCaseData::unload()
+{
+    QMutexLocker locker(&mMutex);
+    if (mModified || mHash.isEmpty())
+        return;
+    mText.clear();
+    mText.squeeze();
+    mLoaded = false;
+}
+
+QString readProblemCaseFilePreview(const QString &filename, int maxLength, bool &truncated)
+{
+    truncated = false;
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly))
+        return QString();
+    // a char takes at least one byte in utf-8
+    QByteArray content = file.read(maxLength);
+    truncated = !file.atEnd();
+    // the decoder drops the incomplete char at the end
+    std::unique_ptr<QTextDecoder> decoder(QTextCodec::codecForName("UTF-8")->makeDecoder());
+    QString result = decoder->toUnicode(content);
+    if (result.length()>maxLength) {
+        truncated = true;
+        result.truncate(maxLength);
+    }
+    return result;
+}
@@ -20,6 +20,7 @@
 #include <memory>
 #include <QVector>
 #include <QList>
+#include <QMutex>
 
 enum class ProblemCaseTestState {
     NotTested,
@@ -39,10 +40,36 @@ enum class ProblemMemoryLimitUnit {
     GB
 };
 
+// Input or expected output of a problem case.
+// Text is stored in content-addressed files (named by its sha1 hash) under
+// the data folder of the problem set, and only loaded when it's needed.
+// The runner thread reads it while the gui may unload it, so it's guarded
+// by a mutex, and the text is returned by value.
+class OJProblemCaseData {
+public:
+    OJProblemCaseData();
+    QString text(const QString& dataDir);
+    void setText(const QString& newText);
+    // the first maxLength chars of the text
+    QString preview(const QString& dataDir, int maxLength, bool &truncated) const;
+    // the file holding the text, or empty if the text is only in memory
+    QString dataFile(const QString& dataDir) const;
+    QString hash() const;
+    void setHash(const QString& newHash);
+    bool save(const QString& oldDataDir, const QString& newDataDir);
+    void unload();
+private:
+    QString doDataFile(const QString& dataDir) const;
+private:
+    mutable QMutex mMutex;
+    QString mText;
+    QString mHash;
+    bool mLoaded;
+    bool mModified;
+};
+
 struct OJProblemCase {
     QString name;
-    QString input;
-    QString expected;
     QString inputFileName;
     QString expectedOutputFileName;
     ProblemCaseTestState testState; // no persistence
@@ -57,8 +84,27 @@ struct OJProblemCase {
 public:
     const QString &getId() const;
 
+    QString input();
+    void setInput(const QString& newInput);
+    QString expected();
+    void setExpected(const QString& newExpected);
+    QString inputPreview(int maxLength, bool &truncated) const;
+    QString expectedPreview(int maxLength, bool &truncated) const;
+    QString inputDataFile() const;
+    QString inputHash() const;
+    QString expectedHash() const;
+    // set by the problem set model when loading, the data is read on demand
+    void setData(const QString& dataDir, const QString& inputHash, const QString& expectedHash);
+    // write the data to dataDir (if not there) and free the memory held by it
+    bool saveData(const QString& dataDir);
+    // free the memory held by the data that is saved in the data files
+    void unloadData();
+
 private:
     QString id;
+    QString mDataDir;
+    OJProblemCaseData mInput;
+    OJProblemCaseData mExpected;
 };
 
 using POJProblemCase = std::shared_ptr<OJProblemCase>;
@@ -89,4 +135,7 @@ struct OJProblemSet {
 
 using POJProblemSet  = std::shared_ptr<OJProblemSet>;
 
+// read at most maxLength chars from the start of a utf-8 text file
+QString readProblemCaseFilePreview(const QString& filename, int maxLength, bool &truncated);
+
 #endif // OJPROBLEMSET_H
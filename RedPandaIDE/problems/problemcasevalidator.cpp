@@ -30,7 +30,7 @@ bool ProblemCaseValidator::validate(POJProblemCase problemCase, ProblemCaseValid
     if (fileExists(problemCase->expectedOutputFileName))
         expected = readFileToLines(problemCase->expectedOutputFileName);
     else
-        expected = textToLines(problemCase->expected);
+        expected = textToLines(problemCase->expected());
     problemCase->outputLineCounts = output.count();
     problemCase->expectedLineCounts = expected.count();
     if (problemCase->expectedLineCounts>5000) {
@@ -25,8 +25,8 @@
 #include "projecttemplate.h"
 #include "systemconsts.h"
 #include "iconsmanager.h"
+#include "filechangewatcher.h"
 
-#include <QFileSystemWatcher>
 #include <QDir>
 #include <QFileDialog>
 #include <QFileInfo>
@@ -46,7 +46,7 @@
 
 Project::Project(const QString &filename, const QString &name,
                  EditorList* editorList,
-                 QFileSystemWatcher* fileSystemWatcher,
+                 FileChangeWatcher* fileSystemWatcher,
                  QObject *parent) :
     QObject(parent),
     mName(name),
@@ -61,10 +61,10 @@ Project::Project(const QString &filename, const QString &name,
                 std::bind(
                     &EditorList::getContentFromOpenedEditor,mEditorList,
                     std::placeholders::_1, std::placeholders::_2));
-    mFileSystemWatcher->addPath(directory());
+    mFileSystemWatcher->addDirectory(directory());
 }
 
-std::shared_ptr<Project> Project::load(const QString &filename, EditorList *editorList, QFileSystemWatcher *fileSystemWatcher, QObject *parent)
+std::shared_ptr<Project> Project::load(const QString &filename, EditorList *editorList, FileChangeWatcher *fileSystemWatcher, QObject *parent)
 {
     std::shared_ptr<Project> project=std::make_shared<Project>(filename,
                                                                "",
@@ -79,7 +79,7 @@ std::shared_ptr<Project> Project::load(const QString &filename, EditorList *edit
 
 std::shared_ptr<Project> Project::create(
         const QString &filename, const QString &name,
-        EditorList *editorList, QFileSystemWatcher *fileSystemWatcher,
+        EditorList *editorList, FileChangeWatcher *fileSystemWatcher,
         const std::shared_ptr<ProjectTemplate> pTemplate,
         bool useCpp,  QObject *parent)
 {
@@ -104,7 +104,7 @@ std::shared_ptr<Project> Project::create(
 
 Project::~Project()
 {
-    mFileSystemWatcher->removePath(directory());
+    mFileSystemWatcher->removeDirectory(directory());
     mEditorList->beginUpdate();
     foreach (const PProjectUnit& unit, mUnits) {
         Editor * editor = unitEditor(unit);
@@ -250,6 +250,7 @@ void Project::open()
         newUnit->setLink(ini.GetBoolValue(groupName,"Link", true));
         newUnit->setPriority(ini.GetLongValue(groupName,"Priority", 1000));
         newUnit->setOverrideBuildCmd(ini.GetBoolValue(groupName,"OverrideBuildCmd", false));
+        newUnit->setUnityBuild(ini.GetBoolValue(groupName,"UnityBuild", true));
         newUnit->setBuildCmd(fromByteArray(ini.GetValue(groupName,"BuildCmd", "")));
         newUnit->setEncoding(ini.GetValue(groupName, "FileEncoding",ENCODING_PROJECT));
         if (newUnit->encoding()!=ENCODING_UTF16_BOM &&
@@ -420,14 +421,16 @@ Editor *Project::openUnit(PProjectUnit &unit, const PProjectEditorLayout &layout
         encoding = unit->encoding();
         if (encoding==ENCODING_PROJECT)
             encoding=options().encoding;
-        editor = mEditorList->newEditor(unit->fileName(), encoding, this, false);
+        //restored editors are loaded when they are shown
+        editor = mEditorList->newEditor(unit->fileName(), encoding, this, false, nullptr, true);
         if (editor) {
             //editor->setInProject(true);
-            editor->setCaretY(layout->caretY);
-            editor->setCaretX(layout->caretX);
-            editor->setTopLine(layout->topLine);
-            editor->setLeftPos(layout->left);
-            editor->activate();
+            Editor::ViewState viewState;
+            viewState.caretX = layout->caretX;
+            viewState.caretY = layout->caretY;
+            viewState.topLine = layout->topLine;
+            viewState.leftPos = layout->left;
+            editor->setViewState(viewState);
             return editor;
         }
     }
@@ -659,11 +662,12 @@ void Project::saveLayout()
         Editor* editor = unitEditor(unit);
         if (editor) {
             QJsonObject jsonLayout;
+            Editor::ViewState viewState = editor->viewState();
             jsonLayout["filename"]=unit->fileName();
-            jsonLayout["caretX"]=editor->caretX();
-            jsonLayout["caretY"]=editor->caretY();
-            jsonLayout["topLine"]=editor->topLine();
-            jsonLayout["left"]=editor->leftPos();
+            jsonLayout["caretX"]=viewState.caretX;
+            jsonLayout["caretY"]=viewState.caretY;
+            jsonLayout["topLine"]=viewState.topLine;
+            jsonLayout["left"]=viewState.leftPos;
             jsonLayout["isOpen"]=true;
             jsonLayout["focused"]=(editor==e);
             int order=editorOrderSet.value(editor->filename(),-1);
@@ -787,6 +791,7 @@ bool Project::saveUnits()
         ini.SetLongValue(groupName,"Link", unit->link());
         ini.SetLongValue(groupName,"Priority", unit->priority());
         ini.SetLongValue(groupName,"OverrideBuildCmd", unit->overrideBuildCmd());
+        ini.SetBoolValue(groupName,"UnityBuild", unit->unityBuild());
         ini.SetValue(groupName,"BuildCmd", toByteArray(unit->buildCmd()));
         //ini.SetLongValue(groupName,"DetectEncoding", unit->encoding()==ENCODING_AUTO_DETECT);
         ini.Delete(groupName,"DetectEncoding");
@@ -1219,6 +1224,9 @@ void Project::saveOptions()
     ini.SetLongValue("Project","ClassBrowserType", (int)mOptions.classBrowserType);
     ini.SetBoolValue("Project","AllowParallelBuilding",mOptions.allowParallelBuilding);
     ini.SetLongValue("Project","ParellelBuildingJobs",mOptions.parellelBuildingJobs);
+    ini.SetBoolValue("Project","TraceCompileTime",mOptions.traceCompileTime);
+    ini.SetBoolValue("Project","UnityBuild",mOptions.unityBuild);
+    ini.SetLongValue("Project","UnityBuildBatches",mOptions.unityBuildBatches);
 
 
     //for Red Panda Dev C++ 6 compatibility
@@ -1799,11 +1807,14 @@ PProjectUnit Project::doAutoOpen()
         }
     }
 
+    Editor * lastEditor = nullptr;
     for (int i=0;i<mUnits.count();i++) {
         PProjectEditorLayout editorLayout = opennedMap.value(i,PProjectEditorLayout());
         if (editorLayout) {
             PProjectUnit unit = findUnit(editorLayout->filename);
-            openUnit(unit,editorLayout);
+            Editor * editor = openUnit(unit,editorLayout);
+            if (editor)
+                lastEditor = editor;
         }
     }
 
@@ -1816,6 +1827,8 @@ PProjectUnit Project::doAutoOpen()
         }
         return unit;
     }
+    if (lastEditor)
+        lastEditor->activate();
     return PProjectUnit();
 }
 
@@ -2139,6 +2152,9 @@ void Project::loadOptions(SimpleIni& ini)
 
         mOptions.allowParallelBuilding = ini.GetBoolValue("Project","AllowParallelBuilding");
         mOptions.parellelBuildingJobs = ini.GetLongValue("Project","ParellelBuildingJobs");
+        mOptions.traceCompileTime = ini.GetBoolValue("Project","TraceCompileTime", false);
+        mOptions.unityBuild = ini.GetBoolValue("Project","UnityBuild", false);
+        mOptions.unityBuildBatches = ini.GetLongValue("Project","UnityBuildBatches", 0);
 
 
         mOptions.versionInfo.major = ini.GetLongValue("VersionInfo", "Major", 0);
@@ -2173,10 +2189,12 @@ void Project::loadUnitLayout(Editor *e)
 
     PProjectEditorLayout layout = layouts.value(e->filename(),PProjectEditorLayout());
     if (layout) {
-        e->setCaretY(layout->caretY);
-        e->setCaretX(layout->caretX);
-        e->setTopLine(layout->topLine);
-        e->setLeftPos(layout->left);
+        Editor::ViewState viewState;
+        viewState.caretX = layout->caretX;
+        viewState.caretY = layout->caretY;
+        viewState.topLine = layout->topLine;
+        viewState.leftPos = layout->left;
+        e->setViewState(viewState);
     }
 }
 
@@ -2275,7 +2293,7 @@ void Project::updateCompilerSetting()
     }
 }
 
-QFileSystemWatcher *Project::fileSystemWatcher() const
+FileChangeWatcher *Project::fileSystemWatcher() const
 {
     return mFileSystemWatcher;
 }
@@ -2375,6 +2393,7 @@ ProjectUnit::ProjectUnit(Project* parent)
 //    mFileMissing = false;
     mPriority=0;
     mNew = true;
+    mUnityBuild = true;
     mEncoding=ENCODING_PROJECT;
     mRealEncoding="";
 }
@@ -2455,6 +2474,16 @@ void ProjectUnit::setOverrideBuildCmd(bool newOverrideBuildCmd)
     mOverrideBuildCmd = newOverrideBuildCmd;
 }
 
+bool ProjectUnit::unityBuild() const
+{
+    return mUnityBuild;
+}
+
+void ProjectUnit::setUnityBuild(bool newUnityBuild)
+{
+    mUnityBuild = newUnityBuild;
+}
+
 const QString &ProjectUnit::buildCmd() const
 {
     return mBuildCmd;
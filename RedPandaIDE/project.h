@@ -29,7 +29,7 @@ class Project;
 class Editor;
 class CppParser;
 class EditorList;
-class QFileSystemWatcher;
+class FileChangeWatcher;
 
 enum ProjectModelNodeType {
     DUMMY_HEADERS_FOLDER,
@@ -87,6 +87,9 @@ public:
     void setCompileCpp(bool newCompileCpp);
     bool overrideBuildCmd() const;
     void setOverrideBuildCmd(bool newOverrideBuildCmd);
+    // the unit can be compiled together with the others in a unity build
+    bool unityBuild() const;
+    void setUnityBuild(bool newUnityBuild);
     const QString &buildCmd() const;
     void setBuildCmd(const QString &newBuildCmd);
     bool link() const;
@@ -115,6 +118,7 @@ private:
     bool mCompile;
     bool mCompileCpp;
     bool mOverrideBuildCmd;
+    bool mUnityBuild;
     QString mBuildCmd;
     bool mLink;
     int mPriority;
@@ -195,17 +199,17 @@ class Project : public QObject
 public:
     explicit Project(const QString& filename, const QString& name,
                      EditorList* editorList,
-                     QFileSystemWatcher* fileSystemWatcher,
+                     FileChangeWatcher* fileSystemWatcher,
                      QObject *parent = nullptr);
 
     static std::shared_ptr<Project> load(const QString& filename,
                                     EditorList* editorList,
-                                    QFileSystemWatcher* fileSystemWatcher,
+                                    FileChangeWatcher* fileSystemWatcher,
                                     QObject *parent = nullptr);
     static std::shared_ptr<Project> create(const QString& filename,
                                            const QString& name,
                                            EditorList* editorList,
-                                           QFileSystemWatcher* fileSystemWatcher,
+                                           FileChangeWatcher* fileSystemWatcher,
                                            const std::shared_ptr<ProjectTemplate> pTemplate,
                                            bool useCpp,
                                            QObject *parent = nullptr);
@@ -289,7 +293,7 @@ public:
 
     EditorList *editorList() const;
 
-    QFileSystemWatcher *fileSystemWatcher() const;
+    FileChangeWatcher *fileSystemWatcher() const;
 
     QString fileSystemNodeFolderPath(const PProjectModelNode& node);
 
@@ -358,7 +362,7 @@ private:
     QList<PProjectModelNode> mCustomFolderNodes;
     ProjectModel mModel;
     EditorList *mEditorList;
-    QFileSystemWatcher* mFileSystemWatcher;
+    FileChangeWatcher* mFileSystemWatcher;
 };
 
 #endif // PROJECT_H
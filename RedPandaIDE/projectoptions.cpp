@@ -57,4 +57,7 @@ ProjectOptions::ProjectOptions()
     execEncoding = ENCODING_SYSTEM_DEFAULT;
     allowParallelBuilding=false;
     parellelBuildingJobs=0;
+    traceCompileTime=false;
+    unityBuild=false;
+    unityBuildBatches=0;
 }
@@ -101,5 +101,8 @@ struct ProjectOptions{
     ProjectClassBrowserType classBrowserType;
     bool allowParallelBuilding;
     int parellelBuildingJobs;
+    bool traceCompileTime;
+    bool unityBuild;
+    int unityBuildBatches; // 0 means the number of parallel jobs
 };
 #endif // PROJECTOPTIONS_H
@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "quickopenindex.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QRunnable>
+#include <QThreadPool>
+#include "utils.h"
+
+class UpdateSymbolsTask: public QRunnable {
+public:
+    UpdateSymbolsTask(QuickOpenIndex* index, int version, const PCppParser& parser,
+                      const QHash<QString, PFileIncludes>& changedFiles,
+                      const QHash<QString, QVector<PQuickOpenItem>>& fileSymbols):
+        mIndex{index}, mVersion{version}, mParser{parser},
+        mChangedFiles{changedFiles}, mFileSymbols{fileSymbols} {}
+    void run() override {
+        bool ok = mParser->freeze();
+        QuickOpenIndex::PackedItems symbolItems;
+        if (ok) {
+            for (auto it=mChangedFiles.constBegin();it!=mChangedFiles.constEnd();++it) {
+                if (it.value())
+                    mFileSymbols.insert(it.key(), QuickOpenIndex::collectSymbols(it.key(), it.value()));
+                else
+                    mFileSymbols.remove(it.key());
+            }
+            mParser->unFreeze();
+            foreach (const QVector<PQuickOpenItem>& symbols, mFileSymbols)
+                symbolItems.items.append(symbols);
+            QuickOpenIndex::pack(symbolItems);
+        }
+        QPointer<QuickOpenIndex> index = mIndex;
+        int version = mVersion;
+        QHash<QString, PFileIncludes> changedFiles = mChangedFiles;
+        QHash<QString, QVector<PQuickOpenItem>> fileSymbols = mFileSymbols;
+        // the index may be deleted while we are running, check it in the gui thread
+        QMetaObject::invokeMethod(qApp, [=](){
+            if (index)
+                index->onSymbolsUpdated(version, ok, changedFiles, fileSymbols, symbolItems);
+        }, Qt::QueuedConnection);
+    }
+private:
+    QPointer<QuickOpenIndex> mIndex;
+    int mVersion;
+    PCppParser mParser;
+    QHash<QString, PFileIncludes> mChangedFiles;
+    QHash<QString, QVector<PQuickOpenItem>> mFileSymbols;
+};
+
+QuickOpenIndex::QuickOpenIndex(QObject *parent)
+    : QObject{parent},
+      mSymbolsVersion{0},
+      mUpdatingSymbols{false},
+      mSymbolsUpdatePending{false}
+{
+    mFileItems.dirty = true;
+    mSymbolItems.dirty = true;
+}
+
+void QuickOpenIndex::setFiles(const QStringList &files)
+{
+    if (files == mFiles)
+        return;
+    mFiles = files;
+    mFileItems.items.clear();
+    foreach (const QString& filename, mFiles) {
+        PQuickOpenItem item = std::make_shared<QuickOpenItem>();
+        item->type = QuickOpenItemType::File;
+        item->name = extractFileName(filename);
+        item->detail = extractFileDir(filename);
+        item->filename = filename;
+        item->line = 1;
+        mFileItems.items.append(item);
+    }
+    mFileItems.dirty = true;
+    mSymbolsVersion++;
+    updateSymbols();
+    emit updated();
+}
+
+void QuickOpenIndex::setParser(const PCppParser &parser)
+{
+    if (parser == mParser)
+        return;
+    if (mParser)
+        disconnect(mParser.get(), &CppParser::onEndParsing,
+                   this, &QuickOpenIndex::onParserEndParsing);
+    mParser = parser;
+    mSymbolsVersion++;
+    mFileSymbols.clear();
+    mParsedFileIncludes.clear();
+    mSymbolItems.dirty = true;
+    if (mParser)
+        connect(mParser.get(), &CppParser::onEndParsing,
+                this, &QuickOpenIndex::onParserEndParsing);
+    updateSymbols();
+    emit updated();
+}
+
+void QuickOpenIndex::clear()
+{
+    mFiles.clear();
+    mSymbolsVersion++;
+    mFileItems.items.clear();
+    mFileItems.dirty = true;
+    mFileSymbols.clear();
+    mParsedFileIncludes.clear();
+    mSymbolItems.items.clear();
+    mSymbolItems.dirty = true;
+    emit updated();
+}
+
+int QuickOpenIndex::count(QuickOpenItemType type)
+{
+    return packed(type).items.count();
+}
+
+PQuickOpenItem QuickOpenIndex::item(QuickOpenItemType type, int index)
+{
+    PackedItems &packedItems = packed(type);
+    if (index<0 || index>=packedItems.items.count())
+        return PQuickOpenItem();
+    return packedItems.items[index];
+}
+
+int QuickOpenIndex::match(QuickOpenItemType type, const QString &pattern, int start, int timeLimit, QVector<QuickOpenMatch> &matches)
+{
+    PackedItems &packedItems = packed(type);
+    QElapsedTimer timer;
+    timer.start();
+    const QChar* names = packedItems.names.constData();
+    const char* wordStarts = packedItems.wordStarts.constData();
+    const int* offsets = packedItems.offsets.constData();
+    int count = packedItems.items.count();
+    int i = start;
+    while (i<count) {
+        int offset = offsets[i];
+        int score = fuzzyScore(pattern, names+offset, offsets[i+1]-offset-1, wordStarts+offset);
+        if (score>0)
+            matches.append(QuickOpenMatch{i,score});
+        i++;
+        // check the timer only once in a while, it's much slower than matching
+        if ((i & 0x3FF) == 0 && timer.elapsed()>=timeLimit)
+            break;
+    }
+    return i;
+}
+
+int QuickOpenIndex::fuzzyScore(const QString &pattern, const QChar *text, int length, const char *wordStarts)
+{
+    int patternLength = pattern.length();
+    if (patternLength==0)
+        return 1;
+    if (patternLength>length)
+        return 0;
+    const QChar* p = pattern.constData();
+    int score = 0;
+    int j = 0;
+    int lastMatched = -2;
+    for (int i=0;i<length && j<patternLength;i++) {
+        if (text[i]!=p[j])
+            continue;
+        int charScore = 1;
+        if (wordStarts[i])
+            charScore += 8;
+        if (lastMatched == i-1)
+            charScore += 5;
+        score += charScore;
+        lastMatched = i;
+        j++;
+    }
+    if (j<patternLength)
+        return 0;
+    // prefer short names
+    return score*8 + std::max(0, 32 - length) + 1;
+}
+
+void QuickOpenIndex::onParserEndParsing()
+{
+    // updated() is emitted when the symbols are collected
+    updateSymbols();
+}
+
+QuickOpenIndex::PackedItems &QuickOpenIndex::packed(QuickOpenItemType type)
+{
+    PackedItems &packedItems = (type == QuickOpenItemType::File)?mFileItems:mSymbolItems;
+    if (packedItems.dirty) {
+        if (type == QuickOpenItemType::Symbol) {
+            packedItems.items.clear();
+            foreach (const QVector<PQuickOpenItem>& fileSymbols, mFileSymbols) {
+                packedItems.items.append(fileSymbols);
+            }
+        }
+        pack(packedItems);
+    }
+    return packedItems;
+}
+
+void QuickOpenIndex::pack(PackedItems &packedItems)
+{
+    int totalLength = 0;
+    foreach (const PQuickOpenItem& item, packedItems.items) {
+        totalLength += item->name.length()+1;
+    }
+    packedItems.names.clear();
+    packedItems.names.reserve(totalLength);
+    packedItems.wordStarts.clear();
+    packedItems.wordStarts.reserve(totalLength);
+    packedItems.offsets.clear();
+    packedItems.offsets.reserve(packedItems.items.count()+1);
+    foreach (const PQuickOpenItem& item, packedItems.items) {
+        packedItems.offsets.append(packedItems.names.length());
+        const QString& name = item->name;
+        QChar lastCh;
+        for (int i=0;i<name.length();i++) {
+            QChar ch = name[i];
+            bool isWordStart = (i==0)
+                    || (ch.isLetterOrNumber() && !lastCh.isLetterOrNumber())
+                    || (ch.isUpper() && lastCh.isLower());
+            packedItems.names.append(ch.toLower());
+            packedItems.wordStarts.append(isWordStart?1:0);
+            lastCh = ch;
+        }
+        packedItems.names.append(QChar(0));
+        packedItems.wordStarts.append((char)0);
+    }
+    packedItems.offsets.append(packedItems.names.length());
+    packedItems.dirty = false;
+}
+
+void QuickOpenIndex::updateSymbols()
+{
+    if (!mParser || !mParser->enabled() || mParser->parsing())
+        return;
+    if (mUpdatingSymbols) {
+        mSymbolsUpdatePending = true;
+        return;
+    }
+    QSet<QString> files(mFiles.begin(),mFiles.end());
+    foreach (const QString& filename, mFileSymbols.keys()) {
+        if (!files.contains(filename)) {
+            mFileSymbols.remove(filename);
+            mParsedFileIncludes.remove(filename);
+            mSymbolItems.dirty = true;
+        }
+    }
+    // only files reparsed since the last update are collected again
+    QHash<QString, PFileIncludes> changedFiles;
+    foreach (const QString& filename, mFiles) {
+        PFileIncludes fileIncludes = mParser->findFileIncludes(filename);
+        PFileIncludes oldFileIncludes = mParsedFileIncludes.value(filename).lock();
+        if (fileIncludes == oldFileIncludes
+                && (fileIncludes || !mFileSymbols.contains(filename)))
+            continue;
+        changedFiles.insert(filename, fileIncludes);
+    }
+    if (changedFiles.isEmpty())
+        return;
+    mUpdatingSymbols = true;
+    QThreadPool::globalInstance()->start(new UpdateSymbolsTask(
+                                             this, mSymbolsVersion, mParser,
+                                             changedFiles, mFileSymbols));
+}
+
+void QuickOpenIndex::onSymbolsUpdated(int version, bool ok,
+                                      const QHash<QString, PFileIncludes> &changedFiles,
+                                      const QHash<QString, QVector<PQuickOpenItem> > &fileSymbols,
+                                      const PackedItems &symbolItems)
+{
+    mUpdatingSymbols = false;
+    // the parser is busy if it can't be frozen, it's updated again when parsing ends
+    if (ok && version == mSymbolsVersion) {
+        for (auto it=changedFiles.constBegin();it!=changedFiles.constEnd();++it)
+            mParsedFileIncludes.insert(it.key(), it.value());
+        mFileSymbols = fileSymbols;
+        mSymbolItems = symbolItems;
+        emit updated();
+    }
+    if (mSymbolsUpdatePending || (ok && version != mSymbolsVersion)) {
+        mSymbolsUpdatePending = false;
+        updateSymbols();
+    }
+}
+
+QVector<PQuickOpenItem> QuickOpenIndex::collectSymbols(const QString &filename, const PFileIncludes &fileIncludes)
+{
+    QVector<PQuickOpenItem> symbols;
+    foreach (const PStatement& statement, fileIncludes->statements) {
+        if (statement->scope == StatementScope::Local)
+            continue;
+        switch(statement->kind) {
+        case StatementKind::skLocalVariable:
+        case StatementKind::skParameter:
+        case StatementKind::skBlock:
+        case StatementKind::skUserCodeSnippet:
+        case StatementKind::skKeyword:
+        case StatementKind::skKeywordType:
+        case StatementKind::skUnknown:
+            continue;
+        default:
+            break;
+        }
+        PQuickOpenItem item = std::make_shared<QuickOpenItem>();
+        item->type = QuickOpenItemType::Symbol;
+        item->name = statement->command;
+        item->detail = statement->fullName;
+        item->filename = filename;
+        if (statement->fileName == filename)
+            item->line = statement->line;
+        else
+            item->line = statement->definitionLine;
+        item->statement = statement;
+        symbols.append(item);
+    }
+    return symbols;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef QUICKOPENINDEX_H
+#define QUICKOPENINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include "parser/cppparser.h"
+
+enum class QuickOpenItemType {
+    File,
+    Symbol
+};
+
+struct QuickOpenItem {
+    QuickOpenItemType type;
+    QString name; // file name or symbol name, used for matching
+    QString detail; // folder of the file, or full name of the symbol
+    QString filename;
+    int line;
+    std::weak_ptr<Statement> statement;
+};
+
+using PQuickOpenItem = std::shared_ptr<QuickOpenItem>;
+
+struct QuickOpenMatch {
+    int index;
+    int score;
+};
+
+class UpdateSymbolsTask;
+
+/**
+ * @brief Files and symbols searched by the quick open popup.
+ *
+ * Symbols of the files reparsed since the last update are collected and
+ * packed in a thread pool, the result is swapped in on the gui thread.
+ */
+class QuickOpenIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QuickOpenIndex(QObject *parent = nullptr);
+    void setFiles(const QStringList& files);
+    void setParser(const PCppParser& parser);
+    void clear();
+
+    int count(QuickOpenItemType type);
+    PQuickOpenItem item(QuickOpenItemType type, int index);
+
+    /**
+     * @brief match items [start,count) against the pattern, until time limit is exceeded
+     * @param pattern lowercased search pattern
+     * @param timeLimit time limit in milliseconds
+     * @param matches matched items are appended to it
+     * @return index of the first unmatched item
+     */
+    int match(QuickOpenItemType type, const QString& pattern, int start,
+              int timeLimit, QVector<QuickOpenMatch>& matches);
+
+    static int fuzzyScore(const QString& pattern, const QChar* text, int length,
+                          const char* wordStarts);
+signals:
+    void updated();
+private slots:
+    void onParserEndParsing();
+private:
+    struct PackedItems {
+        QVector<PQuickOpenItem> items;
+        // lowercased names, each followed by a '\0'
+        QString names;
+        // 1 if the char in names is the start of a word (snake_case or camelCase)
+        QByteArray wordStarts;
+        // offset of each name in names, with an extra one at end
+        QVector<int> offsets;
+        bool dirty;
+    };
+    PackedItems& packed(QuickOpenItemType type);
+    static void pack(PackedItems& packedItems);
+    void updateSymbols();
+    void onSymbolsUpdated(int version, bool ok,
+                          const QHash<QString, PFileIncludes>& changedFiles,
+                          const QHash<QString, QVector<PQuickOpenItem>>& fileSymbols,
+                          const PackedItems& symbolItems);
+    static QVector<PQuickOpenItem> collectSymbols(const QString& filename, const PFileIncludes& fileIncludes);
+    friend class UpdateSymbolsTask;
+private:
+    PackedItems mFileItems;
+    PackedItems mSymbolItems;
+    QStringList mFiles;
+    PCppParser mParser;
+    QHash<QString, QVector<PQuickOpenItem>> mFileSymbols;
+    // FileIncludes of parsed files, a new one is created when the file is reparsed
+    QHash<QString, std::weak_ptr<FileIncludes>> mParsedFileIncludes;
+    // changed when the files or the parser are changed, results of older updates are dropped
+    int mSymbolsVersion;
+    bool mUpdatingSymbols;
+    bool mSymbolsUpdatePending;
+};
+
+#endif // QUICKOPENINDEX_H
@@ -33,6 +33,10 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QMutex>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QWaitCondition>
 #ifdef Q_OS_LINUX
 #include <sys/sysinfo.h>
 #endif
@@ -725,6 +729,16 @@ void Settings::Editor::setUndoMemoryUsage(int newUndoMemoryUsage)
     mUndoMemoryUsage = newUndoMemoryUsage;
 }
 
+int Settings::Editor::maxLoadedEditors() const
+{
+    return mMaxLoadedEditors;
+}
+
+void Settings::Editor::setMaxLoadedEditors(int newMaxLoadedEditors)
+{
+    mMaxLoadedEditors = newMaxLoadedEditors;
+}
+
 bool Settings::Editor::autoFormatWhenSaved() const
 {
     return mAutoFormatWhenSaved;
@@ -1290,6 +1304,26 @@ void Settings::Editor::setScrollPastEol(bool scrollPastEol)
     mScrollPastEol = scrollPastEol;
 }
 
+bool Settings::Editor::wrapLines() const
+{
+    return mWrapLines;
+}
+
+void Settings::Editor::setWrapLines(bool wrapLines)
+{
+    mWrapLines = wrapLines;
+}
+
+bool Settings::Editor::showMiniMap() const
+{
+    return mShowMiniMap;
+}
+
+void Settings::Editor::setShowMiniMap(bool newShowMiniMap)
+{
+    mShowMiniMap = newShowMiniMap;
+}
+
 bool Settings::Editor::scrollPastEof() const
 {
     return mScrollPastEof;
@@ -1338,6 +1372,8 @@ void Settings::Editor::doSave()
     saveValue("auto_hide_scroll_bar", mAutoHideScrollbar);
     saveValue("scroll_past_eof", mScrollPastEof);
     saveValue("scroll_past_eol", mScrollPastEol);
+    saveValue("wrap_lines", mWrapLines);
+    saveValue("show_minimap", mShowMiniMap);
     saveValue("scroll_by_one_less", mScrollByOneLess);
     saveValue("half_page_scroll", mHalfPageScroll);
     saveValue("mouse_wheel_scroll_speed", mMouseWheelScrollSpeed);
@@ -1426,6 +1462,7 @@ void Settings::Editor::doSave()
     saveValue("auto_detect_file_encoding",mAutoDetectFileEncoding);
     saveValue("undo_limit",mUndoLimit);
     saveValue("undo_memory_usage", mUndoMemoryUsage);
+    saveValue("max_loaded_editors", mMaxLoadedEditors);
     saveValue("auto_format_when_saved", mAutoFormatWhenSaved);
     saveValue("remove_trailing_spaces_when_saved",mRemoveTrailingSpacesWhenSaved);
     saveValue("parse_todos",mParseTodos);
@@ -1470,6 +1507,8 @@ void Settings::Editor::doLoad()
     mAutoHideScrollbar = boolValue("auto_hide_scroll_bar", false);
     mScrollPastEof = boolValue("scroll_past_eof", true);
     mScrollPastEol = boolValue("scroll_past_eol", false);
+    mWrapLines = boolValue("wrap_lines", false);
+    mShowMiniMap = boolValue("show_minimap", false);
     mScrollByOneLess = boolValue("scroll_by_one_less", false);
     mHalfPageScroll = boolValue("half_page_scroll",false);
     mMouseWheelScrollSpeed = intValue("mouse_wheel_scroll_speed", 3);
@@ -1590,6 +1629,7 @@ void Settings::Editor::doLoad()
     mAutoDetectFileEncoding = boolValue("auto_detect_file_encoding",true);
     mUndoLimit = intValue("undo_limit",0);
     mUndoMemoryUsage = intValue("undo_memory_usage", 0);
+    mMaxLoadedEditors = intValue("max_loaded_editors", 0);
     mAutoFormatWhenSaved = boolValue("auto_format_when_saved", false);
     mRemoveTrailingSpacesWhenSaved = boolValue("remove_trailing_spaces_when_saved",false);
     mParseTodos = boolValue("parse_todos",true);
@@ -2910,20 +2950,40 @@ void Settings::CompilerSet::setIniOptions(const QByteArray &value)
    }
 }
 
+// Outputs of compiler probes, keyed by the binary (path, mtime and size) and the arguments.
+// Rescanning compilers only runs the binaries that have changed.
+static QMutex compilerOutputCacheMutex;
+static QHash<QString, QByteArray> compilerOutputCache;
+
 QByteArray Settings::CompilerSet::getCompilerOutput(const QString &binDir, const QString &binFile, const QStringList &arguments)
 {
+    QString program = includeTrailingPathDelimiter(binDir)+binFile;
+    QFileInfo info(program);
+    QString key = QString("%1\n%2\n%3\n%4")
+            .arg(info.absoluteFilePath())
+            .arg(info.lastModified().toMSecsSinceEpoch())
+            .arg(info.size())
+            .arg(arguments.join('\n'));
+    {
+        QMutexLocker locker(&compilerOutputCacheMutex);
+        auto it = compilerOutputCache.constFind(key);
+        if (it!=compilerOutputCache.constEnd())
+            return *it;
+    }
     QProcessEnvironment env;
     env.insert("LANG","en");
     QString path = binDir;
     env.insert("PATH",path);
     QByteArray result = runAndGetOutput(
-                includeTrailingPathDelimiter(binDir)+binFile,
+                program,
                 binDir,
                 arguments,
                 QByteArray(),
                 false,
-                env);
-    return result.trimmed();
+                env).trimmed();
+    QMutexLocker locker(&compilerOutputCacheMutex);
+    compilerOutputCache.insert(key, result);
+    return result;
 }
 
 bool Settings::CompilerSet::forceEnglishOutput() const
@@ -3133,13 +3193,12 @@ Settings::PCompilerSet Settings::CompilerSets::addSet()
     return p;
 }
 
-Settings::PCompilerSet Settings::CompilerSets::addSet(const QString &folder, const QString& c_prog)
+Settings::PCompilerSet Settings::CompilerSets::addProbedSet(const PCompilerSet &pSet, const QString& c_prog)
 {
-    PCompilerSet p=std::make_shared<CompilerSet>(folder,c_prog);
-    if (c_prog==GCC_PROGRAM && p->compilerType()==CompilerType::Clang)
+    if (c_prog==GCC_PROGRAM && pSet->compilerType()==CompilerType::Clang)
         return PCompilerSet();
-    mList.push_back(p);
-    return p;
+    mList.push_back(pSet);
+    return pSet;
 }
 
 Settings::PCompilerSet Settings::CompilerSets::addSet(const PCompilerSet &pSet)
@@ -3187,13 +3246,25 @@ static void setDebugOptions(Settings::PCompilerSet pSet, bool enableAsan = false
 
 }
 
-bool Settings::CompilerSets::addSets(const QString &folder, const QString& c_prog) {
+bool Settings::CompilerSets::setsAdded(const QString &folder, const QString &c_prog)
+{
     foreach (const PCompilerSet& set, mList) {
         if (set->binDirs().contains(folder) && extractFileName(set->CCompiler())==c_prog)
-            return false;
+            return true;
     }
+    return false;
+}
+
+bool Settings::CompilerSets::addSets(const QString &folder, const QString& c_prog) {
+    if (setsAdded(folder, c_prog))
+        return false;
+    return addProbedSets(std::make_shared<CompilerSet>(folder,c_prog), c_prog);
+}
+
+bool Settings::CompilerSets::addProbedSets(const PCompilerSet &probedSet, const QString &c_prog)
+{
     // Default, release profile
-    PCompilerSet baseSet = addSet(folder,c_prog);
+    PCompilerSet baseSet = addProbedSet(probedSet,c_prog);
     if (!baseSet || baseSet->name().isEmpty())
         return false;
 #if ENABLE_SDCC
@@ -3255,25 +3326,84 @@ bool Settings::CompilerSets::addSets(const QString &folder, const QString& c_pro
 
 bool Settings::CompilerSets::addSets(const QString &folder)
 {
-    bool found = false;
+    QStringList programs = compilerProgramsIn(folder);
+    foreach (const QString& c_prog, programs) {
+        addSets(folder,c_prog);
+    }
+    return !programs.isEmpty();
+}
+
+QStringList Settings::CompilerSets::compilerProgramsIn(const QString &folder)
+{
+    QStringList programs;
     if (!directoryExists(folder))
-        return found;
-    if (fileExists(folder, GCC_PROGRAM)) {
-        addSets(folder,GCC_PROGRAM);
-        found=true;
+        return programs;
+    if (fileExists(folder, GCC_PROGRAM))
+        programs.append(GCC_PROGRAM);
+    if (fileExists(folder, CLANG_PROGRAM))
+        programs.append(CLANG_PROGRAM);
+#ifdef ENABLE_SDCC
+    if (fileExists(folder, SDCC_PROGRAM))
+        programs.append(SDCC_PROGRAM);
+#endif
+    return programs;
+}
+
+namespace {
+struct CompilerSetProbes {
+    QMutex mutex;
+    QWaitCondition probed;
+    QVector<Settings::PCompilerSet> results;
+    QList<int> newlyProbed;
+};
+
+class CompilerSetProbeTask : public QRunnable {
+public:
+    CompilerSetProbeTask(const std::shared_ptr<CompilerSetProbes>& probes, int index,
+                         const QString& folder, const QString& c_prog):
+        mProbes{probes}, mIndex{index}, mFolder{folder}, mProgram{c_prog} {}
+    void run() override {
+        Settings::PCompilerSet set = std::make_shared<Settings::CompilerSet>(mFolder, mProgram);
+        QMutexLocker locker(&mProbes->mutex);
+        mProbes->results[mIndex] = set;
+        mProbes->newlyProbed.append(mIndex);
+        mProbes->probed.wakeAll();
     }
-    if (fileExists(folder, CLANG_PROGRAM)) {
-        addSets(folder,CLANG_PROGRAM);
-        found=true;
+private:
+    std::shared_ptr<CompilerSetProbes> mProbes;
+    int mIndex;
+    QString mFolder;
+    QString mProgram;
+};
+}
+
+QVector<Settings::PCompilerSet> Settings::CompilerSets::probeSets(const QList<QPair<QString, QString> > &candidates, const FindSetsProgressCallback &onProgress)
+{
+    // the tasks may outlive this call if the thread pool is being torn down, so the state is shared
+    std::shared_ptr<CompilerSetProbes> probes = std::make_shared<CompilerSetProbes>();
+    probes->results.resize(candidates.count());
+    for (int i=0;i<candidates.count();i++) {
+        QThreadPool::globalInstance()->start(
+                    new CompilerSetProbeTask(probes, i, candidates[i].first, candidates[i].second));
     }
-#ifdef ENABLE_SDCC
-    //qDebug()<<folder;
-    if (fileExists(folder, SDCC_PROGRAM)) {
-        addSets(folder,SDCC_PROGRAM);
-        found=true;
+    int probedCount = 0;
+    while (probedCount < candidates.count()) {
+        QList<int> newlyProbed;
+        {
+            QMutexLocker locker(&probes->mutex);
+            if (probes->newlyProbed.isEmpty())
+                probes->probed.wait(&probes->mutex, 50);
+            newlyProbed.swap(probes->newlyProbed);
+        }
+        foreach (int index, newlyProbed) {
+            probedCount++;
+            if (onProgress)
+                onProgress(probedCount, candidates.count(), probes->results[index]->name());
+        }
+        if (onProgress)
+            QCoreApplication::processEvents();
     }
-#endif
-    return found;
+    return probes->results;
 }
 
 Settings::CompilerSetList Settings::CompilerSets::clearSets()
@@ -3291,7 +3421,7 @@ Settings::CompilerSetList Settings::CompilerSets::clearSets()
     return persisted;
 }
 
-void Settings::CompilerSets::findSets()
+void Settings::CompilerSets::findSets(const FindSetsProgressCallback& onProgress)
 {
     CompilerSetList persisted = clearSets();
     // canonical paths that has been searched.
@@ -3339,6 +3469,7 @@ void Settings::CompilerSets::findSets()
     } + pathList;
 #endif
     QString folder, canonicalFolder;
+    QList<QPair<QString,QString>> candidates;
     for (int i=pathList.count()-1;i>=0;i--) {
         folder = QDir(pathList[i]).absolutePath();
         canonicalFolder = QDir(pathList[i]).canonicalPath();
@@ -3352,7 +3483,14 @@ void Settings::CompilerSets::findSets()
         //   /opt/gcc-13 -> /opt/gcc-13.1.0
         // after upgrade:
         //   /opt/gcc-13 -> /opt/gcc-13.2.0
-        addSets(folder);
+        foreach (const QString& c_prog, compilerProgramsIn(folder)) {
+            if (!setsAdded(folder, c_prog))
+                candidates.append(qMakePair(folder, c_prog));
+        }
+    }
+    QVector<PCompilerSet> probedSets = probeSets(candidates, onProgress);
+    for (int i=0;i<candidates.count();i++) {
+        addProbedSets(probedSets[i], candidates[i].second);
     }
 
 #ifdef ENABLE_LUA_ADDON
@@ -4308,6 +4446,26 @@ void Settings::Executor::setEnableVirualTerminalSequence(bool newEnableVirualTer
     mEnableVirualTerminalSequence = newEnableVirualTerminalSequence;
 }
 
+bool Settings::Executor::useIntegratedConsole() const
+{
+    return mUseIntegratedConsole;
+}
+
+void Settings::Executor::setUseIntegratedConsole(bool newUseIntegratedConsole)
+{
+    mUseIntegratedConsole = newUseIntegratedConsole;
+}
+
+int Settings::Executor::heapProfileSampleRate() const
+{
+    return mHeapProfileSampleRate;
+}
+
+void Settings::Executor::setHeapProfileSampleRate(int newHeapProfileSampleRate)
+{
+    mHeapProfileSampleRate = newHeapProfileSampleRate;
+}
+
 bool Settings::Executor::convertHTMLToTextForInput() const
 {
     return mConvertHTMLToTextForInput;
@@ -4373,7 +4531,10 @@ void Settings::Executor::doSave()
     saveValue("pause_console", mPauseConsole);
 #ifdef Q_OS_WIN
     saveValue("enable_virtual_terminal_sequence", mEnableVirualTerminalSequence);
+#else
+    saveValue("use_integrated_console", mUseIntegratedConsole);
 #endif
+    saveValue("heap_profile_sample_rate", mHeapProfileSampleRate);
     saveValue("minimize_on_run", mMinimizeOnRun);
     saveValue("use_params",mUseParams);
     saveValue("params",mParams);
@@ -4411,7 +4572,11 @@ void Settings::Executor::doLoad()
     mPauseConsole = boolValue("pause_console",true);
 #ifdef Q_OS_WIN
     mEnableVirualTerminalSequence = boolValue("enable_virtual_terminal_sequence", true);
+    mUseIntegratedConsole = false;
+#else
+    mUseIntegratedConsole = boolValue("use_integrated_console", false);
 #endif
+    mHeapProfileSampleRate = intValue("heap_profile_sample_rate", 4096);
     mMinimizeOnRun = boolValue("minimize_on_run",false);
     mUseParams = boolValue("use_params",false);
     mParams = stringValue("params", "");
@@ -4579,6 +4744,16 @@ void Settings::Debugger::setAutosave(bool newAutosave)
     mAutosave = newAutosave;
 }
 
+bool Settings::Debugger::keepDebuggerRunning() const
+{
+    return mKeepDebuggerRunning;
+}
+
+void Settings::Debugger::setKeepDebuggerRunning(bool newKeepDebuggerRunning)
+{
+    mKeepDebuggerRunning = newKeepDebuggerRunning;
+}
+
 int Settings::Debugger::arrayElements() const
 {
     return mArrayElements;
@@ -4649,6 +4824,7 @@ void Settings::Debugger::doSave()
     saveValue("memory_view_columns",mMemoryViewColumns);
     saveValue("array_elements",mArrayElements);
     saveValue("string_characters",mCharacters);
+    saveValue("keep_debugger_running",mKeepDebuggerRunning);
 }
 
 void Settings::Debugger::doLoad()
@@ -4675,6 +4851,7 @@ void Settings::Debugger::doLoad()
     mMemoryViewColumns = intValue("memory_view_columns",16);
     mArrayElements = intValue("array_elements",100);
     mCharacters = intValue("string_characters",300);
+    mKeepDebuggerRunning = boolValue("keep_debugger_running",true);
 }
 
 Settings::CodeCompletion::CodeCompletion(Settings *settings):_Base(settings, SETTING_CODE_COMPLETION)
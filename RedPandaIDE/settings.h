@@ -20,6 +20,7 @@
 #include <QSettings>
 #include <vector>
 #include <memory>
+#include <functional>
 #include <QColor>
 #include <QString>
 #include <QPair>
@@ -165,6 +166,12 @@ public:
         bool scrollPastEol() const;
         void setScrollPastEol(bool scrollPastEol);
 
+        bool wrapLines() const;
+        void setWrapLines(bool wrapLines);
+
+        bool showMiniMap() const;
+        void setShowMiniMap(bool newShowMiniMap);
+
         bool scrollByOneLess() const;
         void setScrollByOneLess(bool scrollByOneLess);
 
@@ -371,6 +378,9 @@ public:
         int undoMemoryUsage() const;
         void setUndoMemoryUsage(int newUndoMemoryUsage);
 
+        int maxLoadedEditors() const;
+        void setMaxLoadedEditors(int newMaxLoadedEditors);
+
         bool autoFormatWhenSaved() const;
         void setAutoFormatWhenSaved(bool newAutoFormatWhenSaved);
 
@@ -437,6 +447,8 @@ public:
         bool mAutoHideScrollbar;
         bool mScrollPastEof;
         bool mScrollPastEol;
+        bool mWrapLines;
+        bool mShowMiniMap;
         bool mScrollByOneLess;
         bool mHalfPageScroll;
         int mMouseWheelScrollSpeed;
@@ -525,6 +537,7 @@ public:
         bool mDefaultFileCpp;
         int mUndoLimit;
         int mUndoMemoryUsage;
+        int mMaxLoadedEditors;
         bool mAutoFormatWhenSaved;
         bool mRemoveTrailingSpacesWhenSaved;
         bool mParseTodos;
@@ -966,6 +979,12 @@ public:
 
         bool enableVirualTerminalSequence() const;
         void setEnableVirualTerminalSequence(bool newEnableVirualTerminalSequence);
+
+        bool useIntegratedConsole() const;
+        void setUseIntegratedConsole(bool newUseIntegratedConsole);
+
+        int heapProfileSampleRate() const;
+        void setHeapProfileSampleRate(int newHeapProfileSampleRate);
     private:
         // general
         bool mPauseConsole;
@@ -975,6 +994,8 @@ public:
         bool mRedirectInput;
         QString mInputFilename;
         bool mEnableVirualTerminalSequence;
+        bool mUseIntegratedConsole;
+        int mHeapProfileSampleRate; // in bytes
 
         //Problem Set
         bool mEnableProblemSet;
@@ -1326,6 +1347,9 @@ public:
         int characters() const;
         void setCharacters(int newCharacters);
 
+        bool keepDebuggerRunning() const;
+        void setKeepDebuggerRunning(bool newKeepDebuggerRunning);
+
     private:
         bool mEnableDebugConsole;
         bool mShowDetailLog;
@@ -1345,6 +1369,7 @@ public:
         int mMemoryViewColumns;
         int mArrayElements;
         int mCharacters;
+        bool mKeepDebuggerRunning;
 
         // _Base interface
     protected:
@@ -1555,7 +1580,9 @@ public:
         PCompilerSet addSet();
         bool addSets(const QString& folder);
         CompilerSetList clearSets();
-        void findSets();
+        // called each time a compiler is probed; name is empty if it's not usable
+        using FindSetsProgressCallback = std::function<void (int probed, int total, const QString& name)>;
+        void findSets(const FindSetsProgressCallback& onProgress = FindSetsProgressCallback());
         void saveSets();
         void loadSets();
         void saveDefaultIndex();
@@ -1572,10 +1599,16 @@ public:
 
         static bool isTarget64Bit(const QString &target);
     private:
-        PCompilerSet addSet(const QString& folder, const QString& c_prog);
+        PCompilerSet addProbedSet(const PCompilerSet &pSet, const QString& c_prog);
         PCompilerSet addSet(const PCompilerSet &pSet);
         PCompilerSet addSet(const QJsonObject &set);
+        bool setsAdded(const QString& folder, const QString& c_prog);
         bool addSets(const QString& folder, const QString& c_prog);
+        bool addProbedSets(const PCompilerSet& probedSet, const QString& c_prog);
+        static QStringList compilerProgramsIn(const QString& folder);
+        // probe the compilers concurrently, results are in the same order as the candidates
+        static QVector<PCompilerSet> probeSets(const QList<QPair<QString,QString>>& candidates,
+                                               const FindSetsProgressCallback& onProgress);
         void savePath(const QString& name, const QString& path);
         void savePathList(const QString& name, const QStringList& pathList);
 
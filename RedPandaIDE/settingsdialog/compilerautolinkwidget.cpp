@@ -19,6 +19,7 @@
 #include "../mainwindow.h"
 #include "../settings.h"
 #include "../iconsmanager.h"
+#include "../startuptasks.h"
 
 #include <QMessageBox>
 
@@ -41,6 +42,7 @@ CompilerAutolinkWidget::~CompilerAutolinkWidget()
 void CompilerAutolinkWidget::doLoad()
 {
     ui->grpAutolink->setChecked(pSettings->editor().enableAutolink());
+    StartupTasks::waitFor(STARTUP_TASK_AUTOLINKS);
     mModel.setLinks(pAutolinkManager->links());
 }
 
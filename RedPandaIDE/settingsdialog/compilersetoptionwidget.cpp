@@ -320,12 +320,18 @@ void CompilerSetOptionWidget::on_btnFindCompilers_clicked()
                 pMainWindow);
 
     progressDlg.setWindowModality(Qt::WindowModal);
-    progressDlg.setMaximum(2);
+    progressDlg.setCancelButton(nullptr);
     progressDlg.setLabelText(tr("Searching..."));
-    pSettings->compilerSets().findSets();
-    progressDlg.setValue(1);
+    QStringList found;
+    pSettings->compilerSets().findSets([&](int probed, int total, const QString& name){
+        if (!name.isEmpty())
+            found.append(name);
+        progressDlg.setMaximum(total+1);
+        progressDlg.setLabelText(tr("Found:")+"<br />"+found.join("<br />"));
+        progressDlg.setValue(probed);
+    });
     doLoad();
-    progressDlg.setValue(2);
+    progressDlg.setValue(progressDlg.maximum());
     setSettingsChanged();
     if (pSettings->compilerSets().size()==0) {
         QMessageBox::warning(this,tr("Failed"),tr("Can't find any compiler."));
@@ -50,6 +50,7 @@ void DebugGeneralWidget::doLoad()
     ui->chkSkipProjectLib->setChecked(pSettings->debugger().skipProjectLibraries());
     ui->chkSkipCustomLib->setChecked(pSettings->debugger().skipCustomLibraries());
     ui->chkAutosave->setChecked(pSettings->debugger().autosave());
+    ui->chkKeepDebuggerRunning->setChecked(pSettings->debugger().keepDebuggerRunning());
 #ifdef Q_OS_WIN
     ui->grpUseGDBServer->setCheckable(true);
     ui->grpUseGDBServer->setChecked(pSettings->debugger().useGDBServer());
@@ -77,6 +78,7 @@ void DebugGeneralWidget::doSave()
     pSettings->debugger().setSkipProjectLibraries(ui->chkSkipProjectLib->isChecked());
     pSettings->debugger().setSkipCustomLibraries(ui->chkSkipCustomLib->isChecked());
     pSettings->debugger().setAutosave(ui->chkAutosave->isChecked());
+    pSettings->debugger().setKeepDebuggerRunning(ui->chkKeepDebuggerRunning->isChecked());
 #ifdef Q_OS_WIN
     pSettings->debugger().setUseGDBServer(ui->grpUseGDBServer->isChecked());
 #endif
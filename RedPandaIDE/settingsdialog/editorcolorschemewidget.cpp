@@ -38,11 +38,8 @@ EditorColorSchemeWidget::EditorColorSchemeWidget(const QString& name, const QStr
     mModifiedSchemeComboFont.setBold(true);
     int schemeCount=0;
     for (QString schemeName: pColorManager->getSchemes()) {
-        PColorScheme scheme = pColorManager->get(schemeName);
-        if (!scheme)
-            return;
         ui->cbScheme->addItem(schemeName);
-        if (scheme->customed())
+        if (pColorManager->isCustomed(schemeName))
             ui->cbScheme->setItemData(schemeCount,mModifiedSchemeComboFont,Qt::FontRole);
         schemeCount++;
     }
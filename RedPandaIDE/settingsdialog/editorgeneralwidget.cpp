@@ -75,6 +75,8 @@ void EditorGeneralWidget::doLoad()
     ui->chkAutoHideScrollBars->setChecked(pSettings->editor().autoHideScrollbar());
     ui->chkScrollPastEOF->setChecked(pSettings->editor().scrollPastEof());
     ui->chkScrollPastEOL->setChecked(pSettings->editor().scrollPastEol());
+    ui->chkWrapLines->setChecked(pSettings->editor().wrapLines());
+    ui->chkShowMiniMap->setChecked(pSettings->editor().showMiniMap());
     ui->chkScrollHalfPage->setChecked(pSettings->editor().halfPageScroll());
     ui->chkScrollByOneLess->setChecked(pSettings->editor().scrollByOneLess());
     ui->spinMouseWheelScrollSpeed->setValue(pSettings->editor().mouseWheelScrollSpeed());
@@ -112,6 +114,8 @@ void EditorGeneralWidget::doSave()
     pSettings->editor().setAutoHideScrollbar(ui->chkAutoHideScrollBars->isChecked());
     pSettings->editor().setScrollPastEof(ui->chkScrollPastEOF->isChecked());
     pSettings->editor().setScrollPastEol(ui->chkScrollPastEOL->isChecked());
+    pSettings->editor().setWrapLines(ui->chkWrapLines->isChecked());
+    pSettings->editor().setShowMiniMap(ui->chkShowMiniMap->isChecked());
     pSettings->editor().setScrollByOneLess(ui->chkScrollByOneLess->isChecked());
     pSettings->editor().setHalfPageScroll(ui->chkScrollHalfPage->isChecked());
     pSettings->editor().setMouseWheelScrollSpeed(ui->spinMouseWheelScrollSpeed->value());
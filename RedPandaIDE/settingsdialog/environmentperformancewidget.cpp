@@ -55,6 +55,7 @@ void EnvironmentPerformanceWidget::doLoad()
 //#endif
     ui->chkEditorsShareParser->setChecked(pSettings->codeCompletion().shareParser());
     ui->spinMaxUndoMemory->setValue(pSettings->editor().undoMemoryUsage());
+    ui->spinMaxLoadedEditors->setValue(pSettings->editor().maxLoadedEditors());
 }
 
 void EnvironmentPerformanceWidget::doSave()
@@ -64,5 +65,6 @@ void EnvironmentPerformanceWidget::doSave()
 
     pSettings->codeCompletion().save();
     pSettings->editor().setUndoMemoryUsage(ui->spinMaxUndoMemory->value());
+    pSettings->editor().setMaxLoadedEditors(ui->spinMaxLoadedEditors->value());
     pSettings->editor().save();
 }
@@ -35,8 +35,13 @@ ExecutorGeneralWidget::ExecutorGeneralWidget(const QString& name, const QString&
     ui->txtParsedArgsInJson->setFont(defaultMonoFont());
 #ifdef Q_OS_WIN
     ui->chkVTSeq->setVisible(true);
+    ui->chkIntegratedConsole->setVisible(false);
 #else
     ui->chkVTSeq->setVisible(false);
+    ui->chkIntegratedConsole->setVisible(true);
+#endif
+#ifndef Q_OS_LINUX
+    ui->widgetHeapProfile->setVisible(false);
 #endif
 }
 
@@ -50,8 +55,11 @@ void ExecutorGeneralWidget::doLoad()
     ui->chkPauseConsole->setChecked(pSettings->executor().pauseConsole());
 #ifdef Q_OS_WIN
     ui->chkVTSeq->setChecked(pSettings->executor().enableVirualTerminalSequence());
+#else
+    ui->chkIntegratedConsole->setChecked(pSettings->executor().useIntegratedConsole());
 #endif
     ui->chkMinimizeOnRun->setChecked(pSettings->executor().minimizeOnRun());
+    ui->spinHeapProfileSampleRate->setValue(pSettings->executor().heapProfileSampleRate());
     ui->grpExecuteParameters->setChecked(pSettings->executor().useParams());
     ui->txtExecuteParamaters->setText(pSettings->executor().params());
     ui->grpRedirectInput->setChecked(pSettings->executor().redirectInput());
@@ -63,8 +71,11 @@ void ExecutorGeneralWidget::doSave()
     pSettings->executor().setPauseConsole(ui->chkPauseConsole->isChecked());
 #ifdef Q_OS_WIN
     pSettings->executor().setEnableVirualTerminalSequence(ui->chkVTSeq->isChecked());
+#else
+    pSettings->executor().setUseIntegratedConsole(ui->chkIntegratedConsole->isChecked());
 #endif
     pSettings->executor().setMinimizeOnRun(ui->chkMinimizeOnRun->isChecked());
+    pSettings->executor().setHeapProfileSampleRate(ui->spinHeapProfileSampleRate->value());
     pSettings->executor().setUseParams(ui->grpExecuteParameters->isChecked());
     pSettings->executor().setParams(ui->txtExecuteParamaters->text());
     pSettings->executor().setRedirectInput(ui->grpRedirectInput->isChecked());
@@ -56,6 +56,9 @@ void ProjectCompileParamatersWidget::doLoad()
     ui->txtResource->setPlainText(pMainWindow->project()->options().resourceCmd);
     ui->grpAllowParallelBuilding->setChecked(pMainWindow->project()->options().allowParallelBuilding);
     ui->spinParallelJobs->setValue(pMainWindow->project()->options().parellelBuildingJobs);
+    ui->chkTraceCompileTime->setChecked(pMainWindow->project()->options().traceCompileTime);
+    ui->grpUnityBuild->setChecked(pMainWindow->project()->options().unityBuild);
+    ui->spinUnityBuildBatches->setValue(pMainWindow->project()->options().unityBuildBatches);
 }
 
 void ProjectCompileParamatersWidget::doSave()
@@ -66,6 +69,9 @@ void ProjectCompileParamatersWidget::doSave()
     pMainWindow->project()->options().resourceCmd = ui->txtResource->toPlainText();
     pMainWindow->project()->options().allowParallelBuilding = ui->grpAllowParallelBuilding->isChecked();
     pMainWindow->project()->options().parellelBuildingJobs = ui->spinParallelJobs->value();
+    pMainWindow->project()->options().traceCompileTime = ui->chkTraceCompileTime->isChecked();
+    pMainWindow->project()->options().unityBuild = ui->grpUnityBuild->isChecked();
+    pMainWindow->project()->options().unityBuildBatches = ui->spinUnityBuildBatches->value();
     pMainWindow->project()->saveOptions();
 }
 
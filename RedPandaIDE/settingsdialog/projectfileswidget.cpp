@@ -55,6 +55,7 @@ void ProjectFilesWidget::doSave()
         unit->setLink(unitCopy->link());
         unit->setCompileCpp(unitCopy->compileCpp());
         unit->setOverrideBuildCmd(unitCopy->overrideBuildCmd());
+        unit->setUnityBuild(unitCopy->unityBuild());
         unit->setBuildCmd(unitCopy->buildCmd());
         unit->setEncoding(unitCopy->encoding());
     }
@@ -97,6 +98,7 @@ void ProjectFilesWidget::copyUnits()
         unitCopy->setLink(unit->link());
         unitCopy->setCompileCpp(unit->compileCpp());
         unitCopy->setOverrideBuildCmd(unit->overrideBuildCmd());
+        unitCopy->setUnityBuild(unit->unityBuild());
         unitCopy->setBuildCmd(unit->buildCmd());
         unitCopy->setEncoding(unit->encoding());
         unitCopy->setFileName(unit->fileName());
@@ -111,6 +113,7 @@ void ProjectFilesWidget::disableFileOptions()
     ui->chkCompile->setChecked(false);
     ui->chkLink->setChecked(false);
     ui->chkCompileAsCPP->setChecked(false);
+    ui->chkUnityBuild->setChecked(false);
     ui->chkOverrideBuildCommand->setChecked(false);
     ui->txtBuildCommand->setPlainText("");
 }
@@ -156,6 +159,7 @@ void ProjectFilesWidget::on_treeProject_doubleClicked(const QModelIndex &index)
         ui->chkCompile->setChecked(unit->compile());
         ui->chkLink->setChecked(unit->link());
         ui->chkCompileAsCPP->setChecked(unit->compileCpp());
+        ui->chkUnityBuild->setChecked(unit->unityBuild());
         ui->chkOverrideBuildCommand->setChecked(unit->overrideBuildCmd());
         ui->txtBuildCommand->setPlainText(unit->buildCmd());
         ui->txtBuildCommand->setEnabled(ui->chkOverrideBuildCommand->isChecked());
@@ -202,6 +206,15 @@ void ProjectFilesWidget::on_chkCompileAsCPP_stateChanged(int )
 }
 
 
+void ProjectFilesWidget::on_chkUnityBuild_stateChanged(int )
+{
+    PProjectUnit unit = currentUnit();
+    if(!unit)
+        return;
+    unit->setUnityBuild(ui->chkUnityBuild->isChecked());
+}
+
+
 void ProjectFilesWidget::on_chkOverrideBuildCommand_stateChanged(int )
 {
     PProjectUnit unit = currentUnit();
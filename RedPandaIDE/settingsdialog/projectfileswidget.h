@@ -53,6 +53,7 @@ private slots:
     void on_chkCompile_stateChanged(int arg1);
     void on_chkLink_stateChanged(int arg1);
     void on_chkCompileAsCPP_stateChanged(int arg1);
+    void on_chkUnityBuild_stateChanged(int arg1);
     void on_chkOverrideBuildCommand_stateChanged(int arg1);
     void on_txtBuildCommand_textChanged();
     void on_cbEncoding_currentTextChanged(const QString &arg1);
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "startuptasks.h"
+
+#include <QCoreApplication>
+#include <QMetaObject>
+#include <QRunnable>
+
+static StartupTasks* runningTasks = nullptr;
+
+class StartupTaskRunnable : public QRunnable {
+public:
+    StartupTaskRunnable(const std::function<void()>& run):
+        mRun{run} {
+        setAutoDelete(true);
+    }
+    void run() override {
+        mRun();
+    }
+private:
+    std::function<void()> mRun;
+};
+
+StartupTasks::StartupTasks()
+{
+    mTimer.start();
+    runningTasks = this;
+}
+
+StartupTasks::~StartupTasks()
+{
+    waitForAll();
+    mThreadPool.waitForDone();
+    if (runningTasks == this)
+        runningTasks = nullptr;
+}
+
+void StartupTasks::addTask(const QString &name, const Task &task, const QStringList &dependencies, const Task &onFinished)
+{
+    {
+        QMutexLocker locker(&mMutex);
+        Q_ASSERT(!mTaskIndexes.contains(name));
+        mTaskIndexes.insert(name, mTasks.count());
+        mTasks.append(TaskInfo{name, task, onFinished, dependencies, false, false, 0, 0});
+    }
+    startReadyTasks();
+}
+
+void StartupTasks::wait(const QString &name)
+{
+    QMutexLocker locker(&mMutex);
+    auto it = mTaskIndexes.constFind(name);
+    if (it == mTaskIndexes.constEnd())
+        return;
+    int index = it.value();
+    while (!mTasks[index].finished)
+        mTaskFinished.wait(&mMutex);
+}
+
+void StartupTasks::waitForAll()
+{
+    QMutexLocker locker(&mMutex);
+    for (int i=0;i<mTasks.count();i++) {
+        while (!mTasks[i].finished)
+            mTaskFinished.wait(&mMutex);
+    }
+}
+
+void StartupTasks::beginPhase(const QString &name)
+{
+    QMutexLocker locker(&mMutex);
+    mPhases.append(Phase{name, mTimer.elapsed(), -1});
+}
+
+void StartupTasks::endPhase()
+{
+    QMutexLocker locker(&mMutex);
+    if (!mPhases.isEmpty() && mPhases.last().endTime < 0)
+        mPhases.last().endTime = mTimer.elapsed();
+}
+
+qint64 StartupTasks::elapsed() const
+{
+    return mTimer.elapsed();
+}
+
+QStringList StartupTasks::report() const
+{
+    QMutexLocker locker(&mMutex);
+    QStringList result;
+    foreach (const Phase& phase, mPhases) {
+        if (phase.endTime < 0)
+            continue;
+        result.append(QString("%1: %2 ms (at %3 ms)")
+                      .arg(phase.name)
+                      .arg(phase.endTime - phase.startTime)
+                      .arg(phase.startTime));
+    }
+    foreach (const TaskInfo& task, mTasks) {
+        if (!task.finished)
+            continue;
+        result.append(QString("%1 (background): %2 ms (at %3 ms)")
+                      .arg(task.name)
+                      .arg(task.endTime - task.startTime)
+                      .arg(task.startTime));
+    }
+    return result;
+}
+
+void StartupTasks::waitFor(const QString &name)
+{
+    if (runningTasks)
+        runningTasks->wait(name);
+}
+
+void StartupTasks::startReadyTasks()
+{
+    QMutexLocker locker(&mMutex);
+    for (int i=0;i<mTasks.count();i++) {
+        TaskInfo& task = mTasks[i];
+        if (task.started)
+            continue;
+        bool ready = true;
+        foreach (const QString& dependency, task.dependencies) {
+            auto it = mTaskIndexes.constFind(dependency);
+            // unknown dependencies may be added later
+            if (it == mTaskIndexes.constEnd() || !mTasks[it.value()].finished) {
+                ready = false;
+                break;
+            }
+        }
+        if (!ready)
+            continue;
+        task.started = true;
+        mThreadPool.start(new StartupTaskRunnable([this, i](){
+            runTask(i);
+        }));
+    }
+}
+
+void StartupTasks::runTask(int index)
+{
+    Task task;
+    Task onFinished;
+    {
+        QMutexLocker locker(&mMutex);
+        mTasks[index].startTime = mTimer.elapsed();
+        task = mTasks[index].task;
+        onFinished = mTasks[index].onFinished;
+    }
+    task();
+    {
+        QMutexLocker locker(&mMutex);
+        mTasks[index].endTime = mTimer.elapsed();
+        mTasks[index].finished = true;
+        mTaskFinished.wakeAll();
+    }
+    if (onFinished && QCoreApplication::instance())
+        QMetaObject::invokeMethod(QCoreApplication::instance(), onFinished, Qt::QueuedConnection);
+    startReadyTasks();
+}
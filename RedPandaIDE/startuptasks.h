@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STARTUPTASKS_H
+#define STARTUPTASKS_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+#include <functional>
+
+#define STARTUP_TASK_AUTOLINKS "autolinks"
+#define STARTUP_TASK_SYMBOL_USAGES "symbol usages"
+
+/**
+ * @brief Startup work, run as a dependency graph.
+ *
+ * Background tasks run in a thread pool as soon as the tasks they depend on
+ * are finished, so they must not touch the GUI; their onFinished callbacks
+ * are called in the GUI thread. Code that needs the result of a task calls
+ * wait() first.
+ *
+ * The time of each task, and of the phases run in the GUI thread (recorded
+ * by beginPhase()/endPhase()), is reported by report().
+ */
+class StartupTasks
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit StartupTasks();
+    ~StartupTasks();
+
+    void addTask(const QString& name, const Task& task,
+                 const QStringList& dependencies = QStringList(),
+                 const Task& onFinished = Task());
+    // blocks until the task is finished; returns at once if there's no such task
+    void wait(const QString& name);
+    void waitForAll();
+
+    void beginPhase(const QString& name);
+    void endPhase();
+    // time since the tasks object is created
+    qint64 elapsed() const;
+    QStringList report() const;
+
+    // the wait() of the running instance, if any
+    static void waitFor(const QString& name);
+
+    StartupTasks(const StartupTasks&)=delete;
+    StartupTasks& operator=(const StartupTasks&)=delete;
+private:
+    struct TaskInfo {
+        QString name;
+        Task task;
+        Task onFinished;
+        QStringList dependencies;
+        bool started;
+        bool finished;
+        qint64 startTime;
+        qint64 endTime;
+    };
+    struct Phase {
+        QString name;
+        qint64 startTime;
+        qint64 endTime;
+    };
+    void startReadyTasks();
+    void runTask(int index);
+private:
+    QVector<TaskInfo> mTasks;
+    QHash<QString, int> mTaskIndexes;
+    QVector<Phase> mPhases;
+    QElapsedTimer mTimer;
+    QThreadPool mThreadPool;
+    mutable QMutex mMutex;
+    QWaitCondition mTaskFinished;
+};
+
+#endif // STARTUPTASKS_H
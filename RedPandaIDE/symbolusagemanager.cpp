@@ -24,36 +24,39 @@
 #include <QJsonObject>
 #include <QMessageBox>
 
-SymbolUsageManager::SymbolUsageManager(QObject *parent) : QObject(parent)
+SymbolUsageManager::SymbolUsageManager(QObject *parent) : QObject(parent),
+    mLoaded{false}
 {
 
 }
 
 void SymbolUsageManager::load()
 {
+    mUsages = readUsages();
+    mLoaded = true;
+}
+
+QHash<QString, PSymbolUsage> SymbolUsageManager::readUsages()
+{
+    QHash<QString, PSymbolUsage> usages;
     QString filename = includeTrailingPathDelimiter(pSettings->dirs().config())
             + DEV_SYMBOLUSAGE_FILE;
     if (!fileExists(filename))
-        return;
+        return usages;
     QFile file(filename);
     if (!file.open(QFile::ReadOnly)) {
-        QMessageBox::critical(nullptr,
-                              tr("Load symbol usage info failed"),
-                              tr("Can't open symbol usage file '%1' for read.")
-                              .arg(filename));
+        throw FileError(tr("Can't open symbol usage file '%1' for read.")
+                        .arg(filename));
     }
     QByteArray contents = file.readAll();
     QJsonParseError error;
     QJsonDocument doc = QJsonDocument::fromJson(contents,&error);
     if (error.error != QJsonParseError::NoError) {
-        QMessageBox::critical(nullptr,
-                              tr("Load symbol usage info failed"),
-                              tr("Can't parse symbol usage file '%1': %2")
-                              .arg(filename)
-                              .arg(error.errorString()));
+        throw FileError(tr("Can't parse symbol usage file '%1': %2")
+                        .arg(filename)
+                        .arg(error.errorString()));
     }
 
-    mUsages.clear();
     QJsonArray array = doc.array();
     foreach (const QJsonValue& val, array) {
         QJsonObject obj = val.toObject();
@@ -62,12 +65,28 @@ void SymbolUsageManager::load()
         PSymbolUsage usage = std::make_shared<SymbolUsage>();
         usage->fullName = fullname;
         usage->count = count;
-        mUsages.insert(fullname,usage);
+        usages.insert(fullname,usage);
+    }
+    return usages;
+}
+
+void SymbolUsageManager::addUsages(const QHash<QString, PSymbolUsage> &usages)
+{
+    for (auto it=usages.constBegin();it!=usages.constEnd();++it) {
+        // symbols used before the file is read have their counts added
+        PSymbolUsage usage = mUsages.value(it.key());
+        if (usage)
+            usage->count += it.value()->count;
+        else
+            mUsages.insert(it.key(), it.value());
     }
+    mLoaded = true;
 }
 
 void SymbolUsageManager::save()
 {
+    if (!mLoaded)
+        return;
     QString filename = includeTrailingPathDelimiter(pSettings->dirs().config())
             + DEV_SYMBOLUSAGE_FILE;
     QFile file(filename);
@@ -97,6 +116,7 @@ void SymbolUsageManager::save()
 void SymbolUsageManager::reset()
 {
     mUsages.clear();
+    mLoaded = true;
     save();
 }
 
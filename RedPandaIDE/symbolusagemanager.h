@@ -34,12 +34,18 @@ class SymbolUsageManager : public QObject
 public:
     explicit SymbolUsageManager(QObject *parent = nullptr);
     void load();
+    // reads the usage file without changing the manager, can be called in any thread
+    static QHash<QString, PSymbolUsage> readUsages();
+    // merges the usages read in background, the counts of known symbols are added
+    void addUsages(const QHash<QString, PSymbolUsage>& usages);
     void save();
     void reset();
     PSymbolUsage findUsage(const QString& fullName) const;
     void updateUsage(const QString& symbol, int count);
 private:
     QHash<QString, PSymbolUsage> mUsages;
+    // not saved before the usage file is read, or the usages in it are lost
+    bool mLoaded;
 };
 
 using PSymbolUsageManager = std::shared_ptr<SymbolUsageManager>;
@@ -49,6 +49,7 @@
 #define MAKE_PROGRAM    "make"
 #define WINDRES_PROGRAM ""
 #define GPROF_PROGRAM   "gprof"
+#define ADDR2LINE_PROGRAM   "addr2line"
 #define CLEAN_PROGRAM   "rm -rf"
 #define CPP_PROGRAM     "cpp"
 #define GIT_PROGRAM     "git"
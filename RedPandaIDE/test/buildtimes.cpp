@@ -0,0 +1,136 @@
+#include <cstdlib>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QString>
+#include <QTemporaryDir>
+
+#include "compiler/buildtimes.h"
+
+static void fail(const QString& test, const QString& message)
+{
+    qDebug() << "Error in test" << test << ":" << message;
+    exit(1);
+}
+
+static void writeFile(const QString& fileName, const QByteArray& content = QByteArray())
+{
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+        fail("write", "can't write " + fileName);
+    file.write(content);
+}
+
+static const BuildStep* findStep(const PBuildRecord& record, const QString& outputFile)
+{
+    foreach (const BuildStep& step, record->steps) {
+        if (step.outputFile == outputFile)
+            return &step;
+    }
+    return nullptr;
+}
+
+static void testRecorder()
+{
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("recorder", "can't create temp dir");
+    QString path = QDir(dir.path()).absolutePath();
+    BuildTimeRecorder recorder(path, false);
+    if (recorder.finish())
+        fail("recorder", "nothing is built");
+
+    // output is split in the middle of lines
+    recorder.processOutput("g++ -c main.cpp -o main.o -O2\ng++ -c \"my ut");
+    recorder.processOutput("il.cpp\" -o util.o -O2\n");
+    recorder.processOutput("g++ -c bad.cpp -o bad.o -O2\nmake: *** [bad.o] Error 1\n");
+    writeFile(path+"/main.o");
+    writeFile(path+"/util.o");
+    recorder.processOutput("g++ main.o util.o -o app -s\nrm -f old.o\n");
+    writeFile(path+"/app");
+    PBuildRecord record = recorder.finish();
+    if (!record)
+        fail("recorder", "no record");
+    if (record->steps.count() != 3)
+        fail("recorder", QString("%1 steps, expected 3").arg(record->steps.count()));
+    const BuildStep* util = findStep(record, path+"/util.o");
+    if (!util || util->sourceFile != path+"/my util.cpp" || util->link)
+        fail("recorder", "wrong compile step");
+    const BuildStep* link = findStep(record, path+"/app");
+    if (!link || !link->link || !link->critical)
+        fail("recorder", "link step should be critical");
+    int critical = 0;
+    foreach (const BuildStep& step, record->steps) {
+        if (step.endTime < step.startTime)
+            fail("recorder", "step ends before it starts");
+        if (step.critical)
+            critical++;
+    }
+    if (critical != 2)
+        fail("recorder", QString("%1 critical steps, expected 2").arg(critical));
+}
+
+static void testTimeTrace()
+{
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("time trace", "can't create temp dir");
+    QString path = QDir(dir.path()).absolutePath();
+    BuildTimeRecorder recorder(path, true);
+    recorder.processOutput("clang++ -c a.cpp -o a.o -ftime-trace\nclang++ -c b.cpp -o b.o -ftime-trace\n");
+    QByteArray trace = R"({"traceEvents":[
+        {"name":"Source","dur":3000,"args":{"detail":"/usr/include/c++/vector"}},
+        {"name":"Source","dur":1000,"args":{"detail":"/usr/include/c++/vector"}},
+        {"name":"Source","dur":2000,"args":{"detail":"/usr/include/stdio.h"}},
+        {"name":"ParseClass","dur":500,"args":{"detail":"std::vector"}}]})";
+    writeFile(path+"/a.o");
+    writeFile(path+"/a.json", trace);
+    writeFile(path+"/b.o");
+    writeFile(path+"/b.json", trace);
+    PBuildRecord record = recorder.finish();
+    if (!record || record->headers.count() != 2)
+        fail("time trace", "expected 2 headers");
+    const HeaderCost& vector = record->headers[0];
+    if (vector.fileName != "/usr/include/c++/vector" || vector.time != 8 || vector.count != 2)
+        fail("time trace", QString("vector: %1 ms in %2 files").arg(vector.time).arg(vector.count));
+}
+
+static void testHistory()
+{
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("history", "can't create temp dir");
+    QString path = QDir(dir.path()).absolutePath();
+    QString fileName = path+"/test." BUILD_TIMES_EXT;
+    BuildTimeHistory history(fileName);
+    for (int i=0;i<35;i++) {
+        PBuildRecord record = std::make_shared<BuildRecord>();
+        record->time = QDateTime::currentDateTime();
+        record->wallTime = 1000 + i;
+        record->steps.append(BuildStep{path+"/main.o", path+"/main.cpp", false, 0, 100 + i, true});
+        history.add(record);
+    }
+    if (!history.save())
+        fail("history", "can't save");
+    BuildTimeHistory loaded(fileName);
+    loaded.load();
+    if (loaded.records().count() != 30)
+        fail("history", QString("%1 records kept, expected 30").arg(loaded.records().count()));
+    const PBuildRecord& last = loaded.records().last();
+    if (last->wallTime != 1034 || last->steps.count() != 1)
+        fail("history", "wrong last record");
+    if (last->steps[0].sourceFile != path+"/main.cpp")
+        fail("history", "wrong source file");
+    if (loaded.previousDuration(29, last->steps[0]) != 133)
+        fail("history", "wrong previous duration");
+    if (loaded.previousDuration(0, last->steps[0]) != -1)
+        fail("history", "the first record has no previous duration");
+}
+
+int main()
+{
+    testRecorder();
+    testTimeTrace();
+    testHistory();
+    return 0;
+}
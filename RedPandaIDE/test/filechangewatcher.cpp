@@ -0,0 +1,155 @@
+#include <cstdlib>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QString>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include "filechangewatcher.h"
+
+static void fail(const QString& test, const QString& message)
+{
+    qDebug() << "Error in test" << test << ":" << message;
+    exit(1);
+}
+
+static void writeFile(const QString& test, const QString& fileName, const QByteArray& content)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+        fail(test, "can't write "+fileName);
+    file.write(content);
+    file.close();
+}
+
+// changes reported in the time, united
+static FileChangeSet waitForChanges(FileChangeWatcher& watcher, int timeout = 2000)
+{
+    FileChangeSet result;
+    QEventLoop loop;
+    QObject::connect(&watcher, &FileChangeWatcher::filesChanged, &loop,
+                     [&result](const FileChangeSet& changes) {
+        result.unite(changes);
+    });
+    QTimer::singleShot(timeout, &loop, &QEventLoop::quit);
+    loop.exec();
+    return result;
+}
+
+static void testFiles()
+{
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("files", "can't create temp dir");
+    QString fileName = dir.filePath("main.cpp");
+    QString otherName = dir.filePath("other.cpp");
+    writeFile("files", fileName, "int main() {}\n");
+    writeFile("files", otherName, "\n");
+    FileChangeWatcher watcher;
+    watcher.addPath(fileName);
+    if (!watcher.isWatching(fileName) || watcher.isWatching(otherName))
+        fail("files", "wrong watched files");
+    // let the watches be added
+    waitForChanges(watcher, 300);
+
+    // many writes are reported once
+    for (int i=0;i<20;i++)
+        writeFile("files", fileName, QByteArray("int main() { return ")+QByteArray::number(i)+"; }\n");
+    writeFile("files", otherName, "int x;\n");
+    FileChangeSet changes = waitForChanges(watcher);
+    if (changes.changed != QSet<QString>{fileName})
+        fail("files", QString("%1 files changed, expected main.cpp only").arg(changes.changed.count()));
+
+    // files written by the IDE are not reported
+    watcher.removePath(fileName);
+    writeFile("files", fileName, "int main() { return 100; }\n");
+    watcher.addPath(fileName);
+    changes = waitForChanges(watcher, 500);
+    if (!changes.isEmpty())
+        fail("files", "saved file is reported");
+
+    // replaced by a rename, and removed
+    writeFile("files", otherName, "int main() { return 2000; }\n");
+    QFile::remove(fileName);
+    QFile::rename(otherName, fileName);
+    changes = waitForChanges(watcher);
+    if (!changes.changed.contains(fileName))
+        fail("files", "replaced file is not reported");
+    QFile::remove(fileName);
+    changes = waitForChanges(watcher);
+    if (changes.removed != QSet<QString>{fileName})
+        fail("files", "removed file is not reported");
+}
+
+static void testDirectories()
+{
+#ifdef Q_OS_LINUX
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("directories", "can't create temp dir");
+    QDir root(dir.path());
+    root.mkpath("src/core");
+    root.mkpath(".git/objects");
+    FileChangeWatcher watcher;
+    watcher.addDirectory(dir.path());
+    waitForChanges(watcher, 300);
+
+    QString header = root.filePath("src/core/types.h");
+    writeFile("directories", header, "#pragma once\n");
+    writeFile("directories", root.filePath(".git/objects/1234"), "hidden\n");
+    // files in the new directories are found
+    root.mkpath("include/sub");
+    QString newHeader = root.filePath("include/sub/api.h");
+    writeFile("directories", newHeader, "#pragma once\n");
+    FileChangeSet changes = waitForChanges(watcher);
+    if (!changes.changed.contains(header))
+        fail("directories", "file in sub directory is not reported");
+    if (!changes.changed.contains(newHeader))
+        fail("directories", "file in new directory is not reported");
+    foreach (const QString& file, changes.changed) {
+        if (file.contains("/.git/"))
+            fail("directories", "file in hidden directory is reported");
+    }
+
+    watcher.removeDirectory(dir.path());
+    waitForChanges(watcher, 300);
+    writeFile("directories", header, "#pragma once\nint x;\n");
+    changes = waitForChanges(watcher, 500);
+    if (!changes.isEmpty())
+        fail("directories", "changes reported after the directory is removed");
+#endif
+}
+
+static void testManyFiles()
+{
+    // a branch switch in a large tree
+    const int fileCount = 5000;
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("many files", "can't create temp dir");
+    QDir root(dir.path());
+    for (int i=0;i<50;i++)
+        root.mkpath(QString("module%1").arg(i));
+    FileChangeWatcher watcher;
+    watcher.addDirectory(dir.path());
+    waitForChanges(watcher, 300);
+    for (int i=0;i<fileCount;i++)
+        writeFile("many files", root.filePath(QString("module%1/file%2.cpp").arg(i%50).arg(i)), "\n");
+    FileChangeSet changes = waitForChanges(watcher);
+#ifdef Q_OS_LINUX
+    if (!changes.overflowed && changes.changed.count() != fileCount)
+        fail("many files", QString("%1 files reported, expected %2").arg(changes.changed.count()).arg(fileCount));
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    testFiles();
+    testDirectories();
+    testManyFiles();
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <cstdlib>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QString>
+#include <QTemporaryDir>
+#include <QVector>
+
+#include "parser/filetable.h"
+#include "parser/parserutils.h"
+
+static void fail(const QString& test, const QString& message)
+{
+    qDebug() << "Error in test" << test << ":" << message;
+    exit(1);
+}
+
+static void testIntern()
+{
+    FileTable* table = FileTable::instance();
+    if (table->intern("") != 0)
+        fail("intern", "empty file name should be 0");
+    FileId header = table->intern("/usr/include/stdio.h");
+    FileId source = table->intern("/home/user/main.cpp");
+    FileId other = table->intern("/home/user/README");
+    if (header <= 0 || source <= 0 || other <= 0)
+        fail("intern", "ids should be positive");
+    if (header == source || source == other)
+        fail("intern", "ids should be unique");
+    if (table->intern("/usr/include/stdio.h") != header)
+        fail("intern", "id changed");
+    if (table->find("/home/user/main.cpp") != source)
+        fail("intern", "find returns a different id");
+    if (table->find("/not/interned.h") != 0)
+        fail("intern", "file not interned is found");
+    if (table->fileName(source) != "/home/user/main.cpp")
+        fail("intern", "wrong file name");
+    if (table->kind(header) != FileKind::Header
+            || table->kind(source) != FileKind::Source
+            || table->kind(other) != FileKind::Other)
+        fail("intern", "wrong file kind");
+}
+
+static void testFileIdSet()
+{
+    FileIdSet set;
+    if (!set.isEmpty() || set.contains(1))
+        fail("set", "new set should be empty");
+    set.insert(0);
+    if (!set.isEmpty() || set.contains(0))
+        fail("set", "id 0 should never be in a set");
+    set.insert(3);
+    set.insert(200);
+    if (!set.contains(3) || !set.contains(200) || set.contains(4) || set.contains(100000))
+        fail("set", "wrong content");
+    FileIdSet other;
+    other.insert(70);
+    other.insert(1000);
+    set.unite(other);
+    if (!set.contains(70) || !set.contains(1000) || !set.contains(3))
+        fail("set", "unite lost ids");
+    set.clear();
+    if (!set.isEmpty())
+        fail("set", "set not cleared");
+}
+
+static void testIncludePaths()
+{
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("include paths", "can't create temp dir");
+    QString includePath = includeTrailingPathDelimiter(dir.path());
+    QFile file(includePath+"vector");
+    if (!file.open(QFile::WriteOnly))
+        fail("include paths", "can't create header");
+    file.close();
+    QSet<QString> includePaths{includePath};
+    if (!isSystemHeaderFile("vector", includePaths))
+        fail("include paths", "vector should be found");
+    if (!isSystemHeaderFile(file.fileName(), includePaths))
+        fail("include paths", "full file name should be found");
+    if (isSystemHeaderFile("missing.h", includePaths))
+        fail("include paths", "missing.h should not be found");
+    if (isSystemHeaderFile("vector", QSet<QString>{includePath+"sub/"}))
+        fail("include paths", "vector is not in other include paths");
+    // results of the missing files are not cached
+    QFile missing(includePath+"missing.h");
+    if (!missing.open(QFile::WriteOnly))
+        fail("include paths", "can't create header");
+    missing.close();
+    if (!isSystemHeaderFile("missing.h", includePaths))
+        fail("include paths", "missing.h should be found after created");
+}
+
+int main()
+{
+    initParser();
+    testIntern();
+    testFileIdSet();
+    testIncludePaths();
+    return 0;
+}
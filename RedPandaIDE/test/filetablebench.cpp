@@ -0,0 +1,65 @@
+#include <cstdlib>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include "parser/filetable.h"
+#include "parser/parserutils.h"
+
+static void fail(const QString& test, const QString& message)
+{
+    qDebug() << "Error in test" << test << ":" << message;
+    exit(1);
+}
+
+static void benchLookup()
+{
+    // statements checked against the included files, as in code completion
+    const int fileCount = 2000;
+    const int statementCount = 200000;
+    FileTable* table = FileTable::instance();
+    QVector<QString> fileNames;
+    QVector<FileId> fileIds;
+    QSet<QString> includedNames;
+    FileIdSet includedIds;
+    for (int i=0;i<fileCount;i++) {
+        QString fileName = QString("/usr/include/c++/13/bits/header_%1.h").arg(i);
+        fileNames.append(fileName);
+        fileIds.append(table->intern(fileName));
+        if (i % 3 == 0) {
+            includedNames.insert(fileName);
+            includedIds.insert(fileIds.last());
+        }
+    }
+    QElapsedTimer timer;
+    int nameHits = 0;
+    timer.start();
+    for (int i=0;i<statementCount;i++) {
+        // statements own copies of the file names
+        QString fileName = fileNames[i % fileCount];
+        fileName.detach();
+        if (includedNames.contains(fileName))
+            nameHits++;
+    }
+    qint64 nameTime = timer.nsecsElapsed();
+    int idHits = 0;
+    timer.restart();
+    for (int i=0;i<statementCount;i++) {
+        if (includedIds.contains(fileIds[i % fileCount]))
+            idHits++;
+    }
+    qint64 idTime = timer.nsecsElapsed();
+    if (nameHits != idHits)
+        fail("lookup", "file name and id lookups differ");
+    qDebug() << statementCount << "lookups:" << nameTime / 1000 << "us by name,"
+             << idTime / 1000 << "us by id";
+}
+
+int main()
+{
+    initParser();
+    benchLookup();
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include <cstdlib>
+#include <QByteArray>
+#include <QDebug>
+#include <QFile>
+#include <QString>
+#include <QTemporaryDir>
+
+#include "compiler/heapprofile.h"
+
+static const quint64 SampleRate = 4096;
+static const quint64 ExeStart = 0x555500000000;
+static const quint64 ProfilerStart = 0x7f0000000000;
+static const quint64 LibcStart = 0x7f1000000000;
+
+static void fail(const QString& test, const QString& message)
+{
+    qDebug() << "Error in test" << test << ":" << message;
+    exit(1);
+}
+
+template<typename T>
+static void append(QByteArray& data, T value)
+{
+    data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void appendAllocation(QByteArray& data, quint64 address, quint64 size, const QVector<quint64>& frames)
+{
+    data.append('A');
+    append<quint64>(data, address);
+    append<quint64>(data, size);
+    append<quint16>(data, frames.count());
+    for (quint64 frame : frames)
+        append<quint64>(data, frame);
+}
+
+static QByteArray buildLog(bool finished)
+{
+    QByteArray data("RPHEAP01");
+    append<quint64>(data, SampleRate);
+    // profiler -> f/g -> main -> __libc_start_main
+    QVector<quint64> stackF{ProfilerStart+0x100, ExeStart+0x1100, ExeStart+0x1200, LibcStart+0x100};
+    QVector<quint64> stackG{ProfilerStart+0x100, ExeStart+0x1300, ExeStart+0x1200, LibcStart+0x100};
+    appendAllocation(data, 0x1000, 100, stackF);
+    appendAllocation(data, 0x2000, 10000, stackG);
+    data.append('F');
+    append<quint64>(data, 0x1000);
+    appendAllocation(data, 0x3000, 200, stackF);
+    // freeing a block not sampled
+    data.append('F');
+    append<quint64>(data, 0x4000);
+    if (finished) {
+        QByteArray maps = QString(
+                    "%1-%2 r-xp 00000000 08:01 100 /home/user/test\n"
+                    "%3-%4 r-xp 00001000 08:01 101 /usr/libexec/RedPandaCPP/libredpanda-heapprof.so\n"
+                    "%5-%6 r-xp 00028000 08:01 102 /lib/x86_64-linux-gnu/libc.so.6\n"
+                    "7ffc00000000-7ffc00021000 rw-p 00000000 00:00 0 [stack]\n")
+                .arg(ExeStart, 0, 16).arg(ExeStart+0x10000, 0, 16)
+                .arg(ProfilerStart, 0, 16).arg(ProfilerStart+0x10000, 0, 16)
+                .arg(LibcStart, 0, 16).arg(LibcStart+0x10000, 0, 16).toLatin1();
+        data.append('M');
+        append<quint32>(data, maps.length());
+        data.append(maps);
+        data.append('E');
+        append<quint64>(data, 20000);
+        append<quint64>(data, 30);
+        append<quint64>(data, 50000);
+        append<quint64>(data, 10200);
+    }
+    return data;
+}
+
+static QString writeLog(const QTemporaryDir& dir, const QString& name, const QByteArray& data)
+{
+    QString fileName = dir.filePath(name);
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly))
+        fail("write", "can't create " + fileName);
+    file.write(data);
+    return fileName;
+}
+
+static quint64 frameAddress(const HeapProfile& profile, int frame)
+{
+    return profile.frames()[frame].address;
+}
+
+static void testLoad(const QTemporaryDir& dir)
+{
+    HeapProfile profile;
+    if (!profile.load(writeLog(dir, "test.heapprof", buildLog(true))))
+        fail("load", profile.errorMessage());
+    if (!profile.finished())
+        fail("load", "summary not read");
+    if (profile.sampleRate() != SampleRate || profile.peakHeap() != 20000
+            || profile.allocationCount() != 30 || profile.heapInUse() != 10200)
+        fail("load", "wrong summary");
+    if (profile.modules().count() != 3)
+        fail("load", QString("%1 modules, expected 3").arg(profile.modules().count()));
+    const QList<HeapProfileSample>& samples = profile.samples();
+    if (samples.count() != 3)
+        fail("load", QString("%1 samples, expected 3").arg(samples.count()));
+    if (!samples[0].freed || samples[1].freed || samples[2].freed)
+        fail("load", "wrong freed flags");
+    // frames of the profiler and libc are trimmed
+    for (const HeapProfileSample& sample : samples) {
+        if (sample.frames.count() != 2)
+            fail("load", QString("%1 frames kept, expected 2").arg(sample.frames.count()));
+        if (frameAddress(profile, sample.frames.last()) != ExeStart+0x1200)
+            fail("load", "outermost frame should be main");
+    }
+}
+
+static void testReports(const QTemporaryDir& dir)
+{
+    HeapProfile profile;
+    profile.load(writeLog(dir, "reports.heapprof", buildLog(true)));
+
+    // small blocks count as the sample rate
+    QList<HeapProfileSite> hotSpots = profile.hotSpots();
+    if (hotSpots.count() != 2)
+        fail("hot spots", QString("%1 sites, expected 2").arg(hotSpots.count()));
+    if (frameAddress(profile, hotSpots[0].frame) != ExeStart+0x1300
+            || hotSpots[0].bytes != 10000 || hotSpots[0].count != 1)
+        fail("hot spots", "g should be the first");
+    if (frameAddress(profile, hotSpots[1].frame) != ExeStart+0x1100
+            || hotSpots[1].bytes != 2 * SampleRate || hotSpots[1].count != 2)
+        fail("hot spots", "f should be the second");
+
+    QList<HeapProfileSite> leaks = profile.leaks();
+    if (leaks.count() != 2)
+        fail("leaks", QString("%1 leaks, expected 2").arg(leaks.count()));
+    if (leaks[0].bytes != 10000 || leaks[1].bytes != SampleRate || leaks[1].count != 1)
+        fail("leaks", "freed blocks are counted");
+
+    PHeapFlameNode root = profile.flameGraph();
+    if (root->bytes != 10000 + 2 * SampleRate || root->count != 3)
+        fail("flame graph", "wrong total");
+    if (root->children.count() != 1 || root->children[0]->children.count() != 2)
+        fail("flame graph", "main should have two children");
+    if (frameAddress(profile, root->children[0]->children[0]->frame) != ExeStart+0x1300)
+        fail("flame graph", "children are not sorted by bytes");
+}
+
+static void testBadLogs(const QTemporaryDir& dir)
+{
+    // the program crashed before writing the summary
+    QByteArray data = buildLog(false);
+    data.chop(5);
+    HeapProfile profile;
+    if (!profile.load(writeLog(dir, "crashed.heapprof", data)))
+        fail("crashed", profile.errorMessage());
+    if (profile.finished())
+        fail("crashed", "summary should be missing");
+    if (profile.samples().count() != 3)
+        fail("crashed", QString("%1 samples, expected 3").arg(profile.samples().count()));
+
+    if (profile.load(writeLog(dir, "bad.heapprof", "not a heap profile")))
+        fail("bad", "bad magic accepted");
+    if (profile.load(dir.filePath("missing.heapprof")))
+        fail("bad", "missing file accepted");
+}
+
+int main()
+{
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("main", "can't create temp dir");
+    testLoad(dir);
+    testReports(dir);
+    testBadLogs(dir);
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <cstdlib>
+#include <QDebug>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "utils/linediff.h"
+
+static void fail(const QString& test, const QString& message)
+{
+    qDebug() << "Error in test" << test << ":" << message;
+    exit(1);
+}
+
+// applies the hunks from the bottom up, as the editor does
+static QStringList applyHunks(const QStringList& baseLines, const QStringList& lines,
+                              const QVector<LineDiffHunk>& hunks)
+{
+    QStringList result = baseLines;
+    for (int i=hunks.count()-1;i>=0;i--) {
+        const LineDiffHunk& hunk = hunks[i];
+        for (int j=0;j<hunk.baseCount;j++)
+            result.removeAt(hunk.baseStart);
+        for (int j=hunk.count-1;j>=0;j--)
+            result.insert(hunk.baseStart, lines[hunk.start+j]);
+    }
+    return result;
+}
+
+static void expectHunks(const QString& test, const QStringList& baseLines, const QStringList& lines,
+                        int expectedCount)
+{
+    QVector<LineDiffHunk> hunks = diffLines(baseLines, lines);
+    if (hunks.count() != expectedCount)
+        fail(test, QString("%1 hunks, expected %2").arg(hunks.count()).arg(expectedCount));
+    int lastEnd = 0;
+    foreach (const LineDiffHunk& hunk, hunks) {
+        if (hunk.baseStart < lastEnd)
+            fail(test, "hunks are not in order");
+        lastEnd = hunk.baseStart + hunk.baseCount;
+    }
+    if (applyHunks(baseLines, lines, hunks) != lines)
+        fail(test, "applied hunks don't give the new lines");
+}
+
+static void testDiff()
+{
+    QStringList base{"int main()", "{", "int x=1;", "return x;", "}"};
+    expectHunks("same", base, base, 0);
+    expectHunks("indent", base, {"int main()", "{", "    int x=1;", "    return x;", "}"}, 1);
+    expectHunks("insert", base, {"int main()", "{", "int x=1;", "", "return x;", "}"}, 1);
+    expectHunks("delete", base, {"int main()", "{", "return x;", "}"}, 1);
+    expectHunks("two places", base, {"int main() {", "int x=1;", "return x;", "}", ""}, 2);
+    expectHunks("all", base, {"a", "b"}, 1);
+    expectHunks("from empty", {""}, base, 1);
+}
+
+static void testFormatLargeFile()
+{
+    // a formatter usually changes few lines of a large file
+    const int lineCount = 100000;
+    QStringList base;
+    for (int i=0;i<lineCount;i++)
+        base.append(QString("    int v%1 = %1;").arg(i));
+    QStringList lines = base;
+    for (int i=0;i<lineCount;i+=1000)
+        lines[i] = lines[i].trimmed();
+    QVector<LineDiffHunk> hunks = diffLines(base, lines);
+    if (hunks.count() != lineCount / 1000)
+        fail("large file", QString("%1 hunks, expected %2").arg(hunks.count()).arg(lineCount / 1000));
+    foreach (const LineDiffHunk& hunk, hunks) {
+        if (hunk.baseCount != 1 || hunk.count != 1)
+            fail("large file", "hunk is not a single line");
+    }
+}
+
+int main()
+{
+    testDiff();
+    testFormatLargeFile();
+    return 0;
+}
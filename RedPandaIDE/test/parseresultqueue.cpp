@@ -0,0 +1,71 @@
+#include <cstdlib>
+#include <QDebug>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "debugger/parseresultqueue.h"
+
+static void fail(const QString& test, const QString& message)
+{
+    qDebug() << "Error in test" << test << ":" << message;
+    exit(1);
+}
+
+static QString join(const QList<int>& results)
+{
+    QStringList list;
+    foreach (int result, results)
+        list.append(QString::number(result));
+    return list.join(",");
+}
+
+static void testNotify()
+{
+    ParseResultQueue<int> queue;
+    if (!queue.post(1))
+        fail("notify", "first result is not notified");
+    // not taken yet, handled with the first one
+    if (queue.post(2))
+        fail("notify", "second result is notified again");
+    QList<int> results = queue.take();
+    if (join(results) != "1,2")
+        fail("notify", QString("took [%1], expected [1,2]").arg(join(results)));
+    if (!queue.take().isEmpty())
+        fail("notify", "results are taken twice");
+    if (!queue.post(3))
+        fail("notify", "result posted after take is not notified");
+    // the notified taker found nothing new, it is notified for the next one
+    queue.take();
+    queue.take();
+    if (!queue.post(4))
+        fail("notify", "result posted after an empty take is not notified");
+}
+
+static void testParkedClient()
+{
+    ParseResultQueue<int> queue;
+    // last result of the session, taken by the gui
+    if (!queue.post(1))
+        fail("parked client", "session result is not notified");
+    queue.take();
+    // replies to kill, -target-disconnect and watch removal come in
+    // while nobody listens to the parked client
+    queue.post(2);
+    queue.post(3);
+    queue.post(4);
+    // the client is taken back for the next session
+    queue.take();
+    if (!queue.post(5))
+        fail("parked client", "first result of the next session is not notified");
+    QList<int> results = queue.take();
+    if (join(results) != "5")
+        fail("parked client", QString("took [%1], expected [5]").arg(join(results)));
+}
+
+int main()
+{
+    testNotify();
+    testParkedClient();
+    return 0;
+}
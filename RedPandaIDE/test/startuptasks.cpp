@@ -0,0 +1,104 @@
+#include <atomic>
+#include <cstdlib>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+
+#include "startuptasks.h"
+
+static void fail(const QString& test, const QString& message)
+{
+    qDebug() << "Error in test" << test << ":" << message;
+    exit(1);
+}
+
+static void testDependencies()
+{
+    StartupTasks tasks;
+    QMutex mutex;
+    QStringList order;
+    auto record = [&mutex, &order](const QString& name) {
+        QMutexLocker locker(&mutex);
+        order.append(name);
+    };
+    // dependencies may be added after the tasks depending on them
+    tasks.addTask("c", [&record](){ record("c"); }, QStringList{"a", "b"});
+    tasks.addTask("a", [&record](){
+        QThread::msleep(50);
+        record("a");
+    });
+    tasks.addTask("b", [&record](){ record("b"); }, QStringList{"a"});
+    tasks.wait("c");
+    if (order != QStringList{"a", "b", "c"})
+        fail("dependencies", "wrong order: "+order.join(","));
+    // unknown tasks are not waited for
+    tasks.wait("unknown");
+}
+
+static void testConcurrency()
+{
+    if (QThread::idealThreadCount() < 2)
+        return;
+    StartupTasks tasks;
+    std::atomic<int> running{0};
+    std::atomic<int> maxRunning{0};
+    for (int i=0;i<2;i++) {
+        tasks.addTask(QString("task%1").arg(i), [&running, &maxRunning](){
+            int count = ++running;
+            if (count > maxRunning)
+                maxRunning = count;
+            QThread::msleep(100);
+            running--;
+        });
+    }
+    tasks.waitForAll();
+    if (maxRunning < 2)
+        fail("concurrency", "independent tasks are not run at the same time");
+}
+
+static void testFinishedCallback(QCoreApplication& app)
+{
+    StartupTasks tasks;
+    bool finished = false;
+    QThread* callbackThread = nullptr;
+    tasks.addTask("load", [](){}, QStringList(), [&finished, &callbackThread, &app](){
+        finished = true;
+        callbackThread = QThread::currentThread();
+        app.quit();
+    });
+    QTimer::singleShot(2000, &app, &QCoreApplication::quit);
+    app.exec();
+    if (!finished)
+        fail("callback", "onFinished is not called");
+    if (callbackThread != app.thread())
+        fail("callback", "onFinished is not called in the main thread");
+}
+
+static void testReport()
+{
+    StartupTasks tasks;
+    tasks.beginPhase("phase");
+    QThread::msleep(20);
+    tasks.endPhase();
+    tasks.addTask("task", [](){ QThread::msleep(10); });
+    tasks.waitForAll();
+    QStringList report = tasks.report();
+    if (report.count() != 2)
+        fail("report", QString("%1 lines, expected 2").arg(report.count()));
+    if (!report[0].startsWith("phase: ") || !report[1].startsWith("task (background): "))
+        fail("report", "wrong lines: "+report.join(" | "));
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    testDependencies();
+    testConcurrency();
+    testFinishedCallback(app);
+    testReport();
+    return 0;
+}
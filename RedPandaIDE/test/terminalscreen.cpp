@@ -0,0 +1,127 @@
+#include <cstdlib>
+#include <QByteArray>
+#include <QDebug>
+#include <QString>
+
+#include "widgets/terminalscreen.h"
+
+static void fail(const QString& test, const QString& message)
+{
+    qDebug() << "Error in test" << test << ":" << message;
+    exit(1);
+}
+
+static void expectLine(const QString& test, const TerminalScreen& screen, int index, const QString& expected)
+{
+    if (index >= screen.lineCount())
+        fail(test, QString("no line %1").arg(index));
+    QString text = screen.lineText(index);
+    if (text != expected)
+        fail(test, QString("line %1 is \"%2\", expected \"%3\"").arg(index).arg(text, expected));
+}
+
+static void testText()
+{
+    TerminalScreen screen(5, 10);
+    screen.feed("hello\r\nworld\r\n");
+    expectLine("text", screen, 0, "hello");
+    expectLine("text", screen, 1, "world");
+    if (screen.cursorLine() != 2 || screen.cursorColumn() != 0)
+        fail("text", "cursor not at the start of line 2");
+
+    // carriage return overwrites, backspace moves back
+    screen.feed("abcdef\rxy\b\bZ");
+    expectLine("text", screen, 2, "Zycdef");
+
+    // long lines are wrapped at the last column
+    screen.feed("\r\n0123456789abc");
+    expectLine("wrap", screen, 3, "0123456789");
+    expectLine("wrap", screen, 4, "abc");
+
+    // utf-8 split between feeds, wide characters take two columns
+    TerminalScreen utf8(5, 10);
+    QByteArray text = QString::fromUtf8("\xe4\xbd\xa0\xe5\xa5\xbd!").toUtf8();
+    utf8.feed(text.left(2));
+    utf8.feed(text.mid(2));
+    expectLine("utf8", utf8, 0, QString::fromUtf8("\xe4\xbd\xa0\xe5\xa5\xbd!"));
+    if (utf8.cursorColumn() != 5)
+        fail("utf8", QString("cursor at column %1, expected 5").arg(utf8.cursorColumn()));
+}
+
+static void testEscapes()
+{
+    TerminalScreen screen(3, 20);
+    screen.feed("line1\r\nline2\r\nline3");
+    // cursor home and erase in line
+    screen.feed("\x1b[2;3H\x1b[K");
+    expectLine("escapes", screen, 1, "li");
+    // erase in display
+    screen.feed("\x1b[2J");
+    for (int i=0;i<3;i++)
+        expectLine("escapes", screen, i, "");
+
+    // colors and attributes
+    screen.feed("\x1b[H\x1b[1;31mR\x1b[38;5;200mP\x1b[38;2;1;2;3mT\x1b[0mN");
+    const TerminalLine& line = screen.line(0);
+    if (line.count() != 4)
+        fail("sgr", QString("%1 cells, expected 4").arg(line.count()));
+    if (line[0].foreground != 1 || !(line[0].attributes & taBold))
+        fail("sgr", "R should be bold red");
+    if (line[1].foreground != 200)
+        fail("sgr", "P should use palette color 200");
+    if (line[2].foreground != (TERMINAL_RGB_COLOR | 0x010203))
+        fail("sgr", "T should use rgb color");
+    if (line[3].foreground != TERMINAL_DEFAULT_COLOR || line[3].attributes != 0)
+        fail("sgr", "N should use default style");
+
+    // title sequences are ignored
+    screen.feed("\x1b]0;title\x07!");
+    expectLine("osc", screen, 0, "RPTN!");
+}
+
+static void testScrollback()
+{
+    TerminalScreen screen(10, 80, 100);
+    for (int i=0;i<1000;i++)
+        screen.feed(QString("line %1\r\n").arg(i).toUtf8());
+    if (screen.lineCount() != 100)
+        fail("scrollback", QString("%1 lines kept, expected 100").arg(screen.lineCount()));
+    if (screen.firstLineNumber() != 901)
+        fail("scrollback", QString("first line %1, expected 901").arg(screen.firstLineNumber()));
+    expectLine("scrollback", screen, 98, "line 999");
+    TerminalDamage damage = screen.takeDamage();
+    if (damage.lastLine != 1000)
+        fail("scrollback", QString("last damaged line %1, expected 1000").arg(damage.lastLine));
+    damage = screen.takeDamage();
+    if (damage.firstLine >= 0 || damage.reset)
+        fail("scrollback", "damage is not cleared");
+}
+
+static void testChunkedOutput()
+{
+    // lines split across pty sized chunks
+    const int lineCount = 100000;
+    TerminalScreen screen(40, 120);
+    QByteArray chunk;
+    for (int i=0;i<lineCount;i++) {
+        chunk.append("output line ");
+        chunk.append(QByteArray::number(i));
+        chunk.append("\r\n");
+        if (chunk.length() >= 65536 || i == lineCount-1) {
+            screen.feed(chunk);
+            chunk.clear();
+        }
+    }
+    expectLine("chunked output", screen, screen.lineCount()-2, QString("output line %1").arg(lineCount-1));
+    if (screen.firstLineNumber() + screen.lineCount() != lineCount + 1)
+        fail("chunked output", "lines are lost");
+}
+
+int main()
+{
+    testText();
+    testEscapes();
+    testScrollback();
+    testChunkedOutput();
+    return 0;
+}
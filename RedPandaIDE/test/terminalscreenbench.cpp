@@ -0,0 +1,43 @@
+#include <cstdlib>
+#include <QByteArray>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QString>
+
+#include "widgets/terminalscreen.h"
+
+static void fail(const QString& test, const QString& message)
+{
+    qDebug() << "Error in test" << test << ":" << message;
+    exit(1);
+}
+
+static void benchThroughput()
+{
+    // 1e7 lines, fed in pty sized chunks
+    const int lineCount = 10000000;
+    TerminalScreen screen(40, 120);
+    QByteArray chunk;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i=0;i<lineCount;i++) {
+        chunk.append("output line ");
+        chunk.append(QByteArray::number(i));
+        chunk.append("\r\n");
+        if (chunk.length() >= 65536 || i == lineCount-1) {
+            screen.feed(chunk);
+            chunk.clear();
+        }
+    }
+    qint64 elapsed = timer.elapsed();
+    if (screen.lineText(screen.lineCount()-2) != QString("output line %1").arg(lineCount-1)
+            || screen.firstLineNumber() + screen.lineCount() != lineCount + 1)
+        fail("throughput", "lines are lost");
+    qDebug() << lineCount << "lines parsed in" << elapsed << "ms";
+}
+
+int main()
+{
+    benchThroughput();
+    return 0;
+}
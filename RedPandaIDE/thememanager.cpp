@@ -16,6 +16,7 @@
  */
 #include "thememanager.h"
 #include <QApplication>
+#include <QDateTime>
 #include <QDirIterator>
 #include <QFile>
 #include <QJsonArray>
@@ -33,6 +34,29 @@
 #include "addon/runtime.h"
 #endif
 
+struct CachedTheme {
+    QDateTime lastModified;
+    QString language;
+    PAppTheme theme;
+};
+
+// lua themes are scripts, so each one is run only once until it's changed
+static QHash<QString, CachedTheme> themeCache;
+
+static PAppTheme loadTheme(const QString& filename, AppTheme::ThemeType type)
+{
+    QFileInfo fileInfo(filename);
+    QString language = pSettings->environment().language();
+    auto it = themeCache.constFind(filename);
+    if (it != themeCache.constEnd()
+            && it->lastModified == fileInfo.lastModified()
+            && it->language == language)
+        return it->theme;
+    PAppTheme appTheme = std::make_shared<AppTheme>(filename, type);
+    themeCache.insert(filename, CachedTheme{fileInfo.lastModified(), language, appTheme});
+    return appTheme;
+}
+
 ThemeManager::ThemeManager(QObject *parent) : QObject(parent),
     mUseCustomTheme(false)
 {
@@ -50,9 +74,9 @@ PAppTheme ThemeManager::theme(const QString &themeName)
         themeDir = pSettings->dirs().data(Settings::Dirs::DataType::Theme);
     }
 #ifdef ENABLE_LUA_ADDON
-    PAppTheme appTheme = std::make_shared<AppTheme>(QString("%1/%2.lua").arg(themeDir, themeName), AppTheme::ThemeType::Lua);
+    PAppTheme appTheme = loadTheme(QString("%1/%2.lua").arg(themeDir, themeName), AppTheme::ThemeType::Lua);
 #else
-    PAppTheme appTheme = std::make_shared<AppTheme>(QString("%1/%2.json").arg(themeDir, themeName), AppTheme::ThemeType::JSON);
+    PAppTheme appTheme = loadTheme(QString("%1/%2.json").arg(themeDir, themeName), AppTheme::ThemeType::JSON);
 #endif
     return appTheme;
 }
@@ -104,7 +128,7 @@ QList<PAppTheme> ThemeManager::getThemes()
         QFileInfo fileInfo = it.fileInfo();
         if (fileInfo.suffix().compare(themeExtension, PATH_SENSITIVITY)==0) {
             try {
-                PAppTheme appTheme = std::make_shared<AppTheme>(fileInfo.absoluteFilePath(), themeType);
+                PAppTheme appTheme = loadTheme(fileInfo.absoluteFilePath(), themeType);
                 result.append(appTheme);
             } catch(FileError e) {
                 //just skip it
@@ -61,7 +61,7 @@ void TodoParser::parseFile(const QString &filename,bool isForProject)
     mThread->start();
 }
 
-void TodoParser::parseFiles(const QStringList &files)
+void TodoParser::parseFiles(const QStringList &files, bool clearTodos)
 {
     QMutexLocker locker(&mMutex);
     if (mThread) {
@@ -76,8 +76,10 @@ void TodoParser::parseFiles(const QStringList &files)
             mThread = nullptr;
         }
     });
-    connect(mThread, &TodoThread::parseStarted,
-            pMainWindow, &MainWindow::onTodoParseStarted);
+    if (clearTodos) {
+        connect(mThread, &TodoThread::parseStarted,
+                pMainWindow, &MainWindow::onTodoParseStarted);
+    }
     connect(mThread, &TodoThread::parsingFile,
             pMainWindow, &MainWindow::onTodoParsingFile);
     connect(mThread, &TodoThread::todoFound,
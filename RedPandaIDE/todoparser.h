@@ -95,7 +95,8 @@ class TodoParser : public QObject
 public:
     explicit TodoParser(QObject *parent = nullptr);
     void parseFile(const QString& filename,bool isForProject);
-    void parseFiles(const QStringList& files);
+    // if clearTodos is false, only the todos in the files are replaced
+    void parseFiles(const QStringList& files, bool clearTodos = true);
     bool parsing() const;
 
 private:
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "linediff.h"
+
+#include <QHash>
+#include <algorithm>
+
+void diffLineIds(const QVector<int> &baseIds, int baseStart, int baseEnd,
+                 const QVector<int> &ids, int start, int end,
+                 QVector<LineDiffHunk> &hunks, int maxEditDistance)
+{
+    while (baseStart < baseEnd && start < end && baseIds[baseStart] == ids[start]) {
+        baseStart++;
+        start++;
+    }
+    while (baseStart < baseEnd && start < end && baseIds[baseEnd-1] == ids[end-1]) {
+        baseEnd--;
+        end--;
+    }
+    int n = baseEnd - baseStart;
+    int m = end - start;
+    if (n == 0 && m == 0)
+        return;
+    if (n == 0 || m == 0) {
+        hunks.append(LineDiffHunk{baseStart, n, start, m});
+        return;
+    }
+    // Myers' O(ND) algorithm. x walks the base, y walks the current lines,
+    // and v[k] is the furthest x reached on diagonal k = x - y.
+    const int* a = baseIds.constData() + baseStart;
+    const int* b = ids.constData() + start;
+    int maxD = std::min(n + m, maxEditDistance);
+    int offset = maxD + 1;
+    QVector<int> v(2 * maxD + 3, 0);
+    // trace[d] holds v[-d..d] after step d, for the backtracking
+    QVector<QVector<int>> trace;
+    int found = -1;
+    for (int d=0; d<=maxD && found<0; d++) {
+        for (int k=-d; k<=d; k+=2) {
+            int x;
+            if (k == -d || (k != d && v[offset+k-1] < v[offset+k+1]))
+                x = v[offset+k+1];
+            else
+                x = v[offset+k-1] + 1;
+            int y = x - k;
+            while (x < n && y < m && a[x] == b[y]) {
+                x++;
+                y++;
+            }
+            v[offset+k] = x;
+            if (x >= n && y >= m) {
+                found = d;
+                break;
+            }
+        }
+        trace.append(v.mid(offset-d, 2*d+1));
+    }
+    if (found < 0) {
+        hunks.append(LineDiffHunk{baseStart, n, start, m});
+        return;
+    }
+    // walk back to collect the snakes (runs of matched lines)
+    struct Snake {
+        int x, y, endX, endY;
+    };
+    QVector<Snake> snakes;
+    int x = n;
+    int y = m;
+    for (int d=found; d>0; d--) {
+        const QVector<int>& prev = trace[d-1];
+        auto prevV = [&prev, d](int k) {
+            return prev[k + d - 1];
+        };
+        int k = x - y;
+        bool down = (k == -d || (k != d && prevV(k-1) < prevV(k+1)));
+        int prevK = down ? k+1 : k-1;
+        int prevX = prevV(prevK);
+        int prevY = prevX - prevK;
+        int snakeX = down ? prevX : prevX + 1;
+        int snakeY = snakeX - k;
+        snakes.append(Snake{snakeX, snakeY, x, y});
+        x = prevX;
+        y = prevY;
+    }
+    snakes.append(Snake{0, 0, x, y});
+    int px = 0;
+    int py = 0;
+    for (int i=snakes.count()-1;i>=0;i--) {
+        const Snake& snake = snakes[i];
+        if (snake.x == snake.endX)
+            continue;
+        if (snake.x > px || snake.y > py)
+            hunks.append(LineDiffHunk{baseStart+px, snake.x-px, start+py, snake.y-py});
+        px = snake.endX;
+        py = snake.endY;
+    }
+    if (px < n || py < m)
+        hunks.append(LineDiffHunk{baseStart+px, n-px, start+py, m-py});
+}
+
+QVector<LineDiffHunk> diffLines(const QStringList &baseLines, const QStringList &lines, int maxEditDistance)
+{
+    QHash<QString,int> lineIds;
+    auto lineId = [&lineIds](const QString& text) {
+        auto it = lineIds.find(text);
+        if (it == lineIds.end())
+            it = lineIds.insert(text, lineIds.count());
+        return it.value();
+    };
+    QVector<int> baseIds;
+    baseIds.reserve(baseLines.count());
+    foreach (const QString& line, baseLines)
+        baseIds.append(lineId(line));
+    QVector<int> ids;
+    ids.reserve(lines.count());
+    foreach (const QString& line, lines)
+        ids.append(lineId(line));
+    QVector<LineDiffHunk> hunks;
+    diffLineIds(baseIds, 0, baseIds.count(), ids, 0, ids.count(), hunks, maxEditDistance);
+    return hunks;
+}
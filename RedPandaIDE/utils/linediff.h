@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LINEDIFF_H
+#define LINEDIFF_H
+
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief A run of lines [start, start+count) replacing [baseStart, baseStart+baseCount)
+ * of the base. All line numbers are 0-based.
+ */
+struct LineDiffHunk {
+    int baseStart;
+    int baseCount;
+    int start;
+    int count;
+};
+
+// Beyond this many edits, the rest of the diffed range is reported as one hunk.
+// It bounds both the time and the memory (O(D^2)) used by the diff.
+const int DefaultMaxLineEditDistance = 1000;
+
+/**
+ * @brief Diffs lines (as integer ids) with the Myers O(ND) algorithm.
+ *
+ * Compares baseIds[baseStart, baseEnd) with ids[start, end), and appends the
+ * hunks in order.
+ */
+void diffLineIds(const QVector<int>& baseIds, int baseStart, int baseEnd,
+                 const QVector<int>& ids, int start, int end,
+                 QVector<LineDiffHunk>& hunks,
+                 int maxEditDistance = DefaultMaxLineEditDistance);
+
+QVector<LineDiffHunk> diffLines(const QStringList& baseLines, const QStringList& lines,
+                                int maxEditDistance = DefaultMaxLineEditDistance);
+
+#endif // LINEDIFF_H
@@ -6,6 +6,7 @@
 
 #include <QDir>
 #include <QFileInfo>
+#include <QProcess>
 
 GitManager::GitManager(QObject *parent) : QObject(parent)
 {
@@ -76,6 +77,26 @@ bool GitManager::isFileInRepository(const QFileInfo& fileInfo)
     return output.trimmed() == fileInfo.fileName();
 }
 
+QProcess *GitManager::startFileIndexContent(const QFileInfo &fileInfo, QObject *parent)
+{
+    if (!isValid())
+        return nullptr;
+    QFileInfo gitInfo(pSettings->vcs().gitPath());
+    if (!gitInfo.exists())
+        return nullptr;
+    // The raw blob is needed here, so the process is run directly instead of
+    // runGit(), which merges stderr into the output and escapes it.
+    QProcess* process = new QProcess(parent);
+    process->setProcessEnvironment(gitEnvironment());
+    process->setWorkingDirectory(fileInfo.absolutePath());
+    QStringList args;
+    args.append("cat-file");
+    args.append("blob");
+    args.append(":./"+fileInfo.fileName());
+    process->start(gitInfo.absoluteFilePath(),args);
+    return process;
+}
+
 bool GitManager::isFileStaged(const QFileInfo &fileInfo)
 {
     QStringList args;
@@ -589,23 +610,13 @@ QString GitManager::runGit(const QString& workingFolder, const QStringList &args
                             args.join("\" \"")));
 //    qDebug()<<"---------";
 //    qDebug()<<args;
-    QProcessEnvironment env;
-#ifdef Q_OS_WIN
-    env.insert("PATH",pSettings->dirs().appDir());
-    env.insert("GIT_ASKPASS",includeTrailingPathDelimiter(pSettings->dirs().appDir())+"redpanda-win-git-askpass.exe");
-#else // Unix
-    env.insert(QProcessEnvironment::systemEnvironment());
-    env.insert("LANG","en");
-    env.insert("LANGUAGE","en");
-    env.insert("GIT_ASKPASS",includeTrailingPathDelimiter(pSettings->dirs().appLibexecDir())+"redpanda-git-askpass");
-#endif
     QString output = runAndGetOutput(
                 fileInfo.absoluteFilePath(),
                 workingFolder,
                 args,
                 "",
                 false,
-                env);
+                gitEnvironment());
     output = escapeUTF8String(output.toUtf8());
 //    qDebug()<<output;
     emit gitCmdFinished(output);
@@ -614,6 +625,21 @@ QString GitManager::runGit(const QString& workingFolder, const QStringList &args
     return output;
 }
 
+QProcessEnvironment GitManager::gitEnvironment()
+{
+    QProcessEnvironment env;
+#ifdef Q_OS_WIN
+    env.insert("PATH",pSettings->dirs().appDir());
+    env.insert("GIT_ASKPASS",includeTrailingPathDelimiter(pSettings->dirs().appDir())+"redpanda-win-git-askpass.exe");
+#else // Unix
+    env.insert(QProcessEnvironment::systemEnvironment());
+    env.insert("LANG","en");
+    env.insert("LANGUAGE","en");
+    env.insert("GIT_ASKPASS",includeTrailingPathDelimiter(pSettings->dirs().appLibexecDir())+"redpanda-git-askpass");
+#endif
+    return env;
+}
+
 QString GitManager::escapeUTF8String(const QByteArray &rawString)
 {
     QByteArray stringValue;
@@ -3,10 +3,13 @@
 
 #include <QObject>
 #include <QFileInfo>
+#include <QProcessEnvironment>
 #include <QSet>
 #include "utils.h"
 #include "gitutils.h"
 
+class QProcess;
+
 class GitError: public BaseError {
 public:
     explicit GitError(const QString& reason);
@@ -27,6 +30,9 @@ public:
     bool isFileInRepository(const QFileInfo& fileInfo);
     bool isFileStaged(const QFileInfo& fileInfo);
     bool isFileChanged(const QFileInfo& fileInfo);
+    // starts "git cat-file" for the file's content in the index,
+    // the content is the standard output of the returned process
+    QProcess* startFileIndexContent(const QFileInfo& fileInfo, QObject* parent);
 
     bool add(const QString& folder, const QString& path, QString& output);
     bool remove(const QString& folder, const QString& path, QString& output);
@@ -100,6 +106,7 @@ signals:
     void gitCmdFinished(const QString& message);
 private:
     QString runGit(const QString& workingFolder, const QStringList& args);
+    QProcessEnvironment gitEnvironment();
 
     QString escapeUTF8String(const QByteArray& rawString);
 private:
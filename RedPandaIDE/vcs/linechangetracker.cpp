@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "linechangetracker.h"
+
+#include <algorithm>
+
+LineChangeTracker::LineChangeTracker():
+    mActive{false},
+    mDirtyStart{-1},
+    mDirtyEnd{-1}
+{
+
+}
+
+void LineChangeTracker::setBase(const QStringList &baseLines, const QStringList &currentLines)
+{
+    clear();
+    mBaseIds.reserve(baseLines.count());
+    foreach (const QString& line, baseLines)
+        mBaseIds.append(lineId(line));
+    mIds.reserve(currentLines.count());
+    foreach (const QString& line, currentLines)
+        mIds.append(lineId(line));
+    diff(0, mBaseIds.count(), 0, mIds.count(), mHunks);
+    mActive = true;
+}
+
+void LineChangeTracker::clear()
+{
+    mActive = false;
+    mLineIds.clear();
+    mBaseIds.clear();
+    mIds.clear();
+    mHunks.clear();
+    mDirtyStart = -1;
+    mDirtyEnd = -1;
+}
+
+bool LineChangeTracker::isActive() const
+{
+    return mActive;
+}
+
+void LineChangeTracker::linesInserted(int line, const QStringList &texts)
+{
+    if (!mActive)
+        return;
+    int count = texts.count();
+    QVector<int> ids;
+    ids.reserve(count);
+    foreach (const QString& text, texts)
+        ids.append(lineId(text));
+    mIds.insert(line, count, 0);
+    std::copy(ids.begin(), ids.end(), mIds.begin()+line);
+    for (Hunk& hunk:mHunks) {
+        if (hunk.start >= line)
+            hunk.start += count;
+        else if (hunk.start + hunk.count > line)
+            hunk.count += count;
+    }
+    if (mDirtyStart>=0) {
+        if (mDirtyStart >= line)
+            mDirtyStart += count;
+        if (mDirtyEnd > line)
+            mDirtyEnd += count;
+    }
+    markDirty(line, line+count);
+}
+
+void LineChangeTracker::linesDeleted(int line, int count)
+{
+    if (!mActive)
+        return;
+    int end = line + count;
+    mIds.remove(line, count);
+    auto adjust = [line, end, count](int pos) {
+        if (pos <= line)
+            return pos;
+        if (pos >= end)
+            return pos - count;
+        return line;
+    };
+    for (Hunk& hunk:mHunks) {
+        int start = adjust(hunk.start);
+        hunk.count = adjust(hunk.start + hunk.count) - start;
+        hunk.start = start;
+    }
+    if (mDirtyStart>=0) {
+        mDirtyStart = adjust(mDirtyStart);
+        mDirtyEnd = adjust(mDirtyEnd);
+    }
+    markDirty(line, line);
+}
+
+void LineChangeTracker::lineChanged(int line, const QString &text)
+{
+    if (!mActive)
+        return;
+    mIds[line] = lineId(text);
+    markDirty(line, line+1);
+}
+
+LineChangeType LineChangeTracker::lineChange(int line)
+{
+    if (!mActive)
+        return LineChangeType::Unchanged;
+    resolve();
+    auto it = std::upper_bound(mHunks.begin(), mHunks.end(), line,
+                               [](int line, const Hunk& hunk) {
+        return line < hunk.start;
+    });
+    int i = it - mHunks.begin() - 1;
+    if (i>=0 && line < mHunks[i].start + mHunks[i].count)
+        return (mHunks[i].baseCount == 0)?LineChangeType::Added:LineChangeType::Modified;
+    for (;i>=0 && mHunks[i].start == line;i--) {
+        if (mHunks[i].count == 0)
+            return LineChangeType::Deleted;
+    }
+    // lines deleted at the end of file are shown on the last line
+    if (line == mIds.count()-1 && !mHunks.isEmpty()
+            && mHunks.last().count == 0 && mHunks.last().start == mIds.count())
+        return LineChangeType::Deleted;
+    return LineChangeType::Unchanged;
+}
+
+int LineChangeTracker::lineId(const QString &text)
+{
+    auto it = mLineIds.find(text);
+    if (it == mLineIds.end())
+        it = mLineIds.insert(text, mLineIds.count());
+    return it.value();
+}
+
+void LineChangeTracker::compactLineIds()
+{
+    QVector<bool> used(mLineIds.count(), false);
+    for (int id:mBaseIds)
+        used[id] = true;
+    for (int id:mIds)
+        used[id] = true;
+    QVector<int> newIds(mLineIds.count(), -1);
+    QHash<QString,int> lineIds;
+    for (auto it = mLineIds.cbegin(); it != mLineIds.cend(); ++it) {
+        if (!used[it.value()])
+            continue;
+        newIds[it.value()] = lineIds.count();
+        lineIds.insert(it.key(), lineIds.count());
+    }
+    for (int& id:mBaseIds)
+        id = newIds[id];
+    for (int& id:mIds)
+        id = newIds[id];
+    mLineIds.swap(lineIds);
+}
+
+void LineChangeTracker::markDirty(int start, int end)
+{
+    if (mDirtyStart<0) {
+        mDirtyStart = start;
+        mDirtyEnd = end;
+    } else {
+        mDirtyStart = std::min(mDirtyStart, start);
+        mDirtyEnd = std::max(mDirtyEnd, end);
+    }
+}
+
+void LineChangeTracker::resolve()
+{
+    if (mDirtyStart<0)
+        return;
+    if (mLineIds.count() > 2 * (mBaseIds.count() + mIds.count()) + 1024)
+        compactLineIds();
+    // Lines out of the window are not edited, so they still match the base
+    // as the hunks say. Only the window is diffed again.
+    int start = mDirtyStart;
+    int end = mDirtyEnd;
+    mDirtyStart = -1;
+    mDirtyEnd = -1;
+    int first = 0;
+    int delta = 0;
+    while (first < mHunks.count() && mHunks[first].start + mHunks[first].count < start) {
+        delta += mHunks[first].count - mHunks[first].baseCount;
+        first++;
+    }
+    int last = first;
+    while (last < mHunks.count() && mHunks[last].start <= end) {
+        start = std::min(start, mHunks[last].start);
+        end = std::max(end, mHunks[last].start + mHunks[last].count);
+        last++;
+    }
+    int tailDelta = 0;
+    for (int i=last;i<mHunks.count();i++)
+        tailDelta += mHunks[i].count - mHunks[i].baseCount;
+    int baseStart = start - delta;
+    int baseEnd = mBaseIds.count() - ((mIds.count() - end) - tailDelta);
+    QVector<Hunk> hunks;
+    diff(baseStart, baseEnd, start, end, hunks);
+    mHunks.remove(first, last-first);
+    for (int i=0;i<hunks.count();i++)
+        mHunks.insert(first+i, hunks[i]);
+}
+
+void LineChangeTracker::diff(int baseStart, int baseEnd, int start, int end, QVector<Hunk> &hunks) const
+{
+    diffLineIds(mBaseIds, baseStart, baseEnd, mIds, start, end, hunks);
+}
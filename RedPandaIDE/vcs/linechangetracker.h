@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LINECHANGETRACKER_H
+#define LINECHANGETRACKER_H
+
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include "../utils/linediff.h"
+
+enum class LineChangeType {
+    Unchanged,
+    Added,
+    Modified,
+    Deleted // lines are deleted right before this line
+};
+
+/**
+ * @brief Tracks the changed lines of a document against a base version (the git index).
+ *
+ * Lines are hashed into integer ids and compared with the Myers diff algorithm
+ * (diffLineIds()).
+ * The result is kept as a list of hunks; after an edit only the hunks around
+ * the edited lines are diffed again.
+ * All line numbers are 0-based.
+ */
+class LineChangeTracker
+{
+public:
+    LineChangeTracker();
+    void setBase(const QStringList& baseLines, const QStringList& currentLines);
+    void clear();
+    bool isActive() const;
+
+    void linesInserted(int line, const QStringList& texts);
+    void linesDeleted(int line, int count);
+    void lineChanged(int line, const QString& text);
+
+    LineChangeType lineChange(int line);
+private:
+    using Hunk = LineDiffHunk;
+    int lineId(const QString& text);
+    void compactLineIds();
+    void markDirty(int start, int end);
+    void resolve();
+    void diff(int baseStart, int baseEnd, int start, int end, QVector<Hunk>& hunks) const;
+private:
+    bool mActive;
+    // every edit of a line adds an id, ids not used any more are
+    // dropped by compactLineIds()
+    QHash<QString,int> mLineIds;
+    QVector<int> mBaseIds;
+    QVector<int> mIds;
+    QVector<Hunk> mHunks;
+    // lines edited since the last diff, [mDirtyStart, mDirtyEnd)
+    int mDirtyStart;
+    int mDirtyEnd;
+};
+
+#endif // LINECHANGETRACKER_H
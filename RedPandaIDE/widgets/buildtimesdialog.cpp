@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "buildtimesdialog.h"
+#include "ui_buildtimesdialog.h"
+
+#include <QFont>
+#include <QHeaderView>
+#include <QPainter>
+#include <QSortFilterProxyModel>
+#include <cstdlib>
+#include "../utils.h"
+
+// a step is reported as slower or faster when it changes more than this
+static const double ChangeThreshold = 0.2;
+static const qint64 MinChangedTime = 100;
+
+static QString formatSeconds(qint64 time)
+{
+    return QString::number(time / 1000.0, 'f', 2);
+}
+
+BuildStepsModel::BuildStepsModel(QObject *parent):
+    QAbstractTableModel{parent}
+{
+
+}
+
+void BuildStepsModel::setRecord(const PBuildRecord &record, const QList<qint64> &previousDurations,
+                                const QString &directory)
+{
+    beginResetModel();
+    mRecord = record;
+    mPreviousDurations = previousDurations;
+    mDirectory = directory;
+    endResetModel();
+}
+
+int BuildStepsModel::rowCount(const QModelIndex &) const
+{
+    return mRecord ? mRecord->steps.count() : 0;
+}
+
+int BuildStepsModel::columnCount(const QModelIndex &) const
+{
+    return ColumnCount;
+}
+
+QVariant BuildStepsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || !mRecord || index.row() >= mRecord->steps.count())
+        return QVariant();
+    const BuildStep& step = mRecord->steps[index.row()];
+    qint64 previous = mPreviousDurations.value(index.row(), -1);
+    qint64 change = (previous >= 0) ? step.duration() - previous : 0;
+    if (role == CriticalRole)
+        return step.critical;
+    if (role == Qt::FontRole && step.critical) {
+        QFont font;
+        font.setBold(true);
+        return font;
+    }
+    switch (index.column()) {
+    case FileColumn:
+        if (role == Qt::DisplayRole || role == Qt::UserRole) {
+            QString fileName = step.link ? step.outputFile : step.sourceFile;
+            if (fileName.isEmpty())
+                fileName = step.outputFile;
+            fileName = extractRelativePath(mDirectory, fileName);
+            if (step.link)
+                return tr("%1 (link)").arg(fileName);
+            return fileName;
+        } else if (role == Qt::ToolTipRole && step.critical) {
+            return tr("On the critical path of the build");
+        }
+        break;
+    case StartColumn:
+        if (role == Qt::DisplayRole)
+            return formatSeconds(step.startTime);
+        if (role == Qt::UserRole)
+            return step.startTime;
+        break;
+    case DurationColumn:
+        if (role == Qt::DisplayRole)
+            return formatSeconds(step.duration());
+        if (role == Qt::UserRole)
+            return step.duration();
+        break;
+    case ChangeColumn:
+        if (role == Qt::DisplayRole) {
+            if (previous < 0)
+                return "-";
+            return (change > 0 ? "+" : "") + formatSeconds(change);
+        }
+        if (role == Qt::UserRole)
+            return change;
+        if (role == Qt::ForegroundRole && previous >= 0 && std::abs(change) >= MinChangedTime
+                && std::abs(change) > previous * ChangeThreshold)
+            return QColor(change > 0 ? Qt::red : Qt::darkGreen);
+        break;
+    case TimelineColumn:
+        if (role == TimelineRole && mRecord->wallTime > 0)
+            return QPointF(double(step.startTime) / mRecord->wallTime,
+                           double(step.endTime) / mRecord->wallTime);
+        if (role == Qt::UserRole)
+            return step.startTime;
+        break;
+    }
+    return QVariant();
+}
+
+QVariant BuildStepsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QVariant();
+    switch (section) {
+    case FileColumn:
+        return tr("File");
+    case StartColumn:
+        return tr("Start (secs)");
+    case DurationColumn:
+        return tr("Time (secs)");
+    case ChangeColumn:
+        return tr("Change (secs)");
+    case TimelineColumn:
+        return tr("Timeline");
+    }
+    return QVariant();
+}
+
+HeaderCostsModel::HeaderCostsModel(QObject *parent):
+    QAbstractTableModel{parent}
+{
+
+}
+
+void HeaderCostsModel::setRecord(const PBuildRecord &record)
+{
+    beginResetModel();
+    mRecord = record;
+    endResetModel();
+}
+
+int HeaderCostsModel::rowCount(const QModelIndex &) const
+{
+    return mRecord ? mRecord->headers.count() : 0;
+}
+
+int HeaderCostsModel::columnCount(const QModelIndex &) const
+{
+    return 3;
+}
+
+QVariant HeaderCostsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || !mRecord || index.row() >= mRecord->headers.count())
+        return QVariant();
+    const HeaderCost& cost = mRecord->headers[index.row()];
+    if (role != Qt::DisplayRole && role != Qt::UserRole)
+        return QVariant();
+    switch (index.column()) {
+    case 0:
+        return cost.fileName;
+    case 1:
+        if (role == Qt::UserRole)
+            return cost.time;
+        return formatSeconds(cost.time);
+    case 2:
+        return cost.count;
+    }
+    return QVariant();
+}
+
+QVariant HeaderCostsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QVariant();
+    switch (section) {
+    case 0:
+        return tr("Header");
+    case 1:
+        return tr("Total Time (secs)");
+    case 2:
+        return tr("Included By");
+    }
+    return QVariant();
+}
+
+BuildHistoryModel::BuildHistoryModel(QObject *parent):
+    QAbstractTableModel{parent}
+{
+
+}
+
+void BuildHistoryModel::setRecords(const QList<PBuildRecord> &records)
+{
+    beginResetModel();
+    mRecords = records;
+    endResetModel();
+}
+
+int BuildHistoryModel::rowCount(const QModelIndex &) const
+{
+    return mRecords.count();
+}
+
+int BuildHistoryModel::columnCount(const QModelIndex &) const
+{
+    return 4;
+}
+
+QVariant BuildHistoryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= mRecords.count())
+        return QVariant();
+    if (role != Qt::DisplayRole && role != Qt::UserRole)
+        return QVariant();
+    // newest first
+    const PBuildRecord& record = mRecords[mRecords.count() - 1 - index.row()];
+    switch (index.column()) {
+    case 0:
+        if (role == Qt::UserRole)
+            return record->time;
+        return record->time.toString(Qt::SystemLocaleShortDate);
+    case 1:
+        if (role == Qt::UserRole)
+            return record->wallTime;
+        return formatSeconds(record->wallTime);
+    case 2:
+        return record->steps.count();
+    case 3: {
+        qint64 critical = 0;
+        foreach (const BuildStep& step, record->steps) {
+            if (step.critical)
+                critical += step.duration();
+        }
+        if (role == Qt::UserRole)
+            return critical;
+        return formatSeconds(critical);
+    }
+    }
+    return QVariant();
+}
+
+QVariant BuildHistoryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QVariant();
+    switch (section) {
+    case 0:
+        return tr("Build Time");
+    case 1:
+        return tr("Wall Time (secs)");
+    case 2:
+        return tr("Steps");
+    case 3:
+        return tr("Critical Path (secs)");
+    }
+    return QVariant();
+}
+
+BuildTimelineDelegate::BuildTimelineDelegate(QObject *parent):
+    QStyledItemDelegate{parent}
+{
+
+}
+
+void BuildTimelineDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    QStyledItemDelegate::paint(painter, option, index);
+    QPointF range = index.data(BuildStepsModel::TimelineRole).toPointF();
+    QRect rect = option.rect.adjusted(2, 3, -2, -3);
+    int left = rect.left() + qRound(range.x() * rect.width());
+    int width = std::max(2, qRound((range.y() - range.x()) * rect.width()));
+    bool critical = index.data(BuildStepsModel::CriticalRole).toBool();
+    painter->fillRect(QRect(left, rect.top(), width, rect.height()),
+                      critical ? QColor(Qt::red) : option.palette.color(QPalette::Highlight));
+}
+
+BuildTimesDialog::BuildTimesDialog(const QString &historyFile, const QString &directory, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::BuildTimesDialog),
+    mHistory(historyFile),
+    mDirectory(directory)
+{
+    ui->setupUi(this);
+    setWindowFlag(Qt::WindowContextHelpButtonHint,false);
+    auto setModel = [this](QTableView* view, QAbstractItemModel* model) {
+        QSortFilterProxyModel* proxy = new QSortFilterProxyModel(this);
+        proxy->setSourceModel(model);
+        proxy->setSortRole(Qt::UserRole);
+        view->setModel(proxy);
+        view->setSortingEnabled(true);
+    };
+    setModel(ui->tblSteps, &mStepsModel);
+    setModel(ui->tblHeaders, &mHeadersModel);
+    setModel(ui->tblHistory, &mHistoryModel);
+    ui->tblSteps->setItemDelegateForColumn(BuildStepsModel::TimelineColumn, new BuildTimelineDelegate(this));
+    ui->tblSteps->sortByColumn(BuildStepsModel::DurationColumn, Qt::DescendingOrder);
+    ui->tblHeaders->sortByColumn(1, Qt::DescendingOrder);
+    ui->tblSteps->horizontalHeader()->setSectionResizeMode(BuildStepsModel::FileColumn, QHeaderView::ResizeToContents);
+    ui->tblSteps->horizontalHeader()->setSectionResizeMode(BuildStepsModel::TimelineColumn, QHeaderView::Stretch);
+    ui->tblHeaders->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+    mHistory.load();
+    mHistoryModel.setRecords(mHistory.records());
+    const QList<PBuildRecord>& records = mHistory.records();
+    for (int i=records.count()-1;i>=0;i--) {
+        ui->cbBuilds->addItem(tr("%1 (%2 secs)")
+                              .arg(records[i]->time.toString(Qt::SystemLocaleShortDate),
+                                   formatSeconds(records[i]->wallTime)));
+    }
+    if (records.isEmpty())
+        ui->lblSummary->setText(tr("No build is recorded. Compile the project to record the build times."));
+}
+
+BuildTimesDialog::~BuildTimesDialog()
+{
+    delete ui;
+}
+
+void BuildTimesDialog::on_cbBuilds_currentIndexChanged(int index)
+{
+    const QList<PBuildRecord>& records = mHistory.records();
+    int recordIndex = records.count() - 1 - index;
+    if (recordIndex < 0 || recordIndex >= records.count()) {
+        mStepsModel.setRecord(PBuildRecord(), QList<qint64>(), mDirectory);
+        mHeadersModel.setRecord(PBuildRecord());
+        return;
+    }
+    const PBuildRecord& record = records[recordIndex];
+    QList<qint64> previousDurations;
+    qint64 totalTime = 0;
+    qint64 criticalTime = 0;
+    foreach (const BuildStep& step, record->steps) {
+        previousDurations.append(mHistory.previousDuration(recordIndex, step));
+        totalTime += step.duration();
+        if (step.critical)
+            criticalTime += step.duration();
+    }
+    mStepsModel.setRecord(record, previousDurations, mDirectory);
+    mHeadersModel.setRecord(record);
+    ui->lblSummary->setText(
+                tr("Wall time: %1 secs, sum of steps: %2 secs, critical path: %3 secs.")
+                .arg(formatSeconds(record->wallTime),
+                     formatSeconds(totalTime),
+                     formatSeconds(criticalTime)));
+    ui->tabHeaders->setEnabled(!record->headers.isEmpty());
+}
+
+void BuildTimesDialog::on_tblHistory_doubleClicked(const QModelIndex &index)
+{
+    if (!index.isValid())
+        return;
+    QSortFilterProxyModel* proxy = static_cast<QSortFilterProxyModel*>(ui->tblHistory->model());
+    ui->cbBuilds->setCurrentIndex(proxy->mapToSource(index).row());
+    ui->tabWidget->setCurrentWidget(ui->tabSteps);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BUILDTIMESDIALOG_H
+#define BUILDTIMESDIALOG_H
+
+#include <QAbstractTableModel>
+#include <QDialog>
+#include <QStyledItemDelegate>
+#include "../compiler/buildtimes.h"
+
+namespace Ui {
+class BuildTimesDialog;
+}
+
+class BuildStepsModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    enum Column {
+        FileColumn,
+        StartColumn,
+        DurationColumn,
+        ChangeColumn,
+        TimelineColumn,
+        ColumnCount
+    };
+    // (start, end) of the step as fractions of the build time
+    static const int TimelineRole = Qt::UserRole + 1;
+    static const int CriticalRole = Qt::UserRole + 2;
+
+    explicit BuildStepsModel(QObject* parent = nullptr);
+    void setRecord(const PBuildRecord& record, const QList<qint64>& previousDurations,
+                   const QString& directory);
+    int rowCount(const QModelIndex &parent) const override;
+    int columnCount(const QModelIndex &parent) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+private:
+    PBuildRecord mRecord;
+    QList<qint64> mPreviousDurations;
+    QString mDirectory;
+};
+
+class HeaderCostsModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    explicit HeaderCostsModel(QObject* parent = nullptr);
+    void setRecord(const PBuildRecord& record);
+    int rowCount(const QModelIndex &parent) const override;
+    int columnCount(const QModelIndex &parent) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+private:
+    PBuildRecord mRecord;
+};
+
+class BuildHistoryModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    explicit BuildHistoryModel(QObject* parent = nullptr);
+    void setRecords(const QList<PBuildRecord>& records);
+    int rowCount(const QModelIndex &parent) const override;
+    int columnCount(const QModelIndex &parent) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+private:
+    QList<PBuildRecord> mRecords;
+};
+
+class BuildTimelineDelegate : public QStyledItemDelegate {
+public:
+    explicit BuildTimelineDelegate(QObject* parent = nullptr);
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+};
+
+class BuildTimesDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    BuildTimesDialog(const QString& historyFile, const QString& directory, QWidget *parent = nullptr);
+    ~BuildTimesDialog();
+
+private slots:
+    void on_cbBuilds_currentIndexChanged(int index);
+    void on_tblHistory_doubleClicked(const QModelIndex &index);
+
+private:
+    Ui::BuildTimesDialog *ui;
+    BuildTimeHistory mHistory;
+    QString mDirectory;
+    BuildStepsModel mStepsModel;
+    HeaderCostsModel mHeadersModel;
+    BuildHistoryModel mHistoryModel;
+};
+
+#endif // BUILDTIMESDIALOG_H
@@ -311,6 +311,8 @@ void ClassBrowserModel::sortNode(ClassBrowserNode *node)
         } else {
             std::sort(node->children.begin(),node->children.end(),
                       [](ClassBrowserNode* node1,ClassBrowserNode* node2) {
+                if (node1->statement->fileId == node2->statement->fileId)
+                    return (node1->statement->line < node2->statement->line);
                 int comp=QString::compare(node1->statement->fileName, node2->statement->fileName);
                 if (comp<0)
                     return true;
@@ -430,8 +432,10 @@ PStatement ClassBrowserModel::createDummy(const PStatement& statement)
     result->accessibility = statement->accessibility;
     result->properties = statement->properties;
     result->fileName= statement->fileName;
+    result->fileId = statement->fileId;
     result->line = statement->line;
     result->definitionFileName = statement->fileName;
+    result->definitionFileId = statement->fileId;
     result->definitionLine = statement->definitionLine;
     mDummyStatements.insert(result->fullName,result);
     return result;
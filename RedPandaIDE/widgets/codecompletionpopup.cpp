@@ -22,6 +22,7 @@
 #include "../symbolusagemanager.h"
 #include "../colorscheme.h"
 #include "../iconsmanager.h"
+#include "qt_utils/tracer.h"
 
 #include <QKeyEvent>
 #include <QVBoxLayout>
@@ -98,15 +99,15 @@ void CodeCompletionPopup::prepareSearch(
         getCompletionListForComplexKeyword(preWord);
         break;
     case CodeCompletionType::Types:
-        mIncludedFiles = mParser->getIncludedFiles(filename);
+        mIncludedFiles = mParser->getIncludedFileIds(filename);
         getCompletionListForTypes(preWord,filename,line);
         break;
     case CodeCompletionType::FunctionWithoutDefinition:
-        mIncludedFiles = mParser->getIncludedFiles(filename);
+        mIncludedFiles = mParser->getIncludedFileIds(filename);
         getCompletionForFunctionWithoutDefinition(preWord, ownerExpression,memberOperator,memberExpression, filename,line);
         break;
     case CodeCompletionType::Namespaces:
-        mIncludedFiles = mParser->getIncludedFiles(filename);
+        mIncludedFiles = mParser->getIncludedFileIds(filename);
         getCompletionListForNamespaces(preWord,filename,line);
         break;
     case CodeCompletionType::KeywordsOnly:
@@ -114,7 +115,7 @@ void CodeCompletionPopup::prepareSearch(
         getKeywordCompletionFor(customKeywords);
         break;
     default:
-        mIncludedFiles = mParser->getIncludedFiles(filename);
+        mIncludedFiles = mParser->getIncludedFileIds(filename);
         getCompletionFor(ownerExpression,memberOperator,memberExpression, filename,line, customKeywords);
     }
     setCursor(oldCursor);
@@ -193,8 +194,8 @@ void CodeCompletionPopup::addChildren(const PStatement& scopeStatement,
                                       int line,
                                       bool onlyTypes)
 {
-    if (scopeStatement && !isIncluded(scopeStatement->fileName)
-      && !isIncluded(scopeStatement->definitionFileName))
+    if (scopeStatement && !isIncluded(scopeStatement->fileId)
+      && !isIncluded(scopeStatement->definitionFileId))
         return;
     const StatementMap& children = mParser->statementList().childrenStatements(scopeStatement);
     if (children.isEmpty())
@@ -209,8 +210,8 @@ void CodeCompletionPopup::addChildren(const PStatement& scopeStatement,
                     // hard defines
                     addStatement(childStatement,fileName,-1);
                 } else if (
-                           isIncluded(childStatement->fileName)
-                           || isIncluded(childStatement->definitionFileName)
+                           isIncluded(childStatement->fileId)
+                           || isIncluded(childStatement->definitionFileId)
                            ) {
                     //we must check if the statement is included by the file
                     addStatement(childStatement,fileName,line);
@@ -230,8 +231,8 @@ void CodeCompletionPopup::addChildren(const PStatement& scopeStatement,
                     // hard defines
                     addStatement(childStatement,fileName,-1);
                 } else if (
-                           isIncluded(childStatement->fileName)
-                           || isIncluded(childStatement->definitionFileName)
+                           isIncluded(childStatement->fileId)
+                           || isIncluded(childStatement->definitionFileId)
                            ) {
                     //we must check if the statement is included by the file
                     addStatement(childStatement,fileName,line);
@@ -248,8 +249,8 @@ void CodeCompletionPopup::addChildren(const PStatement& scopeStatement,
 
 void CodeCompletionPopup::addFunctionWithoutDefinitionChildren(const PStatement& scopeStatement, const QString &fileName, int line)
 {
-    if (scopeStatement && !isIncluded(scopeStatement->fileName)
-      && !isIncluded(scopeStatement->definitionFileName))
+    if (scopeStatement && !isIncluded(scopeStatement->fileId)
+      && !isIncluded(scopeStatement->definitionFileId))
         return;
     const StatementMap& children = mParser->statementList().childrenStatements(scopeStatement);
     if (children.isEmpty())
@@ -271,7 +272,7 @@ void CodeCompletionPopup::addFunctionWithoutDefinitionChildren(const PStatement&
             break;
         case StatementKind::skClass:
         case StatementKind::skNamespace:
-            if (isIncluded(childStatement->fileName))
+            if (isIncluded(childStatement->fileId))
                 addStatement(childStatement,fileName,line);
             break;
         default:
@@ -459,6 +460,7 @@ static bool sortByScopeWithUsageComparator(PStatement statement1,PStatement stat
 
 void CodeCompletionPopup::filterList(const QString &member)
 {
+    TraceSpan traceSpan("CodeCompletionPopup::filterList");
     QMutexLocker locker(&mMutex);
     mCompletionStatementList.clear();
 //    if (!mParser)
@@ -808,8 +810,8 @@ void CodeCompletionPopup::getCompletionFor(
                     if (memberOperator=="->" && ownerStatement->pointerLevel!=1)
                         return;
                 }
-                if (!isIncluded(classTypeStatement->fileName) &&
-                    !isIncluded(classTypeStatement->definitionFileName))
+                if (!isIncluded(classTypeStatement->fileId) &&
+                    !isIncluded(classTypeStatement->definitionFileId))
                     return;
                 if ((classTypeStatement == scopeTypeStatement) || (ownerStatement->effectiveTypeStatement->command == "this")) {
                     //we can use all members
@@ -835,8 +837,8 @@ void CodeCompletionPopup::getCompletionFor(
                 PStatement classTypeStatement = ownerStatement->effectiveTypeStatement;
                 if (!classTypeStatement)
                     return;
-                if (!isIncluded(classTypeStatement->fileName) &&
-                    !isIncluded(classTypeStatement->definitionFileName))
+                if (!isIncluded(classTypeStatement->fileId) &&
+                    !isIncluded(classTypeStatement->definitionFileId))
                     return;
                 if (classTypeStatement->kind == StatementKind::skEnumType
                         || classTypeStatement->kind == StatementKind::skEnumClassType) {
@@ -1014,8 +1016,8 @@ void CodeCompletionPopup::getCompletionListForNamespaces(const QString &/*preWor
         foreach (const QString& name, namespaceNames) {
             PStatementList namespaces = mParser->findNamespace(name);
             foreach(const PStatement& statement, *namespaces) {
-                if (isIncluded(statement->fileName)
-                        || isIncluded(statement->definitionFileName)) {
+                if (isIncluded(statement->fileId)
+                        || isIncluded(statement->definitionFileId)) {
                     addStatement(statement,fileName,line);
                     continue;
                 }
@@ -1050,8 +1052,8 @@ void CodeCompletionPopup::getCompletionListForTypes(const QString &preWord, cons
         });
         QList<PStatement> statements = mParser->listTypeStatements(fileName,line);
         foreach(const PStatement& statement, statements) {
-            if (isIncluded(statement->fileName)
-                    || isIncluded(statement->definitionFileName)) {
+            if (isIncluded(statement->fileId)
+                    || isIncluded(statement->definitionFileId)) {
                 addStatement(statement,fileName,line);
             }
         }
@@ -1068,9 +1070,9 @@ void CodeCompletionPopup::addKeyword(const QString &keyword)
     mFullCompletionStatementList.append(statement);
 }
 
-bool CodeCompletionPopup::isIncluded(const QString &fileName)
+bool CodeCompletionPopup::isIncluded(FileId fileId)
 {
-    return mIncludedFiles.contains(fileName);
+    return mIncludedFiles.contains(fileId);
 }
 
 void CodeCompletionPopup::setHideSymbolsStartWithTwoUnderline(bool newHideSymbolsStartWithTwoUnderline)
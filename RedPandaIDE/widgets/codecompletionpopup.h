@@ -160,7 +160,7 @@ private:
                                         const QString& fileName,
                                         int line);
     void addKeyword(const QString& keyword);
-    bool isIncluded(const QString& fileName);
+    bool isIncluded(FileId fileId);
 private:
     CodeCompletionListView * mListView;
     CodeCompletionListModel* mModel;
@@ -168,7 +168,7 @@ private:
     //QList<PStatement> mCodeInsStatements; //temporary (user code template) statements created when show code suggestion
     StatementList mFullCompletionStatementList;
     StatementList mCompletionStatementList;
-    QSet<QString> mIncludedFiles;
+    FileIdSet mIncludedFiles;
     QSet<QString> mUsings;
     QSet<QString> mAddedStatements;
     QString mMemberPhrase;
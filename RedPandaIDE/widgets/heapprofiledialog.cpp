@@ -0,0 +1,401 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "heapprofiledialog.h"
+#include "ui_heapprofiledialog.h"
+
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QHelpEvent>
+#include <QListWidgetItem>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QSortFilterProxyModel>
+#include <QToolTip>
+#include "../editor.h"
+#include "../mainwindow.h"
+#include "../utils.h"
+
+static QString formatBytes(quint64 bytes)
+{
+    if (bytes < 1024)
+        return QObject::tr("%1 bytes").arg(bytes);
+    if (bytes < 1024 * 1024)
+        return QObject::tr("%1 KB").arg(bytes / 1024.0, 0, 'f', 2);
+    if (bytes < 1024 * 1024 * 1024)
+        return QObject::tr("%1 MB").arg(bytes / 1024.0 / 1024.0, 0, 'f', 2);
+    return QObject::tr("%1 GB").arg(bytes / 1024.0 / 1024.0 / 1024.0, 0, 'f', 2);
+}
+
+static QString frameLocation(const HeapProfileFrame& frame, bool fullPath)
+{
+    if (frame.fileName.isEmpty())
+        return QString();
+    QString fileName = fullPath ? frame.fileName : QFileInfo(frame.fileName).fileName();
+    return QString("%1:%2").arg(fileName).arg(frame.line);
+}
+
+HeapSitesModel::HeapSitesModel(QObject *parent):
+    QAbstractTableModel{parent}
+{
+
+}
+
+void HeapSitesModel::setSites(const std::shared_ptr<HeapProfile> &profile, const QList<HeapProfileSite> &sites)
+{
+    beginResetModel();
+    mProfile = profile;
+    mSites = sites;
+    endResetModel();
+}
+
+const HeapProfileSite &HeapSitesModel::site(int row) const
+{
+    return mSites[row];
+}
+
+int HeapSitesModel::rowCount(const QModelIndex &) const
+{
+    return mSites.count();
+}
+
+int HeapSitesModel::columnCount(const QModelIndex &) const
+{
+    return ColumnCount;
+}
+
+QVariant HeapSitesModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= mSites.count())
+        return QVariant();
+    const HeapProfileSite& site = mSites[index.row()];
+    const HeapProfileFrame* frame = site.frame >= 0 ? &mProfile->frames()[site.frame] : nullptr;
+    switch (index.column()) {
+    case FunctionColumn:
+        if (role == Qt::DisplayRole || role == Qt::ToolTipRole || role == Qt::UserRole)
+            return frame ? frame->function : tr("<unknown>");
+        break;
+    case LocationColumn:
+        if (role == Qt::DisplayRole || role == Qt::UserRole)
+            return frame ? frameLocation(*frame, false) : QString();
+        if (role == Qt::ToolTipRole)
+            return frame ? frameLocation(*frame, true) : QString();
+        break;
+    case BytesColumn:
+        if (role == Qt::DisplayRole)
+            return formatBytes(site.bytes);
+        if (role == Qt::UserRole)
+            return site.bytes;
+        break;
+    case CountColumn:
+        if (role == Qt::DisplayRole || role == Qt::UserRole)
+            return site.count;
+        break;
+    }
+    if (role == Qt::TextAlignmentRole && index.column() >= BytesColumn)
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    return QVariant();
+}
+
+QVariant HeapSitesModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QVariant();
+    switch (section) {
+    case FunctionColumn:
+        return tr("Function");
+    case LocationColumn:
+        return tr("Location");
+    case BytesColumn:
+        return tr("Bytes (estimated)");
+    case CountColumn:
+        return tr("Samples");
+    }
+    return QVariant();
+}
+
+HeapFlameGraph::HeapFlameGraph(QWidget *parent):
+    QWidget{parent},
+    mScale{0}
+{
+
+}
+
+void HeapFlameGraph::setProfile(const std::shared_ptr<HeapProfile> &profile)
+{
+    mProfile = profile;
+    mRoot = profile->flameGraph();
+    mZoomPath = {mRoot};
+    setMinimumHeight(sizeHint().height());
+    layoutBoxes();
+    update();
+}
+
+QSize HeapFlameGraph::sizeHint() const
+{
+    int rowHeight = fontMetrics().height() + 4;
+    if (mZoomPath.isEmpty())
+        return QSize(400, rowHeight);
+    return QSize(400, (depth(mZoomPath.last()) + 1) * rowHeight);
+}
+
+void HeapFlameGraph::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.fillRect(event->rect(), palette().color(QPalette::Base));
+    foreach (const Box& box, mBoxes) {
+        if (!box.rect.intersects(event->rect()))
+            continue;
+        QString name = frameName(box.node->frame);
+        QColor color;
+        if (box.node->frame < 0)
+            color = QColor(200, 200, 200);
+        else // warm colors, stable for the same function
+            color = QColor::fromHsv(qHash(name) % 50, 140, 240);
+        painter.fillRect(box.rect, color);
+        painter.setPen(palette().color(QPalette::Base));
+        painter.drawRect(box.rect);
+        if (box.rect.width() > 20) {
+            painter.setPen(Qt::black);
+            QRectF textRect = box.rect.adjusted(3, 0, -3, 0);
+            painter.drawText(textRect, Qt::AlignLeft | Qt::AlignVCenter,
+                             fontMetrics().elidedText(name, Qt::ElideRight, textRect.width()));
+        }
+    }
+}
+
+void HeapFlameGraph::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton)
+        return;
+    int index = boxAt(event->pos());
+    if (index < 0)
+        return;
+    if (index == 0) {
+        if (mZoomPath.count() <= 1)
+            return;
+        mZoomPath.removeLast();
+    } else {
+        QList<PHeapFlameNode> path;
+        for (int i=index; i>0; i=mBoxes[i].parent)
+            path.prepend(mBoxes[i].node);
+        mZoomPath.append(path);
+    }
+    setMinimumHeight(sizeHint().height());
+    layoutBoxes();
+    update();
+}
+
+void HeapFlameGraph::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    // the first click has zoomed to the clicked function, which is the top now
+    if (event->button() == Qt::LeftButton && !mZoomPath.isEmpty())
+        emit frameDoubleClicked(mZoomPath.last()->frame);
+}
+
+bool HeapFlameGraph::event(QEvent *event)
+{
+    if (event->type() == QEvent::ToolTip) {
+        QHelpEvent* helpEvent = static_cast<QHelpEvent*>(event);
+        int index = boxAt(helpEvent->pos());
+        if (index < 0) {
+            QToolTip::hideText();
+            event->ignore();
+            return true;
+        }
+        const PHeapFlameNode& node = mBoxes[index].node;
+        QString text = frameName(node->frame);
+        if (node->frame >= 0) {
+            QString location = frameLocation(mProfile->frames()[node->frame], true);
+            if (!location.isEmpty())
+                text += "\n" + location;
+        }
+        text += "\n" + tr("%1 (%2% of all), %3 samples")
+                .arg(formatBytes(node->bytes))
+                .arg(mRoot->bytes > 0 ? 100.0 * node->bytes / mRoot->bytes : 0, 0, 'f', 1)
+                .arg(node->count);
+        QToolTip::showText(helpEvent->globalPos(), text, this);
+        return true;
+    }
+    return QWidget::event(event);
+}
+
+void HeapFlameGraph::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    layoutBoxes();
+}
+
+void HeapFlameGraph::layoutBoxes()
+{
+    mBoxes.clear();
+    if (mZoomPath.isEmpty() || mZoomPath.last()->bytes == 0)
+        return;
+    const PHeapFlameNode& root = mZoomPath.last();
+    mScale = qreal(width()) / root->bytes;
+    layoutNode(root, 0, 0, -1);
+}
+
+void HeapFlameGraph::layoutNode(const PHeapFlameNode &node, qreal x, int depth, int parent)
+{
+    qreal width = node->bytes * mScale;
+    // too narrow to be seen
+    if (width < 1)
+        return;
+    int rowHeight = fontMetrics().height() + 4;
+    int index = mBoxes.count();
+    mBoxes.append(Box{QRectF(x, depth * rowHeight, width, rowHeight), node, parent});
+    qreal childX = x;
+    foreach (const PHeapFlameNode& child, node->children) {
+        layoutNode(child, childX, depth + 1, index);
+        childX += child->bytes * mScale;
+    }
+}
+
+int HeapFlameGraph::boxAt(const QPoint &pos) const
+{
+    for (int i=0;i<mBoxes.count();i++) {
+        if (mBoxes[i].rect.contains(pos))
+            return i;
+    }
+    return -1;
+}
+
+QString HeapFlameGraph::frameName(int frame) const
+{
+    if (frame < 0)
+        return tr("All sampled allocations");
+    return mProfile->frames()[frame].function;
+}
+
+int HeapFlameGraph::depth(const PHeapFlameNode &node) const
+{
+    int result = 0;
+    foreach (const PHeapFlameNode& child, node->children)
+        result = std::max(result, depth(child) + 1);
+    return result;
+}
+
+HeapProfileDialog::HeapProfileDialog(const std::shared_ptr<HeapProfile> &profile, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::HeapProfileDialog),
+    mProfile(profile)
+{
+    ui->setupUi(this);
+    setWindowFlag(Qt::WindowContextHelpButtonHint,false);
+    auto setModel = [this](QTableView* view, QAbstractItemModel* model) {
+        QSortFilterProxyModel* proxy = new QSortFilterProxyModel(this);
+        proxy->setSourceModel(model);
+        proxy->setSortRole(Qt::UserRole);
+        view->setModel(proxy);
+        view->setSortingEnabled(true);
+        view->sortByColumn(HeapSitesModel::BytesColumn, Qt::DescendingOrder);
+        view->horizontalHeader()->setSectionResizeMode(HeapSitesModel::FunctionColumn, QHeaderView::Stretch);
+        connect(view->selectionModel(), &QItemSelectionModel::currentRowChanged,
+                this, &HeapProfileDialog::onSiteChanged);
+    };
+    mHotSpotsModel.setSites(profile, profile->hotSpots());
+    mLeaksModel.setSites(profile, profile->leaks());
+    setModel(ui->tblHotSpots, &mHotSpotsModel);
+    setModel(ui->tblLeaks, &mLeaksModel);
+
+    mFlameGraph = new HeapFlameGraph();
+    ui->scrollFlameGraph->setWidget(mFlameGraph);
+    mFlameGraph->setProfile(profile);
+    connect(mFlameGraph, &HeapFlameGraph::frameDoubleClicked,
+            this, &HeapProfileDialog::openFrame);
+
+    QString summary;
+    if (profile->finished()) {
+        summary = tr("Peak heap: %1. %2 allocations, %3 in total. %4 in use at exit.")
+                .arg(formatBytes(profile->peakHeap()))
+                .arg(profile->allocationCount())
+                .arg(formatBytes(profile->allocatedBytes()),
+                     formatBytes(profile->heapInUse()));
+    } else {
+        summary = tr("The program didn't exit normally, only the allocations sampled before are shown.");
+    }
+    summary += " ";
+    if (profile->sampleRate() > 0)
+        summary += tr("%1 allocations are sampled, one every %2 bytes allocated.")
+                .arg(profile->samples().count()).arg(profile->sampleRate());
+    else
+        summary += tr("All %1 allocations are sampled.").arg(profile->samples().count());
+    ui->lblSummary->setText(summary);
+    ui->splitter->setStretchFactor(0, 3);
+    ui->splitter->setStretchFactor(1, 1);
+}
+
+HeapProfileDialog::~HeapProfileDialog()
+{
+    delete ui;
+}
+
+void HeapProfileDialog::on_tblHotSpots_doubleClicked(const QModelIndex &index)
+{
+    QSortFilterProxyModel* proxy = static_cast<QSortFilterProxyModel*>(ui->tblHotSpots->model());
+    QModelIndex sourceIndex = proxy->mapToSource(index);
+    if (sourceIndex.isValid())
+        openFrame(mHotSpotsModel.site(sourceIndex.row()).frame);
+}
+
+void HeapProfileDialog::on_tblLeaks_doubleClicked(const QModelIndex &index)
+{
+    QSortFilterProxyModel* proxy = static_cast<QSortFilterProxyModel*>(ui->tblLeaks->model());
+    QModelIndex sourceIndex = proxy->mapToSource(index);
+    if (sourceIndex.isValid())
+        openFrame(mLeaksModel.site(sourceIndex.row()).frame);
+}
+
+void HeapProfileDialog::on_lstStack_itemDoubleClicked(QListWidgetItem *item)
+{
+    openFrame(item->data(Qt::UserRole).toInt());
+}
+
+void HeapProfileDialog::onSiteChanged(const QModelIndex &current)
+{
+    ui->lstStack->clear();
+    const QSortFilterProxyModel* proxy = qobject_cast<const QSortFilterProxyModel*>(current.model());
+    if (!proxy)
+        return;
+    QModelIndex sourceIndex = proxy->mapToSource(current);
+    const HeapSitesModel* model = static_cast<const HeapSitesModel*>(proxy->sourceModel());
+    if (!sourceIndex.isValid())
+        return;
+    foreach (int index, model->site(sourceIndex.row()).stack) {
+        const HeapProfileFrame& frame = mProfile->frames()[index];
+        QString text = frame.function;
+        QString location = frameLocation(frame, false);
+        if (!location.isEmpty())
+            text += "    " + location;
+        QListWidgetItem* item = new QListWidgetItem(text, ui->lstStack);
+        item->setData(Qt::UserRole, index);
+        item->setToolTip(frameLocation(frame, true));
+    }
+}
+
+void HeapProfileDialog::openFrame(int frame)
+{
+    if (frame < 0)
+        return;
+    const HeapProfileFrame& profileFrame = mProfile->frames()[frame];
+    if (profileFrame.fileName.isEmpty() || !fileExists(profileFrame.fileName))
+        return;
+    Editor* editor = pMainWindow->openFile(profileFrame.fileName);
+    if (editor)
+        editor->setCaretPositionAndActivate(std::max(1, profileFrame.line), 1);
+}
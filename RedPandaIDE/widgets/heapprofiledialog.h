@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef HEAPPROFILEDIALOG_H
+#define HEAPPROFILEDIALOG_H
+
+#include <QAbstractTableModel>
+#include <QDialog>
+#include <QWidget>
+#include "../compiler/heapprofile.h"
+
+namespace Ui {
+class HeapProfileDialog;
+}
+
+class QListWidgetItem;
+
+class HeapSitesModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    enum Column {
+        FunctionColumn,
+        LocationColumn,
+        BytesColumn,
+        CountColumn,
+        ColumnCount
+    };
+    explicit HeapSitesModel(QObject* parent = nullptr);
+    void setSites(const std::shared_ptr<HeapProfile>& profile, const QList<HeapProfileSite>& sites);
+    const HeapProfileSite& site(int row) const;
+    int rowCount(const QModelIndex &parent) const override;
+    int columnCount(const QModelIndex &parent) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+private:
+    std::shared_ptr<HeapProfile> mProfile;
+    QList<HeapProfileSite> mSites;
+};
+
+/**
+ * @brief Icicle graph of the sampled allocation stacks, callers above callees
+ */
+class HeapFlameGraph : public QWidget {
+    Q_OBJECT
+public:
+    explicit HeapFlameGraph(QWidget* parent = nullptr);
+    void setProfile(const std::shared_ptr<HeapProfile>& profile);
+    QSize sizeHint() const override;
+signals:
+    void frameDoubleClicked(int frame);
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    bool event(QEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+private:
+    struct Box {
+        QRectF rect;
+        PHeapFlameNode node;
+        int parent; // index in mBoxes
+    };
+    void layoutBoxes();
+    void layoutNode(const PHeapFlameNode& node, qreal x, int depth, int parent);
+    int boxAt(const QPoint& pos) const;
+    QString frameName(int frame) const;
+    int depth(const PHeapFlameNode& node) const;
+private:
+    std::shared_ptr<HeapProfile> mProfile;
+    PHeapFlameNode mRoot;
+    // the shown root is the last one
+    QList<PHeapFlameNode> mZoomPath;
+    QList<Box> mBoxes;
+    qreal mScale; // pixels per byte
+};
+
+class HeapProfileDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    HeapProfileDialog(const std::shared_ptr<HeapProfile>& profile, QWidget *parent = nullptr);
+    ~HeapProfileDialog();
+
+private slots:
+    void on_tblHotSpots_doubleClicked(const QModelIndex &index);
+    void on_tblLeaks_doubleClicked(const QModelIndex &index);
+    void on_lstStack_itemDoubleClicked(QListWidgetItem *item);
+    void onSiteChanged(const QModelIndex &current);
+    void openFrame(int frame);
+
+private:
+    Ui::HeapProfileDialog *ui;
+    std::shared_ptr<HeapProfile> mProfile;
+    HeapSitesModel mHotSpotsModel;
+    HeapSitesModel mLeaksModel;
+    HeapFlameGraph* mFlameGraph;
+};
+
+#endif // HEAPPROFILEDIALOG_H
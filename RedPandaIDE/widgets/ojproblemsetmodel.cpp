@@ -23,6 +23,7 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMimeData>
+#include <QRegularExpression>
 #include "../utils.h"
 #include "../iconsmanager.h"
 #include "../systemconsts.h"
@@ -119,55 +120,72 @@ void OJProblemSetModel::removeAllProblems()
 
 void OJProblemSetModel::saveToFile(const QString &fileName, int currentIndex)
 {
-    QFile file(fileName);
-    if (file.open(QFile::WriteOnly | QFile::Truncate)) {
-        QJsonObject obj;
-        mProblemSet.exportFilename=fileName;
-        obj["name"]=mProblemSet.name;
-        QJsonArray problemsArray;
-        foreach (const POJProblem& problem, mProblemSet.problems) {
-            QJsonObject problemObj;
-            problemObj["name"]=problem->name;
-            problemObj["url"]=problem->url;
-            problemObj["description"]=problem->description;
-            problemObj["time_limit"]=(int)problem->timeLimit;
-            problemObj["memory_limit"]=(int)problem->memoryLimit;
-            problemObj["time_limit_unit"]=(int)problem->timeLimitUnit;
-            problemObj["memory_limit_unit"]=(int)problem->memoryLimitUnit;
-            if (fileExists(problem->answerProgram))
-                problemObj["answer_program"] = problem->answerProgram;
-            QJsonArray cases;
-            foreach (const POJProblemCase& problemCase, problem->cases) {
-                QJsonObject caseObj;
-                caseObj["name"]=problemCase->name;
-                caseObj["input"]=problemCase->input;
-                QString path = problemCase->inputFileName;
-                QString prefix = includeTrailingPathDelimiter(extractFileDir(fileName));
-                if (path.startsWith(prefix, PATH_SENSITIVITY)) {
-                    path = "%ProblemSetPath%/"+ path.mid(prefix.length());
-                }
-                caseObj["input_filename"]=path;
-                path = problemCase->expectedOutputFileName;
-                if (path.startsWith(prefix, PATH_SENSITIVITY)) {
-                    path = "%ProblemSetPath%/"+ path.mid(prefix.length());
-                }
-                caseObj["expected_output_filename"]=path;
-                caseObj["expected"]=problemCase->expected;
-                cases.append(caseObj);
+    QString dataDir = caseDataDir(fileName);
+    if (!QDir().mkpath(dataDir)) {
+        throw FileError(QObject::tr("Can't create folder '%1'.")
+                        .arg(dataDir));
+    }
+    QSet<QString> usedDataFiles;
+    QJsonObject obj;
+    mProblemSet.exportFilename=fileName;
+    obj["name"]=mProblemSet.name;
+    QJsonArray problemsArray;
+    foreach (const POJProblem& problem, mProblemSet.problems) {
+        QJsonObject problemObj;
+        problemObj["name"]=problem->name;
+        problemObj["url"]=problem->url;
+        problemObj["description"]=problem->description;
+        problemObj["time_limit"]=(int)problem->timeLimit;
+        problemObj["memory_limit"]=(int)problem->memoryLimit;
+        problemObj["time_limit_unit"]=(int)problem->timeLimitUnit;
+        problemObj["memory_limit_unit"]=(int)problem->memoryLimitUnit;
+        if (fileExists(problem->answerProgram))
+            problemObj["answer_program"] = problem->answerProgram;
+        QJsonArray cases;
+        foreach (const POJProblemCase& problemCase, problem->cases) {
+            if (!problemCase->saveData(dataDir)) {
+                throw FileError(QObject::tr("Can't save data of problem case '%1' to '%2'.")
+                                .arg(problemCase->name, dataDir));
             }
-            problemObj["cases"]=cases;
-            problemsArray.append(problemObj);
+            QJsonObject caseObj;
+            caseObj["name"]=problemCase->name;
+            caseObj["input_hash"]=problemCase->inputHash();
+            usedDataFiles.insert(problemCase->inputHash());
+            QString path = problemCase->inputFileName;
+            QString prefix = includeTrailingPathDelimiter(extractFileDir(fileName));
+            if (path.startsWith(prefix, PATH_SENSITIVITY)) {
+                path = "%ProblemSetPath%/"+ path.mid(prefix.length());
+            }
+            caseObj["input_filename"]=path;
+            path = problemCase->expectedOutputFileName;
+            if (path.startsWith(prefix, PATH_SENSITIVITY)) {
+                path = "%ProblemSetPath%/"+ path.mid(prefix.length());
+            }
+            caseObj["expected_output_filename"]=path;
+            caseObj["expected_hash"]=problemCase->expectedHash();
+            usedDataFiles.insert(problemCase->expectedHash());
+            cases.append(caseObj);
         }
-        obj["problems"]=problemsArray;
-        obj["current_index"]=currentIndex;
-        QJsonDocument doc;
-        doc.setObject(obj);
-        file.write(doc.toJson());
-        file.close();
-    } else {
-        throw FileError(QObject::tr("Can't open file '%1' for read.")
-                        .arg(fileName));
+        problemObj["cases"]=cases;
+        problemsArray.append(problemObj);
     }
+    obj["problems"]=problemsArray;
+    obj["current_index"]=currentIndex;
+    QJsonDocument doc;
+    doc.setObject(obj);
+    QByteArray content = doc.toJson();
+    // case data are not in the index, so it only changes with the problem infos
+    if (!fileExists(fileName) || readFileToByteArray(fileName)!=content) {
+        QFile file(fileName);
+        if (file.open(QFile::WriteOnly | QFile::Truncate)) {
+            file.write(content);
+            file.close();
+        } else {
+            throw FileError(QObject::tr("Can't open file '%1' for read.")
+                            .arg(fileName));
+        }
+    }
+    removeUnusedCaseData(dataDir, usedDataFiles);
 }
 
 void OJProblemSetModel::loadFromFile(const QString &fileName, int& currentIndex)
@@ -182,6 +200,7 @@ void OJProblemSetModel::loadFromFile(const QString &fileName, int& currentIndex)
                             .arg(fileName)
                             .arg(error.errorString()));
         }
+        QString dataDir = caseDataDir(fileName);
         beginResetModel();
         QJsonObject obj = doc.object();
         mProblemSet.name = obj["name"].toString();
@@ -205,8 +224,14 @@ void OJProblemSetModel::loadFromFile(const QString &fileName, int& currentIndex)
                 QJsonObject caseObj = caseVal.toObject();
                 POJProblemCase problemCase = std::make_shared<OJProblemCase>();
                 problemCase->name = caseObj["name"].toString();
-                problemCase->input = caseObj["input"].toString();
-                problemCase->expected = caseObj["expected"].toString();
+                problemCase->setData(dataDir,
+                                     caseObj["input_hash"].toString(),
+                                     caseObj["expected_hash"].toString());
+                // problem sets saved by older versions keep the data inline
+                if (caseObj.contains("input"))
+                    problemCase->setInput(caseObj["input"].toString());
+                if (caseObj.contains("expected"))
+                    problemCase->setExpected(caseObj["expected"].toString());
                 QString path = caseObj["input_filename"].toString();
                 if (path.startsWith("%ProblemSetPath%/")) {
                     path = includeTrailingPathDelimiter(extractFileDir(fileName))+
@@ -231,6 +256,22 @@ void OJProblemSetModel::loadFromFile(const QString &fileName, int& currentIndex)
     }
 }
 
+QString OJProblemSetModel::caseDataDir(const QString &fileName)
+{
+    return changeFileExt(fileName, "cases");
+}
+
+void OJProblemSetModel::removeUnusedCaseData(const QString &dataDir, const QSet<QString> &usedDataFiles)
+{
+    // only the files written by OJProblemCaseData::save(), other files may be the user's
+    static const QRegularExpression dataFilePattern("^[0-9a-f]{40}(\\.tmp)?$");
+    QDir dir(dataDir);
+    foreach (const QString& name, dir.entryList(QDir::Files)) {
+        if (!usedDataFiles.contains(name) && dataFilePattern.match(name).hasMatch())
+            dir.remove(name);
+    }
+}
+
 void OJProblemSetModel::load(int &currentIndex)
 {
     QDir dir(pSettings->dirs().config());
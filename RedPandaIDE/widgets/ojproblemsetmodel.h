@@ -18,6 +18,7 @@
 #define OJPROBLEMSETMODEL_H
 
 #include <QAbstractTableModel>
+#include <QSet>
 #include <memory>
 #include "../problems/ojproblemset.h"
 
@@ -96,6 +97,10 @@ public:
 signals:
     void problemNameChanged(int index);
 
+private:
+    // folder of the case data files, next to the problem set file
+    static QString caseDataDir(const QString& fileName);
+    static void removeUnusedCaseData(const QString& dataDir, const QSet<QString>& usedDataFiles);
 private:
     OJProblemSet mProblemSet;
 
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "quickopenpopup.h"
+
+#include <algorithm>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QListView>
+#include <QVBoxLayout>
+#include "../iconsmanager.h"
+#include "../utils.h"
+
+// Matching runs in slices of this many milliseconds, so the popup keeps
+// responding to key presses while searching a large index.
+static const int MatchSliceTime = 8;
+static const int MaxResults = 100;
+
+QuickOpenListModel::QuickOpenListModel(QObject *parent):
+    QAbstractListModel{parent}
+{
+}
+
+int QuickOpenListModel::rowCount(const QModelIndex &) const
+{
+    return mItems.count();
+}
+
+QVariant QuickOpenListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+    if (index.row()>=mItems.count())
+        return QVariant();
+    PQuickOpenItem item = mItems[index.row()];
+    switch(role) {
+    case Qt::DisplayRole:
+        if (item->type == QuickOpenItemType::Symbol)
+            return QString("%1    %2:%3").arg(item->detail,
+                                              extractFileName(item->filename))
+                    .arg(item->line);
+        return QString("%1    %2").arg(item->name, item->detail);
+    case Qt::ToolTipRole:
+        return item->filename;
+    case Qt::DecorationRole:
+        if (item->type == QuickOpenItemType::Symbol) {
+            PStatement statement = item->statement.lock();
+            if (statement)
+                return pIconsManager->getPixmapForStatement(statement);
+            return QVariant();
+        }
+        switch(getFileType(item->filename)) {
+        case FileType::CSource:
+            return pIconsManager->getIcon(IconsManager::FILESYSTEM_CFILE);
+        case FileType::CppSource:
+            return pIconsManager->getIcon(IconsManager::FILESYSTEM_CPPFILE);
+        case FileType::CHeader:
+        case FileType::CppHeader:
+            return pIconsManager->getIcon(IconsManager::FILESYSTEM_HFILE);
+        default:
+            return pIconsManager->getIcon(IconsManager::FILESYSTEM_FILE);
+        }
+    }
+    return QVariant();
+}
+
+void QuickOpenListModel::setItems(const QList<PQuickOpenItem> &items)
+{
+    beginResetModel();
+    mItems = items;
+    endResetModel();
+}
+
+PQuickOpenItem QuickOpenListModel::item(int row) const
+{
+    if (row<0 || row>=mItems.count())
+        return PQuickOpenItem();
+    return mItems[row];
+}
+
+QuickOpenPopup::QuickOpenPopup(QuickOpenIndex *index, QWidget *parent):
+    QWidget{parent},
+    mIndex{index},
+    mType{QuickOpenItemType::File},
+    mNextToMatch{0}
+{
+    setWindowFlags(Qt::Popup);
+    mEditFilter = new QLineEdit(this);
+    mListView = new QListView(this);
+    mModel = new QuickOpenListModel(this);
+    mListView->setModel(mModel);
+    mListView->setFocusPolicy(Qt::NoFocus);
+    mListView->setUniformItemSizes(true);
+    setLayout(new QVBoxLayout());
+    layout()->addWidget(mEditFilter);
+    layout()->addWidget(mListView);
+    layout()->setMargin(0);
+    mEditFilter->installEventFilter(this);
+
+    mMatchTimer.setSingleShot(true);
+    mMatchTimer.setInterval(0);
+    connect(&mMatchTimer, &QTimer::timeout,
+            this, &QuickOpenPopup::continueMatching);
+    connect(mEditFilter, &QLineEdit::textChanged,
+            this, &QuickOpenPopup::onTextChanged);
+    connect(mListView, &QListView::activated,
+            this, &QuickOpenPopup::onItemActivated);
+    connect(mIndex, &QuickOpenIndex::updated,
+            this, &QuickOpenPopup::onIndexUpdated);
+}
+
+void QuickOpenPopup::popup(QuickOpenItemType type)
+{
+    mType = type;
+    if (type == QuickOpenItemType::File)
+        mEditFilter->setPlaceholderText(tr("Type to search files"));
+    else
+        mEditFilter->setPlaceholderText(tr("Type to search symbols"));
+    mEditFilter->blockSignals(true);
+    mEditFilter->clear();
+    mEditFilter->blockSignals(false);
+    mPattern.clear();
+    startMatching();
+    show();
+    mEditFilter->setFocus();
+}
+
+bool QuickOpenPopup::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == mEditFilter && event->type() == QEvent::KeyPress) {
+        QKeyEvent* keyEvent = static_cast<QKeyEvent*>(event);
+        switch(keyEvent->key()) {
+        case Qt::Key_Up:
+        case Qt::Key_Down:
+        case Qt::Key_PageUp:
+        case Qt::Key_PageDown: {
+            int row = mListView->currentIndex().row();
+            int pageSize = std::max(1, mListView->height() / std::max(1, mListView->sizeHintForRow(0)));
+            switch(keyEvent->key()) {
+            case Qt::Key_Up:
+                row--;
+                break;
+            case Qt::Key_Down:
+                row++;
+                break;
+            case Qt::Key_PageUp:
+                row-=pageSize;
+                break;
+            default:
+                row+=pageSize;
+            }
+            row = std::max(0, std::min(row, mModel->rowCount(QModelIndex())-1));
+            mListView->setCurrentIndex(mModel->index(row));
+            return true;
+        }
+        case Qt::Key_Return:
+        case Qt::Key_Enter:
+            onItemActivated(mListView->currentIndex());
+            return true;
+        case Qt::Key_Escape:
+            hide();
+            return true;
+        }
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
+void QuickOpenPopup::hideEvent(QHideEvent *event)
+{
+    mMatchTimer.stop();
+    mMatches.clear();
+    mModel->setItems(QList<PQuickOpenItem>());
+    QWidget::hideEvent(event);
+}
+
+void QuickOpenPopup::onTextChanged()
+{
+    QString pattern = mEditFilter->text().trimmed().toLower();
+    pattern.remove(' ');
+    if (pattern == mPattern)
+        return;
+    mPattern = pattern;
+    startMatching();
+}
+
+void QuickOpenPopup::onIndexUpdated()
+{
+    if (isVisible())
+        startMatching();
+}
+
+void QuickOpenPopup::continueMatching()
+{
+    mNextToMatch = mIndex->match(mType, mPattern, mNextToMatch, MatchSliceTime, mMatches);
+    updateResults();
+    if (mNextToMatch < mIndex->count(mType))
+        mMatchTimer.start();
+}
+
+void QuickOpenPopup::onItemActivated(const QModelIndex &index)
+{
+    PQuickOpenItem item = mModel->item(index.row());
+    if (!item)
+        return;
+    hide();
+    emit itemSelected(item);
+}
+
+void QuickOpenPopup::startMatching()
+{
+    mMatchTimer.stop();
+    mMatches.clear();
+    mNextToMatch = 0;
+    continueMatching();
+}
+
+void QuickOpenPopup::updateResults()
+{
+    // only keep the best ones, the rest are dropped for good
+    auto compare = [](const QuickOpenMatch& m1, const QuickOpenMatch& m2) {
+        if (m1.score != m2.score)
+            return m1.score > m2.score;
+        return m1.index < m2.index;
+    };
+    if (mMatches.count() > MaxResults) {
+        std::partial_sort(mMatches.begin(), mMatches.begin()+MaxResults,
+                          mMatches.end(), compare);
+        mMatches.resize(MaxResults);
+    } else {
+        std::sort(mMatches.begin(), mMatches.end(), compare);
+    }
+    PQuickOpenItem oldCurrent = mModel->item(mListView->currentIndex().row());
+    QList<PQuickOpenItem> items;
+    int currentRow = 0;
+    foreach (const QuickOpenMatch& match, mMatches) {
+        PQuickOpenItem item = mIndex->item(mType, match.index);
+        if (item == oldCurrent)
+            currentRow = items.count();
+        items.append(item);
+    }
+    mModel->setItems(items);
+    if (!items.isEmpty())
+        mListView->setCurrentIndex(mModel->index(currentRow));
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef QUICKOPENPOPUP_H
+#define QUICKOPENPOPUP_H
+
+#include <QAbstractListModel>
+#include <QWidget>
+#include <QTimer>
+#include "../quickopenindex.h"
+
+class QLineEdit;
+class QListView;
+
+class QuickOpenListModel: public QAbstractListModel {
+    Q_OBJECT
+public:
+    explicit QuickOpenListModel(QObject *parent = nullptr);
+    int rowCount(const QModelIndex &parent) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    void setItems(const QList<PQuickOpenItem>& items);
+    PQuickOpenItem item(int row) const;
+private:
+    QList<PQuickOpenItem> mItems;
+};
+
+class QuickOpenPopup : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit QuickOpenPopup(QuickOpenIndex* index, QWidget* parent=nullptr);
+    void popup(QuickOpenItemType type);
+signals:
+    void itemSelected(PQuickOpenItem item);
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+private slots:
+    void onTextChanged();
+    void onIndexUpdated();
+    void continueMatching();
+    void onItemActivated(const QModelIndex& index);
+private:
+    void startMatching();
+    void updateResults();
+private:
+    QuickOpenIndex* mIndex;
+    QuickOpenItemType mType;
+    QLineEdit* mEditFilter;
+    QListView* mListView;
+    QuickOpenListModel* mModel;
+    QTimer mMatchTimer;
+    QString mPattern;
+    int mNextToMatch;
+    QVector<QuickOpenMatch> mMatches;
+};
+
+#endif // QUICKOPENPOPUP_H
@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "runconsole.h"
+
+#include <QFontMetrics>
+#include <QKeyEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <cstdlib>
+
+static const QRgb StandardColors[16] = {
+    0x000000, 0xcd0000, 0x00cd00, 0xcdcd00, 0x0000ee, 0xcd00cd, 0x00cdcd, 0xe5e5e5,
+    0x7f7f7f, 0xff0000, 0x00ff00, 0xffff00, 0x5c5cff, 0xff00ff, 0x00ffff, 0xffffff
+};
+
+RunConsole::RunConsole(QWidget *parent):
+    QAbstractScrollArea(parent),
+    mScreen(std::make_shared<TerminalScreen>()),
+    mTopLine(0),
+    mFirstLineNumber(0),
+    mCursorLineNumber(0),
+    mFollowOutput(true),
+    mUpdatingScrollBar(false)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    viewport()->setCursor(Qt::IBeamCursor);
+    mRefreshTimer.setInterval(RefreshInterval);
+    connect(&mRefreshTimer, &QTimer::timeout, this, &RunConsole::refresh);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &RunConsole::onScrollBarValueChanged);
+    updateFontMetrics();
+}
+
+const PTerminalScreen &RunConsole::screen() const
+{
+    return mScreen;
+}
+
+void RunConsole::clear()
+{
+    {
+        QMutexLocker locker(mScreen->mutex());
+        mScreen->reset();
+    }
+    mFollowOutput = true;
+    refresh();
+}
+
+void RunConsole::startRefreshing()
+{
+    mRefreshTimer.start();
+}
+
+void RunConsole::stopRefreshing()
+{
+    mRefreshTimer.stop();
+    // show the output written after the last refresh
+    refresh();
+}
+
+void RunConsole::refresh()
+{
+    QMutexLocker locker(mScreen->mutex());
+    TerminalDamage damage = mScreen->takeDamage();
+    qint64 cursorLineNumber = mScreen->firstLineNumber() + mScreen->cursorLine();
+    if (damage.firstLine < 0 && !damage.reset && cursorLineNumber == mCursorLineNumber)
+        return;
+    int rows = visibleRows();
+    mFirstLineNumber = mScreen->firstLineNumber();
+    int maxTop = std::max(0, mScreen->lineCount() - rows);
+    qint64 newTop;
+    if (mFollowOutput)
+        newTop = mFirstLineNumber + maxTop;
+    else
+        newTop = std::max(mFirstLineNumber, std::min(mTopLine, mFirstLineNumber + maxTop));
+    mUpdatingScrollBar = true;
+    verticalScrollBar()->setRange(0, maxTop);
+    verticalScrollBar()->setPageStep(rows);
+    verticalScrollBar()->setValue(newTop - mFirstLineNumber);
+    mUpdatingScrollBar = false;
+
+    qint64 delta = newTop - mTopLine;
+    mTopLine = newTop;
+    if (damage.reset || std::abs(delta) >= rows) {
+        viewport()->update();
+    } else {
+        if (delta != 0)
+            viewport()->scroll(0, -delta * mLineHeight);
+        if (damage.firstLine >= 0)
+            updateRows(damage.firstLine, damage.lastLine);
+        // the cursor may be moved without writing
+        updateRows(mCursorLineNumber, mCursorLineNumber);
+        updateRows(cursorLineNumber, cursorLineNumber);
+    }
+    mCursorLineNumber = cursorLineNumber;
+}
+
+void RunConsole::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), palette().color(QPalette::Base));
+    painter.setFont(font());
+    int firstRow = event->rect().top() / mLineHeight;
+    int lastRow = event->rect().bottom() / mLineHeight;
+
+    QMutexLocker locker(mScreen->mutex());
+    // lines may be dropped after the last refresh
+    int topIndex = mTopLine - mScreen->firstLineNumber();
+    for (int row=firstRow;row<=lastRow;row++) {
+        int index = topIndex + row;
+        if (index < 0)
+            continue;
+        if (index >= mScreen->lineCount())
+            break;
+        paintLine(painter, mScreen->line(index), row * mLineHeight);
+    }
+    if (mScreen->cursorVisible()) {
+        int row = mScreen->cursorLine() - topIndex;
+        int column = std::min(mScreen->cursorColumn(), mScreen->columns()-1);
+        QRect rect(column * mCharWidth, row * mLineHeight, mCharWidth, mLineHeight);
+        if (hasFocus())
+            painter.fillRect(rect, palette().color(QPalette::Text));
+        else {
+            painter.setPen(palette().color(QPalette::Text));
+            painter.drawRect(rect.adjusted(0,0,-1,-1));
+        }
+    }
+}
+
+void RunConsole::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScreenSize();
+}
+
+void RunConsole::keyPressEvent(QKeyEvent *event)
+{
+    QByteArray data;
+    switch(event->key()) {
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        data = "\r";
+        break;
+    case Qt::Key_Backspace:
+        data = "\x7f";
+        break;
+    case Qt::Key_Tab:
+        data = "\t";
+        break;
+    case Qt::Key_Escape:
+        data = "\x1b";
+        break;
+    case Qt::Key_Up:
+        data = "\x1b[A";
+        break;
+    case Qt::Key_Down:
+        data = "\x1b[B";
+        break;
+    case Qt::Key_Right:
+        data = "\x1b[C";
+        break;
+    case Qt::Key_Left:
+        data = "\x1b[D";
+        break;
+    case Qt::Key_Home:
+        data = "\x1b[H";
+        break;
+    case Qt::Key_End:
+        data = "\x1b[F";
+        break;
+    case Qt::Key_Delete:
+        data = "\x1b[3~";
+        break;
+    case Qt::Key_PageUp:
+        if (event->modifiers() & Qt::ShiftModifier) {
+            verticalScrollBar()->triggerAction(QAbstractSlider::SliderPageStepSub);
+            return;
+        }
+        data = "\x1b[5~";
+        break;
+    case Qt::Key_PageDown:
+        if (event->modifiers() & Qt::ShiftModifier) {
+            verticalScrollBar()->triggerAction(QAbstractSlider::SliderPageStepAdd);
+            return;
+        }
+        data = "\x1b[6~";
+        break;
+    default:
+        if ((event->modifiers() & Qt::ControlModifier)
+                && event->key() >= Qt::Key_A && event->key() <= Qt::Key_Z) {
+            // Ctrl+C is turned into SIGINT by the terminal
+            data.append(char(event->key() - Qt::Key_A + 1));
+        } else {
+            data = event->text().toUtf8();
+        }
+    }
+    if (data.isEmpty()) {
+        QAbstractScrollArea::keyPressEvent(event);
+        return;
+    }
+    mFollowOutput = true;
+    emit inputReceived(data);
+}
+
+void RunConsole::focusInEvent(QFocusEvent *event)
+{
+    QAbstractScrollArea::focusInEvent(event);
+    viewport()->update();
+}
+
+void RunConsole::focusOutEvent(QFocusEvent *event)
+{
+    QAbstractScrollArea::focusOutEvent(event);
+    viewport()->update();
+}
+
+bool RunConsole::focusNextPrevChild(bool)
+{
+    // tab is sent to the program
+    return false;
+}
+
+void RunConsole::changeEvent(QEvent *event)
+{
+    QAbstractScrollArea::changeEvent(event);
+    if (event->type() == QEvent::FontChange) {
+        updateFontMetrics();
+        updateScreenSize();
+        viewport()->update();
+    }
+}
+
+void RunConsole::onScrollBarValueChanged(int value)
+{
+    if (mUpdatingScrollBar)
+        return;
+    mTopLine = mFirstLineNumber + value;
+    mFollowOutput = (value == verticalScrollBar()->maximum());
+    viewport()->update();
+}
+
+void RunConsole::updateFontMetrics()
+{
+    QFontMetrics metrics(font());
+    mCharWidth = std::max(1, metrics.horizontalAdvance("M"));
+    mLineHeight = std::max(1, metrics.height());
+    mAscent = metrics.ascent();
+}
+
+void RunConsole::updateScreenSize()
+{
+    int rows = std::max(1, viewport()->height() / mLineHeight);
+    int columns = std::max(1, viewport()->width() / mCharWidth);
+    {
+        QMutexLocker locker(mScreen->mutex());
+        if (rows == mScreen->rows() && columns == mScreen->columns())
+            return;
+        mScreen->resize(rows, columns);
+    }
+    emit sizeChanged(rows, columns);
+    refresh();
+}
+
+int RunConsole::visibleRows() const
+{
+    return std::max(1, viewport()->height() / mLineHeight);
+}
+
+void RunConsole::updateRows(qint64 firstLine, qint64 lastLine)
+{
+    int rows = visibleRows();
+    qint64 firstRow = std::max<qint64>(0, firstLine - mTopLine);
+    qint64 lastRow = std::min<qint64>(rows, lastLine - mTopLine);
+    if (firstRow > lastRow)
+        return;
+    viewport()->update(0, firstRow * mLineHeight,
+                       viewport()->width(), (lastRow - firstRow + 1) * mLineHeight);
+}
+
+QColor RunConsole::color(qint32 color, bool foreground) const
+{
+    if (color == TERMINAL_DEFAULT_COLOR)
+        return palette().color(foreground ? QPalette::Text : QPalette::Base);
+    if (color & TERMINAL_RGB_COLOR)
+        return QColor(color & 0xFFFFFF);
+    if (color < 16)
+        return QColor(StandardColors[color]);
+    if (color < 232) {
+        // 6x6x6 color cube
+        int index = color - 16;
+        auto level = [](int v) { return v == 0 ? 0 : 55 + v * 40; };
+        return QColor(level(index / 36), level((index / 6) % 6), level(index % 6));
+    }
+    int gray = 8 + (color - 232) * 10;
+    return QColor(gray, gray, gray);
+}
+
+void RunConsole::paintLine(QPainter &painter, const TerminalLine &line, int y)
+{
+    int i = 0;
+    while (i < line.count()) {
+        const TerminalCell& first = line[i];
+        if (first.ch == 0) {
+            i++;
+            continue;
+        }
+        // draw cells of the same style in one run,
+        // wide characters are drawn one by one to keep them on the grid
+        int j = i;
+        QString text;
+        bool wide = TerminalScreen::isWideChar(first.ch);
+        while (j < line.count()) {
+            const TerminalCell& cell = line[j];
+            if (cell.ch != 0) {
+                if (cell.foreground != first.foreground
+                        || cell.background != first.background
+                        || cell.attributes != first.attributes
+                        || TerminalScreen::isWideChar(cell.ch) != wide
+                        || (wide && j > i))
+                    break;
+                if (cell.ch > 0xFFFF) {
+                    text.append(QChar::highSurrogate(cell.ch));
+                    text.append(QChar::lowSurrogate(cell.ch));
+                } else
+                    text.append(QChar(static_cast<ushort>(cell.ch)));
+            }
+            j++;
+        }
+        QColor foreground = color(first.foreground, true);
+        QColor background = color(first.background, false);
+        if (first.attributes & taInverse)
+            std::swap(foreground, background);
+        QRect rect(i * mCharWidth, y, (j - i) * mCharWidth, mLineHeight);
+        if (first.background != TERMINAL_DEFAULT_COLOR || (first.attributes & taInverse))
+            painter.fillRect(rect, background);
+        QFont f = font();
+        f.setBold(first.attributes & taBold);
+        f.setUnderline(first.attributes & taUnderline);
+        painter.setFont(f);
+        painter.setPen(foreground);
+        painter.drawText(rect.left(), y + mAscent, text);
+        i = j;
+    }
+}
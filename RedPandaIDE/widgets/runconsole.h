@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef RUNCONSOLE_H
+#define RUNCONSOLE_H
+
+#include <QAbstractScrollArea>
+#include <QTimer>
+#include "terminalscreen.h"
+
+/**
+ * @brief Console showing the output of the program run in the IDE.
+ *
+ * The screen is filled by the runner thread. The console polls it for
+ * changed lines at most RefreshInterval ms apart, and repaints only those
+ * lines, so heavy output never floods the GUI thread.
+ */
+class RunConsole : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    explicit RunConsole(QWidget* parent = nullptr);
+
+    const PTerminalScreen& screen() const;
+    void clear();
+
+    static const int RefreshInterval = 30;
+
+signals:
+    void inputReceived(const QByteArray& data);
+    void sizeChanged(int rows, int columns);
+
+public slots:
+    void startRefreshing();
+    void stopRefreshing();
+    void refresh();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void focusInEvent(QFocusEvent *event) override;
+    void focusOutEvent(QFocusEvent *event) override;
+    bool focusNextPrevChild(bool next) override;
+    void changeEvent(QEvent *event) override;
+
+private slots:
+    void onScrollBarValueChanged(int value);
+
+private:
+    void updateFontMetrics();
+    void updateScreenSize();
+    int visibleRows() const;
+    void updateRows(qint64 firstLine, qint64 lastLine);
+    QColor color(qint32 color, bool foreground) const;
+    void paintLine(QPainter& painter, const TerminalLine& line, int y);
+
+private:
+    PTerminalScreen mScreen;
+    QTimer mRefreshTimer;
+    // number of the first line shown
+    qint64 mTopLine;
+    qint64 mFirstLineNumber;
+    qint64 mCursorLineNumber;
+    // scroll with the output if the last line is shown
+    bool mFollowOutput;
+    bool mUpdatingScrollBar;
+    int mCharWidth;
+    int mLineHeight;
+    int mAscent;
+};
+
+#endif // RUNCONSOLE_H
@@ -208,7 +208,7 @@ void SearchInFileDialog::doSearch(bool replace)
             if (progressDlg.wasCanceled())
                 break;
             Editor * e = pMainWindow->editorList()->getOpenedEditorByFilename(curFilename);
-            if (e) {
+            if (e && e->contentLoaded()) {
                 fileSearched++;
                 PSearchResultTreeItem parentItem = batchFindInEditor(
                             e,
@@ -0,0 +1,641 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "terminalscreen.h"
+
+#include <algorithm>
+
+static const int MaxCsiParams = 32;
+
+TerminalScreen::TerminalScreen(int rows, int columns, int maxLines):
+    mRows{std::max(1,rows)},
+    mColumns{std::max(1,columns)},
+    mMaxLines{std::max(maxLines,mRows)}
+{
+    reset();
+}
+
+void TerminalScreen::feed(const char *data, int length)
+{
+    int i=0;
+    while (i<length) {
+        unsigned char b = data[i];
+        switch (mState) {
+        case ParseState::Ground:
+            if (b>=0x20 && b<0x7f && mUtf8Remaining==0) {
+                int j=i+1;
+                while (j<length && (unsigned char)data[j]>=0x20 && (unsigned char)data[j]<0x7f)
+                    j++;
+                putAsciiRun(data+i, j-i);
+                i=j;
+                continue;
+            } else if (b>=0x80) {
+                if ((b & 0xC0) == 0x80) {
+                    if (mUtf8Remaining>0) {
+                        mUtf8Char = (mUtf8Char << 6) | (b & 0x3F);
+                        mUtf8Remaining--;
+                        if (mUtf8Remaining==0)
+                            putChar(mUtf8Char);
+                    } else {
+                        putChar(0xFFFD);
+                    }
+                } else {
+                    if (mUtf8Remaining>0)
+                        putChar(0xFFFD);
+                    if ((b & 0xE0) == 0xC0) {
+                        mUtf8Char = b & 0x1F;
+                        mUtf8Remaining = 1;
+                    } else if ((b & 0xF0) == 0xE0) {
+                        mUtf8Char = b & 0x0F;
+                        mUtf8Remaining = 2;
+                    } else if ((b & 0xF8) == 0xF0) {
+                        mUtf8Char = b & 0x07;
+                        mUtf8Remaining = 3;
+                    } else {
+                        mUtf8Remaining = 0;
+                        putChar(0xFFFD);
+                    }
+                }
+            } else {
+                if (mUtf8Remaining>0) {
+                    mUtf8Remaining = 0;
+                    putChar(0xFFFD);
+                }
+                if (b>=0x20 && b<0x7f)
+                    continue; // handled by the ascii run in the next loop
+                executeControl(b);
+            }
+            break;
+        case ParseState::Escape:
+            if (b=='[') {
+                mCsiParams.clear();
+                mCsiPrivate = false;
+                mState = ParseState::Csi;
+            } else if (b==']') {
+                mState = ParseState::Osc;
+            } else if (b=='(' || b==')' || b=='*' || b=='+') {
+                mState = ParseState::Charset;
+            } else if (b<0x20) {
+                executeControl(b);
+            } else {
+                mState = ParseState::Ground;
+                executeEscape(b);
+            }
+            break;
+        case ParseState::Csi:
+            if (b>='0' && b<='9') {
+                if (mCsiParams.isEmpty())
+                    mCsiParams.append(0);
+                int &param = mCsiParams.last();
+                if (param<100000)
+                    param = param*10 + (b-'0');
+            } else if (b==';' || b==':') {
+                if (mCsiParams.isEmpty())
+                    mCsiParams.append(0);
+                if (mCsiParams.count()<MaxCsiParams)
+                    mCsiParams.append(0);
+            } else if (b=='?' || b=='>' || b=='=' || b=='<') {
+                mCsiPrivate = true;
+            } else if (b>=0x40 && b<=0x7e) {
+                mState = ParseState::Ground;
+                executeCsi(b);
+            } else if (b<0x20) {
+                executeControl(b);
+            }
+            // intermediate bytes are ignored
+            break;
+        case ParseState::Osc:
+            if (b==0x07)
+                mState = ParseState::Ground;
+            else if (b==0x1b)
+                mState = ParseState::OscEscape;
+            break;
+        case ParseState::OscEscape:
+        case ParseState::Charset:
+            mState = ParseState::Ground;
+            break;
+        }
+        i++;
+    }
+}
+
+void TerminalScreen::feed(const QByteArray &data)
+{
+    feed(data.constData(), data.length());
+}
+
+void TerminalScreen::reset()
+{
+    mLines.clear();
+    mLines.push_back(TerminalLine());
+    mDroppedLines = 0;
+    mCursorLine = 0;
+    mCursorColumn = 0;
+    mCursorVisible = true;
+    mSavedCursorRow = 0;
+    mSavedCursorColumn = 0;
+    mForeground = TERMINAL_DEFAULT_COLOR;
+    mBackground = TERMINAL_DEFAULT_COLOR;
+    mAttributes = 0;
+    mState = ParseState::Ground;
+    mCsiParams.clear();
+    mCsiPrivate = false;
+    mUtf8Char = 0;
+    mUtf8Remaining = 0;
+    mDamageFirst = -1;
+    mDamageLast = -1;
+    mDamageReset = true;
+}
+
+void TerminalScreen::resize(int rows, int columns)
+{
+    rows = std::max(1,rows);
+    columns = std::max(1,columns);
+    if (rows == mRows && columns == mColumns)
+        return;
+    mRows = rows;
+    mColumns = columns;
+    mMaxLines = std::max(mMaxLines, mRows);
+    mCursorColumn = std::min(mCursorColumn, mColumns);
+    // lines are not wrapped again
+    mDamageReset = true;
+}
+
+int TerminalScreen::rows() const
+{
+    return mRows;
+}
+
+int TerminalScreen::columns() const
+{
+    return mColumns;
+}
+
+int TerminalScreen::maxLines() const
+{
+    return mMaxLines;
+}
+
+void TerminalScreen::setMaxLines(int newMaxLines)
+{
+    mMaxLines = std::max(newMaxLines, mRows);
+}
+
+int TerminalScreen::lineCount() const
+{
+    return mLines.size();
+}
+
+qint64 TerminalScreen::firstLineNumber() const
+{
+    return mDroppedLines;
+}
+
+const TerminalLine &TerminalScreen::line(int index) const
+{
+    return mLines[index];
+}
+
+QString TerminalScreen::lineText(int index) const
+{
+    QString result;
+    const TerminalLine& line = mLines[index];
+    result.reserve(line.count());
+    for (const TerminalCell& cell:line) {
+        if (cell.ch == 0)
+            continue;
+        if (cell.ch > 0xFFFF) {
+            result.append(QChar::highSurrogate(cell.ch));
+            result.append(QChar::lowSurrogate(cell.ch));
+        } else
+            result.append(QChar(static_cast<ushort>(cell.ch)));
+    }
+    return result;
+}
+
+int TerminalScreen::cursorLine() const
+{
+    return mCursorLine;
+}
+
+int TerminalScreen::cursorColumn() const
+{
+    return mCursorColumn;
+}
+
+bool TerminalScreen::cursorVisible() const
+{
+    return mCursorVisible;
+}
+
+TerminalDamage TerminalScreen::takeDamage()
+{
+    TerminalDamage damage{mDamageFirst, mDamageLast, mDamageReset};
+    mDamageFirst = -1;
+    mDamageLast = -1;
+    mDamageReset = false;
+    return damage;
+}
+
+QMutex *TerminalScreen::mutex()
+{
+    return &mMutex;
+}
+
+bool TerminalScreen::isWideChar(char32_t ch)
+{
+    if (ch < 0x1100)
+        return false;
+    return (ch <= 0x115F)
+            || (ch >= 0x2E80 && ch <= 0x303E)
+            || (ch >= 0x3041 && ch <= 0x33FF)
+            || (ch >= 0x3400 && ch <= 0x4DBF)
+            || (ch >= 0x4E00 && ch <= 0x9FFF)
+            || (ch >= 0xA000 && ch <= 0xA4CF)
+            || (ch >= 0xAC00 && ch <= 0xD7A3)
+            || (ch >= 0xF900 && ch <= 0xFAFF)
+            || (ch >= 0xFE30 && ch <= 0xFE4F)
+            || (ch >= 0xFF00 && ch <= 0xFF60)
+            || (ch >= 0xFFE0 && ch <= 0xFFE6)
+            || (ch >= 0x1F300 && ch <= 0x1F64F)
+            || (ch >= 0x1F900 && ch <= 0x1F9FF)
+            || (ch >= 0x20000 && ch <= 0x3FFFD);
+}
+
+void TerminalScreen::putChar(char32_t ch)
+{
+    int width = isWideChar(ch) ? 2 : 1;
+    if (mCursorColumn + width > mColumns) {
+        lineFeed();
+        mCursorColumn = 0;
+    }
+    TerminalLine& line = currentLine();
+    TerminalCell cell = blankCell();
+    cell.ch = ch;
+    cell.attributes = mAttributes;
+    for (int i=0;i<width;i++) {
+        while (line.count()<mCursorColumn)
+            line.append(blankCell());
+        if (mCursorColumn<line.count())
+            line[mCursorColumn] = cell;
+        else
+            line.append(cell);
+        mCursorColumn++;
+        cell.ch = 0;
+    }
+    markDamaged(mCursorLine);
+}
+
+void TerminalScreen::putAsciiRun(const char *data, int length)
+{
+    TerminalCell cell = blankCell();
+    cell.attributes = mAttributes;
+    TerminalLine* line = &currentLine();
+    markDamaged(mCursorLine);
+    for (int i=0;i<length;i++) {
+        if (mCursorColumn >= mColumns) {
+            lineFeed();
+            mCursorColumn = 0;
+            line = &currentLine();
+            markDamaged(mCursorLine);
+        }
+        cell.ch = static_cast<unsigned char>(data[i]);
+        if (mCursorColumn == line->count()) {
+            line->append(cell);
+        } else {
+            while (line->count()<mCursorColumn)
+                line->append(blankCell());
+            if (mCursorColumn == line->count())
+                line->append(cell);
+            else
+                (*line)[mCursorColumn] = cell;
+        }
+        mCursorColumn++;
+    }
+}
+
+void TerminalScreen::lineFeed()
+{
+    if (mCursorLine == lineCount()-1) {
+        appendLine();
+        mCursorLine = lineCount()-1;
+    } else {
+        mCursorLine++;
+    }
+    markDamaged(mCursorLine);
+}
+
+void TerminalScreen::carriageReturn()
+{
+    mCursorColumn = 0;
+}
+
+void TerminalScreen::executeControl(char ch)
+{
+    switch(ch) {
+    case '\r':
+        carriageReturn();
+        break;
+    case '\n':
+    case '\v':
+    case '\f':
+        lineFeed();
+        break;
+    case '\b':
+        if (mCursorColumn>0)
+            mCursorColumn = std::min(mCursorColumn, mColumns) - 1;
+        break;
+    case '\t':
+        mCursorColumn = std::min(mColumns-1, (mCursorColumn / 8 + 1) * 8);
+        break;
+    case 0x1b:
+        mState = ParseState::Escape;
+        break;
+    case 0x18:
+    case 0x1a:
+        mState = ParseState::Ground;
+        break;
+    default:
+        // bell and others
+        break;
+    }
+}
+
+void TerminalScreen::executeEscape(char ch)
+{
+    switch(ch) {
+    case '7':
+        mSavedCursorRow = mCursorLine - screenTop();
+        mSavedCursorColumn = mCursorColumn;
+        break;
+    case '8':
+        moveCursorTo(mSavedCursorRow, mSavedCursorColumn);
+        break;
+    case 'c':
+        reset();
+        break;
+    case 'D':
+        lineFeed();
+        break;
+    case 'E':
+        lineFeed();
+        carriageReturn();
+        break;
+    case 'M':
+        if (mCursorLine > screenTop())
+            mCursorLine--;
+        break;
+    default:
+        break;
+    }
+}
+
+void TerminalScreen::executeCsi(char command)
+{
+    if (mCsiPrivate) {
+        if ((command == 'h' || command == 'l') && mCsiParams.contains(25))
+            mCursorVisible = (command == 'h');
+        return;
+    }
+    int row = mCursorLine - screenTop();
+    switch(command) {
+    case 'A':
+        moveCursorTo(row - csiParam(0,1), mCursorColumn);
+        break;
+    case 'B':
+        moveCursorTo(row + csiParam(0,1), mCursorColumn);
+        break;
+    case 'C':
+        mCursorColumn = std::min(mColumns-1, mCursorColumn + csiParam(0,1));
+        break;
+    case 'D':
+        mCursorColumn = std::max(0, std::min(mCursorColumn, mColumns) - csiParam(0,1));
+        break;
+    case 'E':
+        moveCursorTo(row + csiParam(0,1), 0);
+        break;
+    case 'F':
+        moveCursorTo(row - csiParam(0,1), 0);
+        break;
+    case 'G':
+    case '`':
+        mCursorColumn = std::min(mColumns-1, csiParam(0,1) - 1);
+        break;
+    case 'H':
+    case 'f':
+        moveCursorTo(csiParam(0,1) - 1, csiParam(1,1) - 1);
+        break;
+    case 'd':
+        moveCursorTo(csiParam(0,1) - 1, mCursorColumn);
+        break;
+    case 'J':
+        eraseInDisplay(csiParam(0,0));
+        break;
+    case 'K':
+        eraseInLine(csiParam(0,0));
+        break;
+    case 'm':
+        selectGraphicRendition();
+        break;
+    case 's':
+        mSavedCursorRow = row;
+        mSavedCursorColumn = mCursorColumn;
+        break;
+    case 'u':
+        moveCursorTo(mSavedCursorRow, mSavedCursorColumn);
+        break;
+    default:
+        break;
+    }
+}
+
+void TerminalScreen::selectGraphicRendition()
+{
+    if (mCsiParams.isEmpty()) {
+        mForeground = TERMINAL_DEFAULT_COLOR;
+        mBackground = TERMINAL_DEFAULT_COLOR;
+        mAttributes = 0;
+        return;
+    }
+    for (int i=0;i<mCsiParams.count();i++) {
+        int param = mCsiParams[i];
+        if (param == 0) {
+            mForeground = TERMINAL_DEFAULT_COLOR;
+            mBackground = TERMINAL_DEFAULT_COLOR;
+            mAttributes = 0;
+        } else if (param == 1) {
+            mAttributes |= taBold;
+        } else if (param == 4) {
+            mAttributes |= taUnderline;
+        } else if (param == 7) {
+            mAttributes |= taInverse;
+        } else if (param == 22) {
+            mAttributes &= ~taBold;
+        } else if (param == 24) {
+            mAttributes &= ~taUnderline;
+        } else if (param == 27) {
+            mAttributes &= ~taInverse;
+        } else if (param >= 30 && param <= 37) {
+            mForeground = param - 30;
+        } else if (param == 39) {
+            mForeground = TERMINAL_DEFAULT_COLOR;
+        } else if (param >= 40 && param <= 47) {
+            mBackground = param - 40;
+        } else if (param == 49) {
+            mBackground = TERMINAL_DEFAULT_COLOR;
+        } else if (param >= 90 && param <= 97) {
+            mForeground = param - 90 + 8;
+        } else if (param >= 100 && param <= 107) {
+            mBackground = param - 100 + 8;
+        } else if (param == 38 || param == 48) {
+            qint32 color = TERMINAL_DEFAULT_COLOR;
+            if (i+2<mCsiParams.count() && mCsiParams[i+1] == 5) {
+                color = std::min(255, mCsiParams[i+2]);
+                i += 2;
+            } else if (i+4<mCsiParams.count() && mCsiParams[i+1] == 2) {
+                color = TERMINAL_RGB_COLOR
+                        | (std::min(255, mCsiParams[i+2]) << 16)
+                        | (std::min(255, mCsiParams[i+3]) << 8)
+                        | std::min(255, mCsiParams[i+4]);
+                i += 4;
+            } else {
+                break;
+            }
+            if (param == 38)
+                mForeground = color;
+            else
+                mBackground = color;
+        }
+    }
+}
+
+void TerminalScreen::eraseInDisplay(int mode)
+{
+    int top = screenTop();
+    switch(mode) {
+    case 0:
+        eraseInLine(0);
+        for (int i=mCursorLine+1;i<lineCount();i++)
+            mLines[i].clear();
+        markDamaged(mCursorLine, lineCount()-1);
+        break;
+    case 1:
+        for (int i=top;i<mCursorLine;i++)
+            mLines[i].clear();
+        eraseInLine(1);
+        markDamaged(top, mCursorLine);
+        break;
+    case 2:
+        for (int i=top;i<lineCount();i++)
+            mLines[i].clear();
+        markDamaged(top, lineCount()-1);
+        break;
+    case 3:
+        // also drop the scrollback
+        for (int i=top;i<lineCount();i++)
+            mLines[i].clear();
+        mLines.erase(mLines.begin(), mLines.begin()+top);
+        mDroppedLines += top;
+        mCursorLine -= top;
+        mDamageReset = true;
+        break;
+    }
+}
+
+void TerminalScreen::eraseInLine(int mode)
+{
+    TerminalLine& line = currentLine();
+    int column = std::min(mCursorColumn, mColumns);
+    switch(mode) {
+    case 0:
+        if (column < line.count())
+            line.resize(column);
+        break;
+    case 1:
+        for (int i=0;i<=column && i<mColumns;i++) {
+            if (i<line.count())
+                line[i] = blankCell();
+            else
+                line.append(blankCell());
+        }
+        break;
+    case 2:
+        line.clear();
+        break;
+    }
+    if (mode != 1 && mBackground != TERMINAL_DEFAULT_COLOR) {
+        while (line.count()<mColumns)
+            line.append(blankCell());
+    }
+    markDamaged(mCursorLine);
+}
+
+void TerminalScreen::moveCursorTo(int row, int column)
+{
+    row = std::max(0, std::min(mRows-1, row));
+    int index = screenTop() + row;
+    while (index >= lineCount())
+        appendLine();
+    mCursorLine = index;
+    mCursorColumn = std::max(0, std::min(mColumns-1, column));
+}
+
+int TerminalScreen::csiParam(int index, int defaultValue) const
+{
+    if (index >= mCsiParams.count() || mCsiParams[index] == 0)
+        return defaultValue;
+    return mCsiParams[index];
+}
+
+int TerminalScreen::screenTop() const
+{
+    return std::max(0, lineCount() - mRows);
+}
+
+TerminalLine &TerminalScreen::currentLine()
+{
+    return mLines[mCursorLine];
+}
+
+TerminalCell TerminalScreen::blankCell() const
+{
+    return TerminalCell{' ', mForeground, mBackground, 0};
+}
+
+void TerminalScreen::appendLine()
+{
+    mLines.push_back(TerminalLine());
+    if (lineCount() > mMaxLines) {
+        mLines.pop_front();
+        mDroppedLines++;
+        mCursorLine--;
+    }
+}
+
+void TerminalScreen::markDamaged(int index)
+{
+    qint64 line = mDroppedLines + index;
+    if (mDamageFirst < 0 || line < mDamageFirst)
+        mDamageFirst = line;
+    if (line > mDamageLast)
+        mDamageLast = line;
+}
+
+void TerminalScreen::markDamaged(int firstIndex, int lastIndex)
+{
+    markDamaged(firstIndex);
+    markDamaged(lastIndex);
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TERMINALSCREEN_H
+#define TERMINALSCREEN_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <deque>
+#include <memory>
+
+enum TerminalAttribute {
+    taBold = 0x1,
+    taUnderline = 0x2,
+    taInverse = 0x4
+};
+
+// default colors of the terminal
+#define TERMINAL_DEFAULT_COLOR -1
+// 24 bit colors are stored as TERMINAL_RGB_COLOR | 0xRRGGBB,
+// others are indexes in the 256 colors xterm palette
+#define TERMINAL_RGB_COLOR 0x1000000
+
+struct TerminalCell {
+    // 0 for the second column of wide characters
+    char32_t ch;
+    qint32 foreground;
+    qint32 background;
+    quint8 attributes;
+};
+
+using TerminalLine = QVector<TerminalCell>;
+
+/**
+ * @brief Lines changed since the last call of TerminalScreen::takeDamage()
+ *
+ * Lines are numbered from the first line ever written to the screen,
+ * so the numbers are still valid after old lines are dropped.
+ */
+struct TerminalDamage {
+    qint64 firstLine;
+    qint64 lastLine;
+    bool reset;
+};
+
+/**
+ * @brief Screen and scrollback of the integrated console.
+ *
+ * Understands the subset of VT100/xterm sequences used by console programs:
+ * cursor movement, erasing, colors (16, 256 and 24 bit) and text attributes.
+ * Other sequences are parsed and ignored.
+ *
+ * The screen is the last rows() lines. Older lines are kept as scrollback,
+ * at most maxLines() of them.
+ *
+ * It's written by the runner thread and painted by the GUI thread, both
+ * must lock mutex() when using it.
+ */
+class TerminalScreen
+{
+public:
+    explicit TerminalScreen(int rows=24, int columns=80, int maxLines=10000);
+    TerminalScreen(const TerminalScreen&)=delete;
+    TerminalScreen& operator=(const TerminalScreen&)=delete;
+
+    void feed(const char* data, int length);
+    void feed(const QByteArray& data);
+    void reset();
+    void resize(int rows, int columns);
+
+    int rows() const;
+    int columns() const;
+    int maxLines() const;
+    void setMaxLines(int newMaxLines);
+
+    // lines kept, including the screen
+    int lineCount() const;
+    // number of the oldest line kept
+    qint64 firstLineNumber() const;
+    const TerminalLine& line(int index) const;
+    QString lineText(int index) const;
+
+    // index of the cursor line in the lines kept
+    int cursorLine() const;
+    int cursorColumn() const;
+    bool cursorVisible() const;
+
+    TerminalDamage takeDamage();
+
+    QMutex *mutex();
+
+    static bool isWideChar(char32_t ch);
+private:
+    enum class ParseState {
+        Ground,
+        Escape,
+        Csi,
+        Osc,
+        OscEscape,
+        Charset
+    };
+    void putChar(char32_t ch);
+    void putAsciiRun(const char* data, int length);
+    void lineFeed();
+    void carriageReturn();
+    void executeControl(char ch);
+    void executeEscape(char ch);
+    void executeCsi(char command);
+    void selectGraphicRendition();
+    void eraseInDisplay(int mode);
+    void eraseInLine(int mode);
+    void moveCursorTo(int row, int column);
+    int csiParam(int index, int defaultValue) const;
+    int screenTop() const;
+    TerminalLine& currentLine();
+    TerminalCell blankCell() const;
+    void appendLine();
+    void markDamaged(int index);
+    void markDamaged(int firstIndex, int lastIndex);
+private:
+    std::deque<TerminalLine> mLines;
+    int mRows;
+    int mColumns;
+    int mMaxLines;
+    qint64 mDroppedLines;
+
+    int mCursorLine;
+    int mCursorColumn;
+    bool mCursorVisible;
+    int mSavedCursorRow;
+    int mSavedCursorColumn;
+
+    qint32 mForeground;
+    qint32 mBackground;
+    quint8 mAttributes;
+
+    ParseState mState;
+    QVector<int> mCsiParams;
+    bool mCsiPrivate;
+    // pending bytes of an utf-8 sequence
+    char32_t mUtf8Char;
+    int mUtf8Remaining;
+
+    qint64 mDamageFirst;
+    qint64 mDamageLast;
+    bool mDamageReset;
+
+    QMutex mMutex;
+};
+
+using PTerminalScreen = std::shared_ptr<TerminalScreen>;
+
+#endif // TERMINALSCREEN_H
@@ -37,18 +37,22 @@ target("RedPandaIDE")
         "main.cpp",
         "projectoptions.cpp",
         "settings.cpp",
+        "startuptasks.cpp",
         "syntaxermanager.cpp",
         "systemconsts.cpp",
         "utils.cpp",
         "visithistorymanager.cpp",
         -- compiler
+        "compiler/buildtimes.cpp",
         "compiler/compilerinfo.cpp",
+        "compiler/heapprofile.cpp",
         -- debugger
         "debugger/dapprotocol.cpp",
         "debugger/gdbmiresultparser.cpp",
         -- parser
         "parser/cpppreprocessor.cpp",
         "parser/cpptokenizer.cpp",
+        "parser/filetable.cpp",
         "parser/parserutils.cpp",
         -- problems
         "problems/freeprojectsetformat.cpp",
@@ -56,7 +60,9 @@ target("RedPandaIDE")
         "problems/problemcasevalidator.cpp",
         "utils/escape.cpp",
         "utils/font.cpp",
-        "utils/parsearg.cpp")
+        "utils/linediff.cpp",
+        "utils/parsearg.cpp",
+        "widgets/terminalscreen.cpp")
 
     add_moc_classes(
         "caretlist",
@@ -64,9 +70,11 @@ target("RedPandaIDE")
         "cpprefacter",
         "editor",
         "editorlist",
+        "filechangewatcher",
         "iconsmanager",
         "project",
         "projecttemplate",
+        "quickopenindex",
         "shortcutmanager",
         "symbolusagemanager",
         "thememanager",
@@ -113,6 +121,8 @@ target("RedPandaIDE")
         "widgets/ojproblemsetmodel",
         "widgets/qconsole",
         "widgets/qpatchedcombobox",
+        "widgets/quickopenpopup",
+        "widgets/runconsole",
         "widgets/searchresultview",
         "widgets/shortcutinputedit",
         "widgets/shrinkabletabwidget")
@@ -158,11 +168,13 @@ target("RedPandaIDE")
         "settingsdialog/toolsgeneralwidget",
         -- widgets
         "widgets/aboutdialog",
+        "widgets/buildtimesdialog",
         "widgets/choosethemedialog",
         "widgets/cpudialog",
         "widgets/custommakefileinfodialog",
         "widgets/editorfontdialog",
         "widgets/filepropertiesdialog",
+        "widgets/heapprofiledialog",
         "widgets/infomessagebox",
         "widgets/newclassdialog",
         "widgets/newheaderdialog",
@@ -188,6 +200,8 @@ target("RedPandaIDE")
             "settingsdialog/environmentfileassociationwidget",
             "settingsdialog/projectversioninfowidget")
     else
+        add_moc_classes(
+            "compiler/ptyrunner")
         add_ui_classes(
             "settingsdialog/formatterpathwidget")
     end
@@ -215,6 +229,7 @@ target("RedPandaIDE")
     end
 
     if has_config("vcs") then
+        add_files("vcs/linechangetracker.cpp")
         add_moc_classes(
             "vcs/gitmanager",
             "vcs/gitrepository",
@@ -241,6 +256,8 @@ target("RedPandaIDE")
     end
     if is_os("windows") then
         add_links("psapi", "shlwapi")
+    elseif is_os("linux") then
+        add_syslinks("util")
     end
 
     -- install
@@ -258,3 +275,108 @@ target("test-escape")
 
     add_files("utils/escape.cpp", "test/escape.cpp")
     add_includedirs(".")
+
+target("test-terminal-screen")
+    set_kind("binary")
+    add_rules("qt.console")
+
+    set_default(false)
+    add_tests("test-terminal-screen")
+
+    add_files("widgets/terminalscreen.cpp", "test/terminalscreen.cpp")
+    add_includedirs(".")
+
+-- throughput run, not part of the tests: xmake build bench-terminal-screen && xmake run bench-terminal-screen
+target("bench-terminal-screen")
+    set_kind("binary")
+    add_rules("qt.console")
+
+    set_default(false)
+
+    add_files("widgets/terminalscreen.cpp", "test/terminalscreenbench.cpp")
+    add_includedirs(".")
+
+target("test-file-table")
+    set_kind("binary")
+    add_rules("qt.console")
+    add_deps("redpanda_qt_utils")
+
+    set_default(false)
+    add_tests("test-file-table")
+
+    add_files("parser/filetable.cpp", "parser/parserutils.cpp", "test/filetable.cpp")
+    add_includedirs(".")
+
+-- lookup benchmark, not part of the tests: xmake build bench-file-table && xmake run bench-file-table
+target("bench-file-table")
+    set_kind("binary")
+    add_rules("qt.console")
+    add_deps("redpanda_qt_utils")
+
+    set_default(false)
+
+    add_files("parser/filetable.cpp", "parser/parserutils.cpp", "test/filetablebench.cpp")
+    add_includedirs(".")
+
+target("test-line-diff")
+    set_kind("binary")
+    add_rules("qt.console")
+
+    set_default(false)
+    add_tests("test-line-diff")
+
+    add_files("utils/linediff.cpp", "test/linediff.cpp")
+    add_includedirs(".")
+
+target("test-build-times")
+    set_kind("binary")
+    add_rules("qt.console")
+    add_deps("redpanda_qt_utils")
+
+    set_default(false)
+    add_tests("test-build-times")
+
+    add_files("compiler/buildtimes.cpp", "utils/parsearg.cpp", "test/buildtimes.cpp")
+    add_includedirs(".")
+
+target("test-heap-profile")
+    set_kind("binary")
+    add_rules("qt.console")
+
+    set_default(false)
+    add_tests("test-heap-profile")
+
+    add_files("compiler/heapprofile.cpp", "test/heapprofile.cpp")
+    add_includedirs(".")
+
+target("test-file-change-watcher")
+    set_kind("binary")
+    add_rules("qt.console")
+    add_deps("redpanda_qt_utils")
+
+    set_default(false)
+    add_tests("test-file-change-watcher")
+
+    add_moc_classes("filechangewatcher")
+    add_files("test/filechangewatcher.cpp")
+    add_includedirs(".")
+
+target("test-startup-tasks")
+    set_kind("binary")
+    add_rules("qt.console")
+
+    set_default(false)
+    add_tests("test-startup-tasks")
+
+    add_files("startuptasks.cpp", "test/startuptasks.cpp")
+    add_includedirs(".")
+
+target("test-parse-result-queue")
+    set_kind("binary")
+    add_rules("qt.console")
+
+    set_default(false)
+    add_tests("test-parse-result-queue")
+
+    add_files("test/parseresultqueue.cpp")
+    add_includedirs(".")
@@ -35,6 +35,13 @@ SUBDIRS += \
     RedPandaIDE.depends += redpanda-git-askpass
 }
 
+linux: {
+SUBDIRS += \
+    heapprofiler
+    heapprofiler.subdir = tools/heapprofiler
+    RedPandaIDE.depends += heapprofiler
+}
+
 unix:!macos: {
     isEmpty(PREFIX) {
         PREFIX = /usr/local
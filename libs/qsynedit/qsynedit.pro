@@ -31,9 +31,12 @@ msvc {
 SOURCES += qsynedit/codefolding.cpp \
     qsynedit/constants.cpp \
     qsynedit/document.cpp \
+    qsynedit/filewriter.cpp \
     qsynedit/formatter/cppformatter.cpp \
     qsynedit/formatter/formatter.cpp \
     qsynedit/keystrokes.cpp \
+    qsynedit/linewrap.cpp \
+    qsynedit/minimap.cpp \
     qsynedit/miscprocs.cpp \
     qsynedit/exporter/exporter.cpp \
     qsynedit/exporter/htmlexporter.cpp \
@@ -58,9 +61,12 @@ HEADERS += \
     qsynedit/codefolding.h \
     qsynedit/constants.h \
     qsynedit/document.h \
+    qsynedit/filewriter.h \
     qsynedit/formatter/cppformatter.h \
     qsynedit/formatter/formatter.h \
     qsynedit/keystrokes.h \
+    qsynedit/linewrap.h \
+    qsynedit/minimap.h \
     qsynedit/miscprocs.h \
     qsynedit/types.h \
     qsynedit/exporter/exporter.h \
@@ -16,6 +16,7 @@
  */
 #include "codefolding.h"
 #include "constants.h"
+#include <algorithm>
 
 
 namespace QSynedit {
@@ -122,4 +123,80 @@ const QVector<PCodeFoldingRange> &CodeFoldingRanges::ranges() const
     return mRanges;
 }
 
+CollapsedFoldIndex::CollapsedFoldIndex():
+    mValid{false},
+    mRevision{0}
+{
+
+}
+
+void CollapsedFoldIndex::rebuild(const PCodeFoldingRanges &allFoldRanges)
+{
+    mFromLines.clear();
+    mToLines.clear();
+    mHiddenBefore.clear();
+    mFromRows.clear();
+    int hidden = 0;
+    foreach (const PCodeFoldingRange& range, allFoldRanges->ranges()) {
+        if (!range->collapsed || range->parentCollapsed())
+            continue;
+        mFromLines.append(range->fromLine);
+        mToLines.append(range->toLine);
+        mHiddenBefore.append(hidden);
+        mFromRows.append(range->fromLine - hidden);
+        hidden += range->linesCollapsed;
+    }
+    mHiddenBefore.append(hidden);
+    mValid = true;
+    mRevision++;
+}
+
+void CollapsedFoldIndex::invalidate()
+{
+    mValid = false;
+}
+
+bool CollapsedFoldIndex::isValid() const
+{
+    return mValid;
+}
+
+int CollapsedFoldIndex::revision() const
+{
+    return mRevision;
+}
+
+const QVector<int> &CollapsedFoldIndex::fromLines() const
+{
+    return mFromLines;
+}
+
+const QVector<int> &CollapsedFoldIndex::toLines() const
+{
+    return mToLines;
+}
+
+int CollapsedFoldIndex::count() const
+{
+    return mFromLines.count();
+}
+
+int CollapsedFoldIndex::rowToLine(int row) const
+{
+    // skip all folds starting at the rows before
+    int i = std::lower_bound(mFromRows.begin(), mFromRows.end(), row) - mFromRows.begin();
+    return row + mHiddenBefore[i];
+}
+
+int CollapsedFoldIndex::lineToRow(int line) const
+{
+    // folds ending before the line
+    int i = std::lower_bound(mToLines.begin(), mToLines.end(), line) - mToLines.begin();
+    int row = line - mHiddenBefore[i];
+    // lines inside a fold are shown on its first line
+    if (i < mFromLines.count() && mFromLines[i] < line)
+        row -= line - mFromLines[i];
+    return row;
+}
+
 }
@@ -76,5 +76,31 @@ public:
     void move(int count);
 };
 
+// The collapsed folds that are not inside other collapsed folds, sorted by line.
+// They don't overlap, so rows and lines can be mapped with binary searches.
+class CollapsedFoldIndex {
+public:
+    explicit CollapsedFoldIndex();
+    void rebuild(const PCodeFoldingRanges& allFoldRanges);
+    void invalidate();
+    bool isValid() const;
+    int count() const;
+    int rowToLine(int row) const;
+    int lineToRow(int line) const;
+    // changed each time the index is rebuilt
+    int revision() const;
+    const QVector<int>& fromLines() const;
+    const QVector<int>& toLines() const;
+private:
+    bool mValid;
+    int mRevision;
+    QVector<int> mFromLines;
+    QVector<int> mToLines;
+    // number of lines hidden by the folds before the i-th fold
+    QVector<int> mHiddenBefore;
+    // the row of the i-th fold's first line, ascending
+    QVector<int> mFromRows;
+};
+
 }
 #endif // CODEFOLDING_H
@@ -15,6 +15,7 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "document.h"
+#include "filewriter.h"
 #include "qt_utils/utils.h"
 #include <QDataStream>
 #include <QFile>
@@ -43,15 +44,13 @@ Document::Document(const QFont& font, QObject *parent):
 {
     mAppendNewLineAtEOF = true;
     mNewlineType = NewlineType::Windows;
-    mIndexOfLongestLine = -1;
+    mNotifiedMaxLineWidth = 0;
     mUpdateCount = 0;
     mCharWidth =  mFontMetrics.horizontalAdvance("M");
     mSpaceWidth = mFontMetrics.horizontalAdvance(" ");
     mUpdateDocumentLineWidthFunc = std::bind(&Document::calcLineWidth,
         this,
-        std::placeholders::_1,
-        std::placeholders::_2,
-        std::placeholders::_3);
+        std::placeholders::_1);
 }
 
 static void listIndexOutOfBounds(int index) {
@@ -143,23 +142,9 @@ int Document::blockEnded(int line)
 
 int Document::maxLineWidth() {
     QMutexLocker locker(&mMutex);
-    if (mIndexOfLongestLine < 0) {
-        int MaxLen = -1;
-        mIndexOfLongestLine = -1;
-        if (mLines.count() > 0 ) {
-            for (int i=0;i<mLines.size();i++) {
-                int len = mLines[i]->mWidth;
-                if (len > MaxLen) {
-                    MaxLen = len;
-                    mIndexOfLongestLine = i;
-                }
-            }
-        }
-    }
-    if (mIndexOfLongestLine >= 0)
-        return mLines[mIndexOfLongestLine]->width();
-    else
+    if (mLineWidthCounts.empty())
         return 0;
+    return mLineWidthCounts.rbegin()->first;
 }
 
 QString Document::lineBreak() const
@@ -192,7 +177,7 @@ void Document::insertItem(int line, const QString &s)
     PDocumentLine documentLine = std::make_shared<DocumentLine>(
                 mUpdateDocumentLineWidthFunc);
     documentLine->setLineText(s);
-    mIndexOfLongestLine = -1;
+    countLineWidth(*documentLine, estimateLineWidth(*documentLine));
     mLines.insert(line,documentLine);
     endUpdate();
 }
@@ -202,7 +187,7 @@ void Document::addItem(const QString &s)
     beginUpdate();
     PDocumentLine line = std::make_shared<DocumentLine>(mUpdateDocumentLineWidthFunc);
     line->setLineText(s);
-    mIndexOfLongestLine = -1;
+    countLineWidth(*line, estimateLineWidth(*line));
     mLines.append(line);
     endUpdate();
 }
@@ -246,6 +231,35 @@ int Document::getLineGlyphsCount(int line)
     return mLines[line]->glyphsCount();
 }
 
+QStringList Document::getLines(int startLine, int count, SyntaxState &stateBefore)
+{
+    QMutexLocker locker(&mMutex);
+    QStringList result;
+    if (startLine>0 && startLine<=mLines.count())
+        stateBefore = mLines[startLine-1]->syntaxState();
+    else
+        stateBefore = SyntaxState();
+    int endLine = std::min(startLine+count, (int)mLines.count());
+    for (int i=std::max(startLine,0);i<endLine;i++)
+        result.append(mLines[i]->lineText());
+    return result;
+}
+
+int Document::getLineGlyphs(int line, QString &lineText, QList<int> &glyphStartCharList, QList<int> &glyphStartPositionList)
+{
+    QMutexLocker locker(&mMutex);
+    if (line<0 || line>=mLines.count()) {
+        lineText.clear();
+        glyphStartCharList.clear();
+        glyphStartPositionList.clear();
+        return 0;
+    }
+    lineText = mLines[line]->lineText();
+    glyphStartCharList = mLines[line]->glyphStartCharList();
+    glyphStartPositionList = mLines[line]->glyphStartPositionList();
+    return mLines[line]->width();
+}
+
 // QList<int> Document::getGlyphPositions(int index)
 // {
 //     QMutexLocker locker(&mMutex);
@@ -282,7 +296,6 @@ void Document::setContents(const QStringList &text)
     });
     internalClear();
     if (text.count() > 0) {
-        mIndexOfLongestLine = -1;
         int FirstAdded = mLines.count();
 
         foreach (const QString& s,text) {
@@ -315,6 +328,7 @@ void Document::endUpdate()
 {
     mUpdateCount--;
     if (mUpdateCount == 0) {
+        notifyMaxLineWidth();
         setUpdateState(false);
     }
 }
@@ -335,7 +349,6 @@ void Document::addLines(const QStringList &strings)
 {
     QMutexLocker locker(&mMutex);
     if (strings.count() > 0) {
-        mIndexOfLongestLine = -1;
         beginUpdate();
         auto action = finally([this]{
             endUpdate();
@@ -382,17 +395,12 @@ void Document::deleteLines(int index, int numLines)
     auto action = finally([this]{
         endUpdate();
     });
-    if (mIndexOfLongestLine>=index) {
-        if (mIndexOfLongestLine <index+numLines) {
-            mIndexOfLongestLine = -1;
-        } else {
-            mIndexOfLongestLine -= numLines;
-        }
-    }
     int LinesAfter = mLines.count() - (index + numLines);
     if (LinesAfter < 0) {
        numLines = mLines.count() - index;
     }
+    for (int i=index;i<index+numLines;i++)
+        countLineWidth(*mLines[i], -1);
     mLines.remove(index,numLines);
     emit deleted(index,numLines);
 }
@@ -411,11 +419,6 @@ void Document::exchange(int index1, int index2)
     mLines[index1]=mLines[index2];
     mLines[index2]=temp;
     //mList.swapItemsAt(Index1,Index2);
-    if (mIndexOfLongestLine == index1) {
-        mIndexOfLongestLine = index2;
-    } else if (mIndexOfLongestLine == index2) {
-        mIndexOfLongestLine = index1;
-    }
     endUpdate();
 }
 
@@ -438,10 +441,7 @@ void Document::deleteAt(int index)
         listIndexOutOfBounds(index);
     }
     beginUpdate();
-    if (mIndexOfLongestLine == index)
-        mIndexOfLongestLine = -1;
-    else if (mIndexOfLongestLine>index)
-        mIndexOfLongestLine -= 1;
+    countLineWidth(*mLines[index], -1);
     mLines.removeAt(index);
     emit deleted(index,1);
     endUpdate();
@@ -470,12 +470,8 @@ void Document::putLine(int index, const QString &s, bool notify) {
             listIndexOutOfBounds(index);
         }
         beginUpdate();
-        int oldWidth = -1;
-        if (mIndexOfLongestLine == index)
-            oldWidth = mLines[index]->mWidth;
         mLines[index]->setLineText( s );
-        if (mIndexOfLongestLine == index && oldWidth>mLines[index]->width() )
-            mIndexOfLongestLine = -1;
+        countLineWidth(*mLines[index], estimateLineWidth(*mLines[index]));
         if (notify)
             emit putted(index);
         endUpdate();
@@ -502,11 +498,11 @@ void Document::insertLines(int index, int numLines)
     auto action = finally([this]{
         endUpdate();
     });
-    mIndexOfLongestLine = -1;
     PDocumentLine line;
     mLines.insert(index,numLines,line);
     for (int i=index;i<index+numLines;i++) {
         line = std::make_shared<DocumentLine>(mUpdateDocumentLineWidthFunc);
+        countLineWidth(*line, 0);
         mLines[i]=line;
     }
     emit inserted(index,numLines);
@@ -570,22 +566,6 @@ void Document::loadUTF32BOMFile(QFile &file)
     this->setText(text);
 }
 
-void Document::saveUTF16File(QFile &file, QTextCodec* codec)
-{
-    if (!codec)
-        return;
-    QString text=getTextStr();
-    file.write(codec->fromUnicode(text));
-}
-
-void Document::saveUTF32File(QFile &file, QTextCodec* codec)
-{
-    if (!codec)
-        return;
-    QString text=getTextStr();
-    file.write(codec->fromUnicode(text));
-}
-
 bool Document::forceMonospace() const
 {
     return mForceMonospace;
@@ -633,7 +613,6 @@ void Document::loadFromFile(const QString& filename, const QByteArray& encoding,
             emit inserted(0,mLines.count());
         endUpdate();
     });
-    mIndexOfLongestLine = -1;
     //test for utf8 / utf 8 bom
     if (encoding == ENCODING_AUTO_DETECT) {
         if (file.atEnd()) {
@@ -762,69 +741,12 @@ void Document::loadFromFile(const QString& filename, const QByteArray& encoding,
 
 
 
-void Document::saveToFile(QFile &file, const QByteArray& encoding,
+void Document::saveToFile(const QString& filename, const QByteArray& encoding,
                                    const QByteArray& defaultEncoding, QByteArray& realEncoding)
 {
-    QMutexLocker locker(&mMutex);
-    QTextCodec* codec;
-    realEncoding = encoding;
-    QString codecName = realEncoding;
-    if (realEncoding == ENCODING_UTF16_BOM || realEncoding == ENCODING_UTF16) {
-        codec = QTextCodec::codecForName(ENCODING_UTF16);
-        codecName = ENCODING_UTF16;
-    } else if (realEncoding == ENCODING_UTF32_BOM || realEncoding == ENCODING_UTF32) {
-        codec = QTextCodec::codecForName(ENCODING_UTF32);
-        codecName = ENCODING_UTF32;
-    } else if (realEncoding == ENCODING_UTF8_BOM) {
-        codec = QTextCodec::codecForName(ENCODING_UTF8);
-        codecName = ENCODING_UTF8;
-    } else if (realEncoding == ENCODING_SYSTEM_DEFAULT) {
-        codec = QTextCodec::codecForLocale();
-        codecName = realEncoding;
-    } else if (realEncoding == ENCODING_AUTO_DETECT) {
-        codec = QTextCodec::codecForName(defaultEncoding);
-        codecName = defaultEncoding;
-    } else {
-        codec = QTextCodec::codecForName(realEncoding);
-    }
-    if (!codec)
-        throw FileError(tr("Can't load codec '%1'!").arg(codecName));
-
-    if (!file.open(QFile::WriteOnly | QFile::Truncate))
-        throw FileError(tr("Can't open file '%1' for save!").arg(file.fileName()));
-    if (mLines.isEmpty())
-        return;
-    if (realEncoding == ENCODING_UTF16) {
-        saveUTF16File(file,codec);
-        return;
-    } else if (realEncoding == ENCODING_UTF32) {
-        saveUTF32File(file,codec);
-        return;
-    } if (realEncoding == ENCODING_UTF8_BOM) {
-        file.putChar(0xEF);
-        file.putChar(0xBB);
-        file.putChar(0xBF);
-    }
-    bool allAscii = true;
-    QByteArray data;
-    for (PDocumentLine& line:mLines) {
-        QString text = line->lineText()+lineBreak();
-        data = codec->fromUnicode(text);
-        if (allAscii) {
-            allAscii = (data==text.toLatin1());
-        }
-        if (file.write(data)!=data.size())
-            throw FileError(tr("Data not correctly writed to file '%1'.").arg(file.fileName()));
-    }
-    if (allAscii) {
-        realEncoding = ENCODING_ASCII;
-    } else if (realEncoding == ENCODING_SYSTEM_DEFAULT) {
-        if (QString(codec->name()).compare("System",Qt::CaseInsensitive)==0) {
-            realEncoding = pCharsetInfoManager->getDefaultSystemEncoding();
-        } else {
-            realEncoding = codec->name();
-        }
-    }
+    // the document is not locked while the lines are encoded and written
+    QStringList lines = contents();
+    saveLinesToFile(filename, lines, lineBreak(), encoding, defaultEncoding, realEncoding);
 }
 
 QString Document::glyph(int line, int glyphIdx)
@@ -986,9 +908,12 @@ int Document::charToGlyphIndex(const QString& str, QList<int> glyphStartCharList
     // return glyphStartCharList.length()-1;
 }
 
-QList<int> Document::calcLineWidth(const QString &lineText, const QList<int> &glyphStartCharList, int &width)
+void Document::calcLineWidth(DocumentLine &line)
 {
-    return calcGlyphPositionList(lineText,glyphStartCharList,0,width);
+    line.mGlyphStartPositionList = calcGlyphPositionList(line.mLineText, line.mGlyphStartCharList, 0, line.mWidth);
+    countLineWidth(line, line.mWidth);
+    if (mUpdateCount == 0)
+        notifyMaxLineWidth();
 }
 
 QList<int> Document::calcGlyphPositionList(const QString &lineText, const QList<int> &glyphStartCharList, const QFontMetrics &fontMetrics, int left, int &right) const
@@ -1156,8 +1081,8 @@ void Document::internalClear()
     if (!mLines.isEmpty()) {
         beginUpdate();
         int oldCount = mLines.count();
-        mIndexOfLongestLine = -1;
         mLines.clear();
+        mLineWidthCounts.clear();
         emit deleted(0,oldCount);
         endUpdate();
     }
@@ -1172,17 +1097,46 @@ void Document::setLineWidth(int line, const QString &lineText, int newWidth, con
         return;
     mLines[line]->mWidth = newWidth;
     mLines[line]->mGlyphStartPositionList = glyphStartPositionList;
-    updateLongestLineWidth(line , newWidth);
+    countLineWidth(*mLines[line], newWidth);
+    if (mUpdateCount == 0)
+        notifyMaxLineWidth();
     Q_ASSERT(mLines[line]->mGlyphStartPositionList.length() == mLines[line]->mGlyphStartCharList.length());
 }
 
-void Document::updateLongestLineWidth(int line, int width)
+int Document::estimateLineWidth(const DocumentLine &line) const
 {
-    if (mIndexOfLongestLine<0) {
-        mIndexOfLongestLine = line;
-        emit maxLineWidthChanged(width);
-    } else if (mLines[mIndexOfLongestLine]->mWidth < width) {
-        mIndexOfLongestLine = line;
+    if (line.mWidth >= 0)
+        return line.mWidth;
+    // every glyph is taken as wide as 'M', and tabs are expanded
+    int columns = 0;
+    for (int i=0;i<line.mGlyphStartCharList.length();i++) {
+        if (line.mLineText[line.mGlyphStartCharList[i]] == '\t')
+            columns += std::max(1, mTabSize) - (columns % std::max(1, mTabSize));
+        else
+            columns++;
+    }
+    return columns * mCharWidth;
+}
+
+void Document::countLineWidth(DocumentLine &line, int width)
+{
+    if (line.mCountedWidth == width)
+        return;
+    if (line.mCountedWidth >= 0) {
+        auto it = mLineWidthCounts.find(line.mCountedWidth);
+        if (it != mLineWidthCounts.end() && --(it->second) == 0)
+            mLineWidthCounts.erase(it);
+    }
+    line.mCountedWidth = width;
+    if (width >= 0)
+        mLineWidthCounts[width]++;
+}
+
+void Document::notifyMaxLineWidth()
+{
+    int width = mLineWidthCounts.empty() ? 0 : mLineWidthCounts.rbegin()->first;
+    if (width != mNotifiedMaxLineWidth) {
+        mNotifiedMaxLineWidth = width;
         emit maxLineWidthChanged(width);
     }
 }
@@ -1237,15 +1191,21 @@ bool Document::empty()
 void Document::invalidateAllLineWidth()
 {
     QMutexLocker locker(&mMutex);
-    mIndexOfLongestLine = -1;
+    // lines are measured again when they are shown
+    mLineWidthCounts.clear();
     for (PDocumentLine& line:mLines) {
         line->invalidateWidth();
+        line->mCountedWidth = -1;
+        countLineWidth(*line, estimateLineWidth(*line));
     }
+    if (mUpdateCount == 0)
+        notifyMaxLineWidth();
 }
 
 DocumentLine::DocumentLine(DocumentLine::UpdateWidthFunc updateWidthFunc):
     mSyntaxState{},
     mWidth{-1},
+    mCountedWidth{-1},
     mUpdateWidthFunc{updateWidthFunc}
 {
 }
@@ -1297,7 +1257,7 @@ void DocumentLine::setLineText(const QString &newLineText)
 void DocumentLine::updateWidth()
 {
     Q_ASSERT(mUpdateWidthFunc!=nullptr);
-    mGlyphStartPositionList = mUpdateWidthFunc(mLineText, mGlyphStartCharList, mWidth);
+    mUpdateWidthFunc(*this);
 //    qDebug()<<"Update Width"<<mLineText<<mWidth<<mGlyphPositionList;
 }
 
@@ -22,6 +22,7 @@
 #include <QFontMetrics>
 #include <QMutex>
 #include <QVector>
+#include <map>
 #include <memory>
 #include <QFile>
 #include "miscprocs.h"
@@ -55,7 +56,8 @@ using SearchConfirmAroundProc = std::function<bool ()>;
  */
 class DocumentLine {
 public:
-    using UpdateWidthFunc = std::function<QList<int>(const QString&, const QList<int> &, int &)>;
+    // measures the glyph positions and the width of the line
+    using UpdateWidthFunc = std::function<void(DocumentLine&)>;
 
     explicit DocumentLine(UpdateWidthFunc updateWidthFunc);
     DocumentLine(const DocumentLine&)=delete;
@@ -181,6 +183,12 @@ private:
      * so it must be recalculated each time the font is changed.
      */
     int mWidth;
+    /**
+     * @brief width of the line counted in the document's max line width
+     *
+     * It's estimated from the glyphs count until the line is measured.
+     */
+    int mCountedWidth;
 
     UpdateWidthFunc mUpdateWidthFunc;
 
@@ -294,7 +302,9 @@ public:
     int blockEnded(int line);
 
     /**
-     * @brief get index of the longest line (has the max width)
+     * @brief get the max width of the lines
+     *
+     * Lines not measured yet (not shown) are counted by their estimated width.
      *
      * It's thread safe.
      *
@@ -349,6 +359,32 @@ public:
      */
     int getLineGlyphsCount(int line);
 
+    /**
+     * @brief get text and glyphs of the specified line.
+     *
+     * It's thread safe.
+     *
+     * @param line line index (starts frome 0)
+     * @param lineText the line text
+     * @param glyphStartCharList start index of the chars of each glyph
+     * @param glyphStartPositionList start position (in pixels) of each glyph
+     * @return width of the line
+     */
+    int getLineGlyphs(int line, QString& lineText, QList<int>& glyphStartCharList,
+                      QList<int>& glyphStartPositionList);
+
+    /**
+     * @brief get text of the lines, and the syntax state of the line before them.
+     *
+     * It's thread safe.
+     *
+     * @param startLine index of the first line (starts frome 0)
+     * @param count count of the lines
+     * @param stateBefore syntax state at the end of the line before startLine
+     * @return text of the lines (lines out of range are not returned)
+     */
+    QStringList getLines(int startLine, int count, SyntaxState& stateBefore);
+
     // /**
     //  * @brief get position list of the glyphs on the specified line.
     //  *
@@ -424,7 +460,12 @@ public:
     void insertLines(int index, int numLines);
 
     void loadFromFile(const QString& filename, const QByteArray& encoding, QByteArray& realEncoding);
-    void saveToFile(QFile& file, const QByteArray& encoding,
+    /**
+     * @brief save a snapshot of the lines to the file, atomically
+     *
+     * It's thread safe. Throws FileError if the file can't be saved.
+     */
+    void saveToFile(const QString& filename, const QByteArray& encoding,
                     const QByteArray& defaultEncoding, QByteArray& realEncoding);
 
     QString glyph(int line, int glyphIdx);
@@ -577,7 +618,9 @@ protected:
     void internalClear();
 private:
     void setLineWidth(int line, const QString& lineText, int newWidth, const QList<int> glyphStartPositionList);
-    void updateLongestLineWidth(int line, int width);
+    int estimateLineWidth(const DocumentLine& line) const;
+    void countLineWidth(DocumentLine& line, int width);
+    void notifyMaxLineWidth();
 
     int glyphWidth(const QString& glyph, int left,
                    const QFontMetrics &fontMetrics,
@@ -585,7 +628,7 @@ private:
 
     int xposToGlyphIndex(int strWidth, QList<int> glyphPositionList, int xpos) const;
     int charToGlyphIndex(const QString& str, QList<int> glyphStartCharList, int charPos) const;
-    QList<int> calcLineWidth(const QString& lineText, const QList<int> &glyphStartCharList, int &width);
+    void calcLineWidth(DocumentLine& line);
     QList<int> calcGlyphPositionList(const QString& lineText, const QList<int> &glyphStartCharList,
                                      const QFontMetrics &fontMetrics,
                                      int left, int &right) const;
@@ -596,8 +639,6 @@ private:
     bool tryLoadFileByEncoding(QByteArray encodingName, QFile& file);
     void loadUTF16BOMFile(QFile& file);
     void loadUTF32BOMFile(QFile& file);
-    void saveUTF16File(QFile& file, QTextCodec* codec);
-    void saveUTF32File(QFile& file, QTextCodec* codec);
 
 private:
     DocumentLines mLines;
@@ -614,7 +655,9 @@ private:
     //int mCapacity;
     NewlineType mNewlineType;
     bool mAppendNewLineAtEOF;
-    int mIndexOfLongestLine;
+    // count of the lines of each width, so the max width is kept under edits
+    std::map<int,int> mLineWidthCounts;
+    int mNotifiedMaxLineWidth;
     int mUpdateCount;
     bool mForceMonospace;
 #if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
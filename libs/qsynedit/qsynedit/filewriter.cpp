@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "filewriter.h"
+#include "qt_utils/utils.h"
+#include "qt_utils/charsetinfo.h"
+#include <QCoreApplication>
+#include <QSaveFile>
+#include <QTextCodec>
+#include <memory>
+
+namespace QSynedit {
+
+// chars encoded at a time
+static const int ChunkSize = 64 * 1024;
+static const int Utf8MibEnum = 106;
+
+void saveLinesToFile(const QString &filename, const QStringList &lines, const QString &lineBreak,
+                     const QByteArray &encoding, const QByteArray &defaultEncoding,
+                     QByteArray &realEncoding)
+{
+    QTextCodec* codec;
+    realEncoding = encoding;
+    QString codecName = realEncoding;
+    if (realEncoding == ENCODING_UTF16_BOM || realEncoding == ENCODING_UTF16) {
+        codec = QTextCodec::codecForName(ENCODING_UTF16);
+        codecName = ENCODING_UTF16;
+    } else if (realEncoding == ENCODING_UTF32_BOM || realEncoding == ENCODING_UTF32) {
+        codec = QTextCodec::codecForName(ENCODING_UTF32);
+        codecName = ENCODING_UTF32;
+    } else if (realEncoding == ENCODING_UTF8_BOM) {
+        codec = QTextCodec::codecForName(ENCODING_UTF8);
+        codecName = ENCODING_UTF8;
+    } else if (realEncoding == ENCODING_SYSTEM_DEFAULT) {
+        codec = QTextCodec::codecForLocale();
+        codecName = realEncoding;
+    } else if (realEncoding == ENCODING_AUTO_DETECT) {
+        codec = QTextCodec::codecForName(defaultEncoding);
+        codecName = defaultEncoding;
+    } else {
+        codec = QTextCodec::codecForName(realEncoding);
+    }
+    // the messages share the translations of Document
+    if (!codec)
+        throw FileError(QCoreApplication::translate("QSynedit::Document", "Can't load codec '%1'!").arg(codecName));
+
+    QSaveFile file(filename);
+    // overwrite the file in place if the directory is not writable
+    file.setDirectWriteFallback(true);
+    if (!file.open(QFile::WriteOnly))
+        throw FileError(QCoreApplication::translate("QSynedit::Document", "Can't open file '%1' for save!").arg(filename));
+    if (!lines.isEmpty()) {
+        if (realEncoding == ENCODING_UTF8_BOM)
+            file.write("\xEF\xBB\xBF");
+        // utf-16/32 files don't end with a line break
+        bool endsWithLineBreak = (realEncoding != ENCODING_UTF16 && realEncoding != ENCODING_UTF32);
+        // ascii chars are encoded as is, unless it's an encoding like utf-16
+        const QString asciiChars("\t #09AZaz~");
+        bool allAscii = (codec->fromUnicode(asciiChars) == asciiChars.toLatin1());
+        bool isUtf8 = (codec->mibEnum() == Utf8MibEnum);
+        // the state is kept between chunks, so the bom is written only once
+        std::unique_ptr<QTextEncoder> encoder(codec->makeEncoder());
+        QString chunk;
+        chunk.reserve(ChunkSize);
+        auto writeChunk = [&]() {
+            QByteArray data;
+            if (allAscii)
+                allAscii = isTextAllAscii(chunk);
+            if (allAscii)
+                data = chunk.toLatin1();
+            else if (isUtf8)
+                data = chunk.toUtf8();
+            else
+                data = encoder->fromUnicode(chunk);
+            if (file.write(data) != data.size())
+                throw FileError(QCoreApplication::translate("QSynedit::Document", "Data not correctly writed to file '%1'.").arg(filename));
+            chunk.resize(0);
+        };
+        for (int i=0;i<lines.count();i++) {
+            chunk.append(lines[i]);
+            if (endsWithLineBreak || i < lines.count()-1)
+                chunk.append(lineBreak);
+            if (chunk.length() >= ChunkSize)
+                writeChunk();
+        }
+        if (!chunk.isEmpty())
+            writeChunk();
+        if (allAscii) {
+            realEncoding = ENCODING_ASCII;
+        } else if (realEncoding == ENCODING_SYSTEM_DEFAULT) {
+            if (QString(codec->name()).compare("System",Qt::CaseInsensitive)==0) {
+                realEncoding = pCharsetInfoManager->getDefaultSystemEncoding();
+            } else {
+                realEncoding = codec->name();
+            }
+        }
+    }
+    // flushed to the disk, and renamed to the file
+    if (!file.commit())
+        throw FileError(QCoreApplication::translate("QSynedit::Document", "Data not correctly writed to file '%1'.").arg(filename));
+}
+
+}
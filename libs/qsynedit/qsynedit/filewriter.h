@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FILEWRITER_H
+#define FILEWRITER_H
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+namespace QSynedit {
+
+/**
+ * @brief Save the lines to the file.
+ *
+ * The lines are encoded in chunks, and written to a temporary file in the same
+ * directory, which replaces the file after it's flushed to the disk. So the file
+ * is either saved or kept intact, even if the IDE crashes meanwhile.
+ *
+ * It only uses the arguments, and can be called from a worker thread.
+ * Throws FileError if the file can't be saved.
+ *
+ * @param realEncoding set to the encoding used, or ENCODING_ASCII if all the chars are ascii
+ */
+void saveLinesToFile(const QString& filename, const QStringList& lines, const QString& lineBreak,
+                     const QByteArray& encoding, const QByteArray& defaultEncoding,
+                     QByteArray& realEncoding);
+
+}
+
+#endif // FILEWRITER_H
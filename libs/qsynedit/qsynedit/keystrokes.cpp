@@ -242,6 +242,9 @@ void EditKeyStrokes::setExtraKeyStrokes()
     add(EditCommand::DeleteLine, Qt::Key_E, Qt::ControlModifier);
 
     add(EditCommand::SelectAll, Qt::Key_A, Qt::ControlModifier);
+    add(EditCommand::AddCaretAtNextOccurrence, Qt::Key_D, Qt::KeyboardModifiers(Qt::ControlModifier|Qt::AltModifier));
+    add(EditCommand::SelectAllOccurrences, Qt::Key_L, Qt::KeyboardModifiers(Qt::ControlModifier|Qt::ShiftModifier));
+    add(EditCommand::AddCaretsFromColumnSelection, Qt::Key_I, Qt::KeyboardModifiers(Qt::ShiftModifier|Qt::AltModifier));
     add(EditCommand::Copy, Qt::Key_C, Qt::ControlModifier);
     add(EditCommand::Paste, Qt::Key_V, Qt::ControlModifier);
     add(EditCommand::Cut, Qt::Key_X, Qt::ControlModifier);
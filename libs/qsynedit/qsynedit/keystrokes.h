@@ -96,6 +96,9 @@ enum class EditCommand {
     SelectAll       = 203,  // Select entire contents of editor, cursor to end
     ExpandSelection = 204,  // expand selection
     ShrinkSelection = 205,  // shrink selection
+    AddCaretAtNextOccurrence = 206, // add a caret at the next occurrence of the selection
+    SelectAllOccurrences = 207, // add a caret at each occurrence of the selection
+    AddCaretsFromColumnSelection = 208, // add a caret at each line of the column selection
 
     ScrollUp        = 211,  // Scroll up one line leaving cursor position unchanged.
     ScrollDown      = 212,  // Scroll down one line leaving cursor position unchanged.
@@ -0,0 +1,493 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "linewrap.h"
+#include <algorithm>
+#include <climits>
+
+namespace QSynedit {
+
+// lines in a block, blocks are split when they get twice as large
+static const int BlockSize = 256;
+
+LineWrapper::LineWrapper(const QString &text,
+                         const QList<int> &glyphStartCharList,
+                         const QList<int> &glyphStartPositionList,
+                         int lineWidth, int width):
+    mText{text},
+    mGlyphStartCharList{glyphStartCharList},
+    mGlyphStartPositionList{glyphStartPositionList},
+    mLineWidth{lineWidth},
+    mWidth{width},
+    mGlyphCount{std::min(glyphStartCharList.count(), glyphStartPositionList.count())},
+    mStart{0},
+    mDone{width <= 0 || lineWidth <= width || mGlyphCount == 0}
+{
+
+}
+
+bool LineWrapper::wrap(int maxRows)
+{
+    // the lists are shared with the document, don't detach them
+    const QList<int> &positions = mGlyphStartPositionList;
+    for (int i=0;i<maxRows && !mDone;i++) {
+        int limit = positions.at(mStart) + mWidth;
+        if (mLineWidth <= limit) {
+            mDone = true;
+            break;
+        }
+        // a glyph fits if the next one starts before the limit, so the glyph
+        // before the first one starting after the limit is the first not fitting
+        int end = std::upper_bound(positions.constBegin()+mStart+1,
+                                   positions.constBegin()+mGlyphCount,
+                                   limit) - positions.constBegin() - 1;
+        if (end <= mStart)
+            end = mStart + 1;
+        if (end >= mGlyphCount) {
+            mDone = true;
+            break;
+        }
+        if (!isSpace(end)) {
+            for (int j=end-1;j>mStart;j--) {
+                if (isSpace(j)) {
+                    end = j + 1;
+                    break;
+                }
+            }
+        }
+        mRowStarts.append(positions.at(end));
+        mStart = end;
+    }
+    return mDone;
+}
+
+bool LineWrapper::isDone() const
+{
+    return mDone;
+}
+
+const QVector<int> &LineWrapper::rowStarts() const
+{
+    return mRowStarts;
+}
+
+bool LineWrapper::isSpace(int glyph) const
+{
+    int ch = mGlyphStartCharList.at(glyph);
+    return ch < mText.length() && (mText.at(ch) == ' ' || mText.at(ch) == '\t');
+}
+
+LineWrapIndex::LineWrapIndex():
+    mTreeMask{0},
+    mLineCount{0},
+    mRowCount{0},
+    mUnmeasuredFrom{0},
+    mWrapperLine{-1}
+{
+
+}
+
+void LineWrapIndex::reset(int lineCount)
+{
+    mBlocks.clear();
+    mBlocks.resize((lineCount + BlockSize - 1) / BlockSize);
+    for (int i=0;i<mBlocks.count();i++) {
+        Block& block = mBlocks[i];
+        int count = std::min(BlockSize, lineCount - i * BlockSize);
+        block.rowStarts.resize(count);
+        block.measured.fill(false, count);
+        block.hidden.fill(false, count);
+        block.rows = count;
+    }
+    mUnmeasuredFrom = 0;
+    mWrapperLine = -1;
+    mWrapper.reset();
+    rebuildTree();
+}
+
+void LineWrapIndex::invalidateAll()
+{
+    for (Block& block: mBlocks)
+        block.measured.fill(false);
+    mUnmeasuredFrom = 0;
+    mWrapperLine = -1;
+    mWrapper.reset();
+}
+
+void LineWrapIndex::linesInserted(int line, int count)
+{
+    if (count <= 0)
+        return;
+    if (mWrapper && mWrapperLine >= line)
+        mWrapperLine += count;
+    mUnmeasuredFrom = std::min(mUnmeasuredFrom, line);
+    bool rebuild = false;
+    if (mBlocks.isEmpty()) {
+        mBlocks.resize(1);
+        mBlocks[0].rows = 0;
+        rebuild = true;
+    }
+    int b;
+    int index;
+    if (line >= mLineCount) {
+        b = mBlocks.count() - 1;
+        index = mBlocks[b].rowStarts.count();
+    } else {
+        b = findBlock(line, index);
+    }
+    Block& block = mBlocks[b];
+    block.rowStarts.insert(index, count, QVector<int>());
+    block.measured.insert(index, count, false);
+    block.hidden.insert(index, count, false);
+    block.rows += count;
+    if (block.rowStarts.count() > 2 * BlockSize) {
+        splitBlock(b);
+        rebuild = true;
+    }
+    if (rebuild)
+        rebuildTree();
+    else
+        addToTree(b, count, count);
+}
+
+void LineWrapIndex::linesDeleted(int line, int count)
+{
+    count = std::min(count, mLineCount - line);
+    if (count <= 0)
+        return;
+    if (mWrapper && mWrapperLine >= line + count) {
+        mWrapperLine -= count;
+    } else if (mWrapper && mWrapperLine >= line) {
+        mWrapperLine = -1;
+        mWrapper.reset();
+    }
+    mUnmeasuredFrom = std::min(mUnmeasuredFrom, line);
+    bool rebuild = false;
+    int index;
+    int b = findBlock(line, index);
+    // the deleted lines are in the block of the first one and the blocks after it
+    while (count > 0) {
+        Block& block = mBlocks[b];
+        int n = std::min(count, block.rowStarts.count() - index);
+        int rows = 0;
+        for (int i=index;i<index+n;i++)
+            rows += lineValue(block, i);
+        block.rowStarts.remove(index, n);
+        block.measured.remove(index, n);
+        block.hidden.remove(index, n);
+        block.rows -= rows;
+        count -= n;
+        if (block.rowStarts.isEmpty()) {
+            mBlocks.remove(b);
+            rebuild = true;
+        } else {
+            if (!rebuild)
+                addToTree(b, -n, -rows);
+            b++;
+        }
+        index = 0;
+    }
+    if (rebuild)
+        rebuildTree();
+    // blocks around the deleted lines may be left small
+    if (mLineCount > 0) {
+        b = (line < mLineCount) ? findBlock(line, index) : mBlocks.count() - 1;
+        bool merged = mergeBlock(b);
+        if (b > 0)
+            merged = mergeBlock(std::min(b, mBlocks.count() - 1) - 1) || merged;
+        if (merged)
+            rebuildTree();
+    }
+}
+
+void LineWrapIndex::lineChanged(int line)
+{
+    int index;
+    mBlocks[findBlock(line, index)].measured[index] = false;
+    mUnmeasuredFrom = std::min(mUnmeasuredFrom, line);
+    if (mWrapperLine == line) {
+        mWrapperLine = -1;
+        mWrapper.reset();
+    }
+}
+
+void LineWrapIndex::setHiddenLines(const QVector<int> &fromLines, const QVector<int> &toLines)
+{
+    QVector<bool> hidden(mLineCount, false);
+    for (int i=0;i<fromLines.count();i++) {
+        int end = std::min(toLines[i], mLineCount-1);
+        for (int line=fromLines[i]+1;line<=end;line++)
+            hidden[line] = true;
+    }
+    int line = 0;
+    for (Block& block: mBlocks) {
+        block.rows = 0;
+        for (int i=0;i<block.hidden.count();i++) {
+            block.hidden[i] = hidden[line++];
+            block.rows += lineValue(block, i);
+        }
+    }
+    rebuildTree();
+}
+
+int LineWrapIndex::lineCount() const
+{
+    return mLineCount;
+}
+
+int LineWrapIndex::rowCount() const
+{
+    return mRowCount;
+}
+
+bool LineWrapIndex::isMeasured(int line) const
+{
+    int index;
+    return mBlocks[findBlock(line, index)].measured[index];
+}
+
+int LineWrapIndex::nextUnmeasured()
+{
+    if (mUnmeasuredFrom >= mLineCount)
+        return -1;
+    int index;
+    for (int b = findBlock(mUnmeasuredFrom, index); b<mBlocks.count(); b++, index=0) {
+        const Block& block = mBlocks.at(b);
+        for (;index<block.measured.count();index++) {
+            if (!block.measured[index])
+                return mUnmeasuredFrom;
+            mUnmeasuredFrom++;
+        }
+    }
+    return -1;
+}
+
+int LineWrapIndex::setRowStarts(int line, const QVector<int> &rowStarts)
+{
+    if (mWrapperLine == line) {
+        mWrapperLine = -1;
+        mWrapper.reset();
+    }
+    int index;
+    int b = findBlock(line, index);
+    Block& block = mBlocks[b];
+    block.measured[index] = true;
+    int delta = rowStarts.count() - block.rowStarts[index].count();
+    block.rowStarts[index] = rowStarts;
+    if (delta != 0 && !block.hidden[index]) {
+        block.rows += delta;
+        addToTree(b, 0, delta);
+        return delta;
+    }
+    return 0;
+}
+
+const QVector<int> &LineWrapIndex::rowStarts(int line) const
+{
+    int index;
+    return mBlocks[findBlock(line, index)].rowStarts[index];
+}
+
+PLineWrapper LineWrapIndex::wrapper(int line) const
+{
+    if (mWrapperLine != line)
+        return PLineWrapper();
+    return mWrapper;
+}
+
+void LineWrapIndex::setWrapper(int line, const PLineWrapper &wrapper)
+{
+    mWrapperLine = line;
+    mWrapper = wrapper;
+}
+
+int LineWrapIndex::lineRows(int line) const
+{
+    if (line<0 || line >= mLineCount)
+        return 1;
+    int index;
+    return lineValue(mBlocks[findBlock(line, index)], index);
+}
+
+int LineWrapIndex::lineToRow(int line) const
+{
+    if (line >= mLineCount)
+        return mRowCount + line - mLineCount;
+    int index;
+    int b = findBlock(line, index);
+    const Block& block = mBlocks[b];
+    int row = rowsBefore(b);
+    for (int i=0;i<index;i++)
+        row += lineValue(block, i);
+    // hidden lines are shown on the last row of the fold
+    if (block.hidden[index])
+        return std::max(0, row - 1);
+    return row;
+}
+
+int LineWrapIndex::rowToLine(int row, int &wrapRow) const
+{
+    if (row >= mRowCount) {
+        wrapRow = 0;
+        return mLineCount + row - mRowCount;
+    }
+    // find the last block whose rows before are not more than the row.
+    // blocks taking no rows are skipped, because they don't change the sum
+    int b = 0;
+    int rest = row;
+    for (int step = mTreeMask; step > 0; step >>= 1) {
+        int next = b + step;
+        if (next <= mBlocks.count() && mRowTree[next] <= rest) {
+            b = next;
+            rest -= mRowTree[next];
+        }
+    }
+    const Block& block = mBlocks[b];
+    int line = linesBefore(b);
+    // lines taking no rows are skipped the same way
+    for (int i=0;i<block.rowStarts.count();i++) {
+        int value = lineValue(block, i);
+        if (rest < value) {
+            wrapRow = rest;
+            return line + i;
+        }
+        rest -= value;
+    }
+    wrapRow = 0;
+    return line + block.rowStarts.count();
+}
+
+QVector<int> LineWrapIndex::computeRowStarts(const QString &text,
+                                             const QList<int> &glyphStartCharList,
+                                             const QList<int> &glyphStartPositionList,
+                                             int lineWidth, int width)
+{
+    LineWrapper wrapper(text, glyphStartCharList, glyphStartPositionList, lineWidth, width);
+    wrapper.wrap(INT_MAX);
+    return wrapper.rowStarts();
+}
+
+int LineWrapIndex::lineValue(const Block &block, int index)
+{
+    if (block.hidden[index])
+        return 0;
+    return block.rowStarts[index].count() + 1;
+}
+
+int LineWrapIndex::findBlock(int line, int &index) const
+{
+    // find the last block whose lines before are not more than the line
+    int b = 0;
+    int rest = line;
+    for (int step = mTreeMask; step > 0; step >>= 1) {
+        int next = b + step;
+        if (next <= mBlocks.count() && mLineTree[next] <= rest) {
+            b = next;
+            rest -= mLineTree[next];
+        }
+    }
+    index = rest;
+    return b;
+}
+
+void LineWrapIndex::splitBlock(int block)
+{
+    const Block& large = mBlocks[block];
+    int count = large.rowStarts.count();
+    QVector<Block> blocks((count + BlockSize - 1) / BlockSize);
+    for (int i=0;i<blocks.count();i++) {
+        Block& small = blocks[i];
+        int from = i * BlockSize;
+        int n = std::min(BlockSize, count - from);
+        small.rowStarts = large.rowStarts.mid(from, n);
+        small.measured = large.measured.mid(from, n);
+        small.hidden = large.hidden.mid(from, n);
+        small.rows = 0;
+        for (int j=0;j<n;j++)
+            small.rows += lineValue(small, j);
+    }
+    mBlocks = mBlocks.mid(0, block) + blocks + mBlocks.mid(block + 1);
+}
+
+bool LineWrapIndex::mergeBlock(int block)
+{
+    if (block < 0 || block + 1 >= mBlocks.count())
+        return false;
+    Block& first = mBlocks[block];
+    const Block& second = mBlocks[block + 1];
+    if (first.rowStarts.count() + second.rowStarts.count() > BlockSize)
+        return false;
+    first.rowStarts += second.rowStarts;
+    first.measured += second.measured;
+    first.hidden += second.hidden;
+    first.rows += second.rows;
+    mBlocks.remove(block + 1);
+    return true;
+}
+
+void LineWrapIndex::rebuildTree()
+{
+    int n = mBlocks.count();
+    mLineTree.fill(0, n + 1);
+    mRowTree.fill(0, n + 1);
+    mLineCount = 0;
+    mRowCount = 0;
+    for (int i=1;i<=n;i++) {
+        const Block& block = mBlocks[i-1];
+        mLineCount += block.rowStarts.count();
+        mRowCount += block.rows;
+        mLineTree[i] += block.rowStarts.count();
+        mRowTree[i] += block.rows;
+        int parent = i + (i & -i);
+        if (parent <= n) {
+            mLineTree[parent] += mLineTree[i];
+            mRowTree[parent] += mRowTree[i];
+        }
+    }
+    mTreeMask = 1;
+    while (mTreeMask * 2 <= n)
+        mTreeMask *= 2;
+    if (n == 0)
+        mTreeMask = 0;
+}
+
+void LineWrapIndex::addToTree(int block, int lineDelta, int rowDelta)
+{
+    mLineCount += lineDelta;
+    mRowCount += rowDelta;
+    for (int i=block+1; i<mLineTree.count(); i += (i & -i)) {
+        mLineTree[i] += lineDelta;
+        mRowTree[i] += rowDelta;
+    }
+}
+
+int LineWrapIndex::linesBefore(int block) const
+{
+    int sum = 0;
+    for (int i=block; i>0; i -= (i & -i))
+        sum += mLineTree[i];
+    return sum;
+}
+
+int LineWrapIndex::rowsBefore(int block) const
+{
+    int sum = 0;
+    for (int i=block; i>0; i -= (i & -i))
+        sum += mRowTree[i];
+    return sum;
+}
+
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LINEWRAP_H
+#define LINEWRAP_H
+#include <memory>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+namespace QSynedit {
+
+/**
+ * @brief Breaks a line into rows not wider than a width, some rows at a time.
+ *
+ * Rows are broken after the last space if possible.
+ * Each row has at least one glyph.
+ *
+ * A line too long to be wrapped at once is wrapped by calling wrap() again
+ * until it's done.
+ */
+class LineWrapper {
+public:
+    explicit LineWrapper(const QString& text,
+                         const QList<int>& glyphStartCharList,
+                         const QList<int>& glyphStartPositionList,
+                         int lineWidth,
+                         int width);
+    // break at most maxRows more rows, returns true if the line is done
+    bool wrap(int maxRows);
+    bool isDone() const;
+    // x (in pixels) of the rows found so far but the first one
+    const QVector<int>& rowStarts() const;
+private:
+    bool isSpace(int glyph) const;
+private:
+    QString mText;
+    QList<int> mGlyphStartCharList;
+    QList<int> mGlyphStartPositionList;
+    int mLineWidth;
+    int mWidth;
+    int mGlyphCount;
+    // first glyph of the last row found
+    int mStart;
+    bool mDone;
+    QVector<int> mRowStarts;
+};
+
+using PLineWrapper = std::shared_ptr<LineWrapper>;
+
+/**
+ * @brief Maps display rows to lines when long lines are wrapped.
+ *
+ * Lines are kept in blocks of a few hundred lines. The lines and the rows
+ * of each block are summed in Fenwick trees, so a row can be mapped to its
+ * line (and back), and lines can be inserted or deleted, without going
+ * through all the lines.
+ * Lines hidden by collapsed folds take no rows.
+ *
+ * Lines are wrapped lazily: a line that is not measured yet keeps the rows
+ * it had (or one row), until setRowStarts() is called for it.
+ *
+ * All lines and rows are 0-based.
+ */
+class LineWrapIndex {
+public:
+    explicit LineWrapIndex();
+    void reset(int lineCount);
+    // keep the current rows, but measure all lines again (the wrap width is changed)
+    void invalidateAll();
+    void linesInserted(int line, int count);
+    void linesDeleted(int line, int count);
+    void lineChanged(int line);
+    // lines in (fromLines[i], toLines[i]] are hidden
+    void setHiddenLines(const QVector<int>& fromLines, const QVector<int>& toLines);
+
+    int lineCount() const;
+    int rowCount() const;
+    bool isMeasured(int line) const;
+    // first line not measured yet, -1 if all are measured
+    int nextUnmeasured();
+    /**
+     * @brief set where the rows of the line start
+     * @param line
+     * @param rowStarts x (in pixels) of the rows but the first one
+     * @return change of the line's row count
+     */
+    int setRowStarts(int line, const QVector<int>& rowStarts);
+    const QVector<int>& rowStarts(int line) const;
+    // wrapper of a line wrapped in slices, kept until the line is changed, deleted or measured
+    PLineWrapper wrapper(int line) const;
+    void setWrapper(int line, const PLineWrapper& wrapper);
+    // rows shown for the line, 0 if it's hidden
+    int lineRows(int line) const;
+    // the first row of the line
+    int lineToRow(int line) const;
+    int rowToLine(int row, int &wrapRow) const;
+
+    /**
+     * @brief break a line into rows not wider than width
+     *
+     * Rows are broken after the last space if possible.
+     * Each row has at least one glyph.
+     *
+     * @return x (in pixels) of the rows but the first one
+     */
+    static QVector<int> computeRowStarts(const QString& text,
+                                         const QList<int>& glyphStartCharList,
+                                         const QList<int>& glyphStartPositionList,
+                                         int lineWidth,
+                                         int width);
+private:
+    struct Block {
+        QVector<QVector<int>> rowStarts;
+        QVector<bool> measured;
+        QVector<bool> hidden;
+        // rows shown for the lines of the block
+        int rows;
+    };
+    static int lineValue(const Block& block, int index);
+    // the block holding the line, and the line's index in it
+    int findBlock(int line, int &index) const;
+    // split a block grown too large into blocks of BlockSize lines
+    void splitBlock(int block);
+    // merge a small block with a neighbour, returns true if merged
+    bool mergeBlock(int block);
+    void rebuildTree();
+    void addToTree(int block, int lineDelta, int rowDelta);
+    int linesBefore(int block) const;
+    int rowsBefore(int block) const;
+private:
+    QVector<Block> mBlocks;
+    // 1-based Fenwick trees of the lines and the rows in each block
+    QVector<int> mLineTree;
+    QVector<int> mRowTree;
+    int mTreeMask;
+    int mLineCount;
+    int mRowCount;
+    // no line before it is unmeasured
+    int mUnmeasuredFrom;
+    int mWrapperLine;
+    PLineWrapper mWrapper;
+};
+
+}
+#endif // LINEWRAP_H
@@ -0,0 +1,467 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "minimap.h"
+#include "qsynedit.h"
+#include <QCoreApplication>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QResizeEvent>
+#include <QWheelEvent>
+#include <cmath>
+
+namespace QSynedit {
+
+MiniMapRenderer::MiniMapRenderer(const PDocument &document, QObject *parent):
+    QThread{parent},
+    mDocument{document},
+    mStopped{false}
+{
+
+}
+
+void MiniMapRenderer::setSyntaxer(const PSyntaxer &syntaxer)
+{
+    QMutexLocker locker(&mMutex);
+    mSyntaxer = syntaxer;
+}
+
+void MiniMapRenderer::request(const MiniMapTileRequest &request)
+{
+    QMutexLocker locker(&mMutex);
+    for (int i=0;i<mRequests.count();i++) {
+        if (mRequests[i].id == request.id) {
+            mRequests.remove(i);
+            break;
+        }
+    }
+    mRequests.append(request);
+    mRequested.wakeOne();
+}
+
+void MiniMapRenderer::stop()
+{
+    QMutexLocker locker(&mMutex);
+    mStopped = true;
+    mRequests.clear();
+    mRequested.wakeOne();
+}
+
+void MiniMapRenderer::run()
+{
+    while (true) {
+        MiniMapTileRequest request;
+        PSyntaxer syntaxer;
+        {
+            QMutexLocker locker(&mMutex);
+            while (!mStopped && mRequests.isEmpty())
+                mRequested.wait(&mMutex);
+            if (mStopped)
+                return;
+            // the latest request is most likely to be visible
+            request = mRequests.takeLast();
+            syntaxer = mSyntaxer;
+        }
+        QImage image = renderTile(request, syntaxer);
+        emit tileRendered(request.id, request.revision, image);
+    }
+}
+
+static QRgb blendColor(const QColor& color, const QColor& background)
+{
+    // glyphs are drawn a bit faded, so the viewport frame stands out
+    return qRgb((color.red() * 3 + background.red()) / 4,
+                (color.green() * 3 + background.green()) / 4,
+                (color.blue() * 3 + background.blue()) / 4);
+}
+
+QImage MiniMapRenderer::renderTile(const MiniMapTileRequest &request, const PSyntaxer &syntaxer)
+{
+    SyntaxState state;
+    QStringList lines = mDocument->getLines(request.firstLine, request.lineCount, state);
+    QImage image(std::max(request.width, 1),
+                 std::max(request.lineCount * request.lineHeight, 1),
+                 QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(request.devicePixelRatio);
+    image.fill(request.background);
+
+    // each char takes one pixel, and leave a gap between lines if they are high enough
+    int charWidth = std::max(1, (int)std::round(request.devicePixelRatio));
+    int glyphHeight = request.lineHeight;
+    if (glyphHeight > charWidth)
+        glyphHeight -= charWidth;
+    int maxColumn = image.width() / charWidth;
+    QRgb defaultColor = blendColor(request.foreground, request.background);
+    int tabSize = std::max(request.tabSize, 1);
+
+    if (syntaxer) {
+        if (request.firstLine == 0)
+            syntaxer->resetState();
+        else
+            syntaxer->setState(state);
+    }
+    for (int i=0;i<lines.count();i++) {
+        const QString& line = lines[i];
+        int top = i * request.lineHeight;
+        int column = 0;
+        auto paintChars = [&](int start, int end, QRgb color) {
+            for (int j=start;j<end && column<maxColumn;j++) {
+                QChar ch = line[j];
+                if (ch == '\t') {
+                    column += tabSize - (column % tabSize);
+                    continue;
+                }
+                if (!ch.isSpace()) {
+                    for (int y=top;y<top+glyphHeight;y++) {
+                        QRgb* scanLine = reinterpret_cast<QRgb*>(image.scanLine(y));
+                        for (int x=column*charWidth;x<(column+1)*charWidth;x++)
+                            scanLine[x] = color;
+                    }
+                }
+                column++;
+            }
+        };
+        if (!syntaxer) {
+            paintChars(0, line.length(), defaultColor);
+            continue;
+        }
+        // the whole line is scanned, so the syntax state of the next line is right
+        syntaxer->setLine(line, request.firstLine + i);
+        while (!syntaxer->eol()) {
+            int start = syntaxer->getTokenPos();
+            int end = std::min(start + (int)syntaxer->getToken().length(), (int)line.length());
+            if (column < maxColumn) {
+                const PTokenAttribute& attr = syntaxer->getTokenAttribute();
+                QRgb color = defaultColor;
+                if (attr && attr->foreground().isValid())
+                    color = blendColor(attr->foreground(), request.background);
+                paintChars(start, end, color);
+            }
+            syntaxer->next();
+        }
+    }
+    return image;
+}
+
+MiniMap::MiniMap(QSynEdit *editor):
+    QWidget{editor},
+    mEditor{editor},
+    mLineCount{0},
+    mNextTileId{0},
+    mLineHeight{2}
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setCursor(Qt::ArrowCursor);
+    // the editor keeps the width, and sets the height to the viewport's
+    resize(100, editor->viewport()->height());
+    const PDocument& document = mEditor->document();
+    mRenderer = new MiniMapRenderer(document, this);
+    connect(mRenderer, &MiniMapRenderer::tileRendered,
+            this, &MiniMap::onTileRendered, Qt::QueuedConnection);
+    connect(document.get(), &Document::inserted, this, &MiniMap::onLinesInserted);
+    connect(document.get(), &Document::deleted, this, &MiniMap::onLinesDeleted);
+    connect(document.get(), &Document::putted, this, &MiniMap::onLinePutted);
+    connect(document.get(), &Document::cleared, this, &MiniMap::onLinesCleared);
+    connect(mEditor, &QSynEdit::statusChanged, this, [this](StatusChanges changes){
+        if (changes.testFlag(StatusChange::scTopLine)
+                || changes.testFlag(StatusChange::scAll))
+            update();
+    });
+    resetTiles(document->count());
+    mRenderer->start(QThread::LowPriority);
+}
+
+MiniMap::~MiniMap()
+{
+    mRenderer->stop();
+    mRenderer->wait();
+}
+
+void MiniMap::setSyntaxer(const PSyntaxer &syntaxer)
+{
+    mRenderer->setSyntaxer(syntaxer);
+    invalidateAll();
+}
+
+int MiniMap::lineHeight() const
+{
+    return mLineHeight;
+}
+
+void MiniMap::setLineHeight(int newLineHeight)
+{
+    newLineHeight = std::max(1, std::min(newLineHeight, 2));
+    if (mLineHeight != newLineHeight) {
+        mLineHeight = newLineHeight;
+        invalidateAll();
+    }
+}
+
+void MiniMap::paintEvent(QPaintEvent *)
+{
+    if (mRenderedForeground != mEditor->foregroundColor()
+            || mRenderedBackground != mEditor->backgroundColor()) {
+        mRenderedForeground = mEditor->foregroundColor();
+        mRenderedBackground = mEditor->backgroundColor();
+        invalidateAll();
+    }
+    QPainter painter(this);
+    painter.fillRect(rect(), mRenderedBackground);
+    int offset = scrollOffset();
+    int firstLine = offset / mLineHeight;
+    int lastLine = (offset + height()) / mLineHeight;
+    for (int i=std::max(findTile(firstLine), 0); i<mTiles.count(); i++) {
+        Tile& tile = mTiles[i];
+        if (tile.firstLine > lastLine)
+            break;
+        // lines after an edit may be highlighted differently, e.g. when a comment is opened
+        if (tile.requestedRevision == tile.revision) {
+            SyntaxState state = stateBefore(tile.firstLine);
+            if (!(state == tile.stateBefore))
+                invalidateTile(i);
+        }
+        requestTile(tile);
+        // the old image is shown until the new one is rendered
+        if (!tile.image.isNull())
+            painter.drawImage(0, tile.firstLine * mLineHeight - offset, tile.image);
+    }
+
+    int topLine = mEditor->rowToLine(mEditor->topLine()) - 1;
+    int bottomLine = mEditor->rowToLine(mEditor->topLine() + mEditor->linesInWindow()) - 1;
+    bottomLine = std::max(topLine + 1, std::min(bottomLine, mLineCount));
+    QRect viewRect{0, topLine * mLineHeight - offset,
+                width(), (bottomLine - topLine) * mLineHeight};
+    QColor color = palette().color(QPalette::Highlight);
+    color.setAlpha(40);
+    painter.fillRect(viewRect, color);
+    color.setAlpha(120);
+    painter.setPen(color);
+    painter.drawRect(viewRect.adjusted(0, 0, -1, -1));
+}
+
+void MiniMap::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+        scrollEditorTo(event->pos().y());
+}
+
+void MiniMap::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons().testFlag(Qt::LeftButton))
+        scrollEditorTo(event->pos().y());
+}
+
+void MiniMap::wheelEvent(QWheelEvent *event)
+{
+    QCoreApplication::sendEvent(mEditor->viewport(), event);
+}
+
+void MiniMap::resizeEvent(QResizeEvent *event)
+{
+    if (event->size().width() != event->oldSize().width())
+        invalidateAll();
+}
+
+void MiniMap::onLinesInserted(int line, int count)
+{
+    if (mTiles.isEmpty()) {
+        resetTiles(mLineCount + count);
+        update();
+        return;
+    }
+    int index = findTile(line);
+    mTiles[index].lineCount += count;
+    invalidateTile(index);
+    for (int i=index+1;i<mTiles.count();i++)
+        mTiles[i].firstLine += count;
+    mLineCount += count;
+    if (mTiles[index].lineCount > 2 * TileLines)
+        splitTile(index);
+    update();
+}
+
+void MiniMap::onLinesDeleted(int line, int count)
+{
+    int end = line + count;
+    int i = std::max(findTile(line), 0);
+    while (i < mTiles.count()) {
+        Tile& tile = mTiles[i];
+        if (tile.firstLine >= end) {
+            tile.firstLine -= count;
+            i++;
+            continue;
+        }
+        int overlap = std::min(tile.firstLine + tile.lineCount, end) - std::max(tile.firstLine, line);
+        if (overlap > 0)
+            tile.lineCount -= overlap;
+        // lines left in the tile follow the deleted ones
+        if (tile.firstLine > line)
+            tile.firstLine = line;
+        if (tile.lineCount <= 0) {
+            mTiles.remove(i);
+            continue;
+        }
+        invalidateTile(i);
+        i++;
+    }
+    mLineCount = std::max(0, mLineCount - count);
+    update();
+}
+
+void MiniMap::onLinePutted(int line)
+{
+    int index = findTile(line);
+    if (index >= 0) {
+        invalidateTile(index);
+        update();
+    }
+}
+
+void MiniMap::onLinesCleared()
+{
+    resetTiles(0);
+    update();
+}
+
+void MiniMap::onTileRendered(int id, int revision, QImage image)
+{
+    for (Tile& tile : mTiles) {
+        if (tile.id == id) {
+            if (tile.revision == revision) {
+                tile.image = image;
+                tile.renderedRevision = revision;
+                update();
+            }
+            return;
+        }
+    }
+}
+
+MiniMap::Tile MiniMap::newTile(int firstLine, int lineCount)
+{
+    Tile tile;
+    tile.id = mNextTileId++;
+    tile.firstLine = firstLine;
+    tile.lineCount = lineCount;
+    tile.revision = 1;
+    tile.requestedRevision = 0;
+    tile.renderedRevision = 0;
+    return tile;
+}
+
+void MiniMap::resetTiles(int lineCount)
+{
+    mTiles.clear();
+    mLineCount = lineCount;
+    for (int line=0; line<lineCount; line+=TileLines)
+        mTiles.append(newTile(line, std::min(TileLines, lineCount - line)));
+}
+
+void MiniMap::invalidateAll()
+{
+    for (int i=0;i<mTiles.count();i++)
+        invalidateTile(i);
+    update();
+}
+
+int MiniMap::findTile(int line) const
+{
+    // the last tile starting not after the line
+    int start = 0;
+    int end = mTiles.count() - 1;
+    int result = -1;
+    while (start <= end) {
+        int mid = (start + end) / 2;
+        if (mTiles[mid].firstLine <= line) {
+            result = mid;
+            start = mid + 1;
+        } else {
+            end = mid - 1;
+        }
+    }
+    if (result < 0 && !mTiles.isEmpty())
+        return 0;
+    return result;
+}
+
+void MiniMap::invalidateTile(int index)
+{
+    mTiles[index].revision++;
+}
+
+void MiniMap::splitTile(int index)
+{
+    Tile tile = mTiles[index];
+    mTiles.remove(index);
+    int end = tile.firstLine + tile.lineCount;
+    for (int line=tile.firstLine; line<end; line+=TileLines) {
+        Tile part = newTile(line, std::min(TileLines, end - line));
+        mTiles.insert(index, part);
+        index++;
+    }
+}
+
+void MiniMap::requestTile(Tile &tile)
+{
+    if (tile.requestedRevision == tile.revision)
+        return;
+    tile.requestedRevision = tile.revision;
+    tile.stateBefore = stateBefore(tile.firstLine);
+    qreal dpr = devicePixelRatioF();
+    MiniMapTileRequest request;
+    request.id = tile.id;
+    request.revision = tile.revision;
+    request.firstLine = tile.firstLine;
+    request.lineCount = tile.lineCount;
+    request.width = std::ceil(width() * dpr);
+    request.lineHeight = std::max(1, (int)std::round(mLineHeight * dpr));
+    request.devicePixelRatio = dpr;
+    request.tabSize = mEditor->tabSize();
+    request.foreground = mRenderedForeground;
+    request.background = mRenderedBackground;
+    mRenderer->request(request);
+}
+
+SyntaxState MiniMap::stateBefore(int line) const
+{
+    if (line <= 0 || line > mEditor->document()->count())
+        return SyntaxState();
+    return mEditor->document()->getSyntaxState(line - 1);
+}
+
+int MiniMap::scrollOffset() const
+{
+    int totalHeight = mLineCount * mLineHeight;
+    if (totalHeight <= height())
+        return 0;
+    // the minimap is scrolled in proportion to the editor
+    int topLine = mEditor->rowToLine(mEditor->topLine()) - 1;
+    int maxTopLine = std::max(1, mLineCount - mEditor->linesInWindow());
+    double ratio = std::min(1.0, (double)topLine / maxTopLine);
+    return (int)(ratio * (totalHeight - height()));
+}
+
+void MiniMap::scrollEditorTo(int y)
+{
+    if (mLineCount <= 0)
+        return;
+    int line = (y + scrollOffset()) / mLineHeight;
+    line = std::max(0, std::min(line, mLineCount - 1));
+    // center the clicked line in the editor
+    mEditor->setTopLine(mEditor->lineToRow(line + 1) - mEditor->linesInWindow() / 2);
+}
+
+}
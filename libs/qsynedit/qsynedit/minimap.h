@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include <QImage>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+#include <QWidget>
+#include "document.h"
+#include "syntaxer/syntaxer.h"
+
+namespace QSynedit {
+
+class QSynEdit;
+
+struct MiniMapTileRequest {
+    int id;
+    int revision;
+    int firstLine;
+    int lineCount;
+    int width; // in device pixels
+    int lineHeight; // in device pixels
+    qreal devicePixelRatio;
+    int tabSize;
+    QColor foreground;
+    QColor background;
+};
+
+/**
+ * @brief Renders the tiles of a minimap.
+ *
+ * Tiles are rendered one by one, the latest requested first, because
+ * the syntaxer is not thread safe.
+ */
+class MiniMapRenderer : public QThread
+{
+    Q_OBJECT
+public:
+    explicit MiniMapRenderer(const PDocument& document, QObject* parent = nullptr);
+    // the syntaxer must not be used by others
+    void setSyntaxer(const PSyntaxer& syntaxer);
+    void request(const MiniMapTileRequest& request);
+    void stop();
+signals:
+    void tileRendered(int id, int revision, QImage image);
+protected:
+    void run() override;
+private:
+    QImage renderTile(const MiniMapTileRequest& request, const PSyntaxer& syntaxer);
+private:
+    PDocument mDocument;
+    PSyntaxer mSyntaxer;
+    QVector<MiniMapTileRequest> mRequests;
+    bool mStopped;
+    QMutex mMutex;
+    QWaitCondition mRequested;
+};
+
+/**
+ * @brief Overview of the whole document, shown at the right of the editor.
+ *
+ * The document is drawn at 1 or 2 pixels per line into image tiles of about
+ * TileLines lines, which are rendered by MiniMapRenderer in the background.
+ * Only tiles covering changed lines are rendered again; tiles after inserted
+ * or deleted lines are just moved.
+ */
+class MiniMap : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit MiniMap(QSynEdit* editor);
+    ~MiniMap();
+    MiniMap(const MiniMap&)=delete;
+    MiniMap& operator=(const MiniMap&)=delete;
+
+    // a copy of the editor's syntaxer, it's used in the rendering thread
+    void setSyntaxer(const PSyntaxer& syntaxer);
+
+    int lineHeight() const;
+    void setLineHeight(int newLineHeight);
+
+    static const int TileLines = 256;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private slots:
+    void onLinesInserted(int line, int count);
+    void onLinesDeleted(int line, int count);
+    void onLinePutted(int line);
+    void onLinesCleared();
+    void onTileRendered(int id, int revision, QImage image);
+
+private:
+    struct Tile {
+        int id;
+        int firstLine;
+        int lineCount;
+        // changed each time the lines in the tile are changed
+        int revision;
+        int requestedRevision;
+        int renderedRevision;
+        // syntax state the tile is requested with
+        SyntaxState stateBefore;
+        QImage image;
+    };
+
+    Tile newTile(int firstLine, int lineCount);
+    void resetTiles(int lineCount);
+    void invalidateAll();
+    // index of the tile containing the line
+    int findTile(int line) const;
+    void invalidateTile(int index);
+    void splitTile(int index);
+    void requestTile(Tile& tile);
+    SyntaxState stateBefore(int line) const;
+    // y (in pixels) of the first line shown in the minimap
+    int scrollOffset() const;
+    void scrollEditorTo(int y);
+
+private:
+    QSynEdit* mEditor;
+    MiniMapRenderer* mRenderer;
+    QVector<Tile> mTiles;
+    int mLineCount;
+    int mNextTileId;
+    int mLineHeight;
+    QColor mRenderedForeground;
+    QColor mRenderedBackground;
+};
+
+}
+
+#endif // MINIMAP_H
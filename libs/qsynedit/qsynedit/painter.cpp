@@ -19,6 +19,7 @@
 #include "constants.h"
 #include <cmath>
 #include <QDebug>
+#include "qt_utils/tracer.h"
 
 namespace QSynedit {
 
@@ -28,7 +29,10 @@ QSynEditPainter::QSynEditPainter(QSynEdit *edit, QPainter *painter, int firstRow
     mFirstRow{firstRow},
     mLastRow{lastRow},
     mLeft{left},
-    mRight{right}
+    mRight{right},
+    mViewLeft{left},
+    mViewRight{right},
+    mRowLeft{0}
 {
 }
 
@@ -128,6 +132,8 @@ void QSynEditPainter::paintGutter(const QRect& clip)
             int line = mEdit->rowToLine(row);
             if ((line > mEdit->mDocument->count()) && (mEdit->mDocument->count() > 0 ))
                 break;
+            if (isWrappedRow(row, line))
+                continue;
             if (mEdit->mGutter.activeLineTextColor().isValid()) {
                 if (
                         (mEdit->mCaretY==line)     ||
@@ -174,6 +180,16 @@ void QSynEditPainter::paintGutter(const QRect& clip)
 
           mPainter->setPen(QPen(mEdit->mCodeFolding.folderBarLinesColor,lineWidth));
 
+          if (isWrappedRow(row, line)) {
+              // continue the fold bar along the rows of the line
+              PCodeFoldingRange foldRange = mEdit->foldStartAtLine(line);
+              if (mEdit->foldAroundLine(line) || (foldRange && !foldRange->collapsed)) {
+                  x = rcFold.left() + (rcFold.width() / 2);
+                  mPainter->drawLine(x,rcFold.top(), x, rcFold.bottom());
+              }
+              continue;
+          }
+
         // Need to paint a line?
           if (mEdit->foldAroundLine(line)) {
           x = rcFold.left() + (rcFold.width() / 2);
@@ -231,10 +247,19 @@ void QSynEditPainter::paintGutter(const QRect& clip)
         int line = mEdit->rowToLine(row);
         if ((line > mEdit->mDocument->count()) && (mEdit->mDocument->count() != 0))
             break;
+        if (isWrappedRow(row, line))
+            continue;
         mEdit->onGutterPaint(*mPainter,line, 0, (row - mEdit->mTopLine) * mEdit->mTextHeight);
     }
 }
 
+bool QSynEditPainter::isWrappedRow(int row, int line)
+{
+    return mEdit->mOptions.testFlag(eoWrapLines)
+            && line <= mEdit->mDocument->count()
+            && mEdit->lineToRow(line) != row;
+}
+
 QColor QSynEditPainter::colEditorBG()
 {
     if (mEdit->mActiveLineColor.isValid() && mIsCurrentLine) {
@@ -331,7 +356,7 @@ void QSynEditPainter::setDrawingColors(bool selected)
 
 int QSynEditPainter::fixXValue(int xpos)
 {
-    return mEdit->textOffset() + xpos;
+    return mEdit->textOffset() + xpos - mRowLeft;
 }
 
 void QSynEditPainter::paintToken(
@@ -634,7 +659,7 @@ void QSynEditPainter::paintHighlightToken(const QString& lineText,
         else
             colBG = colEditorBG();
         if (mIsComplexLine) {
-            setDrawingColors(mRcToken.left() < mLineSelEnd);
+            setDrawingColors(mRcToken.left() < fixXValue(mLineSelEnd));
             mRcToken.setRight(mRcLine.right());
             mPainter->fillRect(mRcToken,mPainter->brush());
         }  else {
@@ -769,6 +794,8 @@ void QSynEditPainter::paintFoldAttributes()
             int vLine = mEdit->rowToLine(row);
             if (vLine > mEdit->mDocument->count() && mEdit->mDocument->count() > 0)
                 break;
+            if (isWrappedRow(row, vLine))
+                continue;
             int X;
             // Set vertical coord
             int Y = (row - mEdit->mTopLine) * mEdit->mTextHeight; // limit inside clip rect
@@ -840,7 +867,8 @@ void QSynEditPainter::paintFoldAttributes()
             if (range->collapsed && !range->parentCollapsed() &&
                     (range->fromLine <= mLastLine) && (range->fromLine >= mFirstLine) ) {
                 // Get starting and end points
-                int Y = (mEdit->lineToRow(range->fromLine) - mEdit->mTopLine + 1) * mEdit->mTextHeight - 1;
+                int Y = (mEdit->lineToRow(range->fromLine) + mEdit->lineRowCount(range->fromLine)
+                         - mEdit->mTopLine) * mEdit->mTextHeight - 1;
                 mPainter->drawLine(mClip.left(),Y, mClip.right(),Y);
             }
         }
@@ -875,6 +903,7 @@ void QSynEditPainter::getBraceColorAttr(int level, PTokenAttribute &attr)
 
 void QSynEditPainter::paintLines()
 {
+    TraceSpan traceSpan("QSynEditPainter::paintLines");
     QString sLine; // the current line
     QString sToken; // token info
     int tokenLeft, tokenWidth;
@@ -893,10 +922,20 @@ void QSynEditPainter::paintLines()
     // Now loop through all the lines. The indices are valid for Lines.
     BufferCoord selectionBegin = mEdit->blockBegin();
     BufferCoord selectionEnd= mEdit->blockEnd();
+    bool wrapLines = mEdit->mOptions.testFlag(eoWrapLines);
     for (int row = mFirstRow; row<=mLastRow; row++) {
         int vLine = mEdit->rowToLine(row);
         if (vLine > mEdit->mDocument->count() && mEdit->mDocument->count() != 0)
             break;
+        // only the part of a wrapped line between rowLeft and rowRight is shown on the row
+        int rowLeft, rowRight;
+        mEdit->rowBounds(row, rowLeft, rowRight);
+        bool isLastRowOfLine = (rowRight < 0);
+        mRowLeft = rowLeft;
+        mLeft = mViewLeft + rowLeft;
+        mRight = mViewRight + rowLeft;
+        if (!isLastRowOfLine)
+            mRight = std::min(mRight, rowRight);
 
         // Get the line.
         sLine = mEdit->lineText(vLine);
@@ -938,7 +977,7 @@ void QSynEditPainter::paintLines()
             mLineSelEnd = mRight + 1;
             if ((mEdit->mActiveSelectionMode == SelectionMode::Column) ||
                     ((mEdit->mActiveSelectionMode == SelectionMode::Normal) && (row == mSelStart.row)) ) {
-                int xpos = mSelStart.x;
+                int xpos = mSelStart.x + mRowLeft;
                 if (xpos > mRight) {
                     mLineSelStart = 0;
                     mLineSelEnd = 0;
@@ -949,7 +988,7 @@ void QSynEditPainter::paintLines()
             }
             if ( (mEdit->mActiveSelectionMode == SelectionMode::Column) ||
                  ((mEdit->mActiveSelectionMode == SelectionMode::Normal) && (row == mSelEnd.row)) ) {
-                int xpos = mSelEnd.x;
+                int xpos = mSelEnd.x + mRowLeft;
                 if (xpos < mLeft) {
                     mLineSelStart = 0;
                     mLineSelEnd = 0;
@@ -1014,6 +1053,20 @@ void QSynEditPainter::paintLines()
             int tokenStartChar = mEdit->mSyntaxer->getTokenPos();
             int tokenEndChar = tokenStartChar + sToken.length();
 
+            // the rest of the line is shown on the next rows
+            if (!isLastRowOfLine && tokenLeft >= mRight)
+                break;
+            // tokens shown on the rows above are not measured again
+            if (rowLeft > 0) {
+                int glyphIdx = searchForSegmentIdx(glyphStartCharList, 0, sLine.length(), tokenEndChar);
+                int tokenRight = segmentIntervalStart(glyphStartPositionsList, 0, lineWidth, glyphIdx);
+                if (tokenRight <= mLeft) {
+                    tokenLeft = tokenRight;
+                    mEdit->mSyntaxer->next();
+                    continue;
+                }
+            }
+
             // It's at least partially visible. Get the token attributes now.
             attr = mEdit->mSyntaxer->getTokenAttribute();
 
@@ -1076,7 +1129,15 @@ void QSynEditPainter::paintLines()
             // Let the highlighter scan the next token.
             mEdit->mSyntaxer->next();
         }
-        mEdit->mDocument->setLineWidth(vLine-1, sLine, tokenLeft, glyphStartPositionsList);
+        if (isLastRowOfLine) {
+            mEdit->mDocument->setLineWidth(vLine-1, sLine, tokenLeft, glyphStartPositionsList);
+            if (wrapLines && tokenLeft != lineWidth
+                    && (!mIsCurrentLine || mEdit->mInputPreeditString.isEmpty())) {
+                // glyphs are measured with the fonts of the tokens now, wrap the line again
+                mEdit->mLineWrapIndex.lineChanged(vLine-1);
+                mEdit->mLineWrapTimer->start();
+            }
+        }
         if (tokenLeft<mRight) {
             QString addOnStr;
 
@@ -53,6 +53,8 @@ public:
     void paintGutter(const QRect& clip);
 
 private:
+    // the row is not the first one of the wrapped line
+    bool isWrappedRow(int row, int line);
     QColor colEditorBG();
     void computeSelectionInfo();
     void setDrawingColors(bool selected);
@@ -109,6 +111,10 @@ private:
 
     QRect mClip;
     int mFirstRow, mLastRow, mLeft, mRight;
+    // left and right of the view, mLeft and mRight are moved by the row when lines are wrapped
+    int mViewLeft, mViewRight;
+    // x of the first glyph shown on the row
+    int mRowLeft;
     SynTokenAccu mTokenAccu;
 };
 
@@ -20,13 +20,16 @@
 #include <QFontMetrics>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <QScrollBar>
 #include <QPaintEvent>
 #include <QPainter>
 #include <QTimerEvent>
+#include <QElapsedTimer>
 #include "syntaxer/syntaxer.h"
 #include "syntaxer/textfile.h"
 #include "painter.h"
+#include "minimap.h"
 #include <QClipboard>
 #include <QDebug>
 #include <QGuiApplication>
@@ -37,11 +40,16 @@
 #include <QMessageBox>
 #include <QDrag>
 #include <QMimeData>
+#include "qt_utils/tracer.h"
 #include <QDesktopWidget>
 #include <QTextEdit>
 #include <QMimeData>
 
 namespace QSynedit {
+
+// rows broken in a long line before the events are handled again
+static const int MaxRowsWrappedAtOnce = 1000;
+
 QSynEdit::QSynEdit(QWidget *parent) : QAbstractScrollArea(parent),
     mEditingCount{0},
     mDropped{false},
@@ -57,6 +65,7 @@ QSynEdit::QSynEdit(QWidget *parent) : QAbstractScrollArea(parent),
     mPaintLock = 0;
     mPainterLock = 0;
     mPainting = false;
+    mPendingKeystrokeTime = -1;
     mFontDummy = QFont("monospace",14);
     mFontDummy.setStyleStrategy(QFont::PreferAntialias);
     mDocument = std::make_shared<Document>(mFontDummy, this);
@@ -148,6 +157,17 @@ QSynEdit::QSynEdit(QWidget *parent) : QAbstractScrollArea(parent),
     //mScrollTimer->setInterval(100);
     connect(mScrollTimer, &QTimer::timeout,this, &QSynEdit::onScrollTimeout);
 
+    mLineWrapFoldRevision = 0;
+    mLineWrapWidth = 0;
+    mLineWrapTimer = new QTimer(this);
+    mLineWrapTimer->setInterval(0);
+    connect(mLineWrapTimer, &QTimer::timeout,this, &QSynEdit::onLineWrapTimeout);
+    mMiniMap = nullptr;
+    mEditingAtCarets = false;
+    mDeferReparse = false;
+    mDirtyStartLine = 0;
+    mDirtyEndLine = 0;
+
     qreal dpr=devicePixelRatioF();
     mContentImage = std::make_shared<QImage>(clientWidth()*dpr,clientHeight()*dpr,QImage::Format_ARGB32);
     mContentImage->setDevicePixelRatio(dpr);
@@ -177,6 +197,10 @@ int QSynEdit::displayLineCount() const
     if (mDocument->empty()) {
         return 0;
     }
+    if (mOptions.testFlag(eoWrapLines)) {
+        syncLineWrapIndex();
+        return mLineWrapIndex.rowCount();
+    }
     return lineToRow(mDocument->count());
 }
 
@@ -336,6 +360,8 @@ bool QSynEdit::canRedo() const
 
 int QSynEdit::maxScrollWidth() const
 {
+    if (mOptions.testFlag(eoWrapLines))
+        return 1;
     int maxWidth = mDocument->maxLineWidth();
     if (useCodeFolding())
         maxWidth += stringWidth(syntaxer()->foldString(""),maxWidth);
@@ -674,10 +700,10 @@ void QSynEdit::invalidateGutterLines(int firstLine, int lastLine)
         // find the visible lines first
         if (lastLine < firstLine)
             std::swap(lastLine, firstLine);
-        if (useCodeFolding()) {
+        if (useCodeFolding() || mOptions.testFlag(eoWrapLines)) {
             firstLine = lineToRow(firstLine);
             if (lastLine <= mDocument->count())
-              lastLine = lineToRow(lastLine);
+              lastLine = lineToRow(lastLine) + lineRowCount(lastLine) - 1;
             else
               lastLine = INT_MAX;
         }
@@ -712,19 +738,25 @@ DisplayCoord QSynEdit::pixelsToNearestGlyphPos(int aX, int aY) const
         line = 1;
     if (line>mDocument->count())
         line = mDocument->count();
-    if (xpos<0) {
-        xpos=0;
+    int rowLeft, rowRight;
+    rowBounds(row, rowLeft, rowRight);
+    xpos += rowLeft;
+    if (rowRight >= 0 && xpos >= rowRight) {
+        // the caret can't be put after the last glyph of a wrapped row
+        xpos = mDocument->glyphStartPostion(line-1,
+                    mDocument->xposToGlyphIndex(line-1, rowRight-1));
     } else if (xpos>mDocument->lineWidth(line-1)) {
         xpos=mDocument->lineWidth(line-1)+1;
     } else {
         int glyphIndex = mDocument->xposToGlyphIndex(line-1, xpos);
         int nextGlyphPos = mDocument->glyphStartPostion(line-1, glyphIndex+1);
-        if (nextGlyphPos - xpos < mCharWidth / 2)
+        if (nextGlyphPos - xpos < mCharWidth / 2
+                && (rowRight < 0 || nextGlyphPos < rowRight))
             xpos = nextGlyphPos;
         else
             xpos = mDocument->glyphStartPostion(line-1, glyphIndex);
     }
-    return DisplayCoord{xpos, row};
+    return DisplayCoord{xpos - rowLeft, row};
 }
 
 DisplayCoord QSynEdit::pixelsToGlyphPos(int aX, int aY) const
@@ -734,11 +766,14 @@ DisplayCoord QSynEdit::pixelsToGlyphPos(int aX, int aY) const
     int line = rowToLine(row);
     if (line<1 || line > mDocument->count() )
         return DisplayCoord{-1,-1};
-    if (xpos<0 || xpos>mDocument->lineWidth(line-1))
+    int rowLeft, rowRight;
+    rowBounds(row, rowLeft, rowRight);
+    xpos += rowLeft;
+    if (xpos>mDocument->lineWidth(line-1) || (rowRight >= 0 && xpos >= rowRight))
         return DisplayCoord{-1,-1};
     int glyphIndex = mDocument->xposToGlyphIndex(line-1, xpos);
     xpos = mDocument->glyphStartPostion(line-1, glyphIndex);
-    return DisplayCoord{xpos, row};
+    return DisplayCoord{xpos - rowLeft, row};
 }
 
 QPoint QSynEdit::displayCoordToPixels(const DisplayCoord &coord) const
@@ -763,6 +798,20 @@ DisplayCoord QSynEdit::bufferToDisplayPos(const BufferCoord &p) const
     // Account for tabs and charColumns
     if (p.line-1 <mDocument->count())
         result.x = charToGlyphLeft(p.line,p.ch);
+    if (mOptions.testFlag(eoWrapLines)) {
+        result.row = lineToRow(p.line);
+        if (p.line-1 < mDocument->count()) {
+            // find the wrapped row the glyph is on
+            const QVector<int> &rowStarts = mLineWrapIndex.rowStarts(p.line-1);
+            int wrapRow = std::upper_bound(rowStarts.begin(), rowStarts.end(), result.x)
+                    - rowStarts.begin();
+            if (wrapRow > 0 && mLineWrapIndex.lineRows(p.line-1) > 0) {
+                result.row += wrapRow;
+                result.x -= rowStarts[wrapRow-1];
+            }
+        }
+        return result;
+    }
     // Account for code folding
     if (useCodeFolding())
         result.row = foldLineToRow(result.row);
@@ -779,12 +828,21 @@ BufferCoord QSynEdit::displayToBufferPos(const DisplayCoord &p) const
     BufferCoord result{p.x,p.row};
     if (p.row<1)
         return result;
-    // Account for code folding
-    if (useCodeFolding())
+    int x = p.x;
+    if (mOptions.testFlag(eoWrapLines)) {
+        result.line = rowToLine(p.row);
+        int rowLeft, rowRight;
+        rowBounds(p.row, rowLeft, rowRight);
+        x += rowLeft;
+        if (rowRight >= 0)
+            x = std::min(x, rowRight-1);
+    } else if (useCodeFolding()) {
+        // Account for code folding
         result.line = foldRowToLine(p.row);
+    }
     // Account for tabs
     if (result.line <= mDocument->count() ) {
-        result.ch = xposToGlyphStartChar(result.line,p.x);
+        result.ch = xposToGlyphStartChar(result.line,x);
     }
     return result;
 }
@@ -917,6 +975,13 @@ int QSynEdit::getLineIndent(const QString &line) const
 
 int QSynEdit::rowToLine(int aRow) const
 {
+    if (mOptions.testFlag(eoWrapLines)) {
+        if (aRow<1)
+            return aRow;
+        syncLineWrapIndex();
+        int wrapRow;
+        return mLineWrapIndex.rowToLine(aRow-1, wrapRow)+1;
+    }
     if (useCodeFolding())
         return foldRowToLine(aRow);
     else
@@ -926,36 +991,191 @@ int QSynEdit::rowToLine(int aRow) const
 
 int QSynEdit::lineToRow(int aLine) const
 {
-    return bufferToDisplayPos({1, aLine}).row;
+    if (aLine<1)
+        return aLine;
+    if (mOptions.testFlag(eoWrapLines)) {
+        syncLineWrapIndex();
+        return mLineWrapIndex.lineToRow(aLine-1)+1;
+    }
+    if (useCodeFolding())
+        return foldLineToRow(aLine);
+    return aLine;
 }
 
-int QSynEdit::foldRowToLine(int row) const
+int QSynEdit::lineRowCount(int line) const
 {
-    int result = row;
-    for (int i=0;i<mAllFoldRanges->count();i++) {
-        PCodeFoldingRange range = (*mAllFoldRanges)[i];
-        if (range->collapsed && !range->parentCollapsed() && range->fromLine < result) {
-            result += range->linesCollapsed;
+    if (!mOptions.testFlag(eoWrapLines))
+        return 1;
+    syncLineWrapIndex();
+    return std::max(1, mLineWrapIndex.lineRows(line-1));
+}
+
+void QSynEdit::rowBounds(int row, int &left, int &right) const
+{
+    left = 0;
+    right = -1;
+    if (!mOptions.testFlag(eoWrapLines) || row<1)
+        return;
+    syncLineWrapIndex();
+    int wrapRow;
+    int line = mLineWrapIndex.rowToLine(row-1, wrapRow);
+    if (line >= mLineWrapIndex.lineCount())
+        return;
+    const QVector<int> &rowStarts = mLineWrapIndex.rowStarts(line);
+    if (wrapRow > 0 && wrapRow <= rowStarts.count())
+        left = rowStarts[wrapRow-1];
+    if (wrapRow < rowStarts.count())
+        right = rowStarts[wrapRow];
+}
+
+void QSynEdit::syncLineWrapIndex() const
+{
+    if (mLineWrapIndex.lineCount() != mDocument->count()) {
+        mLineWrapIndex.reset(mDocument->count());
+        mLineWrapFoldRevision = 0;
+    }
+    if (useCodeFolding()) {
+        if (!mCollapsedFoldIndex.isValid())
+            mCollapsedFoldIndex.rebuild(mAllFoldRanges);
+        if (mCollapsedFoldIndex.revision() != mLineWrapFoldRevision) {
+            QVector<int> fromLines = mCollapsedFoldIndex.fromLines();
+            QVector<int> toLines = mCollapsedFoldIndex.toLines();
+            for (int i=0;i<fromLines.count();i++) {
+                fromLines[i]--;
+                toLines[i]--;
+            }
+            mLineWrapIndex.setHiddenLines(fromLines, toLines);
+            mLineWrapFoldRevision = mCollapsedFoldIndex.revision();
         }
+    } else if (mLineWrapFoldRevision != 0) {
+        mLineWrapIndex.setHiddenLines(QVector<int>(), QVector<int>());
+        mLineWrapFoldRevision = 0;
     }
-    return result;
 }
 
-int QSynEdit::foldLineToRow(int line) const
+int QSynEdit::lineWrapWidth() const
 {
-    int result = line;
-    for (int i=mAllFoldRanges->count()-1;i>=0;i--) {
-        PCodeFoldingRange range =(*mAllFoldRanges)[i];
-        if (range->collapsed && !range->parentCollapsed()) {
-            // Line is found after fold
-            if (range->toLine < line)
-                result -= range->linesCollapsed;
-            // Inside fold
-            else if (range->fromLine < line && line <= range->toLine)
-                result -= line - range->fromLine;
+    return std::max(viewWidth() - mCharWidth, mCharWidth);
+}
+
+int QSynEdit::wrapLine(int line)
+{
+    PLineWrapper wrapper = mLineWrapIndex.wrapper(line-1);
+    if (!wrapper) {
+        QString lineText;
+        QList<int> glyphStartCharList;
+        QList<int> glyphStartPositionList;
+        int lineWidth = mDocument->getLineGlyphs(line-1, lineText, glyphStartCharList, glyphStartPositionList);
+        if (lineWidth <= mLineWrapWidth)
+            return mLineWrapIndex.setRowStarts(line-1, QVector<int>());
+        wrapper = std::make_shared<LineWrapper>(lineText, glyphStartCharList,
+                                                glyphStartPositionList, lineWidth, mLineWrapWidth);
+    }
+    // a very long line is wrapped a slice at a time, it stays unmeasured
+    // and the wrap timer goes on with it
+    if (!wrapper->wrap(MaxRowsWrappedAtOnce)) {
+        mLineWrapIndex.setWrapper(line-1, wrapper);
+        mLineWrapTimer->start();
+        return 0;
+    }
+    return mLineWrapIndex.setRowStarts(line-1, wrapper->rowStarts());
+}
+
+bool QSynEdit::wrapVisibleLines()
+{
+    syncLineWrapIndex();
+    bool changed = false;
+    int row = mTopLine;
+    int lastRow = mTopLine + mLinesInWindow;
+    while (row <= lastRow) {
+        int line = rowToLine(row);
+        if (line > mDocument->count())
+            break;
+        if (!mLineWrapIndex.isMeasured(line-1) && wrapLine(line) != 0)
+            changed = true;
+        row = lineToRow(line) + lineRowCount(line);
+    }
+    return changed;
+}
+
+void QSynEdit::wrapChangedLines(int line, int count)
+{
+    // wrap a small edit now, so rows below it don't jump when painted
+    if (count <= 100) {
+        for (int i=line;i<line+count;i++)
+            wrapLine(i);
+    }
+    mLineWrapTimer->start();
+}
+
+void QSynEdit::rewrapLines(bool force)
+{
+    if (!mOptions.testFlag(eoWrapLines))
+        return;
+    int width = lineWrapWidth();
+    if (width == mLineWrapWidth && !force)
+        return;
+    mLineWrapWidth = width;
+    syncLineWrapIndex();
+    mLineWrapIndex.invalidateAll();
+    mLineWrapTimer->start();
+    invalidate();
+}
+
+void QSynEdit::onLineWrapTimeout()
+{
+    if (!mOptions.testFlag(eoWrapLines)) {
+        mLineWrapTimer->stop();
+        return;
+    }
+    syncLineWrapIndex();
+    // keep the first visible row where it is while lines above it are wrapped
+    int topLine = rowToLine(mTopLine);
+    int topWrapRow = mTopLine - lineToRow(topLine);
+    int lastRow = mTopLine + mLinesInWindow;
+    bool visibleChanged = false;
+    bool rowsChanged = false;
+    QElapsedTimer timer;
+    timer.start();
+    int line;
+    while ((line = mLineWrapIndex.nextUnmeasured()) >= 0) {
+        if (wrapLine(line+1) != 0)
+            rowsChanged = true;
+        // rows may be broken at other glyphs even if their count is not changed
+        if (line+1 >= topLine && lineToRow(line+1) <= lastRow)
+            visibleChanged = true;
+        if (timer.elapsed() > 10)
+            break;
+    }
+    if (line < 0)
+        mLineWrapTimer->stop();
+    if (rowsChanged) {
+        if (topLine <= mDocument->count()) {
+            int topRow = lineToRow(topLine)
+                    + std::min(topWrapRow, lineRowCount(topLine)-1);
+            if (topRow != mTopLine) {
+                mTopLine = topRow;
+                visibleChanged = true;
+            }
         }
+        updateVScrollbar();
     }
-    return result;
+    if (visibleChanged)
+        invalidate();
+}
+
+int QSynEdit::foldRowToLine(int row) const
+{
+    if (!mCollapsedFoldIndex.isValid())
+        mCollapsedFoldIndex.rebuild(mAllFoldRanges);
+    return mCollapsedFoldIndex.rowToLine(row);
+}
+
+int QSynEdit::foldLineToRow(int line) const
+{
+    if (!mCollapsedFoldIndex.isValid())
+        mCollapsedFoldIndex.rebuild(mAllFoldRanges);
+    return mCollapsedFoldIndex.lineToRow(line);
 }
 
 void QSynEdit::setDefaultKeystrokes()
@@ -978,13 +1198,15 @@ void QSynEdit::invalidateLine(int line)
         return;
 
     // invalidate text area of this line
-    if (useCodeFolding())
-        line = foldLineToRow(line);
-    if (line >= mTopLine && line <= mTopLine + mLinesInWindow) {
+    int row = lineToRow(line);
+    int lastRow = row + lineRowCount(line) - 1;
+    if (lastRow >= mTopLine && row <= mTopLine + mLinesInWindow) {
+        row = std::max(row, mTopLine);
+        lastRow = std::min(lastRow, mTopLine + mLinesInWindow);
         rcInval = { mGutterWidth,
-                    mTextHeight * (line - mTopLine),
+                    mTextHeight * (row - mTopLine),
                     clientWidth(),
-                    mTextHeight};
+                    mTextHeight * (lastRow - row + 1)};
         if (mStateFlags.testFlag(StateFlag::sfLinesChanging))
             mInvalidateRect = mInvalidateRect.united(rcInval);
         else
@@ -1018,7 +1240,7 @@ void QSynEdit::invalidateLines(int firstLine, int lastLine)
         if (lastLine >= mDocument->count())
           lastLine = INT_MAX; // paint empty space beyond last line
 
-        if (useCodeFolding()) {
+        if (useCodeFolding() || mOptions.testFlag(eoWrapLines)) {
           firstLine = lineToRow(firstLine);
           // Could avoid this conversion if (First = Last) and
           // (Length < CharsInWindow) but the dependency isn't worth IMO.
@@ -1055,6 +1277,8 @@ void QSynEdit::invalidateSelection()
 
 void QSynEdit::invalidateRect(const QRect &rect)
 {
+    mContentImageDirtyRegion += rect;
+    mContentImageBlitRegion -= rect;
     if (mPainterLock>0)
         return;
     // if (rect.height()>mTextHeight)
@@ -1064,6 +1288,8 @@ void QSynEdit::invalidateRect(const QRect &rect)
 
 void QSynEdit::invalidate()
 {
+    mContentImageDirtyRegion = QRegion(0, 0, clientWidth(), clientHeight());
+    mContentImageBlitRegion = QRegion();
     if (mPainterLock>0) {
         mStateFlags.setFlag(StateFlag::sfRedrawNeeded);
     } else {
@@ -1246,7 +1472,7 @@ void QSynEdit::processGutterClick(QMouseEvent *event)
             QRect rect;
             rect.setLeft(mGutterWidth - mGutter.rightOffset());
             rect.setRight(rect.left() + mGutter.rightOffset() - 4);
-            rect.setTop((row - mTopLine) * mTextHeight);
+            rect.setTop((lineToRow(line) - mTopLine) * mTextHeight);
             rect.setBottom(rect.top() + mTextHeight - 1);
             if (rect.contains(event->pos())) {
                 if (foldRange->collapsed)
@@ -1578,6 +1804,384 @@ void QSynEdit::doSelectAll()
     emit statusChanged(StatusChange::scSelection);
 }
 
+bool QSynEdit::hasExtraCarets() const
+{
+    return !mExtraCarets.isEmpty();
+}
+
+const QVector<CaretSelection> &QSynEdit::extraCarets() const
+{
+    return mExtraCarets;
+}
+
+void QSynEdit::clearExtraCarets()
+{
+    if (mExtraCarets.isEmpty())
+        return;
+    mExtraCarets.clear();
+    invalidate();
+}
+
+static bool coordLessThan(const BufferCoord& c1, const BufferCoord& c2)
+{
+    return (c1.line < c2.line) || (c1.line == c2.line && c1.ch < c2.ch);
+}
+
+bool QSynEdit::findOccurrence(const QString &text, const BufferCoord &from, BufferCoord &found)
+{
+    int count = mDocument->count();
+    if (text.isEmpty() || count == 0)
+        return false;
+    // search to the end of the document, then from its start
+    for (int i=0;i<=count;i++) {
+        int line = (from.line - 1 + i) % count;
+        QString s = mDocument->getLine(line);
+        int start = 0;
+        if (i==0)
+            start = from.ch - 1;
+        int pos = s.indexOf(text, start);
+        if (i==count && pos >= from.ch - 1)
+            pos = -1;
+        if (pos >= 0) {
+            found = BufferCoord{pos + 1, line + 1};
+            return true;
+        }
+    }
+    return false;
+}
+
+void QSynEdit::doAddCaretAtNextOccurrence()
+{
+    if (!selAvail()) {
+        setSelWord();
+        return;
+    }
+    if (mActiveSelectionMode != SelectionMode::Normal || blockBegin().line != blockEnd().line)
+        return;
+    QString text = selText();
+    // search after the last added caret
+    BufferCoord from = blockEnd();
+    BufferCoord found;
+    while (findOccurrence(text, from, found)) {
+        BufferCoord foundEnd{found.ch + text.length(), found.line};
+        if (found == blockBegin())
+            return;
+        bool exists = false;
+        for (const CaretSelection& caret : mExtraCarets) {
+            BufferCoord begin = coordLessThan(caret.anchor, caret.caret) ? caret.anchor : caret.caret;
+            if (begin == found) {
+                exists = true;
+                break;
+            }
+        }
+        if (!exists) {
+            mExtraCarets.append(CaretSelection{caretXY(), caretXY() == blockBegin() ? blockEnd() : blockBegin()});
+            setCaretAndSelection(foundEnd, found, foundEnd);
+            ensureCursorPosVisible();
+            invalidate();
+            return;
+        }
+        from = foundEnd;
+    }
+}
+
+void QSynEdit::doSelectAllOccurrences()
+{
+    if (!selAvail())
+        setSelWord();
+    if (!selAvail() || mActiveSelectionMode != SelectionMode::Normal
+            || blockBegin().line != blockEnd().line)
+        return;
+    QString text = selText();
+    BufferCoord primary = blockBegin();
+    mExtraCarets.clear();
+    for (int line=0;line<mDocument->count();line++) {
+        QString s = mDocument->getLine(line);
+        int pos = s.indexOf(text);
+        while (pos >= 0) {
+            BufferCoord begin{pos + 1, line + 1};
+            if (begin != primary)
+                mExtraCarets.append(CaretSelection{BufferCoord{pos + text.length() + 1, line + 1}, begin});
+            pos = s.indexOf(text, pos + text.length());
+        }
+    }
+    setCaretAndSelection(blockEnd(), blockBegin(), blockEnd());
+    invalidate();
+}
+
+void QSynEdit::doAddCaretsFromColumnSelection()
+{
+    if (mActiveSelectionMode != SelectionMode::Column)
+        return;
+    int anchorX = charToGlyphLeft(mBlockBegin.line, mBlockBegin.ch);
+    int caretX = charToGlyphLeft(mBlockEnd.line, mBlockEnd.ch);
+    int firstLine = std::min(mBlockBegin.line, mBlockEnd.line);
+    int lastLine = std::max(mBlockBegin.line, mBlockEnd.line);
+    int primaryLine = minMax(mCaretY, firstLine, lastLine);
+    BufferCoord primaryCaret, primaryAnchor;
+    mExtraCarets.clear();
+    for (int line=firstLine; line<=lastLine; line++) {
+        BufferCoord caret{xposToGlyphStartChar(line, caretX), line};
+        BufferCoord anchor{xposToGlyphStartChar(line, anchorX), line};
+        if (line == primaryLine) {
+            primaryCaret = caret;
+            primaryAnchor = anchor;
+        } else {
+            mExtraCarets.append(CaretSelection{caret, anchor});
+        }
+    }
+    setActiveSelectionMode(SelectionMode::Normal);
+    setCaretAndSelection(primaryCaret, primaryAnchor, primaryCaret);
+    invalidate();
+}
+
+bool QSynEdit::isMultiCaretCommand(EditCommand command) const
+{
+    switch(command) {
+    case EditCommand::Char:
+    case EditCommand::String:
+    case EditCommand::ImeStr:
+    case EditCommand::DeleteLastChar:
+    case EditCommand::DeleteChar:
+    case EditCommand::LineBreak:
+    case EditCommand::Paste:
+    case EditCommand::Left:
+    case EditCommand::Right:
+    case EditCommand::LineStart:
+    case EditCommand::LineEnd:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void QSynEdit::doEditAtCarets(EditCommand command, QChar ch, void *pData)
+{
+    if (mReadOnly)
+        return;
+    struct CaretEdit {
+        BufferCoord begin;
+        BufferCoord end;
+        bool primary;
+    };
+    QVector<CaretEdit> edits;
+    edits.reserve(mExtraCarets.count() + 1);
+    edits.append(CaretEdit{blockBegin(), blockEnd(), true});
+    for (const CaretSelection& caret : mExtraCarets) {
+        if (coordLessThan(caret.anchor, caret.caret))
+            edits.append(CaretEdit{caret.anchor, caret.caret, false});
+        else
+            edits.append(CaretEdit{caret.caret, caret.anchor, false});
+    }
+    std::sort(edits.begin(), edits.end(), [](const CaretEdit& e1, const CaretEdit& e2){
+        return coordLessThan(e1.begin, e2.begin);
+    });
+    // drop carets in the selection of others
+    QVector<CaretEdit> carets;
+    carets.reserve(edits.count());
+    for (CaretEdit& edit : edits) {
+        if (!carets.isEmpty()) {
+            CaretEdit& last = carets.last();
+            if (coordLessThan(edit.begin, last.end)
+                    || (edit.begin == last.begin && edit.end == last.end)) {
+                last.primary = last.primary || edit.primary;
+                continue;
+            }
+        }
+        carets.append(edit);
+    }
+
+    QList<QStringList> texts;
+    switch(command) {
+    case EditCommand::Char:
+        texts.append(QStringList{QString(ch)});
+        break;
+    case EditCommand::String:
+    case EditCommand::ImeStr:
+        texts.append(splitStrings(*((QString*)pData)));
+        break;
+    case EditCommand::LineBreak:
+        texts.append(QStringList{"", ""});
+        break;
+    case EditCommand::Paste: {
+        QString text = QGuiApplication::clipboard()->text();
+        if (text.isEmpty())
+            return;
+        QStringList lines = splitStrings(text);
+        // paste a line at each caret, if lines are copied from the same number of carets
+        if (lines.count() == carets.count()) {
+            for (const QString& line : lines)
+                texts.append(QStringList{line});
+        } else {
+            texts.append(lines);
+        }
+    }
+        break;
+    default:
+        break;
+    }
+
+    beginEditing();
+    deferReparse();
+    mEditingAtCarets = true;
+    auto action = finally([this]{
+        mEditingAtCarets = false;
+        endEditing();
+    });
+    addCaretToUndo();
+    addSelectionToUndo();
+    // Positions after the last edit are moved by it: lines by lineDelta, and
+    // chars on lastLine (before any edit) by chDelta.
+    int lineDelta = 0;
+    int lastLine = -1;
+    int chDelta = 0;
+    auto mapPos = [&](const BufferCoord& pos) {
+        return BufferCoord{pos.ch + (pos.line == lastLine ? chDelta : 0), pos.line + lineDelta};
+    };
+    QVector<CaretSelection> newCarets;
+    newCarets.reserve(carets.count());
+    BufferCoord primaryPos{1, 1};
+    for (int i=0;i<carets.count();i++) {
+        BufferCoord deleteBegin = mapPos(carets[i].begin);
+        BufferCoord deleteEnd = mapPos(carets[i].end);
+        if (deleteBegin == deleteEnd) {
+            if (command == EditCommand::DeleteLastChar) {
+                if (deleteBegin.ch > 1) {
+                    deleteBegin.ch = mDocument->charToGlyphStartChar(deleteBegin.line - 1, deleteBegin.ch - 2) + 1;
+                } else if (deleteBegin.line > 1) {
+                    deleteBegin.line--;
+                    deleteBegin.ch = mDocument->getLine(deleteBegin.line - 1).length() + 1;
+                }
+            } else if (command == EditCommand::DeleteChar) {
+                int len = mDocument->getLine(deleteEnd.line - 1).length();
+                if (deleteEnd.ch <= len) {
+                    int glyphIdx = mDocument->charToGlyphIndex(deleteEnd.line - 1, deleteEnd.ch - 1);
+                    deleteEnd.ch = mDocument->glyphStartChar(deleteEnd.line - 1, glyphIdx)
+                            + mDocument->glyphLength(deleteEnd.line - 1, glyphIdx) + 1;
+                } else if (deleteEnd.line < mDocument->count()) {
+                    deleteEnd.line++;
+                    deleteEnd.ch = 1;
+                }
+            }
+        }
+        // the text after deleteEnd (before the edit) is moved to newPos
+        int origEndLine = deleteEnd.line - lineDelta;
+        int origEndCh = deleteEnd.ch - (origEndLine == lastLine ? chDelta : 0);
+        BufferCoord newPos = deleteBegin;
+        if (deleteBegin != deleteEnd)
+            doDeleteText(deleteBegin, deleteEnd, SelectionMode::Normal);
+        if (!texts.isEmpty()) {
+            const QStringList& text = texts[texts.count() == carets.count() ? i : 0];
+            int insertedLines = doInsertTextByNormalMode(deleteBegin, text, newPos);
+            doLinesInserted(deleteBegin.line + 1, insertedLines);
+        }
+        lastLine = origEndLine;
+        chDelta = newPos.ch - origEndCh;
+        lineDelta = newPos.line - origEndLine;
+        if (carets[i].primary)
+            primaryPos = newPos;
+        else
+            newCarets.append(CaretSelection{newPos, newPos});
+    }
+    mExtraCarets = newCarets;
+    setCaretAndSelection(primaryPos, primaryPos, primaryPos);
+    ensureCursorPosVisible();
+    invalidate();
+}
+
+void QSynEdit::doMoveCarets(EditCommand command)
+{
+    auto movePos = [this, command](BufferCoord caret, BufferCoord anchor) {
+        BufferCoord pos = caret;
+        QString s = mDocument->getLine(pos.line - 1);
+        switch(command) {
+        case EditCommand::Left:
+            // collapse the selection to its begin
+            if (caret != anchor)
+                return coordLessThan(caret, anchor) ? caret : anchor;
+            if (pos.ch > 1) {
+                pos.ch = mDocument->charToGlyphStartChar(pos.line - 1, pos.ch - 2) + 1;
+            } else if (pos.line > 1) {
+                pos.line--;
+                pos.ch = mDocument->getLine(pos.line - 1).length() + 1;
+            }
+            break;
+        case EditCommand::Right:
+            if (caret != anchor)
+                return coordLessThan(caret, anchor) ? anchor : caret;
+            if (pos.ch <= s.length()) {
+                int glyphIdx = mDocument->charToGlyphIndex(pos.line - 1, pos.ch - 1);
+                pos.ch = mDocument->glyphStartChar(pos.line - 1, glyphIdx)
+                        + mDocument->glyphLength(pos.line - 1, glyphIdx) + 1;
+            } else if (pos.line < mDocument->count()) {
+                pos.line++;
+                pos.ch = 1;
+            }
+            break;
+        case EditCommand::LineStart:
+            pos.ch = 1;
+            break;
+        case EditCommand::LineEnd:
+            pos.ch = s.length() + 1;
+            break;
+        default:
+            break;
+        }
+        return pos;
+    };
+    BufferCoord primaryPos = movePos(caretXY(), caretXY() == blockBegin() ? blockEnd() : blockBegin());
+    QVector<CaretSelection> newCarets;
+    newCarets.reserve(mExtraCarets.count());
+    for (const CaretSelection& caret : mExtraCarets) {
+        BufferCoord pos = movePos(caret.caret, caret.anchor);
+        // carets moved to the same place are merged
+        bool exists = (pos == primaryPos);
+        if (!exists && !newCarets.isEmpty() && newCarets.last().caret == pos)
+            exists = true;
+        if (!exists)
+            newCarets.append(CaretSelection{pos, pos});
+    }
+    mExtraCarets = newCarets;
+    setCaretAndSelection(primaryPos, primaryPos, primaryPos);
+    ensureCursorPosVisible();
+    invalidate();
+}
+
+void QSynEdit::paintExtraCarets(QPainter &painter)
+{
+    if (mExtraCarets.isEmpty())
+        return;
+    QColor caretColor = mCaretUseTextColor ? mForegroundColor : mCaretColor;
+    QColor selectionColor = mSelectedBackground;
+    selectionColor.setAlpha(128);
+    int firstLine = rowToLine(mTopLine);
+    int lastLine = rowToLine(mTopLine + mLinesInWindow + 1);
+    int caretWidth = std::max(1, mTextHeight/15);
+    painter.setClipRect(QRect(mGutterWidth, 0, clientWidth() - mGutterWidth, clientHeight()),
+                        Qt::IntersectClip);
+    for (const CaretSelection& caret : mExtraCarets) {
+        BufferCoord begin = coordLessThan(caret.anchor, caret.caret) ? caret.anchor : caret.caret;
+        BufferCoord end = coordLessThan(caret.anchor, caret.caret) ? caret.caret : caret.anchor;
+        if (end.line < firstLine || begin.line > lastLine)
+            continue;
+        if (begin != end) {
+            QPoint p1 = displayCoordToPixels(bufferToDisplayPos(begin));
+            QPoint p2 = displayCoordToPixels(bufferToDisplayPos(end));
+            if (p1.y() == p2.y()) {
+                painter.fillRect(QRect(p1.x(), p1.y(), p2.x() - p1.x(), mTextHeight), selectionColor);
+            } else {
+                painter.fillRect(QRect(p1.x(), p1.y(), clientWidth() - p1.x(), mTextHeight), selectionColor);
+                painter.fillRect(QRect(mGutterWidth, p1.y() + mTextHeight,
+                                       clientWidth() - mGutterWidth, p2.y() - p1.y() - mTextHeight), selectionColor);
+                painter.fillRect(QRect(mGutterWidth, p2.y(), p2.x() - mGutterWidth, mTextHeight), selectionColor);
+            }
+        }
+        QPoint p = displayCoordToPixels(bufferToDisplayPos(caret.caret));
+        if (p.x() >= mGutterWidth)
+            painter.fillRect(QRect(p.x() + 1, p.y(), caretWidth, mTextHeight), caretColor);
+    }
+}
+
 void QSynEdit::doComment()
 {
     BufferCoord origBlockBegin, origBlockEnd, origCaret;
@@ -1828,7 +2432,10 @@ void QSynEdit::endEditing()
     if (mEditingCount==0) {
         if (!mUndoing)
             mUndoList->endBlock();
-        reparseDocument();
+        if (mDeferReparse)
+            reparseDirtyLines();
+        else
+            reparseDocument();
     }
     decPaintLock();
 }
@@ -2491,6 +3098,9 @@ QRect QSynEdit::calculateCaretRect() const
             coord.x = segmentIntervalStart(mGlyphPostionCacheForInputMethod.glyphPositionList,0,mGlyphPostionCacheForInputMethod.strWidth, glyphIdx);
         } else
             coord.x = charToGlyphLeft(mCaretY, sLine, mCaretX+mInputPreeditString.length());
+        int rowLeft, rowRight;
+        rowBounds(coord.row, rowLeft, rowRight);
+        coord.x -= rowLeft;
     }
     int rows=1;
     if (mActiveSelectionMode == SelectionMode::Column) {
@@ -3009,6 +3619,35 @@ SyntaxState QSynEdit::calcSyntaxStateAtLine(int line, const QString &newLineText
     return syntaxer()->getState();
 }
 
+MiniMap *QSynEdit::miniMap() const
+{
+    return mMiniMap;
+}
+
+void QSynEdit::setMiniMap(MiniMap *miniMap)
+{
+    if (mMiniMap == miniMap)
+        return;
+    delete mMiniMap;
+    mMiniMap = miniMap;
+    if (mMiniMap) {
+        mMiniMap->setParent(this);
+        setViewportMargins(0, 0, mMiniMap->width(), 0);
+        updateMiniMapGeometry();
+        mMiniMap->show();
+    } else {
+        setViewportMargins(0, 0, 0, 0);
+    }
+}
+
+void QSynEdit::updateMiniMapGeometry()
+{
+    if (!mMiniMap)
+        return;
+    QRect rect = viewport()->geometry();
+    mMiniMap->setGeometry(rect.right() + 1, rect.top(), mMiniMap->width(), rect.height());
+}
+
 int QSynEdit::clientWidth() const
 {
     return viewport()->size().width();
@@ -3137,7 +3776,7 @@ void QSynEdit::updateHScrollbar()
         mStateFlags.setFlag(StateFlag::sfHScrollbarChanged);
     } else {
         mStateFlags.setFlag(StateFlag::sfHScrollbarChanged,false);
-        if (mScrollBars != ScrollStyle::ssNone) {
+        if (mScrollBars != ScrollStyle::ssNone && !mOptions.testFlag(eoWrapLines)) {
             if (mOptions.testFlag(eoHideShowScrollbars)) {
                 setHorizontalScrollBarPolicy(Qt::ScrollBarPolicy::ScrollBarAsNeeded);
             } else {
@@ -3315,7 +3954,12 @@ void QSynEdit::updateModifiedStatus()
 
 void QSynEdit::reparseLines(int startLine, int endLine)
 {
+    TraceSpan traceSpan("QSynEdit::reparseLines");
 
+    if (mDeferReparse) {
+        markLinesDirty(startLine, endLine);
+        return;
+    }
     SyntaxState state;
     startLine = std::max(0,startLine);
     endLine = std::min(endLine, mDocument->count());
@@ -3364,6 +4008,64 @@ void QSynEdit::reparseLines(int startLine, int endLine)
 //     mDocument->setSyntaxState(line,iRange);
 // }
 
+void QSynEdit::deferReparse()
+{
+    // must be called in an editing block, the lines are reparsed when it ends
+    Q_ASSERT(mEditingCount > 0);
+    if (mDeferReparse)
+        return;
+    mDeferReparse = true;
+    mDirtyStartLine = INT_MAX;
+    mDirtyEndLine = 0;
+}
+
+void QSynEdit::markLinesDirty(int startLine, int endLine)
+{
+    mDirtyStartLine = std::min(mDirtyStartLine, startLine);
+    mDirtyEndLine = std::max(mDirtyEndLine, endLine);
+}
+
+void QSynEdit::reparseDirtyLines()
+{
+    TraceSpan traceSpan("QSynEdit::reparseDirtyLines");
+    mDeferReparse = false;
+    flushDirtyLines();
+    if (useCodeFolding())
+        rescanFolds();
+}
+
+void QSynEdit::flushDirtyLines()
+{
+    int startLine = std::max(0, mDirtyStartLine);
+    int endLine = std::min(mDirtyEndLine, mDocument->count());
+    if (startLine < endLine) {
+        if (startLine == 0) {
+            mSyntaxer->resetState();
+        } else {
+            mSyntaxer->setState(mDocument->getSyntaxState(startLine-1));
+        }
+        int line = startLine;
+        while (line < mDocument->count()) {
+            mSyntaxer->setLine(mDocument->getLine(line), line);
+            mSyntaxer->nextToEol();
+            SyntaxState state = mSyntaxer->getState();
+            // lines after the changed ones are parsed until their states are not changed
+            if (line >= endLine) {
+                if (!mSyntaxer->needsLineState())
+                    break;
+                SyntaxState oldState = mDocument->getSyntaxState(line);
+                if (oldState == state)
+                    break;
+            }
+            mDocument->setSyntaxState(line, state);
+            line++;
+        }
+        invalidateLines(startLine + 1, line + 1);
+    }
+    mDirtyStartLine = INT_MAX;
+    mDirtyEndLine = 0;
+}
+
 void QSynEdit::reparseDocument()
 {
     if (!mDocument->empty()) {
@@ -3386,6 +4088,7 @@ void QSynEdit::uncollapse(PCodeFoldingRange FoldRange)
 {
     FoldRange->linesCollapsed = 0;
     FoldRange->collapsed = false;
+    mCollapsedFoldIndex.invalidate();
 
     // Redraw the collapsed line
     invalidateLines(FoldRange->fromLine, INT_MAX);
@@ -3400,6 +4103,7 @@ void QSynEdit::collapse(PCodeFoldingRange FoldRange)
 {
     FoldRange->linesCollapsed = FoldRange->toLine - FoldRange->fromLine;
     FoldRange->collapsed = true;
+    mCollapsedFoldIndex.invalidate();
 
     // Extract caret from fold
     if ((mCaretY > FoldRange->fromLine) && (mCaretY <= FoldRange->toLine)) {
@@ -3419,6 +4123,7 @@ void QSynEdit::collapse(PCodeFoldingRange FoldRange)
 
 void QSynEdit::foldOnLinesInserted(int Line, int Count)
 {
+    mCollapsedFoldIndex.invalidate();
     // Delete collapsed inside selection
     for (int i = mAllFoldRanges->count()-1;i>=0;i--) {
         PCodeFoldingRange range = (*mAllFoldRanges)[i];
@@ -3432,6 +4137,7 @@ void QSynEdit::foldOnLinesInserted(int Line, int Count)
 
 void QSynEdit::foldOnLinesDeleted(int Line, int Count)
 {
+    mCollapsedFoldIndex.invalidate();
     // Delete collapsed inside selection
     for (int i = mAllFoldRanges->count()-1;i>=0;i--) {
         PCodeFoldingRange range = (*mAllFoldRanges)[i];
@@ -3449,6 +4155,7 @@ void QSynEdit::foldOnLinesDeleted(int Line, int Count)
 
 void QSynEdit::foldOnListCleared()
 {
+    mCollapsedFoldIndex.invalidate();
     mAllFoldRanges->clear();
 }
 
@@ -3467,6 +4174,7 @@ void QSynEdit::rescanFolds()
 
 void QSynEdit::rescanForFoldRanges()
 {
+    mCollapsedFoldIndex.invalidate();
     // Delete all uncollapsed folds
 //    for (int i=mAllFoldRanges.count()-1;i>=0;i--) {
 //        PSynEditFoldRange range =mAllFoldRanges[i];
@@ -3813,6 +4521,7 @@ void QSynEdit::onSizeOrFontChanged(bool bFont)
         } else {
             updateHScrollbar();
         }
+        rewrapLines(bFont);
         //if (!mOptions.testFlag(SynEditorOption::eoScrollPastEol))
         setLeftPos(mLeftPos);
         //if (!mOptions.testFlag(SynEditorOption::eoScrollPastEof))
@@ -3827,9 +4536,64 @@ void QSynEdit::onChanged()
 
 void QSynEdit::onScrolled(int)
 {
+    int oldLeftPos = mLeftPos;
+    int oldTopLine = mTopLine;
     mLeftPos = horizontalScrollBar()->value();
     mTopLine = verticalScrollBar()->value();
-    invalidate();
+    if (!scrollContentImage(oldLeftPos - mLeftPos, (oldTopLine - mTopLine) * mTextHeight))
+        invalidate();
+}
+
+bool QSynEdit::scrollContentImage(int dx, int dy)
+{
+    if (dx == 0 && dy == 0)
+        return true;
+    if (dx != 0 && dy != 0)
+        return false;
+    if (mPainterLock>0 || mStateFlags.testFlag(StateFlag::sfRedrawNeeded) || !isVisible())
+        return false;
+    // the gutter and the left margin don't move horizontally, so they are always repainted
+    QRect scrollRect{mGutterWidth + 2, 0, clientWidth() - mGutterWidth - 2, clientHeight()};
+    if (std::abs(dx) >= scrollRect.width() || std::abs(dy) >= scrollRect.height())
+        return false;
+    // the image can only be moved by whole device pixels
+    qreal dpr = mContentImage->devicePixelRatioF();
+    if (dpr != std::floor(dpr))
+        return false;
+    int scale = (int)dpr;
+    QRect deviceRect{scrollRect.left()*scale, scrollRect.top()*scale,
+                scrollRect.width()*scale, scrollRect.height()*scale};
+    deviceRect = deviceRect.intersected(mContentImage->rect());
+    int deviceDX = dx*scale;
+    int deviceDY = dy*scale;
+    QRect source = deviceRect.translated(-deviceDX, -deviceDY).intersected(deviceRect);
+    if (source.isEmpty())
+        return false;
+    int bytesPerPixel = mContentImage->depth() / 8;
+    int bytesPerLine = mContentImage->bytesPerLine();
+    int length = source.width() * bytesPerPixel;
+    uchar* bits = mContentImage->bits();
+    auto moveLine = [&](int y) {
+        std::memmove(bits + (y + deviceDY) * bytesPerLine + (source.left() + deviceDX) * bytesPerPixel,
+                     bits + y * bytesPerLine + source.left() * bytesPerPixel,
+                     length);
+    };
+    if (deviceDY > 0) {
+        for (int y = source.bottom(); y >= source.top(); y--)
+            moveLine(y);
+    } else {
+        for (int y = source.top(); y <= source.bottom(); y++)
+            moveLine(y);
+    }
+
+    QRect target = scrollRect.translated(dx, dy).intersected(scrollRect);
+    QRegion all{0, 0, clientWidth(), clientHeight()};
+    // unpainted parts are moved with the content, and the exposed band is painted
+    mContentImageDirtyRegion = mContentImageDirtyRegion.translated(dx, dy).intersected(target)
+            + (all - target);
+    mContentImageBlitRegion = all - mContentImageDirtyRegion;
+    viewport()->update();
+    return true;
 }
 
 const PFormatter &QSynEdit::formatter() const
@@ -4071,6 +4835,7 @@ void QSynEdit::setTabSize(int newTabSize)
     if (newTabSize!=tabSize()) {
         incPaintLock();
         mDocument->setTabSize(newTabSize);
+        rewrapLines(true);
         invalidate();
         decPaintLock();
     }
@@ -4103,9 +4868,29 @@ void QSynEdit::setOptions(const EditorOptions &Value)
                 || !sameEditorOption(Value,mOptions, eoShowTrailingSpaces)
                 || !sameEditorOption(Value,mOptions, eoShowLineBreaks)
                 || !sameEditorOption(Value,mOptions, eoShowRainbowColor);
+        bool bWrapChanged = !sameEditorOption(Value,mOptions, eoWrapLines);
+        bool bRewrap = !sameEditorOption(Value,mOptions, eoLigatureSupport)
+                || !sameEditorOption(Value,mOptions, eoForceMonospace);
+        // rows are counted differently after wrapping is changed, keep the top line in view
+        int topLine = rowToLine(mTopLine);
         mOptions = Value;
 
         mDocument->setForceMonospace(mOptions.testFlag(eoForceMonospace) );
+        if (bWrapChanged) {
+            bUpdateAll = true;
+            if (mOptions.testFlag(eoWrapLines)) {
+                mLineWrapIndex.reset(mDocument->count());
+                mLineWrapFoldRevision = 0;
+                rewrapLines(true);
+            } else {
+                mLineWrapTimer->stop();
+                mLineWrapIndex.reset(0);
+            }
+            mTopLine = lineToRow(topLine);
+            updateVScrollbar();
+        } else if (bRewrap) {
+            rewrapLines(true);
+        }
 
         // constrain caret position to MaxScrollWidth if eoScrollPastEol is enabled
         internalSetCaretXY(caretXY());
@@ -4160,6 +4945,14 @@ void QSynEdit::doUndo()
     if (item) {
         size_t oldChangeNumber = item->changeNumber();
         {
+            // changes of a multi-caret edit are reparsed together
+            incPaintLock();
+            beginEditingWithoutUndo();
+            deferReparse();
+            auto action = finally([this]{
+                endEditingWithoutUndo();
+                decPaintLock();
+            });
             ChangeReason  lastChange = mUndoList->lastChangeReason();
             bool keepGoing;
             do {
@@ -4361,6 +5154,9 @@ void QSynEdit::doRedo()
     }
     ChangeReason lastChange = mRedoList->lastChangeReason();
     bool keepGoing;
+    incPaintLock();
+    beginEditingWithoutUndo();
+    deferReparse();
     do {
       doRedoItem();
       item = mRedoList->peekItem();
@@ -4377,6 +5173,8 @@ void QSynEdit::doRedo()
         lastChange = item->changeReason();
       }
     } while (keepGoing);
+    endEditingWithoutUndo();
+    decPaintLock();
 
     //restore Group Break
     while (mRedoList->lastChangeReason()==ChangeReason::GroupBreak) {
@@ -4783,8 +5581,7 @@ void QSynEdit::moveCaretHorz(int deltaX, bool isSelection)
             if (mActiveSelectionMode==SelectionMode::Column) {
                 return;
             }
-            int row = lineToRow(ptDst.line);
-            row++;
+            int row = lineToRow(ptDst.line) + lineRowCount(ptDst.line);
             int line = rowToLine(row);
             if (line!=ptDst.line && line<=mDocument->count()) {
                 ptDst.line = line;
@@ -5420,6 +6217,9 @@ int QSynEdit::doInsertTextByNormalMode(const BufferCoord& pos, const QStringList
         if (!mUndoing && mSyntaxer->language()==ProgrammingLanguage::CPP && mOptions.testFlag(eoAutoIndent)) {
             QString s = trimLeft(text[0]);
             if (sLeftSide.isEmpty()) {
+                // the indent is calculated from the syntax states of the lines above
+                if (mDeferReparse)
+                    flushDirtyLines();
                 sLeftSide = GetLeftSpacing(calcIndentSpaces(caretY,s,true),true);
             }
             str = sLeftSide + s;
@@ -5455,6 +6255,8 @@ int QSynEdit::doInsertTextByNormalMode(const BufferCoord& pos, const QStringList
                 str += sRightSide;
         }
         if (!mUndoing && mSyntaxer->language()==ProgrammingLanguage::CPP && mOptions.testFlag(eoAutoIndent) && notInComment) {
+            if (mDeferReparse)
+                flushDirtyLines();
             int indentSpaces = calcIndentSpaces(caretY,str,true);
             str = GetLeftSpacing(indentSpaces,true)+trimLeft(str);
         }
@@ -5608,6 +6410,30 @@ void QSynEdit::executeCommand(EditCommand command, QChar ch, void *pData)
         decPaintLock();
         showCaret();
     });
+    if (!mExtraCarets.isEmpty()) {
+        if (isMultiCaretCommand(command)) {
+            if (command == EditCommand::Left || command == EditCommand::Right
+                    || command == EditCommand::LineStart || command == EditCommand::LineEnd)
+                doMoveCarets(command);
+            else
+                doEditAtCarets(command, ch, pData);
+            return;
+        }
+        switch(command) {
+        case EditCommand::Copy:
+        case EditCommand::ScrollUp:
+        case EditCommand::ScrollDown:
+        case EditCommand::ScrollLeft:
+        case EditCommand::ScrollRight:
+        case EditCommand::ZoomIn:
+        case EditCommand::ZoomOut:
+        case EditCommand::AddCaretAtNextOccurrence:
+        case EditCommand::SelectAllOccurrences:
+            break;
+        default:
+            clearExtraCarets();
+        }
+    }
     switch(command) {
     //horizontal caret movement or selection
     case EditCommand::Left:
@@ -5713,6 +6539,15 @@ void QSynEdit::executeCommand(EditCommand command, QChar ch, void *pData)
     case EditCommand::SelectAll:
         doSelectAll();
         break;
+    case EditCommand::AddCaretAtNextOccurrence:
+        doAddCaretAtNextOccurrence();
+        break;
+    case EditCommand::SelectAllOccurrences:
+        doSelectAllOccurrences();
+        break;
+    case EditCommand::AddCaretsFromColumnSelection:
+        doAddCaretsFromColumnSelection();
+        break;
     case EditCommand::ExpandSelection:
         doExpandSelection(caretXY());
         break;
@@ -5881,8 +6716,12 @@ void QSynEdit::beginEditingWithoutUndo()
 void QSynEdit::endEditingWithoutUndo()
 {
     mEditingCount--;
-    if (mEditingCount==0)
-        reparseDocument();
+    if (mEditingCount==0) {
+        if (mDeferReparse)
+            reparseDirtyLines();
+        else
+            reparseDocument();
+    }
 }
 
 bool QSynEdit::isIdentChar(const QChar &ch)
@@ -5938,11 +6777,19 @@ void QSynEdit::paintEvent(QPaintEvent *event)
     auto action = finally([&,this] {
         mPainting = false;
     });
+    TraceSpan traceSpan("QSynEdit::paintEvent");
 
     // Now paint everything while the caret is hidden.
     QPainter painter(viewport());
     //Get the invalidated rect.
     QRect rcClip = event->rect();
+    if (mOptions.testFlag(eoWrapLines) && wrapVisibleLines()) {
+        // rows of the visible lines are changed, everything below them moves
+        rcClip = clientRect();
+        mContentImageBlitRegion = QRegion();
+        updateVScrollbar();
+        mLineWrapTimer->start();
+    }
     QRect rcCaret = calculateCaretRect();
 
     if (rcCaret == rcClip) {
@@ -5958,37 +6805,21 @@ void QSynEdit::paintEvent(QPaintEvent *event)
         painter.drawImage(rcCaret,*mContentImage,cacheRC);
     } else {
         //qDebug()<<"paint event:"<<rcClip;
-        QRect rcDraw;
-        int nL1, nL2, nX1, nX2;
-        // Compute the invalid area in lines / columns.
-        // columns
-        nX1 = mLeftPos;
-        if (rcClip.left() > mGutterWidth + 2 )
-            nX1 += (rcClip.left() - mGutterWidth - 2 ) ;
-        nX2 = mLeftPos + (rcClip.right() - mGutterWidth - 2);
-        // lines
-        nL1 = minMax(mTopLine + rcClip.top() / mTextHeight, mTopLine, displayLineCount());
-        nL2 = minMax(mTopLine + (rcClip.bottom() + mTextHeight - 1) / mTextHeight, 1, displayLineCount());
-
-        //qDebug()<<"Paint:"<<nL1<<nL2<<nC1<<nC2;
-
         QPainter cachePainter(mContentImage.get());
         cachePainter.setFont(font());
-        QSynEditPainter textPainter(this, &cachePainter,
-                                       nL1,nL2,nX1,nX2);
-        // First paint paint the text area if it was (partly) invalidated.
-        if (rcClip.right() > mGutterWidth ) {
-            rcDraw = rcClip;
-            rcDraw.setLeft( std::max(rcDraw.left(), mGutterWidth));
-            textPainter.paintEditingArea(rcDraw);
-        }
-
-        // Then the gutter area if it was (partly) invalidated.
-        if (rcClip.left() < mGutterWidth) {
-            rcDraw = rcClip;
-            rcDraw.setRight(mGutterWidth-1);
-            textPainter.paintGutter(rcDraw);
+        if (mContentImageBlitRegion.isEmpty()) {
+            paintContent(cachePainter, rcClip);
+        } else {
+            // content moved by scrolling is already in the image
+            QRegion region = QRegion(rcClip) - mContentImageBlitRegion;
+            for (const QRect& rect : region) {
+                cachePainter.setClipRect(rect);
+                paintContent(cachePainter, rect);
+            }
+            cachePainter.setClipping(false);
         }
+        mContentImageDirtyRegion -= rcClip;
+        mContentImageBlitRegion -= rcClip;
 
         //PluginsAfterPaint(Canvas, rcClip, nL1, nL2);
         // If there is a custom paint handler call it.
@@ -6004,6 +6835,72 @@ void QSynEdit::paintEvent(QPaintEvent *event)
         rcCaret = calculateCaretRect();
     }
     paintCaret(painter, rcCaret);
+    painter.setClipRect(rcClip);
+    paintExtraCarets(painter);
+    if (mPendingKeystrokeTime>=0) {
+        qint64 now = Tracer::now();
+        Tracer::record("keystroke-to-paint", mPendingKeystrokeTime, now);
+        Tracer::addLatencySample(now - mPendingKeystrokeTime);
+        mPendingKeystrokeTime = -1;
+        // the overlay may be outside of the painted area
+        viewport()->update(0, 0, clientWidth(), QFontMetrics(QApplication::font()).height() + 8);
+    }
+    if (Tracer::enabled())
+        paintTracerOverlay(painter);
+}
+
+void QSynEdit::paintTracerOverlay(QPainter &painter)
+{
+    QVector<qint64> samples = Tracer::sortedLatencySamples();
+    QString text = QString("key-to-paint p50 %1ms  p95 %2ms  p99 %3ms  max %4ms  (%5)")
+            .arg(Tracer::percentile(samples, 50) / 1000000.0, 0, 'f', 2)
+            .arg(Tracer::percentile(samples, 95) / 1000000.0, 0, 'f', 2)
+            .arg(Tracer::percentile(samples, 99) / 1000000.0, 0, 'f', 2)
+            .arg(Tracer::percentile(samples, 100) / 1000000.0, 0, 'f', 2)
+            .arg(samples.count());
+    QFont font = QApplication::font();
+    QFontMetrics metrics(font);
+    QRect rect = metrics.boundingRect(text).adjusted(-4, -2, 4, 2);
+    rect.moveTopRight(QPoint(clientWidth() - 4, 4));
+    painter.save();
+    painter.setFont(font);
+    painter.fillRect(rect, QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+    painter.drawText(rect, Qt::AlignCenter, text);
+    painter.restore();
+}
+
+void QSynEdit::paintContent(QPainter &painter, const QRect &rcClip)
+{
+    QRect rcDraw;
+    int nL1, nL2, nX1, nX2;
+    // Compute the invalid area in lines / columns.
+    // columns
+    nX1 = mLeftPos;
+    if (rcClip.left() > mGutterWidth + 2 )
+        nX1 += (rcClip.left() - mGutterWidth - 2 ) ;
+    nX2 = mLeftPos + (rcClip.right() - mGutterWidth - 2);
+    // lines
+    nL1 = minMax(mTopLine + rcClip.top() / mTextHeight, mTopLine, displayLineCount());
+    nL2 = minMax(mTopLine + (rcClip.bottom() + mTextHeight - 1) / mTextHeight, 1, displayLineCount());
+
+    //qDebug()<<"Paint:"<<nL1<<nL2<<nC1<<nC2;
+
+    QSynEditPainter textPainter(this, &painter,
+                                   nL1,nL2,nX1,nX2);
+    // First paint paint the text area if it was (partly) invalidated.
+    if (rcClip.right() > mGutterWidth ) {
+        rcDraw = rcClip;
+        rcDraw.setLeft( std::max(rcDraw.left(), mGutterWidth));
+        textPainter.paintEditingArea(rcDraw);
+    }
+
+    // Then the gutter area if it was (partly) invalidated.
+    if (rcClip.left() < mGutterWidth) {
+        rcDraw = rcClip;
+        rcDraw.setRight(mGutterWidth-1);
+        textPainter.paintGutter(rcDraw);
+    }
 }
 
 void QSynEdit::resizeEvent(QResizeEvent *)
@@ -6013,6 +6910,8 @@ void QSynEdit::resizeEvent(QResizeEvent *)
     mContentImage = std::make_shared<QImage>(clientWidth()*dpr,clientHeight()*dpr,
                                                             QImage::Format_ARGB32);
     mContentImage->setDevicePixelRatio(dpr);
+    mContentImageDirtyRegion = QRegion(0, 0, clientWidth(), clientHeight());
+    mContentImageBlitRegion = QRegion();
 //    QRect newRect = image->rect().intersected(mContentImage->rect());
 
 //    QPainter painter(image.get());
@@ -6021,6 +6920,7 @@ void QSynEdit::resizeEvent(QResizeEvent *)
 
 //    mContentImage = image;
 
+    updateMiniMapGeometry();
     onSizeOrFontChanged(false);
 }
 
@@ -6074,11 +6974,17 @@ void QSynEdit::focusOutEvent(QFocusEvent *)
 
 void QSynEdit::keyPressEvent(QKeyEvent *event)
 {
+    TraceSpan traceSpan("QSynEdit::keyPressEvent");
+    if (Tracer::enabled() && mPendingKeystrokeTime<0)
+        mPendingKeystrokeTime = Tracer::now();
     if (event->key() == Qt::Key_Escape && mActiveSelectionMode != SelectionMode::Normal) {
         setActiveSelectionMode(SelectionMode::Normal);
         setBlockBegin(caretXY());
         setBlockEnd(caretXY());
         event->accept();
+    } else if (event->key() == Qt::Key_Escape && !mExtraCarets.isEmpty()) {
+        clearExtraCarets();
+        event->accept();
     } else {
         EditCommand cmd=TranslateKeyCode(event->key(),event->modifiers());
         if (cmd!=EditCommand::None) {
@@ -6109,6 +7015,7 @@ void QSynEdit::mousePressEvent(QMouseEvent *event)
 
     QAbstractScrollArea::mousePressEvent(event);
 
+    clearExtraCarets();
 
     BufferCoord oldCaret=caretXY();
     if (button == Qt::RightButton) {
@@ -6227,6 +7134,9 @@ void QSynEdit::mouseDoubleClickEvent(QMouseEvent *event)
 
 void QSynEdit::inputMethodEvent(QInputMethodEvent *event)
 {
+    TraceSpan traceSpan("QSynEdit::inputMethodEvent");
+    if (Tracer::enabled() && mPendingKeystrokeTime<0)
+        mPendingKeystrokeTime = Tracer::now();
 //    qDebug()<<event->replacementStart()<<":"<<event->replacementLength()<<" - "
 //           << event->preeditString()<<" - "<<event->commitString();
 
@@ -6301,6 +7211,11 @@ void QSynEdit::wheelEvent(QWheelEvent *event)
 
 bool QSynEdit::viewportEvent(QEvent * event)
 {
+    if (event->type() == QEvent::Hide) {
+        // changes are not tracked while hidden
+        mContentImageDirtyRegion = QRegion(0, 0, clientWidth(), clientHeight());
+        mContentImageBlitRegion = QRegion();
+    }
 //    switch (event->type()) {
 //        case QEvent::Resize:
 //            sizeOrFontChanged(false);
@@ -6512,6 +7427,7 @@ void QSynEdit::setGutterWidth(int Value)
     if (mGutterWidth != Value) {
         mGutterWidth = Value;
         // onSizeOrFontChanged(false);
+        rewrapLines(false);
         invalidate();
     }
 }
@@ -6570,6 +7486,8 @@ void QSynEdit::onLinesCleared()
 {
     if (useCodeFolding())
         foldOnListCleared();
+    if (mOptions.testFlag(eoWrapLines))
+        mLineWrapIndex.reset(0);
     clearUndo();
     // invalidate the *whole* client area
     mInvalidateRect={0,0,0,0};
@@ -6584,9 +7502,21 @@ void QSynEdit::onLinesCleared()
 
 void QSynEdit::onLinesDeleted(int line, int count)
 {
+    if (!mEditingAtCarets)
+        clearExtraCarets();
     if (useCodeFolding())
         foldOnLinesDeleted(line + 1, count);
-    if (mSyntaxer->needsLineState()) {
+    if (mOptions.testFlag(eoWrapLines)
+            && mLineWrapIndex.lineCount() - count == mDocument->count())
+        mLineWrapIndex.linesDeleted(line, count);
+    if (mDeferReparse) {
+        // move the dirty lines after the deleted ones
+        if (mDirtyEndLine > line)
+            mDirtyEndLine = std::max(line, mDirtyEndLine - count);
+        if (mDirtyStartLine > line)
+            mDirtyStartLine = std::max(line, mDirtyStartLine - count);
+        markLinesDirty(line, line + 1);
+    } else if (mSyntaxer->needsLineState()) {
         reparseLines(line, mDocument->count());
     }
     invalidateLines(line + 1, INT_MAX);
@@ -6595,9 +7525,24 @@ void QSynEdit::onLinesDeleted(int line, int count)
 
 void QSynEdit::onLinesInserted(int line, int count)
 {
+    if (!mEditingAtCarets)
+        clearExtraCarets();
     if (useCodeFolding())
         foldOnLinesInserted(line + 1, count);
-    if (mSyntaxer->needsLineState()) {
+    if (mOptions.testFlag(eoWrapLines)) {
+        if (mLineWrapIndex.lineCount() + count == mDocument->count())
+            mLineWrapIndex.linesInserted(line, count);
+        syncLineWrapIndex();
+        wrapChangedLines(line + 1, count);
+    }
+    if (mDeferReparse) {
+        // move the dirty lines after the inserted ones
+        if (mDirtyEndLine > line)
+            mDirtyEndLine += count;
+        if (mDirtyStartLine > line && mDirtyStartLine != INT_MAX)
+            mDirtyStartLine += count;
+        markLinesDirty(line, line + count);
+    } else if (mSyntaxer->needsLineState()) {
         reparseLines(line, mDocument->count());
     } else {
         // new lines should be parsed
@@ -6609,7 +7554,20 @@ void QSynEdit::onLinesInserted(int line, int count)
 
 void QSynEdit::onLinesPutted(int line)
 {
-    if (mSyntaxer->needsLineState()) {
+    if (!mEditingAtCarets)
+        clearExtraCarets();
+    if (mOptions.testFlag(eoWrapLines)) {
+        syncLineWrapIndex();
+        mLineWrapIndex.lineChanged(line);
+        if (wrapLine(line + 1) != 0) {
+            invalidateLines(line + 1, INT_MAX);
+            updateVScrollbar();
+        }
+    }
+    if (mDeferReparse) {
+        markLinesDirty(line, line + 1);
+        invalidateLine(line + 1);
+    } else if (mSyntaxer->needsLineState()) {
         reparseLines(line, mDocument->count());
         invalidateLines(line + 1, INT_MAX);
         //invalidateGutterLines(line +1 , INT_MAX);
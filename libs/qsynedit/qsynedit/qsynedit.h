@@ -21,11 +21,13 @@
 #include <QCursor>
 #include <QDateTime>
 #include <QFrame>
+#include <QRegion>
 #include <QStringList>
 #include <QTimer>
 #include <QWidget>
 #include "gutter.h"
 #include "codefolding.h"
+#include "linewrap.h"
 #include "types.h"
 #include "document.h"
 #include "keystrokes.h"
@@ -104,6 +106,7 @@ enum EditorOption {
     eoShowInnerSpaces =       0x00800000,
     eoShowLineBreaks =        0x01000000,
     eoForceMonospace =        0x02000000,
+    eoWrapLines =             0x04000000, //Wraps lines longer than the width of the editor into more rows
 };
 
 Q_DECLARE_FLAGS(EditorOptions, EditorOption)
@@ -135,6 +138,12 @@ using SearchMathedProc = std::function<SearchAction(const QString& sSearch,
     const QString& sReplace, int Line, int ch, int wordLen)>;
 using SearchConfirmAroundProc = std::function<bool ()>;
 
+// an extra caret of multi-caret editing, with the selection from anchor to caret
+struct CaretSelection {
+    BufferCoord caret;
+    BufferCoord anchor;
+};
+
 struct GlyphPostionsListCache {
     QString str;
     QList<int> glyphCharList;
@@ -144,6 +153,7 @@ struct GlyphPostionsListCache {
 
 
 class QSynEdit;
+class MiniMap;
 using PSynEdit = std::shared_ptr<QSynEdit>;
 
 class QSynEdit : public QAbstractScrollArea
@@ -256,6 +266,15 @@ public:
     void setSelLength(int Value);
     void setSelText(const QString& text);
 
+    // Multi-caret editing. The normal caret and selection is the primary one;
+    // chars typed, deleted or pasted are applied at all carets as one edit.
+    bool hasExtraCarets() const;
+    const QVector<CaretSelection>& extraCarets() const;
+    void clearExtraCarets();
+    void addCaretAtNextOccurrence() { processCommand(EditCommand::AddCaretAtNextOccurrence); }
+    void selectAllOccurrences() { processCommand(EditCommand::SelectAllOccurrences); }
+    void addCaretsFromColumnSelection() { processCommand(EditCommand::AddCaretsFromColumnSelection); }
+
     void replaceLine(int line, const QString& lineText);
     int searchReplace(const QString& sSearch, const QString& sReplace, SearchOptions options,
                PSynSearchBase searchEngine,  SearchMathedProc matchedCallback = nullptr,
@@ -399,6 +418,10 @@ public:
 
     int tabSize() const { return mDocument->tabSize(); }
     void setTabSize(int tabSize);
+
+    MiniMap *miniMap() const;
+    // the editor takes the ownership of the minimap, nullptr removes it
+    void setMiniMap(MiniMap *miniMap);
     int tabWidth() const { return mDocument->tabWidth(); }
 
     QColor caretColor() const;
@@ -506,6 +529,8 @@ protected:
     void incPaintLock();
     void decPaintLock();
     SyntaxState calcSyntaxStateAtLine(int line, const QString &newLineText);
+    // lines are reparsed once when the editing ends, instead of after each change
+    void deferReparse();
 private:
     BufferCoord ensureBufferCoordValid(const BufferCoord& coord);
     void beginEditingWithoutUndo();
@@ -543,6 +568,10 @@ private:
     void reparseLines(int startLine, int endLine);
     //void reparseLine(int line);
     void reparseDocument();
+    void markLinesDirty(int startLine, int endLine);
+    void reparseDirtyLines();
+    // reparse the dirty lines now, but keep deferring the later changes
+    void flushDirtyLines();
     void uncollapse(PCodeFoldingRange FoldRange);
     void collapse(PCodeFoldingRange FoldRange);
 
@@ -563,7 +592,18 @@ private:
     PCodeFoldingRange foldAroundLineEx(int line, bool wantCollapsed, bool acceptFromLine, bool acceptToLine);
     PCodeFoldingRange checkFoldRange(PCodeFoldingRanges foldRangesToCheck,int line, bool wantCollapsed, bool AcceptFromLine, bool AcceptToLine);
     PCodeFoldingRange foldEndAtLine(int line);
+    int lineRowCount(int line) const;
+    void rowBounds(int row, int& left, int& right) const;
+    void syncLineWrapIndex() const;
+    int lineWrapWidth() const;
+    int wrapLine(int line);
+    bool wrapVisibleLines();
+    void wrapChangedLines(int line, int count);
+    void rewrapLines(bool force);
     void paintCaret(QPainter& painter, const QRect rcClip);
+    void paintContent(QPainter& painter, const QRect& rcClip);
+    bool scrollContentImage(int dx, int dy);
+    void paintTracerOverlay(QPainter& painter);
     int textOffset() const;
     EditCommand TranslateKeyCode(int key, Qt::KeyboardModifiers modifiers);
     /**
@@ -647,6 +687,14 @@ private:
     void doZoomIn();
     void doZoomOut();
     void doSelectAll();
+    void doAddCaretAtNextOccurrence();
+    void doSelectAllOccurrences();
+    void doAddCaretsFromColumnSelection();
+    bool findOccurrence(const QString& text, const BufferCoord& from, BufferCoord& found);
+    bool isMultiCaretCommand(EditCommand command) const;
+    void doEditAtCarets(EditCommand command, QChar ch, void* pData);
+    void doMoveCarets(EditCommand command);
+    void paintExtraCarets(QPainter& painter);
     void doComment();
     void doUncomment();
     void doToggleComment();
@@ -670,12 +718,30 @@ private slots:
     void onDraggingScrollTimeout();
     void onUndoAdded();
     void onSizeOrFontChanged(bool bFont);
+    void updateMiniMapGeometry();
     void onChanged();
     void onScrolled(int value);
+    void onLineWrapTimeout();
 
 private:
     std::shared_ptr<QImage> mContentImage;
     PCodeFoldingRanges mAllFoldRanges;
+    // rebuilt lazily after folds are changed
+    mutable CollapsedFoldIndex mCollapsedFoldIndex;
+    // rows of the lines when eoWrapLines is set
+    mutable LineWrapIndex mLineWrapIndex;
+    // revision of mCollapsedFoldIndex the hidden lines are taken from
+    mutable int mLineWrapFoldRevision;
+    int mLineWrapWidth;
+    // wraps the lines not measured yet, in small batches
+    QTimer* mLineWrapTimer;
+    MiniMap* mMiniMap;
+    QVector<CaretSelection> mExtraCarets;
+    bool mEditingAtCarets;
+    bool mDeferReparse;
+    // lines changed while reparsing is deferred, [start, end)
+    int mDirtyStartLine;
+    int mDirtyEndLine;
     CodeFoldingOptions mCodeFolding;
     int mEditingCount;
     bool mUseCodeFolding;
@@ -693,6 +759,13 @@ private:
 
     bool mInserting;
     bool mPainting;
+    // parts of mContentImage that are not painted since invalidated
+    QRegion mContentImageDirtyRegion;
+    // parts of the viewport that only need to be copied from mContentImage,
+    // because their content is moved there by scrolling
+    QRegion mContentImageBlitRegion;
+    // when the last unpainted keystroke is received, -1 if none
+    qint64 mPendingKeystrokeTime;
     PDocument mDocument;
     int mLinesInWindow;
     int mLeftPos;
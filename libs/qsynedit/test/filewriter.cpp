@@ -0,0 +1,107 @@
+#include <cstdlib>
+#include <QByteArray>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextCodec>
+
+#include "qsynedit/filewriter.h"
+
+using namespace QSynedit;
+
+static void fail(const QString& test, const QString& message)
+{
+    qDebug() << "Error in test" << test << ":" << message;
+    exit(1);
+}
+
+static QByteArray readFile(const QString& test, const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        fail(test, "can't read " + fileName);
+    return file.readAll();
+}
+
+static QByteArray save(const QString& test, const QString& fileName, const QStringList& lines,
+                       const QString& lineBreak, const QByteArray& encoding, QByteArray& realEncoding)
+{
+    try {
+        saveLinesToFile(fileName, lines, lineBreak, encoding, ENCODING_UTF8, realEncoding);
+    } catch (FileError& e) {
+        fail(test, e.reason());
+    }
+    return readFile(test, fileName);
+}
+
+static void testEncodings(const QTemporaryDir& dir)
+{
+    QString fileName = dir.filePath("encodings.txt");
+    QByteArray realEncoding;
+    QByteArray data = save("ascii", fileName, {"int main()", "{", "}"}, "\n", ENCODING_AUTO_DETECT, realEncoding);
+    if (data != "int main()\n{\n}\n" || realEncoding != ENCODING_ASCII)
+        fail("ascii", "wrong content or encoding");
+
+    QString chinese = QString::fromUtf8("\xe4\xbd\xa0\xe5\xa5\xbd");
+    data = save("utf8", fileName, {"// " + chinese, "int x;"}, "\r\n", ENCODING_UTF8, realEncoding);
+    if (data != ("// " + chinese + "\r\nint x;\r\n").toUtf8() || realEncoding != ENCODING_UTF8)
+        fail("utf8", "wrong content or encoding");
+
+    data = save("utf8 bom", fileName, {"x"}, "\n", ENCODING_UTF8_BOM, realEncoding);
+    if (data != "\xEF\xBB\xBFx\n")
+        fail("utf8 bom", "wrong content");
+
+    // utf-16 files have one bom, and don't end with a line break
+    data = save("utf16", fileName, {"a", "b"}, "\n", ENCODING_UTF16, realEncoding);
+    if (data.length() != 8 || realEncoding != ENCODING_UTF16)
+        fail("utf16", QString("%1 bytes, expected 8").arg(data.length()));
+
+    // stateful codecs are encoded across the chunks
+    QStringList lines;
+    for (int i=0;i<20000;i++)
+        lines.append(QString("line %1 ").arg(i) + chinese);
+    data = save("gbk", fileName, lines, "\n", "GBK", realEncoding);
+    QTextCodec* codec = QTextCodec::codecForName("GBK");
+    if (codec && data != codec->fromUnicode(lines.join("\n")+"\n"))
+        fail("gbk", "wrong content");
+}
+
+static void testAtomic(const QTemporaryDir& dir)
+{
+    QDir atomicDir(dir.filePath("atomic"));
+    if (!atomicDir.mkpath("."))
+        fail("atomic", "can't create dir");
+    QString fileName = atomicDir.filePath("atomic.txt");
+    QByteArray realEncoding;
+    save("atomic", fileName, {"old"}, "\n", ENCODING_UTF8, realEncoding);
+    // the file is kept if the codec can't be loaded
+    try {
+        saveLinesToFile(fileName, {"new"}, "\n", "no-such-codec", ENCODING_UTF8, realEncoding);
+        fail("atomic", "bad codec accepted");
+    } catch (FileError&) {
+    }
+    if (readFile("atomic", fileName) != "old\n")
+        fail("atomic", "file changed by a failed save");
+    try {
+        saveLinesToFile(atomicDir.filePath("missing/file.txt"), {"new"}, "\n", ENCODING_UTF8, ENCODING_UTF8, realEncoding);
+        fail("atomic", "missing directory accepted");
+    } catch (FileError&) {
+    }
+    // no temporary files are left
+    QStringList files = atomicDir.entryList(QDir::Files);
+    if (files != QStringList{"atomic.txt"})
+        fail("atomic", "files left in the directory: " + files.join(", "));
+}
+
+int main()
+{
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("main", "can't create temp dir");
+    testEncodings(dir);
+    testAtomic(dir);
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <cstdlib>
+#include <random>
+#include <QDebug>
+#include <QVector>
+
+#include "qsynedit/codefolding.h"
+
+using namespace QSynedit;
+
+// the linear implementations QSynEdit::foldRowToLine / foldLineToRow used before
+int linearRowToLine(const PCodeFoldingRanges& allFoldRanges, int row)
+{
+    int result = row;
+    for (int i=0;i<allFoldRanges->count();i++) {
+        PCodeFoldingRange range = (*allFoldRanges)[i];
+        if (range->collapsed && !range->parentCollapsed() && range->fromLine < result) {
+            result += range->linesCollapsed;
+        }
+    }
+    return result;
+}
+
+int linearLineToRow(const PCodeFoldingRanges& allFoldRanges, int line)
+{
+    int result = line;
+    for (int i=allFoldRanges->count()-1;i>=0;i--) {
+        PCodeFoldingRange range =(*allFoldRanges)[i];
+        if (range->collapsed && !range->parentCollapsed()) {
+            if (range->toLine < line)
+                result -= range->linesCollapsed;
+            else if (range->fromLine < line && line <= range->toLine)
+                result -= line - range->fromLine;
+        }
+    }
+    return result;
+}
+
+// nested folds, like the ones found by QSynEdit::findSubFoldRange
+PCodeFoldingRanges randomFolds(std::mt19937& random, int lineCount)
+{
+    PCodeFoldingRanges allFoldRanges = std::make_shared<CodeFoldingRanges>();
+    PCodeFoldingRanges parentFoldRanges = allFoldRanges;
+    PCodeFoldingRange parent;
+    for (int line=1;line<=lineCount;line++) {
+        int closes = random() % 3;
+        for (int i=0;i<closes && parent && parent->fromLine<line;i++) {
+            parent->toLine = line;
+            parent = parent->parent.lock();
+            parentFoldRanges = parent ? parent->subFoldRanges : allFoldRanges;
+        }
+        int opens = random() % 3;
+        for (int i=0;i<opens && line<lineCount;i++) {
+            parent = parentFoldRanges->addByParts(parent, allFoldRanges, line, line);
+            parentFoldRanges = parent->subFoldRanges;
+        }
+    }
+    while (parent) {
+        parent->toLine = lineCount;
+        parent = parent->parent.lock();
+    }
+    foreach (const PCodeFoldingRange& range, allFoldRanges->ranges()) {
+        if (range->toLine > range->fromLine && random() % 3 == 0) {
+            range->collapsed = true;
+            range->linesCollapsed = range->toLine - range->fromLine;
+        }
+    }
+    return allFoldRanges;
+}
+
+int main()
+{
+    std::mt19937 random(20230101);
+    for (int round=0;round<2000;round++) {
+        int lineCount = 1 + random() % 200;
+        PCodeFoldingRanges allFoldRanges = randomFolds(random, lineCount);
+        CollapsedFoldIndex index;
+        index.rebuild(allFoldRanges);
+        for (int i=1;i<=lineCount;i++) {
+            int expected = linearRowToLine(allFoldRanges, i);
+            int actual = index.rowToLine(i);
+            if (expected != actual) {
+                qDebug() << "Error in round" << round << ": row" << i
+                         << "expected line" << expected << "got" << actual;
+                exit(1);
+            }
+            expected = linearLineToRow(allFoldRanges, i);
+            actual = index.lineToRow(i);
+            if (expected != actual) {
+                qDebug() << "Error in round" << round << ": line" << i
+                         << "expected row" << expected << "got" << actual;
+                exit(1);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,280 @@
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <QDebug>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "qsynedit/linewrap.h"
+
+using namespace QSynedit;
+
+// rows of each line are counted one by one
+struct LinearWrapIndex {
+    QVector<int> rows;
+    QVector<bool> hidden;
+
+    int rowCount() const {
+        int result = 0;
+        for (int i=0;i<rows.count();i++)
+            result += hidden[i] ? 0 : rows[i];
+        return result;
+    }
+};
+
+static void fail(int round, const QString& message)
+{
+    qDebug() << "Error in round" << round << ":" << message;
+    exit(1);
+}
+
+static void checkLine(int round, const LineWrapIndex& index, int line, int expectedRow)
+{
+    if (index.lineToRow(line) != expectedRow)
+        fail(round, QString("line %1 at row %2, expected %3")
+             .arg(line).arg(index.lineToRow(line)).arg(expectedRow));
+}
+
+static void checkRow(int round, const LineWrapIndex& index, int row, int expectedLine, int expectedWrapRow)
+{
+    int wrapRow;
+    int line = index.rowToLine(row, wrapRow);
+    if (line != expectedLine || wrapRow != expectedWrapRow)
+        fail(round, QString("row %1 at line %2:%3, expected %4:%5")
+             .arg(row).arg(line).arg(wrapRow).arg(expectedLine).arg(expectedWrapRow));
+}
+
+static void check(int round, const LineWrapIndex& index, const LinearWrapIndex& expected)
+{
+    if (index.rowCount() != expected.rowCount())
+        fail(round, QString("row count %1, expected %2").arg(index.rowCount()).arg(expected.rowCount()));
+    int lineCount = expected.rows.count();
+    if (index.lineCount() != lineCount)
+        fail(round, QString("line count %1, expected %2").arg(index.lineCount()).arg(lineCount));
+    // the rows of each line are counted one by one
+    int row = 0;
+    for (int line=0;line<lineCount;line++) {
+        if (expected.hidden[line]) {
+            // hidden lines are shown on the last row of the fold
+            checkLine(round, index, line, std::max(0, row - 1));
+            continue;
+        }
+        checkLine(round, index, line, row);
+        for (int wrapRow=0;wrapRow<expected.rows[line];wrapRow++)
+            checkRow(round, index, row + wrapRow, line, wrapRow);
+        row += expected.rows[line];
+    }
+    for (int i=0;i<2;i++) {
+        checkLine(round, index, lineCount + i, row + i);
+        checkRow(round, index, row + i, lineCount + i, 0);
+    }
+}
+
+static void testIndex(int rounds, int maxLineCount, int maxChange)
+{
+    std::mt19937 random(20230101);
+    for (int round=0;round<rounds;round++) {
+        LineWrapIndex index;
+        LinearWrapIndex expected;
+        int lineCount = random() % maxLineCount;
+        index.reset(lineCount);
+        expected.rows.fill(1, lineCount);
+        expected.hidden.fill(false, lineCount);
+        for (int step=0;step<20;step++) {
+            int count = expected.rows.count();
+            switch (random() % 5) {
+            case 0: {
+                int line = count>0 ? random() % (count + 1) : 0;
+                int n = 1 + random() % maxChange;
+                index.linesInserted(line, n);
+                expected.rows.insert(line, n, 1);
+                expected.hidden.insert(line, n, false);
+            }
+                break;
+            case 1:
+                if (count > 0) {
+                    int line = random() % count;
+                    int n = 1 + random() % std::min(maxChange, count - line);
+                    index.linesDeleted(line, n);
+                    expected.rows.remove(line, n);
+                    expected.hidden.remove(line, n);
+                }
+                break;
+            case 2: {
+                QVector<int> fromLines, toLines;
+                expected.hidden.fill(false);
+                int line = 0;
+                while (count > 0 && line < count - 1) {
+                    line += random() % 10;
+                    int to = line + 1 + random() % 5;
+                    if (to >= count)
+                        break;
+                    fromLines.append(line);
+                    toLines.append(to);
+                    for (int i=line+1;i<=to;i++)
+                        expected.hidden[i] = true;
+                    line = to + 1;
+                }
+                index.setHiddenLines(fromLines, toLines);
+            }
+                break;
+            default:
+                for (int i=0;i<std::max(5, count/20) && count>0;i++) {
+                    int line = random() % count;
+                    int rows = 1 + random() % 4;
+                    QVector<int> rowStarts;
+                    for (int j=1;j<rows;j++)
+                        rowStarts.append(j*100);
+                    index.lineChanged(line);
+                    int delta = index.setRowStarts(line, rowStarts);
+                    int expectedDelta = expected.hidden[line] ? 0 : rows - expected.rows[line];
+                    expected.rows[line] = rows;
+                    if (delta != expectedDelta)
+                        fail(round, QString("row count of line %1 changed by %2, expected %3")
+                             .arg(line).arg(delta).arg(expectedDelta));
+                }
+                break;
+            }
+            check(round, index, expected);
+        }
+    }
+}
+
+static void testRowStarts()
+{
+    std::mt19937 random(20230102);
+    for (int round=0;round<2000;round++) {
+        QString text;
+        QList<int> glyphStartCharList;
+        QList<int> glyphStartPositionList;
+        int length = 1 + random() % 300;
+        int x = 0;
+        for (int i=0;i<length;i++) {
+            glyphStartCharList.append(i);
+            glyphStartPositionList.append(x);
+            bool space = random() % 6 == 0;
+            text += space ? QChar(' ') : QChar('a' + random() % 26);
+            x += (space ? 5 : 6 + random() % 10);
+        }
+        int lineWidth = x;
+        int width = 1 + random() % 200;
+        QVector<int> rowStarts = LineWrapIndex::computeRowStarts(
+                    text, glyphStartCharList, glyphStartPositionList, lineWidth, width);
+        int start = 0;
+        for (int i=0;i<=rowStarts.count();i++) {
+            int end = (i < rowStarts.count()) ? rowStarts[i] : lineWidth;
+            if (end <= start)
+                fail(round, QString("empty row %1").arg(i));
+            int startGlyph = glyphStartPositionList.indexOf(start);
+            int endGlyph = (i < rowStarts.count()) ? glyphStartPositionList.indexOf(end) : length;
+            if (startGlyph < 0 || endGlyph < 0)
+                fail(round, QString("row %1 is not broken between glyphs").arg(i));
+            // rows are too wide only if they have just one glyph
+            if (end - start > width && endGlyph - startGlyph > 1)
+                fail(round, QString("row %1 is %2 wide, more than %3").arg(i).arg(end - start).arg(width));
+            // a row broken in the middle of a word has no space to break after
+            if (i < rowStarts.count() && text[endGlyph] != ' ' && text[endGlyph-1] != ' ') {
+                for (int g=startGlyph+1;g<endGlyph;g++) {
+                    if (text[g] == ' ')
+                        fail(round, QString("row %1 is not broken after the space at %2").arg(i).arg(g));
+                }
+            }
+            start = end;
+        }
+    }
+}
+
+static void testWrapper()
+{
+    std::mt19937 random(20230103);
+    for (int round=0;round<500;round++) {
+        QString text;
+        QList<int> glyphStartCharList;
+        QList<int> glyphStartPositionList;
+        int length = 1 + random() % 3000;
+        int x = 0;
+        for (int i=0;i<length;i++) {
+            glyphStartCharList.append(i);
+            glyphStartPositionList.append(x);
+            bool space = random() % 6 == 0;
+            text += space ? QChar(' ') : QChar('a' + random() % 26);
+            x += (space ? 5 : 6 + random() % 10);
+        }
+        int width = 1 + random() % 200;
+        QVector<int> expected = LineWrapIndex::computeRowStarts(
+                    text, glyphStartCharList, glyphStartPositionList, x, width);
+        // the same rows are found when the line is wrapped in slices
+        LineWrapper wrapper(text, glyphStartCharList, glyphStartPositionList, x, width);
+        int slices = 0;
+        while (!wrapper.wrap(1 + random() % 10)) {
+            if (++slices > length)
+                fail(round, "wrapping is not done");
+        }
+        if (wrapper.rowStarts() != expected)
+            fail(round, QString("%1 rows wrapped in slices, expected %2")
+                 .arg(wrapper.rowStarts().count()).arg(expected.count()));
+    }
+
+    // the wrapper of a line follows it, until it's changed, deleted or measured
+    LineWrapIndex index;
+    index.reset(10);
+    PLineWrapper wrapper = std::make_shared<LineWrapper>("a b", QList<int>{0, 1, 2},
+                                                         QList<int>{0, 10, 20}, 30, 15);
+    index.setWrapper(5, wrapper);
+    index.linesInserted(2, 3);
+    if (index.wrapper(5) || index.wrapper(8) != wrapper)
+        fail(0, "wrapper is not moved with inserted lines");
+    index.linesDeleted(0, 2);
+    if (index.wrapper(6) != wrapper)
+        fail(0, "wrapper is not moved with deleted lines");
+    index.lineChanged(5);
+    if (index.wrapper(6) != wrapper)
+        fail(0, "wrapper is dropped when another line is changed");
+    index.setRowStarts(6, QVector<int>{10});
+    if (index.wrapper(6))
+        fail(0, "wrapper is kept after the line is measured");
+    index.setWrapper(6, wrapper);
+    index.linesDeleted(5, 2);
+    if (index.wrapper(5) || index.wrapper(6))
+        fail(0, "wrapper is kept after the line is deleted");
+}
+
+static void testMeasured()
+{
+    LineWrapIndex index;
+    index.reset(600);
+    for (int line=0;line<600;line++) {
+        if (line != 300 && line != 550)
+            index.setRowStarts(line, QVector<int>());
+    }
+    if (index.nextUnmeasured() != 300)
+        fail(0, QString("next unmeasured line %1, expected 300").arg(index.nextUnmeasured()));
+    index.setRowStarts(300, QVector<int>());
+    if (index.nextUnmeasured() != 550)
+        fail(0, QString("next unmeasured line %1, expected 550").arg(index.nextUnmeasured()));
+    index.setRowStarts(550, QVector<int>());
+    if (index.nextUnmeasured() != -1)
+        fail(0, QString("next unmeasured line %1, expected none").arg(index.nextUnmeasured()));
+    index.lineChanged(10);
+    if (index.nextUnmeasured() != 10 || index.isMeasured(10) || !index.isMeasured(11))
+        fail(0, "changed line is not measured again");
+    // lines moved up by a deletion are not skipped
+    index.setRowStarts(10, QVector<int>());
+    index.linesInserted(400, 1);
+    index.nextUnmeasured();
+    index.linesDeleted(0, 100);
+    if (index.nextUnmeasured() != 300)
+        fail(0, QString("next unmeasured line %1, expected 300").arg(index.nextUnmeasured()));
+}
+
+int main()
+{
+    testIndex(2000, 100, 5);
+    // lines are split into blocks and merged again
+    testIndex(30, 3000, 1200);
+    testRowStarts();
+    testWrapper();
+    testMeasured();
+    return 0;
+}
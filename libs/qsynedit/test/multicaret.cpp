@@ -0,0 +1,99 @@
+#include <cstdlib>
+#include <QApplication>
+#include <QDebug>
+#include <QString>
+#include <QStringList>
+
+#include "qsynedit/qsynedit.h"
+#include "qsynedit/formatter/cppformatter.h"
+#include "qsynedit/syntaxer/cpp.h"
+
+using namespace QSynedit;
+
+static void fail(const QString& test, const QString& message)
+{
+    qDebug() << "Error in test" << test << ":" << message;
+    exit(1);
+}
+
+static void checkLines(const QString& test, const QSynEdit& edit, const QStringList& expected)
+{
+    QStringList lines = edit.document()->contents();
+    if (lines != expected)
+        fail(test, QString("lines [%1], expected [%2]").arg(lines.join("|"), expected.join("|")));
+}
+
+static void checkPos(const QString& test, BufferCoord pos, int ch, int line)
+{
+    if (pos.ch != ch || pos.line != line)
+        fail(test, QString("caret at (%1,%2), expected (%3,%4)").arg(pos.ch).arg(pos.line).arg(ch).arg(line));
+}
+
+// select the first occurrence of text at line 1, and add carets at all others
+static void selectAll(QSynEdit& edit, const QStringList& lines, int length)
+{
+    edit.document()->setContents(lines);
+    edit.setCaretAndSelection(BufferCoord{length + 1, 1}, BufferCoord{1, 1}, BufferCoord{length + 1, 1});
+    edit.selectAllOccurrences();
+}
+
+static void testTyping(QSynEdit& edit)
+{
+    selectAll(edit, {"ab ab", "ab"}, 2);
+    if (edit.extraCarets().count() != 2)
+        fail("typing", QString("%1 extra carets, expected 2").arg(edit.extraCarets().count()));
+    // carets after an edit on the same line are moved by it
+    edit.processCommand(EditCommand::Char, 'y');
+    checkLines("typing", edit, {"y y", "y"});
+    checkPos("typing", edit.caretXY(), 2, 1);
+    checkPos("typing", edit.extraCarets()[0].caret, 4, 1);
+    checkPos("typing", edit.extraCarets()[1].caret, 2, 2);
+
+    edit.processCommand(EditCommand::DeleteLastChar);
+    checkLines("delete", edit, {" ", ""});
+    checkPos("delete", edit.caretXY(), 1, 1);
+    checkPos("delete", edit.extraCarets()[0].caret, 2, 1);
+    checkPos("delete", edit.extraCarets()[1].caret, 1, 2);
+}
+
+static void testLineBreak(QSynEdit& edit)
+{
+    selectAll(edit, {"ab ab"}, 2);
+    // the second caret is moved to the line inserted by the first one
+    edit.processCommand(EditCommand::LineBreak);
+    checkLines("line break", edit, {"", " ", ""});
+    checkPos("line break", edit.caretXY(), 1, 2);
+    if (edit.extraCarets().count() != 1)
+        fail("line break", QString("%1 extra carets, expected 1").arg(edit.extraCarets().count()));
+    checkPos("line break", edit.extraCarets()[0].caret, 1, 3);
+}
+
+static void testIndent(QSynEdit& edit)
+{
+    edit.setSyntaxer(std::make_shared<CppSyntaxer>());
+    edit.setFormatter(std::make_shared<CppFormatter>());
+    selectAll(edit, {"x", "x"}, 1);
+    // the lines inserted at each caret are indented by the brace typed before them
+    QString text = "x {\ny;\n}";
+    edit.processCommand(EditCommand::String, QChar(), &text);
+    QStringList lines = edit.document()->contents();
+    if (lines.count() != 6)
+        fail("indent", QString("%1 lines, expected 6").arg(lines.count()));
+    if (lines[1].trimmed() != "y;" || lines[1] == "y;")
+        fail("indent", QString("line 2 is \"%1\", expected an indented \"y;\"").arg(lines[1]));
+    if (lines[4] != lines[1])
+        fail("indent", QString("line 5 is \"%1\", expected \"%2\"").arg(lines[4], lines[1]));
+    checkPos("indent", edit.caretXY(), 2, 3);
+    checkPos("indent", edit.extraCarets()[0].caret, 2, 6);
+}
+
+int main(int argc, char *argv[])
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    QSynEdit edit;
+    testTyping(edit);
+    testLineBreak(edit);
+    testIndent(edit);
+    return 0;
+}
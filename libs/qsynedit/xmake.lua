@@ -7,7 +7,10 @@ target("qsynedit")
     add_files(
         "qsynedit/codefolding.cpp",
         "qsynedit/constants.cpp",
+        "qsynedit/filewriter.cpp",
         "qsynedit/keystrokes.cpp",
+        "qsynedit/linewrap.cpp",
+        "qsynedit/minimap.cpp",
         "qsynedit/miscprocs.cpp",
         "qsynedit/painter.cpp",
         "qsynedit/types.cpp",
@@ -31,6 +34,7 @@ target("qsynedit")
     add_moc_classes(
         "qsynedit/document",
         "qsynedit/gutter",
+        "qsynedit/minimap",
         "qsynedit/qsynedit",
         -- searcher
         "qsynedit/searcher/baseseacher",
@@ -43,3 +47,46 @@ target("qsynedit")
 
     -- do not install
     on_install(function (target) end)
+
+target("test-fold-index")
+    set_kind("binary")
+    add_rules("qt.console")
+
+    set_default(false)
+    add_tests("test-fold-index")
+
+    add_files("qsynedit/codefolding.cpp", "test/foldindex.cpp")
+    add_includedirs(".")
+
+target("test-line-wrap")
+    set_kind("binary")
+    add_rules("qt.console")
+
+    set_default(false)
+    add_tests("test-line-wrap")
+
+    add_files("qsynedit/linewrap.cpp", "test/linewrap.cpp")
+    add_includedirs(".")
+
+target("test-file-writer")
+    set_kind("binary")
+    add_rules("qt.console")
+    add_deps("redpanda_qt_utils")
+
+    set_default(false)
+    add_tests("test-file-writer")
+
+    add_files("qsynedit/filewriter.cpp", "test/filewriter.cpp")
+    add_includedirs(".")
+
+target("test-multi-caret")
+    set_kind("binary")
+    add_rules("qt.console")
+    add_frameworks("QtGui", "QtWidgets")
+    add_deps("qsynedit")
+
+    set_default(false)
+    add_tests("test-multi-caret")
+
+    add_files("test/multicaret.cpp")
+    add_includedirs(".")
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "tracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+static const int EventsPerThread = 64*1024;
+// events of exited threads kept for the export, oldest threads are dropped first
+static const int MaxFinishedBuffers = 16;
+static const int MaxLatencySamples = 1024;
+
+std::atomic<bool> Tracer::mEnabled{false};
+
+struct TraceEvent {
+    const char* name;
+    qint64 start;
+    qint64 duration;
+};
+
+struct ThreadTraceBuffer {
+    // only contended while exporting
+    QMutex mutex;
+    QVector<TraceEvent> events;
+    int next;
+    bool wrapped;
+    int threadId;
+    QString threadName;
+};
+
+using PThreadTraceBuffer = std::shared_ptr<ThreadTraceBuffer>;
+
+static void retireBuffer(const PThreadTraceBuffer& buffer);
+
+// retires the buffer of its thread when the thread exits
+struct ThreadTraceBufferOwner {
+    ~ThreadTraceBufferOwner() {
+        if (buffer)
+            retireBuffer(buffer);
+    }
+    PThreadTraceBuffer buffer;
+};
+
+static QMutex buffersMutex;
+// buffers of running threads
+static QList<PThreadTraceBuffer> buffers;
+// buffers of exited threads, only holding their recorded events
+static QList<PThreadTraceBuffer> finishedBuffers;
+static int nextThreadId = 1;
+static thread_local ThreadTraceBufferOwner threadBuffer;
+
+static QMutex latencyMutex;
+static QVector<qint64> latencySamples;
+static int nextLatencySample = 0;
+
+static ThreadTraceBuffer* currentThreadBuffer()
+{
+    if (!threadBuffer.buffer) {
+        PThreadTraceBuffer buffer = std::make_shared<ThreadTraceBuffer>();
+        buffer->events.resize(EventsPerThread);
+        buffer->next = 0;
+        buffer->wrapped = false;
+        QMutexLocker locker(&buffersMutex);
+        buffer->threadId = nextThreadId++;
+        QThread* thread = QThread::currentThread();
+        if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+            buffer->threadName = "GUI";
+        else if (thread && !thread->objectName().isEmpty())
+            buffer->threadName = thread->objectName();
+        else
+            buffer->threadName = QString("Thread %1").arg(buffer->threadId);
+        buffers.append(buffer);
+        threadBuffer.buffer = buffer;
+    }
+    return threadBuffer.buffer.get();
+}
+
+// oldest first, buffer->mutex must be locked
+static QVector<TraceEvent> recordedEvents(const ThreadTraceBuffer* buffer)
+{
+    if (buffer->wrapped)
+        return buffer->events.mid(buffer->next) + buffer->events.mid(0, buffer->next);
+    return buffer->events.mid(0, buffer->next);
+}
+
+static void retireBuffer(const PThreadTraceBuffer& buffer)
+{
+    QMutexLocker locker(&buffersMutex);
+    buffers.removeOne(buffer);
+    {
+        // the ring is freed, only the recorded events are kept
+        QMutexLocker bufferLocker(&buffer->mutex);
+        buffer->events = recordedEvents(buffer.get());
+        buffer->next = buffer->events.count();
+        buffer->wrapped = false;
+        if (buffer->events.isEmpty())
+            return;
+    }
+    finishedBuffers.append(buffer);
+    while (finishedBuffers.count() > MaxFinishedBuffers)
+        finishedBuffers.removeFirst();
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+    if (enabled) {
+        QMutexLocker locker(&latencyMutex);
+        latencySamples.clear();
+        nextLatencySample = 0;
+    }
+    mEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+qint64 Tracer::now()
+{
+    static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Tracer::record(const char *name, qint64 start, qint64 end)
+{
+    ThreadTraceBuffer* buffer = currentThreadBuffer();
+    QMutexLocker locker(&buffer->mutex);
+    buffer->events[buffer->next] = TraceEvent{name, start, end - start};
+    buffer->next++;
+    if (buffer->next >= buffer->events.count()) {
+        buffer->next = 0;
+        buffer->wrapped = true;
+    }
+}
+
+void Tracer::clear()
+{
+    QMutexLocker locker(&buffersMutex);
+    foreach (const PThreadTraceBuffer& buffer, buffers) {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        buffer->next = 0;
+        buffer->wrapped = false;
+    }
+    finishedBuffers.clear();
+    QMutexLocker latencyLocker(&latencyMutex);
+    latencySamples.clear();
+    nextLatencySample = 0;
+}
+
+bool Tracer::exportChromeTrace(const QString &filename)
+{
+    QFile file(filename);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+        return false;
+    QByteArray content;
+    content.append("{\"traceEvents\":[\n");
+    bool first = true;
+    QMutexLocker locker(&buffersMutex);
+    foreach (const PThreadTraceBuffer& buffer, finishedBuffers + buffers) {
+        QVector<TraceEvent> events;
+        {
+            QMutexLocker bufferLocker(&buffer->mutex);
+            events = recordedEvents(buffer.get());
+        }
+        if (!first)
+            content.append(",\n");
+        first = false;
+        content.append(QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,\"args\":{\"name\":\"%2\"}}")
+                       .arg(buffer->threadId)
+                       .arg(buffer->threadName).toUtf8());
+        foreach (const TraceEvent& event, events) {
+            // timestamps in the trace event format are in microseconds
+            content.append(QString(",\n{\"name\":\"%1\",\"ph\":\"X\",\"pid\":1,\"tid\":%2,\"ts\":%3,\"dur\":%4}")
+                           .arg(event.name)
+                           .arg(buffer->threadId)
+                           .arg(event.start / 1000.0, 0, 'f', 3)
+                           .arg(event.duration / 1000.0, 0, 'f', 3).toUtf8());
+        }
+        if (content.length() >= 1024*1024) {
+            if (file.write(content) != content.length())
+                return false;
+            content.clear();
+        }
+    }
+    content.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+    return file.write(content) == content.length();
+}
+
+void Tracer::addLatencySample(qint64 latency)
+{
+    QMutexLocker locker(&latencyMutex);
+    if (latencySamples.count() < MaxLatencySamples) {
+        latencySamples.append(latency);
+    } else {
+        latencySamples[nextLatencySample] = latency;
+        nextLatencySample = (nextLatencySample + 1) % MaxLatencySamples;
+    }
+}
+
+QVector<qint64> Tracer::sortedLatencySamples()
+{
+    QVector<qint64> samples;
+    {
+        QMutexLocker locker(&latencyMutex);
+        samples = latencySamples;
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples;
+}
+
+qint64 Tracer::percentile(const QVector<qint64> &sortedSamples, int percent)
+{
+    if (sortedSamples.isEmpty())
+        return 0;
+    int index = (sortedSamples.count() - 1) * percent / 100;
+    return sortedSamples[index];
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef QT_UTILS_TRACER_H
+#define QT_UTILS_TRACER_H
+#include <atomic>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Collects timed spans of the IDE's hot paths.
+ *
+ * Each thread records into its own ring buffer, so only the newest events are kept.
+ * The result can be exported in the Chrome trace event format, and viewed with
+ * chrome://tracing or Perfetto.
+ */
+class Tracer
+{
+public:
+    static bool enabled() {
+        return mEnabled.load(std::memory_order_relaxed);
+    }
+    static void setEnabled(bool enabled);
+    // monotonic time in nanoseconds
+    static qint64 now();
+    // name must point to a string that lives as long as the program (a literal)
+    static void record(const char* name, qint64 start, qint64 end);
+    static void clear();
+    static bool exportChromeTrace(const QString& filename);
+
+    // keystroke-to-paint latencies, in nanoseconds
+    static void addLatencySample(qint64 latency);
+    static QVector<qint64> sortedLatencySamples();
+    static qint64 percentile(const QVector<qint64>& sortedSamples, int percent);
+private:
+    static std::atomic<bool> mEnabled;
+};
+
+/**
+ * @brief Records the lifetime of a scope as a span.
+ *
+ * When the tracer is disabled, it costs only a check of the flag.
+ */
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name):
+        mName{name},
+        mStart{Tracer::enabled()?Tracer::now():-1}
+    {
+    }
+    ~TraceSpan() {
+        if (mStart>=0)
+            Tracer::record(mName, mStart, Tracer::now());
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+private:
+    const char* mName;
+    qint64 mStart;
+};
+
+#endif // QT_UTILS_TRACER_H
@@ -22,10 +22,12 @@ msvc {
 }
 
 SOURCES += qt_utils/utils.cpp \
-	qt_utils/charsetinfo.cpp
+	qt_utils/charsetinfo.cpp \
+	qt_utils/tracer.cpp
 
 HEADERS += qt_utils/utils.h \
-	qt_utils/charsetinfo.h
+	qt_utils/charsetinfo.h \
+	qt_utils/tracer.h
 
 TRANSLATIONS += \
     qt_utils_zh_CN.ts
@@ -3,7 +3,7 @@ target("redpanda_qt_utils")
     add_rules("qt.ts")
     add_frameworks("QtGui", "QtWidgets")
 
-    add_files("qt_utils/utils.cpp")
+    add_files("qt_utils/utils.cpp", "qt_utils/tracer.cpp")
     add_moc_classes("qt_utils/charsetinfo")
     add_includedirs(".", {interface = true})
 
@@ -0,0 +1,367 @@
+/*
+ *  This file is part of Red Panda C++
+ *  Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Heap allocation profiler, loaded into the profiled program by LD_PRELOAD.
+ *
+ * malloc/calloc/realloc/memalign and free are replaced by wrappers of the
+ * glibc implementations. C++ new/delete are caught through the malloc/free
+ * calls of libstdc++. Every allocation updates the heap counters; after each
+ * REDPANDA_HEAPPROF_RATE allocated bytes, the stack of the next allocation is
+ * sampled with backtrace() and written to the REDPANDA_HEAPPROF_OUTPUT file.
+ * Frees of the sampled blocks are written too, so the blocks never freed are
+ * known at exit.
+ *
+ * Log format (native byte order):
+ *   header: "RPHEAP01", u64 sample rate
+ *   'A' u64 address, u64 size, u16 depth, u64 frames[depth]
+ *   'F' u64 address
+ *   'M' u32 length, contents of /proc/self/maps (at exit)
+ *   'E' u64 peak heap, u64 allocation count, u64 allocated bytes, u64 heap in use
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define MAX_DEPTH 64
+#define DEFAULT_SAMPLE_RATE 4096
+#define BUFFER_SIZE 65536
+/* live sampled blocks, must be a power of 2 */
+#define TABLE_SIZE (1 << 20)
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *ptr);
+
+#define EXPORT __attribute__((visibility("default")))
+#define TLS __thread __attribute__((tls_model("initial-exec")))
+
+static atomic_int gEnabled;
+static int gFd = -1;
+static uint64_t gSampleRate = DEFAULT_SAMPLE_RATE;
+static atomic_int_fast64_t gHeapInUse;
+static atomic_int_fast64_t gPeakHeap;
+static atomic_uint_fast64_t gAllocCount;
+static atomic_uint_fast64_t gAllocBytes;
+
+static pthread_mutex_t gLock = PTHREAD_MUTEX_INITIALIZER;
+static uintptr_t *gTable = NULL;
+static size_t gTableCount = 0;
+static char gBuffer[BUFFER_SIZE];
+static size_t gBufferUsed = 0;
+
+static TLS int tInHook = 0;
+static TLS int64_t tBytesUntilSample = 0;
+
+static void flushBuffer(void)
+{
+    size_t written = 0;
+    while (written < gBufferUsed) {
+        ssize_t n = write(gFd, gBuffer + written, gBufferUsed - written);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            /* stop logging if the file can't be written */
+            gEnabled = 0;
+            break;
+        }
+        written += n;
+    }
+    gBufferUsed = 0;
+}
+
+static void writeBytes(const void *data, size_t length)
+{
+    const char *p = (const char *)data;
+    while (length > 0) {
+        if (gBufferUsed == BUFFER_SIZE)
+            flushBuffer();
+        size_t n = BUFFER_SIZE - gBufferUsed;
+        if (n > length)
+            n = length;
+        memcpy(gBuffer + gBufferUsed, p, n);
+        gBufferUsed += n;
+        p += n;
+        length -= n;
+    }
+}
+
+static void writeU64(uint64_t value)
+{
+    writeBytes(&value, sizeof(value));
+}
+
+static size_t tableSlot(uintptr_t address)
+{
+    /* blocks are at least 16 bytes aligned */
+    return (size_t)((address >> 4) * 0x9E3779B97F4A7C15ull) & (TABLE_SIZE - 1);
+}
+
+static int tableInsert(uintptr_t address)
+{
+    if (gTableCount >= TABLE_SIZE / 2)
+        return 0;
+    size_t i = tableSlot(address);
+    while (gTable[i] != 0) {
+        if (gTable[i] == address)
+            return 1;
+        i = (i + 1) & (TABLE_SIZE - 1);
+    }
+    gTable[i] = address;
+    gTableCount++;
+    return 1;
+}
+
+static int tableRemove(uintptr_t address)
+{
+    size_t i = tableSlot(address);
+    while (gTable[i] != address) {
+        if (gTable[i] == 0)
+            return 0;
+        i = (i + 1) & (TABLE_SIZE - 1);
+    }
+    gTable[i] = 0;
+    gTableCount--;
+    /* move the following entries of the probe chain back */
+    size_t j = i;
+    while (1) {
+        j = (j + 1) & (TABLE_SIZE - 1);
+        if (gTable[j] == 0)
+            break;
+        size_t k = tableSlot(gTable[j]);
+        if ((j > i && (k <= i || k > j)) || (j < i && (k <= i && k > j))) {
+            gTable[i] = gTable[j];
+            gTable[j] = 0;
+            i = j;
+        }
+    }
+    return 1;
+}
+
+static void recordAlloc(void *ptr, size_t size)
+{
+    if (ptr == NULL)
+        return;
+    int64_t usable = (int64_t)malloc_usable_size(ptr);
+    int64_t inUse = atomic_fetch_add(&gHeapInUse, usable) + usable;
+    int64_t peak = atomic_load(&gPeakHeap);
+    while (inUse > peak && !atomic_compare_exchange_weak(&gPeakHeap, &peak, inUse))
+        ;
+    atomic_fetch_add(&gAllocCount, 1);
+    atomic_fetch_add(&gAllocBytes, size);
+    if (!gEnabled || tInHook)
+        return;
+    tBytesUntilSample -= (int64_t)size;
+    if (tBytesUntilSample > 0)
+        return;
+    tBytesUntilSample = (int64_t)gSampleRate;
+
+    tInHook = 1;
+    void *frames[MAX_DEPTH];
+    int depth = backtrace(frames, MAX_DEPTH);
+    pthread_mutex_lock(&gLock);
+    if (gEnabled && tableInsert((uintptr_t)ptr)) {
+        char type = 'A';
+        uint16_t frameCount = (uint16_t)depth;
+        writeBytes(&type, 1);
+        writeU64((uintptr_t)ptr);
+        writeU64(size);
+        writeBytes(&frameCount, sizeof(frameCount));
+        for (int i = 0; i < depth; i++)
+            writeU64((uintptr_t)frames[i]);
+    }
+    pthread_mutex_unlock(&gLock);
+    tInHook = 0;
+}
+
+static void recordFree(void *ptr)
+{
+    if (ptr == NULL)
+        return;
+    atomic_fetch_sub(&gHeapInUse, (int64_t)malloc_usable_size(ptr));
+    if (!gEnabled)
+        return;
+    pthread_mutex_lock(&gLock);
+    if (gEnabled && gTableCount > 0 && tableRemove((uintptr_t)ptr)) {
+        char type = 'F';
+        writeBytes(&type, 1);
+        writeU64((uintptr_t)ptr);
+    }
+    pthread_mutex_unlock(&gLock);
+}
+
+EXPORT void *malloc(size_t size)
+{
+    void *ptr = __libc_malloc(size);
+    recordAlloc(ptr, size);
+    return ptr;
+}
+
+EXPORT void *calloc(size_t count, size_t size)
+{
+    void *ptr = __libc_calloc(count, size);
+    recordAlloc(ptr, count * size);
+    return ptr;
+}
+
+EXPORT void *realloc(void *ptr, size_t size)
+{
+    if (ptr == NULL)
+        return malloc(size);
+    size_t oldSize = malloc_usable_size(ptr);
+    recordFree(ptr);
+    void *newPtr = __libc_realloc(ptr, size);
+    if (newPtr == NULL) {
+        /* the old block is still alive */
+        if (size != 0)
+            atomic_fetch_add(&gHeapInUse, (int64_t)oldSize);
+        return NULL;
+    }
+    recordAlloc(newPtr, size);
+    return newPtr;
+}
+
+EXPORT void *memalign(size_t alignment, size_t size)
+{
+    void *ptr = __libc_memalign(alignment, size);
+    recordAlloc(ptr, size);
+    return ptr;
+}
+
+EXPORT void *aligned_alloc(size_t alignment, size_t size)
+{
+    return memalign(alignment, size);
+}
+
+EXPORT int posix_memalign(void **result, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    void *ptr = memalign(alignment, size);
+    if (ptr == NULL)
+        return ENOMEM;
+    *result = ptr;
+    return 0;
+}
+
+EXPORT void *valloc(size_t size)
+{
+    return memalign(sysconf(_SC_PAGESIZE), size);
+}
+
+EXPORT void free(void *ptr)
+{
+    recordFree(ptr);
+    __libc_free(ptr);
+}
+
+static void disableInChild(void)
+{
+    /* the forked child shares the log file with its parent */
+    gEnabled = 0;
+}
+
+static int isProfiledProgram(void)
+{
+    const char *target = getenv("REDPANDA_HEAPPROF_EXE");
+    if (target == NULL || target[0] == '\0')
+        return 1;
+    /* the terminal emulator and the console pauser also get LD_PRELOAD */
+    char exe[4096];
+    ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (n < 0)
+        return 0;
+    exe[n] = '\0';
+    return strcmp(exe, target) == 0;
+}
+
+__attribute__((constructor))
+static void startProfiling(void)
+{
+    const char *output = getenv("REDPANDA_HEAPPROF_OUTPUT");
+    if (output == NULL || output[0] == '\0' || !isProfiledProgram())
+        return;
+    const char *rate = getenv("REDPANDA_HEAPPROF_RATE");
+    if (rate != NULL && rate[0] != '\0')
+        gSampleRate = strtoull(rate, NULL, 10);
+    gTable = (uintptr_t *)mmap(NULL, TABLE_SIZE * sizeof(uintptr_t), PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (gTable == MAP_FAILED) {
+        gTable = NULL;
+        return;
+    }
+    gFd = open(output, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (gFd < 0)
+        return;
+    /* backtrace() loads libgcc on the first call, which allocates */
+    void *frames[1];
+    tInHook = 1;
+    backtrace(frames, 1);
+    tInHook = 0;
+    writeBytes("RPHEAP01", 8);
+    writeU64(gSampleRate);
+    pthread_atfork(NULL, NULL, disableInChild);
+    gEnabled = 1;
+}
+
+__attribute__((destructor))
+static void stopProfiling(void)
+{
+    if (!gEnabled)
+        return;
+    tInHook = 1;
+    pthread_mutex_lock(&gLock);
+    gEnabled = 0;
+    /* module addresses are needed to symbolize the frames */
+    int maps = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+    if (maps >= 0) {
+        static char contents[1 << 20];
+        uint32_t length = 0;
+        ssize_t n;
+        while (length < sizeof(contents)
+               && (n = read(maps, contents + length, sizeof(contents) - length)) > 0)
+            length += (uint32_t)n;
+        close(maps);
+        char type = 'M';
+        writeBytes(&type, 1);
+        writeBytes(&length, sizeof(length));
+        writeBytes(contents, length);
+    }
+    int64_t inUse = atomic_load(&gHeapInUse);
+    char type = 'E';
+    writeBytes(&type, 1);
+    writeU64((uint64_t)atomic_load(&gPeakHeap));
+    writeU64(atomic_load(&gAllocCount));
+    writeU64(atomic_load(&gAllocBytes));
+    writeU64(inUse > 0 ? (uint64_t)inUse : 0);
+    flushBuffer();
+    close(gFd);
+    gFd = -1;
+    pthread_mutex_unlock(&gLock);
+}
@@ -0,0 +1,28 @@
+TEMPLATE = lib
+
+CONFIG += plugin
+CONFIG -= qt
+
+TARGET = redpanda-heapprof
+
+isEmpty(APP_NAME) {
+    APP_NAME = RedPandaCPP
+}
+
+SOURCES += \
+    heapprofiler.c
+
+LIBS += \
+    -ldl \
+    -lpthread
+
+isEmpty(PREFIX) {
+    PREFIX = /usr/local
+}
+isEmpty(LIBEXECDIR) {
+    LIBEXECDIR = $${PREFIX}/libexec
+}
+
+# Default rules for deployment.
+target.path = $${LIBEXECDIR}/$${APP_NAME}
+INSTALLS += target
@@ -0,0 +1,9 @@
+target("redpanda-heapprof")
+    set_kind("shared")
+
+    add_files("heapprofiler.c")
+    add_syslinks("dl", "pthread")
+
+    if is_xdg() then
+        on_install(install_libexec)
+    end
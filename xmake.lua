@@ -191,6 +191,9 @@ includes("libs/qsynedit")
 includes("libs/redpanda_qt_utils")
 includes("tools/astyle")
 includes("tools/consolepauser")
+if is_os("linux") then
+    includes("tools/heapprofiler")
+end
 if has_config("vcs") then
     if is_os("windows") then
         includes("tools/redpanda-win-git-askpass")